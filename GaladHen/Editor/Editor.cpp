@@ -14,6 +14,8 @@
 #include <Systems/RenderingSystem/Entities/ShaderPipeline.h>
 #include <Systems/AssetSystem/AssetSystem.h>
 #include <Systems/TimeSystem/TimeSystem.h>
+#include <Systems/RenderingSystem/Baking/LightmapBaker.h>
+#include <Math/AABB/AABB.h>
 
 #include <glm/glm.hpp>
 
@@ -23,6 +25,7 @@ namespace GaladHen
     // STATIC INITIALIZATIONS -----------------------------------------------------------------------------------
 
     Scene Editor::Scene{};
+    ScenePicker Editor::Picker{};
 
     // STATIC INITIALIZATIONS -----------------------------------------------------------------------------------
 
@@ -37,6 +40,9 @@ namespace GaladHen
 
         //AddDefaultGizmosToScene();
         AddDefaultBunnyToScene();
+
+        // refitted every frame, before the ui picks
+        Picker.Build(Scene);
 	}
 
     void Editor::AddDefaultBunnyToScene()
@@ -73,33 +79,35 @@ namespace GaladHen
         shBunnyMat->SetPipeline(pbrBunny);
         shBunnyMat->TextureData.emplace("DiffuseTexture", texAlbedo);
         shBunnyMat->TextureData.emplace("NormalMap", texNormal);
-        shBunnyMat->ScalarData.emplace("Metallic", 0.0f);
-        shBunnyMat->ScalarData.emplace("Roughness", 0.5f);
+        shBunnyMat->SetScalar("Metallic", 0.0f);
+        shBunnyMat->SetScalar("Roughness", 0.5f);
 
         std::weak_ptr<Material> planeMat = AssetSystem::GetInstance()->CreateAndStoreMaterial("PlaneMaterial");
         std::shared_ptr<Material> shPlaneMat = planeMat.lock();
 
         std::weak_ptr<ShaderPipeline> pbrPlane = AssetSystem::GetInstance()->LoadAndStoreShaderPipeline("GaladHen/Shaders/ShadingModels/Pbr/Pbr.vert", "", "", "", "GaladHen/Shaders/Materials/Plane.frag", "", "Plane");
         shPlaneMat->SetPipeline(pbrPlane);
-        shPlaneMat->Vec4Data.emplace("DiffuseConstant", 1.0f);
-        shPlaneMat->ScalarData.emplace("Metallic", 0.0f);
-        shPlaneMat->ScalarData.emplace("Roughness", 1.0f);
+        shPlaneMat->SetVec4("DiffuseConstant", glm::vec4(1.0f));
+        shPlaneMat->SetScalar("Metallic", 0.0f);
+        shPlaneMat->SetScalar("Roughness", 1.0f);
 
        /* std::weak_ptr<ShaderPipeline> debugShadowDepth = AssetSystem::GetInstance()->LoadAndStoreShaderPipeline("GaladHen/Shaders/ShadingModels/Unlit/Unlit.vert", "", "", "", "GaladHen/Shaders/Materials/DebugShadowDepth.frag", "", "DebugShadowDepth");
         shPlaneMat->SetPipeline(debugShadowDepth);*/
 
         /*shPlaneMat->SetPipeline(unlit);
-        shPlaneMat->Vec4Data.emplace("ConstantColor", glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
-        shPlaneMat->ScalarData.emplace("Metallic", 0.0f);
-        shPlaneMat->ScalarData.emplace("Roughness", 0.1f);*/
+        shPlaneMat->SetVec4("ConstantColor", glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
+        shPlaneMat->SetScalar("Metallic", 0.0f);
+        shPlaneMat->SetScalar("Roughness", 0.1f);*/
 
         // load models
         std::weak_ptr<Model> bunny = AssetSystem::GetInstance()->LoadAndStoreModel("Assets/Models/bunny.glb", "Bunny");
         std::weak_ptr<Model> plane = AssetSystem::GetInstance()->LoadAndStoreModel("Assets/Models/plane.glb", "Plane");
 
-        // bvh
-        /*bunny->GetMeshes()[0].BVH.BuildBVH(bunny->GetMeshes()[0], AABBSplitMethod::PlaneCandidates);
-        bunny->BVH.BuildBVH(*bunny, AABBSplitMethod::PlaneCandidates);*/
+        // bvh (used by ray casting, ex: lightmap baking)
+        for (Mesh& mesh : bunny.lock()->Meshes)
+            mesh.BVH.BuildBVH(mesh, AABBSplitMethod::PlaneCandidates);
+        for (Mesh& mesh : plane.lock()->Meshes)
+            mesh.BVH.BuildBVH(mesh, AABBSplitMethod::PlaneCandidates);
 
         // shaders and materials
         //std::shared_ptr<ShaderPipeline> unlit = AssetsManager::LoadAndStoreShaderPipeline("GaladHen/Shaders/ShadingModels/Unlit/Unlit.vert", "", "", "", "GaladHen/Shaders/Materials/UnlitColor.frag", "", "UnlitColor");
@@ -119,13 +127,34 @@ namespace GaladHen
         bunnyObj.SetMeshMaterialLink(0, bunnyMat);
         bunnyObj.Transform.SetPosition(glm::vec3(0.0f, 1.5f, 0.0f));
         bunnyObj.Transform.SetYaw(50.0f);
+        bunnyObj.SetStatic(true); // never moved: the shadow cascades keep its depth between frames
         Scene.SceneObjects.emplace_back(bunnyObj);
 
         SceneObject planeObj{ plane };
         planeObj.SetMeshMaterialLink(0, planeMat);
         planeObj.Transform.SetScale(glm::vec3(50.0f, 1.0f, 50.0f));
+        planeObj.SetStatic(true);
         Scene.SceneObjects.emplace_back(planeObj);
 
+        // the plane is static: bake its ambient occlusion and directional light shadows into a lightmap
+        LightmapBaker baker{};
+        baker.Settings.Width = 512;
+        baker.Settings.Height = 512;
+        unsigned char* lightmapData = baker.Bake(Scene, (unsigned int)Scene.SceneObjects.size() - 1, 0);
+        if (lightmapData)
+        {
+            std::weak_ptr<Texture> planeLightmap = AssetSystem::GetInstance()->CreateAndStoreTexture(lightmapData, baker.Settings.Width, baker.Settings.Height, TextureFormat::RGBA8, "PlaneLightmap");
+            planeLightmap.lock()->SetWrapping(TextureWrapping::ClampToEdge);
+
+            std::weak_ptr<ShaderPipeline> lightmappedPlane = AssetSystem::GetInstance()->LoadAndStoreShaderPipeline("GaladHen/Shaders/ShadingModels/Unlit/Unlit.vert", "", "", "", "GaladHen/Shaders/Materials/LightmappedPlane.frag", "", "LightmappedPlane");
+            shPlaneMat->SetPipeline(lightmappedPlane);
+            shPlaneMat->TextureData.emplace("BakedLightmap", planeLightmap);
+        }
+
+        // indirect diffuse lighting for the pbr objects
+        Scene.IrradianceVolume.Settings.ProbeCount = glm::uvec3(16, 4, 16);
+        Scene.IrradianceVolume.Bake(Scene);
+
         //RayModelHitInfo hit = Math::RayModelIntersection(ray, *bunny, bunny->BVH, bunnyObj.Transform, BVHTraversalMethod::FrontToBack);
         //std::vector<unsigned int> indices = { 0, 1, 2 };
         //std::vector<MeshVertexData> vertices;
@@ -171,7 +200,7 @@ namespace GaladHen
         // shaders and materials
         std::weak_ptr<ShaderPipeline> unlit = AssetSystem::GetInstance()->LoadAndStoreShaderPipeline("GaladHen/Shaders/ShadingModels/Unlit/Unlit.vert", "", "", "", "GaladHen/Shaders/Materials/VertexUnlitColor.frag", "", "VertexUnlitColor");
         std::shared_ptr<Material> aabbMat{ new Material{ unlit } };
-        aabbMat->Vec4Data.emplace("Diffuse", glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+        aabbMat->SetVec4("Diffuse", glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
 
         std::shared_ptr<Material> gizmosMat{ new Material{ unlit } };
 
@@ -181,6 +210,19 @@ namespace GaladHen
         Scene.SceneObjects.emplace_back(gizmoObj);
     }
 
+    SceneRayHit Editor::PickSceneObject(const glm::vec2& viewportPoint)
+    {
+        return Picker.Pick(Scene.MainCamera.ViewportPointToRay(viewportPoint));
+    }
+
+    SceneObject* Editor::GetSceneObject(unsigned int sceneObjectIndex)
+    {
+        if (sceneObjectIndex >= Scene.SceneObjects.size())
+            return nullptr;
+
+        return &Scene.SceneObjects[sceneObjectIndex];
+    }
+
 	void Editor::Run()
 	{
         TimeSystem::GetInstance()->Start();
@@ -231,6 +273,9 @@ namespace GaladHen
             Scene.MainCamera.Transform.RotateYaw(cameraAngMov.x);
             Scene.MainCamera.Transform.RotatePitch(cameraAngMov.y);
 
+            // follow the scene objects moved, added or removed during the last frame
+            Picker.Refit(Scene);
+
             RenderingSystem::GetInstance()->Draw(Scene);
             RenderingSystem::GetInstance()->DrawUI();
 
@@ -6,6 +6,7 @@
 #include <Systems/RenderingSystem/Entities/Scene.h>
 #include <Systems/RenderingSystem/Common.h>
 #include <Systems/RenderingSystem/RenderingSystem.h>
+#include <Systems/RenderingSystem/RayTracing/ScenePicker.h>
 
 #include <vector>
 
@@ -32,9 +33,18 @@ namespace GaladHen
 		// Run the editor, assuming Init() was already called
 		static void Run();
 
+		// @brief
+		// Find the scene object under a point of the viewport
+		// @param viewportPoint: point in normalized viewport coordinates ([0,1] range, origin at the bottom left corner)
+		static SceneRayHit PickSceneObject(const glm::vec2& viewportPoint);
+
+		// @returns the scene object at the given index, nullptr if the index is not valid
+		static SceneObject* GetSceneObject(unsigned int sceneObjectIndex);
+
 	private:
 
 		static Scene Scene;
+		static ScenePicker Picker;
 
 	};
 }
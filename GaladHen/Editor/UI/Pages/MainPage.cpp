@@ -16,9 +16,11 @@ namespace GaladHen
 		: UIPage(pageName)
 	{
 		// Populate widgets for main page
+		UIInspectorWidget* inspector = new UIInspectorWidget{ "Inspector" };
+
 		Widgets.emplace_back(new UINavBarWidget{ "NavBar" });
-		Widgets.emplace_back(new UIViewportWidget{ "Viewport" });
-		//Widgets.emplace_back(new UIInspectorWidget{ "Inspector" });
+		Widgets.emplace_back(new UIViewportWidget{ "Viewport", inspector });
+		Widgets.emplace_back(inspector);
 	}
 
 	void UIMainPage::Build()
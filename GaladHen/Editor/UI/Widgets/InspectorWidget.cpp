@@ -3,28 +3,60 @@
 
 #include <imgui/imgui.h>
 
+#include <Editor/Editor.h>
 #include <Systems/RenderingSystem/Entities/SceneObject.h>
 
 namespace GaladHen
 {
 	UIInspectorWidget::UIInspectorWidget(const char* widgetName)
 		: UIWidget(widgetName)
+		, HasInspectedSceneObject(false)
+		, InspectedSceneObjectIndex(0)
+		, InspectedMeshIndex(0)
+		, InspectedTriangleIndex(0)
 		{}
 
 	void UIInspectorWidget::Build()
 	{
 		ImGui::Begin(WidgetName.data());
 
-		if (ImGui::CollapsingHeader("Transform"))
+		SceneObject* sceneObject = HasInspectedSceneObject ? Editor::GetSceneObject(InspectedSceneObjectIndex) : nullptr;
+		if (sceneObject)
 		{
-			ImGui::Text("Test");
+			ImGui::Text("Scene object %u", InspectedSceneObjectIndex);
+
+			if (ImGui::CollapsingHeader("Transform", ImGuiTreeNodeFlags_DefaultOpen))
+			{
+				glm::vec3 position = sceneObject->Transform.GetPosition();
+				glm::vec3 scale = sceneObject->Transform.GetScale();
+				ImGui::Text("Position: %.3f %.3f %.3f", position.x, position.y, position.z);
+				ImGui::Text("Scale: %.3f %.3f %.3f", scale.x, scale.y, scale.z);
+			}
+
+			if (ImGui::CollapsingHeader("Selection", ImGuiTreeNodeFlags_DefaultOpen))
+			{
+				ImGui::Text("Mesh: %u", InspectedMeshIndex);
+				ImGui::Text("Triangle: %u", InspectedTriangleIndex);
+			}
+		}
+		else
+		{
+			ImGui::Text("Nothing selected");
 		}
 
 		ImGui::End();
 	}
 
-	void UIInspectorWidget::SetInspectedSceneObject(std::weak_ptr<SceneObject> sceneObject)
+	void UIInspectorWidget::SetInspectedSceneObject(unsigned int sceneObjectIndex, unsigned int meshIndex, unsigned int triangleIndex)
+	{
+		HasInspectedSceneObject = true;
+		InspectedSceneObjectIndex = sceneObjectIndex;
+		InspectedMeshIndex = meshIndex;
+		InspectedTriangleIndex = triangleIndex;
+	}
+
+	void UIInspectorWidget::ClearInspectedSceneObject()
 	{
-		InspectedSceneObject = sceneObject;
+		HasInspectedSceneObject = false;
 	}
 }
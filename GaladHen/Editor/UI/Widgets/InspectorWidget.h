@@ -3,14 +3,10 @@
 
 #pragma once
 
-#include <memory>
-
 #include <Systems/RenderingSystem/UI/Widget.h>
 
 namespace GaladHen
 {
-	class SceneObject;
-
 	class UIInspectorWidget : public UIWidget
 	{
 	public:
@@ -19,11 +15,24 @@ namespace GaladHen
 
 		virtual void Build() override;
 
-		void SetInspectedSceneObject(std::weak_ptr<SceneObject> sceneObject);
+		// @brief
+		// Inspect a scene object of the editor scene (ex: the one picked in the viewport)
+		// @param sceneObjectIndex: index of the scene object inside the scene
+		// @param meshIndex: index of the selected mesh inside the scene object model
+		// @param triangleIndex: index of the selected triangle inside the mesh
+		void SetInspectedSceneObject(unsigned int sceneObjectIndex, unsigned int meshIndex, unsigned int triangleIndex);
+
+		// @brief
+		// Stop inspecting the current scene object
+		void ClearInspectedSceneObject();
 
 	protected:
 
-		std::weak_ptr<SceneObject> InspectedSceneObject;
+		// the scene object is stored by index: pointers inside the scene are not stable when objects are added
+		bool HasInspectedSceneObject;
+		unsigned int InspectedSceneObjectIndex;
+		unsigned int InspectedMeshIndex;
+		unsigned int InspectedTriangleIndex;
 
 	};
 }
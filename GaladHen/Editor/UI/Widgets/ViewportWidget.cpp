@@ -5,13 +5,15 @@
 #include <imgui/imgui_internal.h>
 
 #include <Editor/Editor.h>
+#include <Editor/UI/Widgets/InspectorWidget.h>
 #include <Systems/RenderingSystem/Entities/RenderBuffer.h>
 #include <Utils/Log.h>
 
 namespace GaladHen
 {
-	UIViewportWidget::UIViewportWidget(const char* widgetName)
+	UIViewportWidget::UIViewportWidget(const char* widgetName, UIInspectorWidget* inspector)
 		: UIWidget(widgetName)
+		, Inspector(inspector)
 	{}
 
 	void UIViewportWidget::Build()
@@ -43,6 +45,8 @@ namespace GaladHen
 		{
 			ImGui::GetWindowDrawList()->AddImage(RenderingSystem::GetInstance()->GetRenderBufferColorApiID(*shFrontBuffer), pos, size, ImVec2{ 0, 1 }, ImVec2{ 1, 0 });
 
+			PickUnderMouse(glm::vec2(pos.x, pos.y), glm::vec2(size.x, size.y));
+
 			ImGui::End();
 		}
 		else
@@ -50,4 +54,34 @@ namespace GaladHen
 			Log::Warning("ViewportWidget", "Invalid front buffer, widget will be empty");
 		}
 	}
+
+	void UIViewportWidget::PickUnderMouse(const glm::vec2& imageMin, const glm::vec2& imageMax)
+	{
+		if (!ImGui::IsWindowHovered())
+			return;
+
+		ImVec2 mouse = ImGui::GetMousePos();
+		glm::vec2 extent = imageMax - imageMin;
+		if (extent.x <= 0.0f || extent.y <= 0.0f)
+			return;
+
+		// the image is drawn flipped (screen y goes down, viewport y goes up)
+		glm::vec2 viewportPoint = (glm::vec2(mouse.x, mouse.y) - imageMin) / extent;
+		viewportPoint.y = 1.0f - viewportPoint.y;
+		if (glm::any(glm::lessThan(viewportPoint, glm::vec2(0.0f))) || glm::any(glm::greaterThan(viewportPoint, glm::vec2(1.0f))))
+			return;
+
+		// cheap enough to hover every frame
+		SceneRayHit hit = Editor::PickSceneObject(viewportPoint);
+		if (hit.Hit)
+			ImGui::SetTooltip("Scene object %u (mesh %u, triangle %u)", hit.SceneObjectIndex, hit.MeshIndex, hit.TriangleIndex);
+
+		if (Inspector && ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+		{
+			if (hit.Hit)
+				Inspector->SetInspectedSceneObject(hit.SceneObjectIndex, hit.MeshIndex, hit.TriangleIndex);
+			else
+				Inspector->ClearInspectedSceneObject();
+		}
+	}
 }
@@ -7,14 +7,26 @@
 
 namespace GaladHen
 {
+	class UIInspectorWidget;
+
 	class UIViewportWidget : public UIWidget
 	{
 	public:
 
-		UIViewportWidget(const char* widgetName);
+		// @param inspector: the widget receiving the scene objects picked with the mouse (can be nullptr)
+		UIViewportWidget(const char* widgetName, UIInspectorWidget* inspector = nullptr);
 
 		virtual void Build() override;
 
+	protected:
+
+		// @brief
+		// Pick the scene object under the mouse: hovered every frame, selected on left click
+		// @param imageMin: top left corner of the viewport image (screen coordinates)
+		// @param imageMax: bottom right corner of the viewport image (screen coordinates)
+		void PickUnderMouse(const glm::vec2& imageMin, const glm::vec2& imageMax);
+
+		UIInspectorWidget* Inspector;
+
 	};
 }
-
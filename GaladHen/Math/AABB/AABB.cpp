@@ -19,7 +19,7 @@ namespace GaladHen
 		assert(indices.size() % indicesStep == 0); // correct number of indices for the primitive type
 
 		MinBound = glm::vec3(std::numeric_limits<float>::max());
-		MaxBound = glm::vec3(std::numeric_limits<float>::min());
+		MaxBound = glm::vec3(std::numeric_limits<float>::lowest());
 
 		for (unsigned int i = fromIndex; i < fromIndex + countIndex; i += indicesStep)
 		{
@@ -31,7 +31,24 @@ namespace GaladHen
 
 	void AABB::BuildAABB(const std::vector<Mesh>& meshes, unsigned int fromIndex, unsigned int countIndex)
 	{
+		MinBound = glm::vec3(std::numeric_limits<float>::max());
+		MaxBound = glm::vec3(std::numeric_limits<float>::lowest());
 
+		for (unsigned int i = fromIndex; i < fromIndex + countIndex; ++i)
+		{
+			const Mesh& mesh = meshes[i];
+
+			if (mesh.BVH.GetNodeNumber() > 0)
+			{
+				// the root of the mesh bvh already bounds the whole mesh
+				BoundAABB(mesh.BVH.GetRootNode().AABoundingBox);
+			}
+			else
+			{
+				for (const MeshVertexData& vertex : mesh.Vertices)
+					BoundPoint(vertex.Position);
+			}
+		}
 	}
 
 	void AABB::BoundPoint(const glm::vec3& pointToBound)
@@ -20,7 +20,7 @@ namespace GaladHen
 	void BVH::BuildBVH(Mesh& mesh, AABBSplitMethod splitMethod)
 	{
 		Nodes.clear();
-		Nodes.reserve(mesh.Vertices.size() * 2 - 1); // the size of the BVH for N triangles has an upper limit: we can never have more than 2N-1 nodes, since N primitives in N leaves have no more than N/2 parents, N/4 grandparents and so on
+		Nodes.reserve(mesh.Indices.size() / ((int)mesh.PrimitiveType + 1) * 2 - 1); // the size of the BVH for N triangles has an upper limit: we can never have more than 2N-1 nodes, since N primitives in N leaves have no more than N/2 parents, N/4 grandparents and so on
 
 		Nodes.emplace_back(BVHNode{});
 		BVHNode& root = Nodes[0];
@@ -50,6 +50,8 @@ namespace GaladHen
 
 			break;
 		}
+
+		mesh.UpdateVersion(); // the indices were sorted
 	}
 
 	void BVH::BuildBVH(Model& model, AABBSplitMethod splitMethod)
@@ -182,11 +184,21 @@ namespace GaladHen
 		return Nodes[0];
 	}
 
+	const BVHNode& BVH::GetRootNode() const
+	{
+		return Nodes[0];
+	}
+
 	BVHNode& BVH::GetNode(unsigned int index)
 	{
 		return Nodes[index];
 	}
 
+	const BVHNode& BVH::GetNode(unsigned int index) const
+	{
+		return Nodes[index];
+	}
+
 	unsigned int BVH::GetNodeNumber() const
 	{
 		return Nodes.size();
@@ -217,6 +229,7 @@ namespace GaladHen
 					bestHit.VertexIndex0 = mesh.Indices[i];
 					bestHit.VertexIndex1 = mesh.Indices[i + 1];
 					bestHit.VertexIndex2 = mesh.Indices[i + 2];
+					bestHit.TriangleIndex = i / 3;
 				}
 			}
 		}
@@ -320,6 +333,10 @@ namespace GaladHen
 						bestHit.VertexIndex0 = mesh.Indices[i];
 						bestHit.VertexIndex1 = mesh.Indices[i + 1];
 						bestHit.VertexIndex2 = mesh.Indices[i + 2];
+						bestHit.TriangleIndex = i / 3;
+
+						// traversal optimization: shortening the ray discards nodes further than the current intersection point
+						ray.Length = hit.HitDistance;
 					}
 				}
 
@@ -393,6 +410,9 @@ namespace GaladHen
 					{
 						*(RayTriangleMeshHitInfo*)&bestHit = hit;
 						bestHit.MeshIndex = i;
+
+						// traversal optimization: shortening the ray discards nodes further than the current intersection point
+						ray.Length = hit.HitDistance;
 					}
 				}
 
@@ -473,9 +493,10 @@ namespace GaladHen
 			}
 			else
 			{
-				std::swap(mesh.Indices[i], mesh.Indices[j]);
+				// swap whole primitives, keeping the winding order of both
+				std::swap(mesh.Indices[i], mesh.Indices[j - 2]);
 				std::swap(mesh.Indices[i + 1], mesh.Indices[j - 1]);
-				std::swap(mesh.Indices[i + 2], mesh.Indices[j - 2]);
+				std::swap(mesh.Indices[i + 2], mesh.Indices[j]);
 
 				j -= primitive;
 			}
@@ -598,9 +619,10 @@ namespace GaladHen
 			}
 			else
 			{
-				std::swap(mesh.Indices[i], mesh.Indices[j]);
+				// swap whole primitives, keeping the winding order of both
+				std::swap(mesh.Indices[i], mesh.Indices[j - 2]);
 				std::swap(mesh.Indices[i + 1], mesh.Indices[j - 1]);
-				std::swap(mesh.Indices[i + 2], mesh.Indices[j - 2]);
+				std::swap(mesh.Indices[i + 2], mesh.Indices[j]);
 
 				j -= primitive;
 			}
@@ -664,7 +686,7 @@ namespace GaladHen
 			{
 				std::swap(model.Meshes[i], model.Meshes[j]);
 
-				++j;
+				--j;
 			}
 		}
 
@@ -728,9 +750,10 @@ namespace GaladHen
 			}
 			else
 			{
-				std::swap(mesh.Indices[i], mesh.Indices[j]);
+				// swap whole primitives, keeping the winding order of both
+				std::swap(mesh.Indices[i], mesh.Indices[j - 2]);
 				std::swap(mesh.Indices[i + 1], mesh.Indices[j - 1]);
-				std::swap(mesh.Indices[i + 2], mesh.Indices[j - 2]);
+				std::swap(mesh.Indices[i + 2], mesh.Indices[j]);
 
 				j -= primitive;
 			}
@@ -794,7 +817,7 @@ namespace GaladHen
 			{
 				std::swap(model.Meshes[i], model.Meshes[j]);
 
-				++j;
+				--j;
 			}
 		}
 
@@ -899,11 +922,11 @@ namespace GaladHen
 
 		float bestCost = std::numeric_limits<float>::max();
 
-		float boundMin = std::numeric_limits<float>::max();
-		float boundMax = std::numeric_limits<float>::min();
 		int primitive = (int)mesh.PrimitiveType + 1;
 		for (unsigned int a = 0; a < 3; ++a)
 		{
+			float boundMin = std::numeric_limits<float>::max();
+			float boundMax = std::numeric_limits<float>::lowest();
 			for (unsigned int i = node.LeftOrFirst; i < node.LeftOrFirst + node.IndexCount; i += primitive)
 			{
 				const glm::vec3& v0 = mesh.Vertices[mesh.Indices[i]].Position;
@@ -982,10 +1005,10 @@ namespace GaladHen
 
 		float bestCost = std::numeric_limits<float>::max();
 
-		float boundMin = std::numeric_limits<float>::max();
-		float boundMax = std::numeric_limits<float>::min();
 		for (unsigned int a = 0; a < 3; ++a)
 		{
+			float boundMin = std::numeric_limits<float>::max();
+			float boundMax = std::numeric_limits<float>::lowest();
 			for (unsigned int i = node.LeftOrFirst; i < node.LeftOrFirst + node.IndexCount; ++i)
 			{
 				glm::vec3 centroid = model.Meshes[i].BVH.GetRootNode().AABoundingBox.Center();
@@ -82,8 +82,10 @@ namespace GaladHen
 		RayModelHitInfo CheckModelIntersection(const Ray& ray, const Model& model, unsigned int nodeIndex, BVHTraversalMethod traversalMethod) const;
 
 		BVHNode& GetRootNode();
+		const BVHNode& GetRootNode() const;
 		
 		BVHNode& GetNode(unsigned int index);
+		const BVHNode& GetNode(unsigned int index) const;
 
 		unsigned int GetNodeNumber() const;
 
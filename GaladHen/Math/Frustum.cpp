@@ -0,0 +1,108 @@
+#include "Frustum.h"
+
+#include <Math/AABB/AABB.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define GH_FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace GaladHen
+{
+	Frustum::Frustum()
+	{
+		for (glm::vec4& plane : Planes)
+			plane = glm::vec4(0.0f);
+
+		PackPlanes();
+	}
+
+	Frustum::Frustum(const glm::mat4& viewProjection)
+	{
+		// rows of the matrix combined as in Gribb-Hartmann: a point is inside when -w <= x, y, z <= w in clip space
+		glm::mat4 transposed = glm::transpose(viewProjection);
+
+		Planes[0] = transposed[3] + transposed[0];
+		Planes[1] = transposed[3] - transposed[0];
+		Planes[2] = transposed[3] + transposed[1];
+		Planes[3] = transposed[3] - transposed[1];
+		Planes[4] = transposed[3] + transposed[2];
+		Planes[5] = transposed[3] - transposed[2];
+
+		// normalized, so that the plane distances are world distances
+		for (glm::vec4& plane : Planes)
+			plane /= glm::length(glm::vec3(plane));
+
+		PackPlanes();
+	}
+
+	bool Frustum::IntersectsAABB(const AABB& aabb) const
+	{
+		return ClassifyAABB(aabb) != FrustumTest::Outside;
+	}
+
+	FrustumTest Frustum::ClassifyAABB(const AABB& aabb) const
+	{
+		// the box is outside a plane if its center is farther behind it than the projection of the extents on the plane normal,
+		// and inside it if the center is farther in front of it
+		glm::vec3 center = (aabb.MinBound + aabb.MaxBound) * 0.5f;
+		glm::vec3 extents = (aabb.MaxBound - aabb.MinBound) * 0.5f;
+
+#ifdef GH_FRUSTUM_SSE
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		const __m128 centerX = _mm_set1_ps(center.x);
+		const __m128 centerY = _mm_set1_ps(center.y);
+		const __m128 centerZ = _mm_set1_ps(center.z);
+		const __m128 extentsX = _mm_set1_ps(extents.x);
+		const __m128 extentsY = _mm_set1_ps(extents.y);
+		const __m128 extentsZ = _mm_set1_ps(extents.z);
+
+		int crossed = 0;
+		for (unsigned int p = 0; p < GH_FRUSTUM_PACKED_PLANES; p += 4)
+		{
+			__m128 x = _mm_load_ps(PlanesX + p);
+			__m128 y = _mm_load_ps(PlanesY + p);
+			__m128 z = _mm_load_ps(PlanesZ + p);
+
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, centerX), _mm_mul_ps(y, centerY)), _mm_add_ps(_mm_mul_ps(z, centerZ), _mm_load_ps(PlanesW + p)));
+			__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, x), extentsX), _mm_mul_ps(_mm_andnot_ps(signMask, y), extentsY)), _mm_mul_ps(_mm_andnot_ps(signMask, z), extentsZ));
+
+			if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), zero)))
+				return FrustumTest::Outside;
+
+			crossed |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(distance, radius), zero));
+		}
+
+		return crossed ? FrustumTest::Intersecting : FrustumTest::Inside;
+#else
+		bool crossed = false;
+		for (const glm::vec4& plane : Planes)
+		{
+			float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+			float radius = glm::dot(glm::abs(glm::vec3(plane)), extents);
+
+			if (distance + radius < 0.0f)
+				return FrustumTest::Outside;
+
+			crossed |= distance - radius < 0.0f;
+		}
+
+		return crossed ? FrustumTest::Intersecting : FrustumTest::Inside;
+#endif
+	}
+
+	void Frustum::PackPlanes()
+	{
+		for (unsigned int p = 0; p < GH_FRUSTUM_PACKED_PLANES; ++p)
+		{
+			// padding planes have no normal and a positive distance: every point is in front of them
+			glm::vec4 plane = p < 6 ? Planes[p] : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+			PlanesX[p] = plane.x;
+			PlanesY[p] = plane.y;
+			PlanesZ[p] = plane.z;
+			PlanesW[p] = plane.w;
+		}
+	}
+}
@@ -0,0 +1,51 @@
+// View frustum, as the six planes bounding the volume seen by a camera
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#define GH_FRUSTUM_PACKED_PLANES 8 // planes tested four at a time: the last two are padding planes, containing everything
+
+namespace GaladHen
+{
+	struct AABB;
+
+	enum class FrustumTest
+	{
+		Outside,
+		Intersecting,
+		Inside
+	};
+
+	struct Frustum
+	{
+		Frustum();
+
+		// @brief
+		// Extract the planes from a view projection matrix (clip space depth from -1 to 1)
+		Frustum(const glm::mat4& viewProjection);
+
+		// @brief
+		// Check if an axis aligned bounding box is at least partially inside the frustum
+		// Boxes near the corners can pass the test while outside: the test is conservative
+		bool IntersectsAABB(const AABB& aabb) const;
+
+		// @brief
+		// Check if an axis aligned bounding box is outside, crossing or entirely inside the frustum
+		// Like IntersectsAABB(), boxes near the corners can be classified as intersecting while outside
+		FrustumTest ClassifyAABB(const AABB& aabb) const;
+
+		// Planes in the form (normal, distance) with normals pointing inside: left, right, bottom, top, near, far
+		glm::vec4 Planes[6];
+
+	protected:
+
+		void PackPlanes();
+
+		// Components of the planes stored by plane, so that four planes are tested at once
+		alignas(16) float PlanesX[GH_FRUSTUM_PACKED_PLANES];
+		alignas(16) float PlanesY[GH_FRUSTUM_PACKED_PLANES];
+		alignas(16) float PlanesZ[GH_FRUSTUM_PACKED_PLANES];
+		alignas(16) float PlanesW[GH_FRUSTUM_PACKED_PLANES];
+	};
+}
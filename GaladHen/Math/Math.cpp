@@ -83,6 +83,8 @@ namespace GaladHen
 
 			RayHitInfo info{};
 			info.HitDistance = std::numeric_limits<float>::max();
+
+			return info;
 		}
 
 		RayTriangleMeshHitInfo RayTriangleMeshIntersection(const Ray& ray, const Mesh& mesh, const BVH& bvh, BVHTraversalMethod traversalMethod)
@@ -93,9 +95,14 @@ namespace GaladHen
 		RayTriangleMeshHitInfo RayTriangleMeshIntersection(const Ray& ray, const Mesh& mesh, const BVH& bvh, const Transform& transform, BVHTraversalMethod traversalMethod)
 		{
 			// Transform world space ray into given transform space
-			Ray inverseRay = transform.Inverse() * ray;
+			float distanceScale;
+			Ray inverseRay = TransformRay(ray, glm::inverse(transform.ToMatrix()), distanceScale);
 
-			return bvh.CheckTriangleMeshIntersection(ray, mesh, traversalMethod);
+			RayTriangleMeshHitInfo hit = bvh.CheckTriangleMeshIntersection(inverseRay, mesh, traversalMethod);
+			if (hit.Hit())
+				hit.HitDistance /= distanceScale; // back to world space distance
+
+			return hit;
 		}
 
 		RayModelHitInfo RayModelIntersection(const Ray& ray, const Model& model, const BVH& bvh, BVHTraversalMethod traversalMethod)
@@ -106,9 +113,25 @@ namespace GaladHen
 		RayModelHitInfo RayModelIntersection(const Ray& ray, const Model& model, const BVH& bvh, const Transform& transform, BVHTraversalMethod traversalMethod)
 		{
 			// Transform world space ray into given transform space
-			Ray inverseRay = transform.Inverse() * ray;
+			float distanceScale;
+			Ray inverseRay = TransformRay(ray, glm::inverse(transform.ToMatrix()), distanceScale);
 
-			return bvh.CheckModelIntersection(ray, model, traversalMethod);
+			RayModelHitInfo hit = bvh.CheckModelIntersection(inverseRay, model, traversalMethod);
+			if (hit.Hit())
+				hit.HitDistance /= distanceScale; // back to world space distance
+
+			return hit;
+		}
+
+		Ray TransformRay(const Ray& ray, const glm::mat4& matrix, float& outDistanceScale)
+		{
+			glm::vec3 origin = glm::vec3(matrix * glm::vec4(ray.Origin, 1.0f));
+			glm::vec3 direction = glm::vec3(matrix * glm::vec4(ray.Direction, 0.0f));
+
+			// a non-uniform or non-unit scale changes the length of the direction: distances along the ray change accordingly
+			outDistanceScale = glm::length(direction);
+
+			return Ray{ origin, direction, ray.Length * outDistanceScale };
 		}
 
 		Ray operator*(const Transform transform, const Ray ray)
@@ -57,6 +57,14 @@ namespace GaladHen
 		// @returns intersection info
 		RayModelHitInfo RayModelIntersection(const Ray& ray, const Model& model, const BVH& bvh, const Transform& transform, BVHTraversalMethod traversalMethod);
 
+		// @brief
+		// Transform a ray by a generic affine matrix (ex: from world space to object space, using the inverse model matrix)
+		// @param ray: the ray to transform
+		// @param matrix: the affine transformation to apply
+		// @param[out] outDistanceScale: factor converting distances along the source ray into distances along the transformed ray
+		// @returns the transformed ray (with normalized direction)
+		Ray TransformRay(const Ray& ray, const glm::mat4& matrix, float& outDistanceScale);
+
 		Ray operator*(const Transform transform, const Ray ray);
 		Ray operator*(const Ray ray, const Transform transform);
 	}
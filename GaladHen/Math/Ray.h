@@ -53,12 +53,14 @@ namespace GaladHen
 			: VertexIndex0(0)
 			, VertexIndex1(0)
 			, VertexIndex2(0)
+			, TriangleIndex(0)
 		{}
 
 		// Indices of the vertices array of the mesh, representing the primitive hitted
 		unsigned int VertexIndex0;
 		unsigned int VertexIndex1;
 		unsigned int VertexIndex2;
+		unsigned int TriangleIndex; // position of the primitive inside the indices array of the mesh (first index = 3 * TriangleIndex)
 	};
 
 	struct RayModelHitInfo : RayTriangleMeshHitInfo
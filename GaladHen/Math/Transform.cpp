@@ -4,8 +4,13 @@
 #include <glm/ext/quaternion_trigonometric.hpp>
 #include <glm/ext/quaternion_float.hpp>
 
+#include <atomic>
+
 namespace GaladHen
 {
+    // Incremented at every modification of any transform, so that the versions are unique
+    static std::atomic<unsigned int> LastTransformVersion{ 0 };
+
     const glm::vec3 Transform::GlobalFront = glm::vec3(1.0f, 0.0f, 0.0f);
     const glm::vec3 Transform::GlobalUp = glm::vec3(0.0f, 1.0f, 0.0f);
     const glm::vec3 Transform::GlobalRight = glm::vec3(0.0f, 0.0f, 1.0f);
@@ -17,6 +22,7 @@ namespace GaladHen
         , Pitch(0.0f)
         , Yaw(0.0f)
         , Roll(0.0f)
+        , Version(0)
     {}
 
     void Transform::Rotate(float deltaPitch, float deltaYaw, float deltaRoll)
@@ -29,11 +35,13 @@ namespace GaladHen
     void Transform::RotateGlobal(const glm::quat& rotation)
     {
         Orientation = glm::normalize(rotation * Orientation);
+        Version = ++LastTransformVersion;
     }
 
     void Transform::RotateLocal(const glm::quat& rotation)
     {
         Orientation = glm::normalize(Orientation * rotation);
+        Version = ++LastTransformVersion;
     }
 
     void Transform::RotatePitch(float deltaPitch)
@@ -110,6 +118,7 @@ namespace GaladHen
     void Transform::SetPosition(const glm::vec3& position)
     {
         Position = position;
+        Version = ++LastTransformVersion;
     }
 
     void Transform::SetOrientation(const glm::quat& orientation)
@@ -117,6 +126,7 @@ namespace GaladHen
         Orientation = orientation;
 
         UpdateEulerAngles();
+        Version = ++LastTransformVersion;
     }
 
     void Transform::SetPitch(float angle)
@@ -143,21 +153,25 @@ namespace GaladHen
     void Transform::SetScale(const glm::vec3& scale)
     {
         Scale = scale;
+        Version = ++LastTransformVersion;
     }
 
     void Transform::ScaleX(float scaleX)
     {
         Scale.x = scaleX;
+        Version = ++LastTransformVersion;
     }
 
     void Transform::ScaleY(float scaleY)
     {
         Scale.y = scaleY;
+        Version = ++LastTransformVersion;
     }
 
     void Transform::ScaleZ(float scaleZ)
     {
         Scale.z = scaleZ;
+        Version = ++LastTransformVersion;
     }
 
     glm::vec3 Transform::GetScale() const
@@ -199,6 +213,11 @@ namespace GaladHen
         SetOrientation(rot);
     }
 
+    unsigned int Transform::GetVersion() const
+    {
+        return Version;
+    }
+
     // privates
     // TODO: add euler angles management when we have a rotation of 90 -> angles become inaccurate
     void Transform::UpdateEulerAngles()
@@ -87,6 +87,11 @@ namespace GaladHen
 
         void LookAt(const glm::vec3& position);
 
+        // @brief
+        // Get the version of the transform, changed by every modification
+        // Versions are unique among all the transforms, so a copy has the same version only if it has the same values
+        unsigned int GetVersion() const;
+
     protected:
 
         // @brief
@@ -101,5 +106,7 @@ namespace GaladHen
         float Pitch; // around X axis
         float Yaw; // around Y axis
         float Roll; // around Z axis
+
+        unsigned int Version;
     };
 }
@@ -0,0 +1,37 @@
+// Point lights assigned to the clusters of the view frustum: screen tiles by exponential depth slices (same layouts of LightClusterBufferData.h)
+layout (std140, binding = 6) uniform LightClusterData
+{
+	uniform uvec4 ClusterGridSize; // clusters along the screen x, the screen y and the view depth
+	uniform vec2 ClusterTileSize; // pixels of the screen tile of a cluster
+	uniform float ClusterDepthSliceScale; // depth slice = log(view depth) * scale + bias
+	uniform float ClusterDepthSliceBias;
+};
+
+struct LightCluster
+{
+	uint FirstLight;
+	uint LightNumber;
+};
+
+layout (std430, binding = 4) buffer ClusterLightGridBuffer
+{
+	LightCluster LightClusters[];
+};
+
+// Lists of the clusters one after the other, each of them indexing the point light buffer
+layout (std430, binding = 5) buffer ClusterLightIndexBuffer
+{
+	uint ClusterLightIndices[];
+};
+
+// @param fragCoord: window coords of the fragment (gl_FragCoord)
+// @param viewDepth: distance of the fragment from the camera along the view direction, selecting the depth slice
+// @returns the lights of the cluster of the fragment, starting at ClusterLightIndices[FirstLight]
+LightCluster GetLightCluster(vec2 fragCoord, float viewDepth)
+{
+	uvec2 tile = min(uvec2(fragCoord / ClusterTileSize), ClusterGridSize.xy - 1u);
+	float slice = log(max(viewDepth, 0.0001)) * ClusterDepthSliceScale + ClusterDepthSliceBias;
+	uint depthSlice = uint(clamp(slice, 0.0, float(ClusterGridSize.z - 1u)));
+
+	return LightClusters[tile.x + tile.y * ClusterGridSize.x + depthSlice * ClusterGridSize.x * ClusterGridSize.y];
+}
@@ -0,0 +1,42 @@
+// G-buffer of the deferred render path: the parameters of the PBR shading model, written by the materials and shaded once for each pixel
+// Attachments (same order of the render buffer created by the rendering system):
+// 0: diffuse color (RGBA8)
+// 1: world normal (RGBA16F)
+// 2: metallic, roughness (RGBA8)
+// World positions are reconstructed from the depth of the render buffer
+
+#ifdef GH_GBUFFER_PASS
+
+layout (location = 0) out vec4 GBufferDiffuseOut;
+layout (location = 1) out vec4 GBufferNormalOut;
+layout (location = 2) out vec4 GBufferMaterialOut;
+
+void WriteGBuffer(vec4 diffuseColor, vec3 wNormal, float metallic, float roughness)
+{
+	GBufferDiffuseOut = diffuseColor;
+	GBufferNormalOut = vec4(wNormal, 0.0);
+	GBufferMaterialOut = vec4(metallic, roughness, 0.0, 0.0);
+}
+
+#else
+
+uniform sampler2D GBufferDiffuse;
+uniform sampler2D GBufferNormal;
+uniform sampler2D GBufferMaterial;
+uniform sampler2D GBufferDepth;
+
+// @param pixel: window coords of the pixel, the g-buffer has the size of the window
+// @returns the depth of the pixel, 1.0 if nothing was drawn on it
+float ReadGBuffer(ivec2 pixel, out vec4 diffuseColor, out vec3 wNormal, out float metallic, out float roughness)
+{
+	diffuseColor = texelFetch(GBufferDiffuse, pixel, 0);
+	wNormal = texelFetch(GBufferNormal, pixel, 0).xyz; // as written by the material, the shading model gets the same normal of the forward path
+
+	vec2 material = texelFetch(GBufferMaterial, pixel, 0).xy;
+	metallic = material.x;
+	roughness = material.y;
+
+	return texelFetch(GBufferDepth, pixel, 0).r;
+}
+
+#endif
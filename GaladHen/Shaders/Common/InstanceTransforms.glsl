@@ -0,0 +1,26 @@
+// Transforms of the instances drawn by instanced draw calls
+// The instances of a draw call are stored one after the other, so a single buffer holds the instances of all the draw calls
+// Each instance gets its index inside the buffer as a per-instance attribute: direct draws read consecutive indices, indirect draws the indices of the visible instances only
+
+struct InstanceTransform
+{
+    mat4 ModelMatrix;
+    mat4 NormalMatrix;
+};
+
+layout(std430, binding = 3) buffer InstanceTransformBuffer
+{
+    InstanceTransform InstanceTransforms[];
+};
+
+layout (location = 6) in uint InstanceIndex; // GH_INSTANCE_INDEX_ATTRIBUTE_LOCATION
+
+mat4 GetInstanceModelMatrix()
+{
+    return InstanceTransforms[InstanceIndex].ModelMatrix;
+}
+
+mat4 GetInstanceNormalMatrix()
+{
+    return InstanceTransforms[InstanceIndex].NormalMatrix;
+}
@@ -0,0 +1,71 @@
+// Baked indirect diffuse lighting: grid of probes storing irradiance as L2 spherical harmonics (cosine convolution and 1/pi already applied)
+
+struct IrradianceProbe
+{
+	vec4 PackedCoefficients[7]; // 27 floats: rgb of each of the 9 coefficients, one after the other
+};
+
+layout(std140, binding = 2) buffer IrradianceProbeBuffer
+{
+	IrradianceProbe IrradianceProbes[];
+};
+
+layout(std140, binding = 3) uniform IrradianceVolumeData
+{
+	vec3 IrradianceVolumeMinBound;
+	int IrradianceVolumeEnabled;
+	vec3 IrradianceVolumeCellSize;
+	ivec3 IrradianceVolumeProbeCount;
+};
+
+vec3 ProbeCoefficient(int probeIndex, int coefficient)
+{
+	int first = coefficient * 3;
+	return vec3
+	(
+		IrradianceProbes[probeIndex].PackedCoefficients[first / 4][first % 4],
+		IrradianceProbes[probeIndex].PackedCoefficients[(first + 1) / 4][(first + 1) % 4],
+		IrradianceProbes[probeIndex].PackedCoefficients[(first + 2) / 4][(first + 2) % 4]
+	);
+}
+
+vec3 EvaluateIrradianceProbe(int probeIndex, vec3 n)
+{
+	vec3 irradiance = ProbeCoefficient(probeIndex, 0) * 0.282095;
+	irradiance += ProbeCoefficient(probeIndex, 1) * 0.488603 * n.y;
+	irradiance += ProbeCoefficient(probeIndex, 2) * 0.488603 * n.z;
+	irradiance += ProbeCoefficient(probeIndex, 3) * 0.488603 * n.x;
+	irradiance += ProbeCoefficient(probeIndex, 4) * 1.092548 * n.x * n.y;
+	irradiance += ProbeCoefficient(probeIndex, 5) * 1.092548 * n.y * n.z;
+	irradiance += ProbeCoefficient(probeIndex, 6) * 0.315392 * (3.0 * n.z * n.z - 1.0);
+	irradiance += ProbeCoefficient(probeIndex, 7) * 1.092548 * n.x * n.z;
+	irradiance += ProbeCoefficient(probeIndex, 8) * 0.546274 * (n.x * n.x - n.y * n.y);
+
+	return max(irradiance, vec3(0.0));
+}
+
+// Trilinear interpolation of the 8 probes around a world position
+// Returns irradiance divided by pi (i.e. multiply by the albedo to get the outgoing diffuse radiance)
+vec3 SampleIrradianceVolume(vec3 wPosition, vec3 wNormal)
+{
+	if (IrradianceVolumeEnabled == 0)
+		return vec3(0.0);
+
+	vec3 gridPosition = clamp((wPosition - IrradianceVolumeMinBound) / IrradianceVolumeCellSize, vec3(0.0), vec3(IrradianceVolumeProbeCount - 1));
+	ivec3 baseProbe = min(ivec3(gridPosition), IrradianceVolumeProbeCount - 2);
+	vec3 weights = gridPosition - vec3(baseProbe);
+	vec3 n = normalize(wNormal);
+
+	vec3 irradiance = vec3(0.0);
+	for (int i = 0; i < 8; ++i)
+	{
+		ivec3 offset = ivec3(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+		ivec3 probe = baseProbe + offset;
+		int probeIndex = probe.x + probe.y * IrradianceVolumeProbeCount.x + probe.z * IrradianceVolumeProbeCount.x * IrradianceVolumeProbeCount.y;
+
+		vec3 trilinear = mix(vec3(1.0) - weights, weights, vec3(offset));
+		irradiance += EvaluateIrradianceProbe(probeIndex, n) * trilinear.x * trilinear.y * trilinear.z;
+	}
+
+	return irradiance;
+}
@@ -0,0 +1,13 @@
+
+// Baked lighting: rgb = static direct lighting (shadows included), alpha = ambient occlusion
+
+uniform sampler2D BakedLightmap;
+uniform float AmbientIntensity = 0.2;
+
+vec4 BakedLighting(vec4 diffuseColor, vec2 lightmapUV)
+{
+    vec4 baked = texture(BakedLightmap, lightmapUV);
+    vec3 irradiance = baked.rgb + vec3(AmbientIntensity * baked.a);
+
+    return vec4(diffuseColor.rgb * irradiance, diffuseColor.a);
+}
@@ -1,19 +1,34 @@
 
-const float ShadowBias = 0.00005; // TODO: add dynamic shadow bias basing on angle between normal and lightdir
+#define MAX_SHADOW_CASCADES 4 // GH_MAX_SHADOW_CASCADES
 
-uniform sampler2D ShadowMap;
+// Cascades of the directional light shadow map, a layer of ShadowMap for each of them (same layout of ShadowCascadeBufferData.h)
+layout (std140, binding = 5) uniform ShadowCascadeData
+{
+	uniform mat4 CascadeMatrices[MAX_SHADOW_CASCADES];
+	uniform vec4 CascadeSplits; // view depth where each cascade ends
+	uniform vec4 CascadeBiases; // depth bias of each cascade, in its [0,1] depth range
+	uniform int CascadeNumber;
+};
+
+uniform sampler2DArray ShadowMap;
 
-float ShadowTest(vec4 lightSpaceFragPos)
+// @param viewDepth: distance of the fragment from the camera along the view direction, selecting the cascade
+float ShadowTest(vec3 worldPosition, float viewDepth)
 {
-	// Perspective division -> opengl do that automatically to gl_Position, we need to do that manually
-	// From clip space to NDC ([-1,1])
-	vec3 projectedLightSpaceFragPos = lightSpaceFragPos.xyz / lightSpaceFragPos.w;
+	// Cascades cover consecutive slices of the view: the first one ending after the fragment is the one with the most detail
+	int cascade = 0;
+	while (cascade < CascadeNumber && viewDepth > CascadeSplits[cascade])
+		++cascade;
+
+	// No shadows after the last cascade
+	if (cascade >= CascadeNumber)
+		return 0.0;
 
-	// We want to sample shadow map, which is inside [0,1] uv coords, so from NDC to [0,1]
-	projectedLightSpaceFragPos = projectedLightSpaceFragPos * 0.5 + 0.5;
+	// From world to the clip space of the cascade (orthographic: no perspective division), then from NDC ([-1,1]) to [0,1] uv coords
+	vec3 projectedLightSpaceFragPos = (CascadeMatrices[cascade] * vec4(worldPosition, 1.0)).xyz * 0.5 + 0.5;
 
 	// Sample shadow map and check its depth value (shadow caster depth) to fragment actual depth in light space (z component)
-	float shadowCasterDepth = texture(ShadowMap, projectedLightSpaceFragPos.xy).r;
+	float shadowCasterDepth = texture(ShadowMap, vec3(projectedLightSpaceFragPos.xy, float(cascade))).r;
 	float fragmentLightSpaceDepth = projectedLightSpaceFragPos.z;
 
 	if (fragmentLightSpaceDepth < 0.0 || fragmentLightSpaceDepth > 1.0)
@@ -22,5 +37,76 @@ float ShadowTest(vec4 lightSpaceFragPos)
 		return 0.0;
 	}
 
-	return fragmentLightSpaceDepth > shadowCasterDepth + ShadowBias ? 1.0 : 0.0;
+	return fragmentLightSpaceDepth > shadowCasterDepth + CascadeBiases[cascade] ? 1.0 : 0.0;
+}
+
+// Shadow of a point light, a tile of ShadowAtlas for each cube face: +x -x +y -y +z -z (same layout of ShadowAtlasBufferData.h)
+struct PointShadow
+{
+	mat4 FaceMatrices[6];
+	vec4 FaceRects[6]; // offset (xy) and size (zw) of each face in the atlas, size 0 while the face was never rendered
+	float Near;
+	float Far;
+	float BiasTexels;
+	float Padding;
+};
+
+layout(std140, binding = 6) buffer PointLightShadowBuffer
+{
+	PointShadow PointShadows[];
+};
+
+uniform sampler2D ShadowAtlas;
+
+// @param shadowIndex: of the light inside PointShadows
+float PointShadowTest(int shadowIndex, vec3 lightPosition, vec3 worldPosition, vec3 worldNormal)
+{
+	// The face is the one of the major axis of the direction from the light, its distance along that axis is the depth seen by the face
+	vec3 lightToFragment = worldPosition - lightPosition;
+	vec3 absLightToFragment = abs(lightToFragment);
+	int face;
+	int faceAxis;
+	float faceDepth;
+	if (absLightToFragment.x >= absLightToFragment.y && absLightToFragment.x >= absLightToFragment.z)
+	{
+		face = lightToFragment.x > 0.0 ? 0 : 1;
+		faceAxis = 0;
+		faceDepth = absLightToFragment.x;
+	}
+	else if (absLightToFragment.y >= absLightToFragment.z)
+	{
+		face = lightToFragment.y > 0.0 ? 2 : 3;
+		faceAxis = 1;
+		faceDepth = absLightToFragment.y;
+	}
+	else
+	{
+		face = lightToFragment.z > 0.0 ? 4 : 5;
+		faceAxis = 2;
+		faceDepth = absLightToFragment.z;
+	}
+
+	vec4 faceRect = PointShadows[shadowIndex].FaceRects[face];
+	if (faceRect.z <= 0.0)
+		return 0.0;
+
+	// The position moves along the normal by a texel (2 * depth / tile size at 90 degrees), so that surfaces at grazing angles don't shadow themselves
+	vec2 atlasSize = vec2(textureSize(ShadowAtlas, 0));
+	float tileTexels = faceRect.z * atlasSize.x;
+	vec3 offsetPosition = worldPosition + normalize(worldNormal) * (2.0 * faceDepth / tileTexels);
+	faceDepth = abs(offsetPosition[faceAxis] - lightPosition[faceAxis]);
+
+	// From the clip space of the face to the uv coords of its tile, kept half a texel inside it so that the tiles beside are never read
+	vec4 faceClipPosition = PointShadows[shadowIndex].FaceMatrices[face] * vec4(offsetPosition, 1.0);
+	vec2 faceUV = faceClipPosition.xy / faceClipPosition.w * 0.5 + 0.5;
+	vec2 tileTexel = clamp(faceUV * tileTexels, vec2(0.5), vec2(tileTexels - 0.5));
+	float shadowCasterDepth = texelFetch(ShadowAtlas, ivec2(faceRect.xy * atlasSize + tileTexel), 0).r;
+
+	// Depth back to the distance along the face axis, to compare it with the same bias in texels at any distance (a texel covers 2 * depth / tile size)
+	float nearDistance = PointShadows[shadowIndex].Near;
+	float farDistance = PointShadows[shadowIndex].Far;
+	float shadowCasterDistance = 2.0 * nearDistance * farDistance / (farDistance + nearDistance - (shadowCasterDepth * 2.0 - 1.0) * (farDistance - nearDistance));
+	float bias = PointShadows[shadowIndex].BiasTexels * 2.0 * faceDepth / tileTexels;
+
+	return faceDepth > shadowCasterDistance + bias ? 1.0 : 0.0;
 }
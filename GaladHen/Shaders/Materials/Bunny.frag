@@ -1,6 +1,13 @@
 
 #include "GaladHen/Shaders/ShadingModels/Pbr/Pbr.frag"
 
+// material parameters, packed by the renderer
+layout (std140, binding = 4) uniform MaterialData
+{
+    float Metallic;
+    float Roughness;
+};
+
 uniform sampler2D DiffuseTexture;
 vec4 ComputeDiffuseColor()
 {
@@ -16,13 +23,11 @@ vec3 ComputeNormal()
     return normalSample;
 }
 
-uniform float Metallic = 0.0;
 float ComputeMetallic()
 {
     return Metallic;
 }
 
-uniform float Roughness = 1.0;
 float ComputeRoughness()
 {
     return Roughness;
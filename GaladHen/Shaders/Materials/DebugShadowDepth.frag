@@ -1,11 +1,11 @@
 
 #include "GaladHen/Shaders/ShadingModels/Unlit/Unlit.frag"
 
-uniform sampler2D ShadowMap;
+uniform sampler2DArray ShadowMap; // first cascade only
 
 vec4 ComputeUnlitColor()
 {
-	float depthValue = texture(ShadowMap, vs_out.TexCoord).r;
+	float depthValue = texture(ShadowMap, vec3(vs_out.TexCoord, 0.0)).r;
 
 	return vec4(vec3(depthValue), 1.0);
 }
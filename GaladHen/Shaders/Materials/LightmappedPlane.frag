@@ -0,0 +1,16 @@
+
+#include "GaladHen/Shaders/ShadingModels/Unlit/Unlit.frag"
+
+// Lightmapping
+#include "GaladHen/Shaders/Common/Lightmapping.glsl"
+
+// material parameters, packed by the renderer
+layout (std140, binding = 4) uniform MaterialData
+{
+    vec4 DiffuseConstant;
+};
+
+vec4 ComputeUnlitColor()
+{
+	return BakedLighting(DiffuseConstant, vs_out.TexCoord);
+}
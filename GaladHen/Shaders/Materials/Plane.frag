@@ -1,7 +1,14 @@
 
 #include "GaladHen/Shaders/ShadingModels/Pbr/Pbr.frag"
 
-uniform vec4 DiffuseConstant = vec4(1.0);
+// material parameters, packed by the renderer
+layout (std140, binding = 4) uniform MaterialData
+{
+    vec4 DiffuseConstant;
+    float Metallic;
+    float Roughness;
+};
+
 vec4 ComputeDiffuseColor()
 {
 	return DiffuseConstant;
@@ -12,13 +19,11 @@ vec3 ComputeNormal()
 	return vs_out.SmoothWNormal;
 }
 
-uniform float Metallic = 0.0;
 float ComputeMetallic()
 {
     return Metallic;
 }
 
-uniform float Roughness = 1.0;
 float ComputeRoughness()
 {
     return Roughness;
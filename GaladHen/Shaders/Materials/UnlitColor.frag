@@ -1,7 +1,11 @@
 
 #include "GaladHen/Shaders/ShadingModels/Unlit/Unlit.frag"
 
-uniform vec4 ConstantColor = vec4(0.0);
+// material parameters, packed by the renderer
+layout (std140, binding = 4) uniform MaterialData
+{
+    vec4 ConstantColor;
+};
 
 vec4 ComputeUnlitColor()
 {
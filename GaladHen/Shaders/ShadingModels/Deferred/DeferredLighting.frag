@@ -0,0 +1,41 @@
+// Deferred lighting fragment shader: shades each pixel of the g-buffer once with the PBR shading model
+
+// outputs
+out vec4 color;
+
+// uniforms
+uniform mat4 InverseViewProjection;
+
+// G-buffer samplers
+#include "GaladHen/Shaders/Common/GBuffer.glsl"
+
+// Lights, BRDFs and shading model
+#include "GaladHen/Shaders/ShadingModels/Pbr/PbrLighting.glsl"
+
+void main()
+{
+    vec4 diffuse;
+    vec3 normal;
+    float metallic;
+    float roughness;
+    float depth = ReadGBuffer(ivec2(gl_FragCoord.xy), diffuse, normal, metallic, roughness);
+
+    // background
+    if (depth == 1.0)
+        discard;
+
+    // world position from the window coords and the depth
+    vec4 ndcPosition = vec4(gl_FragCoord.xy / vec2(textureSize(GBufferDepth, 0)), depth, 1.0) * 2.0 - 1.0;
+    vec4 wPosition = InverseViewProjection * ndcPosition;
+    wPosition /= wPosition.w;
+
+    vec3 viewDirection = normalize(WCameraPosition - wPosition.xyz);
+
+    // shading
+    vec4 shading = PhysicallyBasedShadingModel(wPosition.xyz, viewDirection, normal, diffuse, metallic, roughness);
+
+    // gamma correction
+    shading = GammaCorrection(shading);
+
+    color = vec4(shading);
+}
@@ -0,0 +1,8 @@
+// Deferred lighting vertex shader: a triangle covering the screen, already in clip coordinates
+
+layout (location = 0) in vec3 Position;
+
+void main()
+{
+    gl_Position = vec4(Position.xy, 0.0, 1.0);
+}
@@ -10,14 +10,14 @@ layout (std140, binding = 0) uniform CameraData
     uniform mat4 ProjectionMatrix;
     uniform vec3 WCameraPosition;
 };
-layout (std140, binding = 1) uniform TransformData
-{
-    uniform mat4 ModelMatrix;
-    uniform mat4 NormalMatrix;
-};
+
+// per-instance transforms
+#include "GaladHen/Shaders/Common/InstanceTransforms.glsl"
 
 void main()
 {
+    mat4 ModelMatrix = GetInstanceModelMatrix();
+
     // vertex position in view coordinates
     vec3 ViewPosition = (ViewMatrix * ModelMatrix * vec4(Position, 1.0)).xyz;
 
@@ -12,11 +12,9 @@ layout (std140, binding = 0) uniform CameraData
     uniform mat4 ProjectionMatrix;
     uniform vec3 WCameraPosition;
 };
-layout (std140, binding = 1) uniform TransformData
-{
-    uniform mat4 ModelMatrix;
-    uniform mat4 NormalMatrix;
-};
+
+// per-instance transforms
+#include "GaladHen/Shaders/Common/InstanceTransforms.glsl"
 
 // output
 out VS_OUT
@@ -25,8 +23,13 @@ out VS_OUT
     out vec4 VertexColor;
 } vs_out;
 
+// same position in the depth pre-pass and in the shading pass, compared with an equal depth test
+invariant gl_Position;
+
 void main()
 {
+    mat4 ModelMatrix = GetInstanceModelMatrix();
+
     // pass texture coordinates
     vs_out.TexCoord = UV;
     // pass vertex Color
@@ -14,11 +14,9 @@ layout (std140, binding = 0) uniform CameraData
     uniform mat4 ProjectionMatrix;
     uniform vec3 WCameraPosition;
 };
-layout (std140, binding = 1) uniform TransformData
-{
-    uniform mat4 ModelMatrix;
-    uniform mat4 NormalMatrix;
-};
+
+// per-instance transforms
+#include "GaladHen/Shaders/Common/InstanceTransforms.glsl"
 
 // output
 out VS_OUT
@@ -29,13 +27,16 @@ out VS_OUT
     out vec3 WViewDirection;
     out vec2 TexCoord;
     out mat3 TBN;
-    out vec4 LightSpaceFragPos;
 } vs_out;
 
-uniform mat4 LightSpaceMatrix;
+// same position in the depth pre-pass and in the shading pass, compared with an equal depth test
+invariant gl_Position;
 
 void main()
 {
+    mat4 ModelMatrix = GetInstanceModelMatrix();
+    mat4 NormalMatrix = GetInstanceNormalMatrix();
+
     // smooth and flat normals in world coordinates
     vec3 transNormal = (NormalMatrix * vec4(Normal, 1.0)).xyz;
     vs_out.SmoothWNormal = transNormal;
@@ -44,10 +45,10 @@ void main()
     // vertex position in view coordinates
     vec3 ViewPosition = (ViewMatrix * ModelMatrix * vec4(Position, 1.0)).xyz;
 
-    // point of view direction in world coords
-    vs_out.WViewDirection = normalize(WCameraPosition - Position);
     // vertex position in world coords
-    vs_out.WPosition = Position;
+    vs_out.WPosition = (ModelMatrix * vec4(Position, 1.0)).xyz;
+    // point of view direction in world coords
+    vs_out.WViewDirection = normalize(WCameraPosition - vs_out.WPosition);
 
     // pass texture coordinates
     vs_out.TexCoord = UV;
@@ -56,9 +57,6 @@ void main()
     vec3 adjTangent = normalize(Tangent - dot(Tangent, transNormal) * transNormal); // re-orthogonalize tangent with respect to normal to ensure tangents are orthogonal when calculated (possible smoothing)
     vs_out.TBN = mat3(adjTangent, normalize(cross(transNormal, adjTangent)), transNormal);
 
-    // transform vertex to light space
-    vs_out.LightSpaceFragPos = LightSpaceMatrix * ModelMatrix * vec4(Position, 1.0);
-
     // transformed vertex position
     gl_Position = ProjectionMatrix * vec4(ViewPosition, 1.0);
 }
@@ -64,6 +64,21 @@ namespace GaladHen
         return std::weak_ptr<Texture>{ uniqueTexture };
     }
 
+    std::weak_ptr<Texture> AssetSystem::CreateAndStoreTexture(unsigned char* data, unsigned int width, unsigned int height, TextureFormat textureFormat, const std::string& textureName)
+    {
+        if (Textures.find(textureName) != Textures.end())
+        {
+            Log::Warning("AssetSystem", "Tried to save a texture image with an already used name");
+            delete[] data;
+            return std::weak_ptr<Texture>{};
+        }
+
+        std::shared_ptr<Texture> uniqueTexture = std::shared_ptr<Texture>{ new Texture{ data, width, height, 0, textureFormat } };
+        Textures.emplace(textureName, uniqueTexture);
+
+        return std::weak_ptr<Texture>{ uniqueTexture };
+    }
+
     std::weak_ptr<ShaderPipeline> AssetSystem::LoadAndStoreShaderPipeline(const std::string& vShaderPath, const std::string& tContShaderPath, const std::string& tEvalShaderPath, const std::string& gShaderPath, const std::string& fShaderPath, const std::string& cShaderPath, const std::string& pipelineName)
     {
         if (ShaderPipelines.find(pipelineName) != ShaderPipelines.end())
@@ -38,6 +38,11 @@ namespace GaladHen
 		// Load a texture from a file and make it owned by asset system
 		std::weak_ptr<Texture> LoadAndStoreTexture(const std::string& texturePath, const std::string& textureName, TextureFormat textureFormat);
 
+		// @brief
+		// Create a texture from raw data (ex: baked data) and make it owned by asset system
+		// @param data: texture data, whose ownership passes to the texture
+		std::weak_ptr<Texture> CreateAndStoreTexture(unsigned char* data, unsigned int width, unsigned int height, TextureFormat textureFormat, const std::string& textureName);
+
 		// @brief
 		// Load a shader pipeline from a shader files and make it owned by asset system
 		std::weak_ptr<ShaderPipeline> LoadAndStoreShaderPipeline(
@@ -0,0 +1,283 @@
+#include "IrradianceVolume.h"
+#include "LightmapBaker.h"
+
+#include <Systems/RenderingSystem/Entities/Scene.h>
+#include <Systems/RenderingSystem/Entities/Model.h>
+#include <Math/Math.h>
+#include <Math/Ray.h>
+#include <Utils/Log.h>
+
+#include <thread>
+#include <atomic>
+#include <limits>
+
+#include <glm/gtc/constants.hpp>
+
+#define GH_IRRADIANCE_PROBES_PER_JOB 4
+#define GH_IRRADIANCE_SHADOW_RAY_LENGTH 1000.0f
+#define GH_IRRADIANCE_MAX_RAY_LENGTH 1000.0f
+
+namespace GaladHen
+{
+	// Incremented at every bake of any volume, so that the bake versions are unique
+	static std::atomic<unsigned int> LastBakeVersion{ 0 };
+
+	// Same generator of the lightmap baker (xorshift32), one per probe to keep the bake deterministic
+	static float NextRandom(unsigned int& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return (state & 0x00FFFFFF) / (float)0x01000000;
+	}
+
+	static glm::vec3 UniformSphereDirection(unsigned int& randomState)
+	{
+		float z = 1.0f - 2.0f * NextRandom(randomState);
+		float phi = 2.0f * glm::pi<float>() * NextRandom(randomState);
+		float radius = glm::sqrt(glm::max(0.0f, 1.0f - z * z));
+		return glm::vec3(radius * glm::cos(phi), radius * glm::sin(phi), z);
+	}
+
+	// Real spherical harmonics basis up to the second band
+	static void SHBasis(const glm::vec3& d, float outBasis[9])
+	{
+		outBasis[0] = 0.282095f;
+		outBasis[1] = 0.488603f * d.y;
+		outBasis[2] = 0.488603f * d.z;
+		outBasis[3] = 0.488603f * d.x;
+		outBasis[4] = 1.092548f * d.x * d.y;
+		outBasis[5] = 1.092548f * d.y * d.z;
+		outBasis[6] = 0.315392f * (3.0f * d.z * d.z - 1.0f);
+		outBasis[7] = 1.092548f * d.x * d.z;
+		outBasis[8] = 0.546274f * (d.x * d.x - d.y * d.y);
+	}
+
+	IrradianceVolumeSettings::IrradianceVolumeSettings()
+		: ProbeCount(glm::uvec3(8, 4, 8))
+		, BoundsPadding(0.5f)
+		, RaysPerProbe(256)
+		, RayBias(0.001f)
+		, SkyColor(glm::vec3(0.3f, 0.35f, 0.4f))
+		, DefaultAlbedo(glm::vec3(0.5f))
+		, NumberOfThreads(0)
+	{}
+
+	IrradianceVolume::IrradianceVolume()
+		: MinBound(glm::vec3(0.0f))
+		, CellSize(glm::vec3(0.0f))
+		, ProbeCount(glm::uvec3(0))
+		, BakeVersion(0)
+	{}
+
+	void IrradianceVolume::Bake(const Scene& scene)
+	{
+		std::vector<BakeInstance> instances;
+		LightmapBaker::BuildBakeInstances(scene, instances);
+
+		if (instances.empty())
+		{
+			Log::Warning("IrradianceVolume", "No geometry to bake the irradiance volume against");
+			Clear();
+			return;
+		}
+
+		// Probes grid over the scene bounds
+		AABB sceneBounds;
+		sceneBounds.MinBound = glm::vec3(std::numeric_limits<float>::max());
+		sceneBounds.MaxBound = glm::vec3(std::numeric_limits<float>::lowest());
+		for (const BakeInstance& instance : instances)
+		{
+			sceneBounds.BoundPoint(instance.WorldBounds.MinBound);
+			sceneBounds.BoundPoint(instance.WorldBounds.MaxBound);
+		}
+
+		ProbeCount = glm::max(Settings.ProbeCount, glm::uvec3(2));
+		MinBound = sceneBounds.MinBound - glm::vec3(Settings.BoundsPadding);
+		glm::vec3 maxBound = sceneBounds.MaxBound + glm::vec3(Settings.BoundsPadding);
+		CellSize = (maxBound - MinBound) / glm::vec3(ProbeCount - glm::uvec3(1));
+
+		// Albedo of each mesh of each instance, taken once from the materials
+		std::vector<std::vector<glm::vec3>> albedos;
+		albedos.resize(instances.size());
+		for (unsigned int i = 0; i < instances.size(); ++i)
+		{
+			const std::vector<Mesh>& meshes = instances[i].InstanceModel->Meshes;
+			albedos[i].resize(meshes.size(), Settings.DefaultAlbedo);
+
+			for (unsigned int m = 0; m < meshes.size(); ++m)
+			{
+				std::shared_ptr<Material> material = instances[i].InstanceObject->GetMaterial(m).lock();
+				if (!material)
+					continue;
+
+				std::unordered_map<ShaderParameterName, glm::vec4>::const_iterator diffuse = material->Vec4Data.find("DiffuseConstant");
+				if (diffuse != material->Vec4Data.end())
+					albedos[i][m] = glm::vec3(diffuse->second);
+			}
+		}
+
+		// Light directions are the same for all the hit points
+		std::vector<glm::vec3> toLightDirections;
+		std::vector<glm::vec3> lightRadiances;
+		for (const DirectionalLight& light : scene.DirectionalLights)
+		{
+			toLightDirections.push_back(-glm::normalize(light.GetLightDirection()));
+			lightRadiances.push_back(glm::vec3(light.Color) * light.Intensity);
+		}
+
+		const unsigned int probesNumber = ProbeCount.x * ProbeCount.y * ProbeCount.z;
+		Probes.clear();
+		Probes.resize(probesNumber);
+
+		// Multi-threaded bake: each worker takes a few probes at a time
+		std::atomic<unsigned int> nextProbe{ 0 };
+		const IrradianceVolumeSettings settings = Settings;
+		const unsigned int raysPerProbe = glm::max(settings.RaysPerProbe, 1u);
+
+		auto worker = [&]()
+		{
+			while (true)
+			{
+				unsigned int first = nextProbe.fetch_add(GH_IRRADIANCE_PROBES_PER_JOB);
+				if (first >= probesNumber)
+					break;
+
+				unsigned int last = glm::min(first + GH_IRRADIANCE_PROBES_PER_JOB, probesNumber);
+				for (unsigned int p = first; p < last; ++p)
+				{
+					glm::uvec3 coords = glm::uvec3(p % ProbeCount.x, (p / ProbeCount.x) % ProbeCount.y, p / (ProbeCount.x * ProbeCount.y));
+					glm::vec3 probePosition = MinBound + glm::vec3(coords) * CellSize;
+
+					glm::vec3 radianceSH[9];
+					for (unsigned int c = 0; c < 9; ++c)
+						radianceSH[c] = glm::vec3(0.0f);
+
+					unsigned int randomState = p * 7919u + 104729u;
+					for (unsigned int r = 0; r < raysPerProbe; ++r)
+					{
+						Ray ray{ probePosition, UniformSphereDirection(randomState), GH_IRRADIANCE_MAX_RAY_LENGTH };
+
+						// Radiance coming from the ray direction: sky, or direct lighting reflected by the first surface hit (single bounce)
+						glm::vec3 radiance = settings.SkyColor;
+
+						unsigned int instanceIndex, meshIndex;
+						RayTriangleMeshHitInfo hit;
+						float hitDistance = LightmapBaker::ClosestHit(ray, instances, instanceIndex, meshIndex, hit);
+						if (hitDistance >= 0.0f)
+						{
+							const BakeInstance& instance = instances[instanceIndex];
+							const std::vector<MeshVertexData>& vertices = instance.InstanceModel->Meshes[meshIndex].GetVertices();
+
+							glm::vec3 v0 = glm::vec3(instance.ObjectToWorld * glm::vec4(vertices[hit.VertexIndex0].Position, 1.0f));
+							glm::vec3 v1 = glm::vec3(instance.ObjectToWorld * glm::vec4(vertices[hit.VertexIndex1].Position, 1.0f));
+							glm::vec3 v2 = glm::vec3(instance.ObjectToWorld * glm::vec4(vertices[hit.VertexIndex2].Position, 1.0f));
+
+							// geometric normal, facing the probe
+							glm::vec3 normal = glm::cross(v1 - v0, v2 - v0);
+							float normalLength = glm::length(normal);
+							normal = normalLength > 0.0f ? normal / normalLength : -ray.Direction;
+							if (glm::dot(normal, ray.Direction) > 0.0f)
+								normal = -normal;
+
+							glm::vec3 hitPosition = ray.Origin + ray.Direction * hitDistance + normal * settings.RayBias;
+
+							glm::vec3 irradiance = glm::vec3(0.0f);
+							for (unsigned int l = 0; l < toLightDirections.size(); ++l)
+							{
+								float NdotL = glm::dot(normal, toLightDirections[l]);
+								if (NdotL <= 0.0f)
+									continue;
+
+								Ray shadowRay{ hitPosition, toLightDirections[l], GH_IRRADIANCE_SHADOW_RAY_LENGTH };
+								if (!LightmapBaker::IsOccluded(shadowRay, instances))
+									irradiance += lightRadiances[l] * NdotL;
+							}
+
+							// lambertian surface
+							radiance = albedos[instanceIndex][meshIndex] * irradiance / glm::pi<float>();
+						}
+
+						float basis[9];
+						SHBasis(ray.Direction, basis);
+						for (unsigned int c = 0; c < 9; ++c)
+							radianceSH[c] += radiance * basis[c];
+					}
+
+					// Monte Carlo weight of uniform sphere sampling, then convolution with the cosine lobe (divided by pi)
+					const float weight = 4.0f * glm::pi<float>() / raysPerProbe;
+					const float bandFactors[3] = { 1.0f, 2.0f / 3.0f, 1.0f / 4.0f };
+
+					IrradianceProbe& probe = Probes[p];
+					for (unsigned int c = 0; c < 9; ++c)
+					{
+						unsigned int band = c == 0 ? 0 : (c < 4 ? 1 : 2);
+						probe.Coefficients[c] = radianceSH[c] * weight * bandFactors[band];
+					}
+				}
+			}
+		};
+
+		unsigned int numberOfThreads = Settings.NumberOfThreads > 0 ? Settings.NumberOfThreads : std::thread::hardware_concurrency();
+		numberOfThreads = glm::max(numberOfThreads, 1u);
+
+		std::vector<std::thread> threads;
+		for (unsigned int i = 1; i < numberOfThreads; ++i)
+			threads.emplace_back(worker);
+		worker(); // calling thread works too
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		BakeVersion = ++LastBakeVersion;
+	}
+
+	void IrradianceVolume::Clear()
+	{
+		Probes.clear();
+		ProbeCount = glm::uvec3(0);
+		BakeVersion = ++LastBakeVersion;
+	}
+
+	bool IrradianceVolume::IsBaked() const
+	{
+		return !Probes.empty();
+	}
+
+	unsigned int IrradianceVolume::GetBakeVersion() const
+	{
+		return BakeVersion;
+	}
+
+	const std::vector<IrradianceProbe>& IrradianceVolume::GetProbes() const
+	{
+		return Probes;
+	}
+
+	glm::vec3 IrradianceVolume::GetMinBound() const
+	{
+		return MinBound;
+	}
+
+	glm::vec3 IrradianceVolume::GetCellSize() const
+	{
+		return CellSize;
+	}
+
+	glm::uvec3 IrradianceVolume::GetProbeCount() const
+	{
+		return ProbeCount;
+	}
+
+	glm::vec3 IrradianceVolume::EvaluateProbe(const IrradianceProbe& probe, const glm::vec3& direction)
+	{
+		float basis[9];
+		SHBasis(direction, basis);
+
+		glm::vec3 result = glm::vec3(0.0f);
+		for (unsigned int c = 0; c < 9; ++c)
+			result += probe.Coefficients[c] * basis[c];
+
+		return glm::max(result, glm::vec3(0.0f));
+	}
+}
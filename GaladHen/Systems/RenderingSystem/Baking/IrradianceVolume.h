@@ -0,0 +1,83 @@
+// Grid of irradiance probes baked offline, using the BVHs of the scene meshes for ray casting
+// Each probe stores the irradiance around it as second order (L2) spherical harmonics, which is evaluated in the shaders for indirect diffuse lighting
+
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace GaladHen
+{
+	class Scene;
+
+	struct IrradianceVolumeSettings
+	{
+		IrradianceVolumeSettings();
+
+		glm::uvec3 ProbeCount; // Number of probes along each axis (at least 2 per axis)
+		float BoundsPadding; // Extra space around the scene bounds (in world units)
+		unsigned int RaysPerProbe;
+		float RayBias; // Offset of the secondary rays from the hit surface, to avoid self intersections
+		glm::vec3 SkyColor; // Radiance of the rays that do not hit anything
+		glm::vec3 DefaultAlbedo; // Albedo of the surfaces whose material has no DiffuseConstant
+		unsigned int NumberOfThreads; // 0 = use all the available hardware threads
+	};
+
+	// Irradiance of a probe as L2 spherical harmonics (9 coefficients per color channel)
+	// The cosine lobe convolution is already applied, so evaluating the harmonics along a normal gives the irradiance divided by pi
+	struct IrradianceProbe
+	{
+		glm::vec3 Coefficients[9];
+	};
+
+	class IrradianceVolume
+	{
+	public:
+
+		IrradianceVolume();
+
+		// @brief
+		// Place the probes over the bounds of the scene and bake them
+		// The BVHs of all the meshes in the scene must be already built
+		// @param scene: the scene casting rays against
+		void Bake(const Scene& scene);
+
+		// @brief
+		// Remove all the baked probes
+		void Clear();
+
+		bool IsBaked() const;
+
+		// @brief
+		// Unique number identifying the last bake, useful to know when the probes need to be uploaded again
+		// @returns the bake version, 0 if the volume was never baked
+		unsigned int GetBakeVersion() const;
+
+		const std::vector<IrradianceProbe>& GetProbes() const;
+
+		glm::vec3 GetMinBound() const;
+
+		// @returns the distance between two adjacent probes along each axis
+		glm::vec3 GetCellSize() const;
+
+		glm::uvec3 GetProbeCount() const;
+
+		// @brief
+		// Evaluate the irradiance stored in a probe along a direction
+		// @param direction: normalized world space direction
+		// @returns irradiance divided by pi
+		static glm::vec3 EvaluateProbe(const IrradianceProbe& probe, const glm::vec3& direction);
+
+		IrradianceVolumeSettings Settings;
+
+	protected:
+
+		std::vector<IrradianceProbe> Probes;
+		glm::vec3 MinBound;
+		glm::vec3 CellSize;
+		glm::uvec3 ProbeCount;
+		unsigned int BakeVersion;
+
+	};
+}
@@ -0,0 +1,381 @@
+#include "LightmapBaker.h"
+
+#include <Systems/RenderingSystem/Entities/Scene.h>
+#include <Systems/RenderingSystem/Entities/Model.h>
+#include <Math/Math.h>
+#include <Math/Ray.h>
+#include <Utils/Log.h>
+
+#include <thread>
+#include <atomic>
+#include <limits>
+
+#include <glm/gtc/constants.hpp>
+
+#define GH_LIGHTMAP_TEXELS_PER_JOB 64
+#define GH_LIGHTMAP_SHADOW_RAY_LENGTH 1000.0f
+
+namespace GaladHen
+{
+	// Small and fast pseudo random generator (xorshift32), one per texel to keep the bake deterministic
+	static float NextRandom(unsigned int& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return (state & 0x00FFFFFF) / (float)0x01000000;
+	}
+
+	static glm::vec3 CosineWeightedHemisphereDirection(const glm::vec3& normal, unsigned int& randomState)
+	{
+		float r1 = NextRandom(randomState);
+		float r2 = NextRandom(randomState);
+
+		float phi = 2.0f * glm::pi<float>() * r1;
+		float radius = glm::sqrt(r2);
+		glm::vec3 local = glm::vec3(radius * glm::cos(phi), radius * glm::sin(phi), glm::sqrt(glm::max(0.0f, 1.0f - r2)));
+
+		// orthonormal basis around the normal
+		glm::vec3 helper = glm::abs(normal.x) > 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+		glm::vec3 tangent = glm::normalize(glm::cross(helper, normal));
+		glm::vec3 bitangent = glm::cross(normal, tangent);
+
+		return tangent * local.x + bitangent * local.y + normal * local.z;
+	}
+
+	LightmapBakeSettings::LightmapBakeSettings()
+		: Width(256)
+		, Height(256)
+		, AOSamples(32)
+		, AODistance(2.0f)
+		, RayBias(0.001f)
+		, DilationPasses(2)
+		, NumberOfThreads(0)
+	{}
+
+	LightmapBaker::LightmapBaker()
+	{}
+
+	unsigned char* LightmapBaker::Bake(const Scene& scene, unsigned int sceneObjectIndex, unsigned int meshIndex)
+	{
+		if (sceneObjectIndex >= scene.SceneObjects.size())
+		{
+			Log::Error("LightmapBaker", "Scene object index out of range");
+			return nullptr;
+		}
+
+		const SceneObject& sceneObject = scene.SceneObjects[sceneObjectIndex];
+		std::shared_ptr<Model> model = sceneObject.GetSceneObjectModel().lock();
+		if (!model || meshIndex >= model->Meshes.size())
+		{
+			Log::Error("LightmapBaker", "Invalid model or mesh index for the scene object to bake");
+			return nullptr;
+		}
+
+		if (model->Meshes[meshIndex].GetPrimitive() != MeshPrimitive::Triangle)
+		{
+			Log::Error("LightmapBaker", "Only triangle meshes can be baked");
+			return nullptr;
+		}
+
+		std::vector<BakeInstance> instances;
+		BuildBakeInstances(scene, instances);
+
+		// Collect texels covered by the mesh
+		std::vector<LightmapTexel> texels;
+		std::vector<bool> coverage;
+		RasterizeTexels(*model, meshIndex, sceneObject.Transform.ToMatrix(), texels, coverage);
+
+		if (texels.empty())
+		{
+			Log::Warning("LightmapBaker", "The mesh to bake does not cover any texel: check its uv coordinates");
+		}
+
+		// Light directions are the same for all the texels
+		std::vector<glm::vec3> toLightDirections;
+		std::vector<glm::vec3> lightRadiances;
+		for (const DirectionalLight& light : scene.DirectionalLights)
+		{
+			toLightDirections.push_back(-glm::normalize(light.GetLightDirection()));
+			lightRadiances.push_back(glm::vec3(light.Color) * light.Intensity);
+		}
+
+		std::vector<glm::vec4> results;
+		results.resize(Settings.Width * Settings.Height, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+
+		// Multi-threaded bake: each worker takes a small batch of texels at a time
+		std::atomic<unsigned int> nextTexel{ 0 };
+		const LightmapBakeSettings settings = Settings;
+
+		auto worker = [&]()
+		{
+			while (true)
+			{
+				unsigned int first = nextTexel.fetch_add(GH_LIGHTMAP_TEXELS_PER_JOB);
+				if (first >= texels.size())
+					break;
+
+				unsigned int last = glm::min(first + GH_LIGHTMAP_TEXELS_PER_JOB, (unsigned int)texels.size());
+				for (unsigned int t = first; t < last; ++t)
+				{
+					const LightmapTexel& texel = texels[t];
+					glm::vec3 origin = texel.WPosition + texel.WNormal * settings.RayBias;
+
+					// ambient occlusion
+					unsigned int randomState = texel.TexelIndex * 9781u + 6271u;
+					unsigned int occludedRays = 0;
+					for (unsigned int s = 0; s < settings.AOSamples; ++s)
+					{
+						Ray aoRay{ origin, CosineWeightedHemisphereDirection(texel.WNormal, randomState), settings.AODistance };
+						if (IsOccluded(aoRay, instances))
+							++occludedRays;
+					}
+					float ao = settings.AOSamples > 0 ? 1.0f - (float)occludedRays / settings.AOSamples : 1.0f;
+
+					// direct lighting
+					glm::vec3 direct = glm::vec3(0.0f);
+					for (unsigned int l = 0; l < toLightDirections.size(); ++l)
+					{
+						float NdotL = glm::dot(texel.WNormal, toLightDirections[l]);
+						if (NdotL <= 0.0f)
+							continue;
+
+						Ray shadowRay{ origin, toLightDirections[l], GH_LIGHTMAP_SHADOW_RAY_LENGTH };
+						if (!IsOccluded(shadowRay, instances))
+							direct += lightRadiances[l] * NdotL;
+					}
+
+					results[texel.TexelIndex] = glm::vec4(direct, ao);
+				}
+			}
+		};
+
+		unsigned int numberOfThreads = Settings.NumberOfThreads > 0 ? Settings.NumberOfThreads : std::thread::hardware_concurrency();
+		numberOfThreads = glm::max(numberOfThreads, 1u);
+
+		std::vector<std::thread> threads;
+		for (unsigned int i = 1; i < numberOfThreads; ++i)
+			threads.emplace_back(worker);
+		worker(); // calling thread works too
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		Dilate(results, coverage);
+
+		// Quantize to RGBA8
+		unsigned char* data = new unsigned char[Settings.Width * Settings.Height * 4];
+		for (unsigned int i = 0; i < results.size(); ++i)
+		{
+			glm::vec4 value = glm::clamp(results[i], 0.0f, 1.0f);
+			data[i * 4] = (unsigned char)(value.r * 255.0f + 0.5f);
+			data[i * 4 + 1] = (unsigned char)(value.g * 255.0f + 0.5f);
+			data[i * 4 + 2] = (unsigned char)(value.b * 255.0f + 0.5f);
+			data[i * 4 + 3] = (unsigned char)(value.a * 255.0f + 0.5f);
+		}
+
+		return data;
+	}
+
+	void LightmapBaker::BuildBakeInstances(const Scene& scene, std::vector<BakeInstance>& outInstances)
+	{
+		outInstances.clear();
+		outInstances.reserve(scene.SceneObjects.size());
+
+		for (const SceneObject& sceneObject : scene.SceneObjects)
+		{
+			std::shared_ptr<Model> model = sceneObject.GetSceneObjectModel().lock();
+			if (!model)
+				continue;
+
+			BakeInstance instance;
+			instance.InstanceObject = &sceneObject;
+			instance.InstanceModel = model.get(); // models are owned by the asset system and outlive the bake
+			instance.ObjectToWorld = sceneObject.Transform.ToMatrix();
+			instance.WorldToObject = glm::inverse(instance.ObjectToWorld);
+			instance.WorldBounds.MinBound = glm::vec3(std::numeric_limits<float>::max());
+			instance.WorldBounds.MaxBound = glm::vec3(std::numeric_limits<float>::lowest());
+
+			bool hasGeometry = false;
+			for (const Mesh& mesh : model->Meshes)
+			{
+				if (mesh.BVH.GetNodeNumber() == 0)
+				{
+					Log::Warning("LightmapBaker", "Found a mesh without BVH: it will be ignored by ray casting");
+					continue;
+				}
+
+				// world space bounds of the mesh, from the 8 corners of its object space aabb
+				const AABB& bounds = mesh.BVH.GetRootNode().AABoundingBox;
+				for (unsigned int c = 0; c < 8; ++c)
+				{
+					glm::vec3 corner
+					{
+						(c & 1) ? bounds.MaxBound.x : bounds.MinBound.x,
+						(c & 2) ? bounds.MaxBound.y : bounds.MinBound.y,
+						(c & 4) ? bounds.MaxBound.z : bounds.MinBound.z
+					};
+					instance.WorldBounds.BoundPoint(glm::vec3(instance.ObjectToWorld * glm::vec4(corner, 1.0f)));
+				}
+
+				hasGeometry = true;
+			}
+
+			if (hasGeometry)
+				outInstances.push_back(instance);
+		}
+	}
+
+	bool LightmapBaker::IsOccluded(const Ray& ray, const std::vector<BakeInstance>& instances)
+	{
+		unsigned int instanceIndex, meshIndex;
+		RayTriangleMeshHitInfo hit;
+		float hitDistance = ClosestHit(ray, instances, instanceIndex, meshIndex, hit);
+		return hitDistance >= 0.0f && hitDistance < ray.Length;
+	}
+
+	float LightmapBaker::ClosestHit(const Ray& ray, const std::vector<BakeInstance>& instances, unsigned int& outInstanceIndex, unsigned int& outMeshIndex, RayTriangleMeshHitInfo& outHit)
+	{
+		float closest = std::numeric_limits<float>::max();
+
+		for (unsigned int i = 0; i < instances.size(); ++i)
+		{
+			const BakeInstance& instance = instances[i];
+
+			if (!Math::RayAABBIntersection(ray, instance.WorldBounds).Hit())
+				continue;
+
+			// intersect in object space, so the mesh bvh can be reused whatever the transform is
+			Ray worldRay = ray;
+			worldRay.Length = glm::min(ray.Length, closest);
+			float distanceScale;
+			Ray objectRay = Math::TransformRay(worldRay, instance.WorldToObject, distanceScale);
+
+			const std::vector<Mesh>& meshes = instance.InstanceModel->Meshes;
+			for (unsigned int m = 0; m < meshes.size(); ++m)
+			{
+				if (meshes[m].BVH.GetNodeNumber() == 0)
+					continue;
+
+				RayTriangleMeshHitInfo hit = meshes[m].BVH.CheckTriangleMeshIntersection(objectRay, meshes[m], BVHTraversalMethod::FrontToBack);
+				if (!hit.Hit())
+					continue;
+
+				float worldDistance = hit.HitDistance / distanceScale;
+				if (worldDistance < closest)
+				{
+					closest = worldDistance;
+					objectRay.Length = hit.HitDistance;
+					outInstanceIndex = i;
+					outMeshIndex = m;
+					outHit = hit;
+				}
+			}
+		}
+
+		return closest < std::numeric_limits<float>::max() ? closest : -1.0f;
+	}
+
+	void LightmapBaker::RasterizeTexels(const Model& model, unsigned int meshIndex, const glm::mat4& objectToWorld, std::vector<LightmapTexel>& outTexels, std::vector<bool>& outCoverage) const
+	{
+		const Mesh& mesh = model.Meshes[meshIndex];
+		const std::vector<MeshVertexData>& vertices = mesh.GetVertices();
+		const std::vector<unsigned int>& indices = mesh.GetIndices();
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(objectToWorld)));
+
+		outCoverage.assign(Settings.Width * Settings.Height, false);
+		outTexels.clear();
+
+		glm::vec2 size = glm::vec2(Settings.Width, Settings.Height);
+
+		for (unsigned int i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const MeshVertexData& v0 = vertices[indices[i]];
+			const MeshVertexData& v1 = vertices[indices[i + 1]];
+			const MeshVertexData& v2 = vertices[indices[i + 2]];
+
+			// triangle in texel space
+			glm::vec2 p0 = v0.UV * size;
+			glm::vec2 p1 = v1.UV * size;
+			glm::vec2 p2 = v2.UV * size;
+
+			float area = (p1.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p1.y - p0.y);
+			if (glm::abs(area) < Math::Epsilon)
+				continue; // degenerate in uv space
+
+			glm::vec2 minP = glm::max(glm::floor(glm::min(p0, glm::min(p1, p2))), glm::vec2(0.0f));
+			glm::vec2 maxP = glm::min(glm::ceil(glm::max(p0, glm::max(p1, p2))), size - 1.0f);
+
+			for (int y = (int)minP.y; y <= (int)maxP.y; ++y)
+			{
+				for (int x = (int)minP.x; x <= (int)maxP.x; ++x)
+				{
+					unsigned int texelIndex = y * Settings.Width + x;
+					if (outCoverage[texelIndex])
+						continue;
+
+					// barycentric coordinates of the texel center
+					glm::vec2 p = glm::vec2(x + 0.5f, y + 0.5f);
+					float w0 = ((p1.x - p.x) * (p2.y - p.y) - (p2.x - p.x) * (p1.y - p.y)) / area;
+					float w1 = ((p2.x - p.x) * (p0.y - p.y) - (p0.x - p.x) * (p2.y - p.y)) / area;
+					float w2 = 1.0f - w0 - w1;
+					if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+						continue;
+
+					LightmapTexel texel;
+					glm::vec3 position = v0.Position * w0 + v1.Position * w1 + v2.Position * w2;
+					glm::vec3 normal = v0.Normal * w0 + v1.Normal * w1 + v2.Normal * w2;
+					texel.WPosition = glm::vec3(objectToWorld * glm::vec4(position, 1.0f));
+					texel.WNormal = glm::normalize(normalMatrix * normal);
+					texel.TexelIndex = texelIndex;
+
+					outTexels.push_back(texel);
+					outCoverage[texelIndex] = true;
+				}
+			}
+		}
+	}
+
+	void LightmapBaker::Dilate(std::vector<glm::vec4>& texels, std::vector<bool>& coverage) const
+	{
+		const int width = Settings.Width;
+		const int height = Settings.Height;
+
+		for (unsigned int pass = 0; pass < Settings.DilationPasses; ++pass)
+		{
+			std::vector<bool> newCoverage = coverage;
+
+			for (int y = 0; y < height; ++y)
+			{
+				for (int x = 0; x < width; ++x)
+				{
+					if (coverage[y * width + x])
+						continue;
+
+					glm::vec4 sum = glm::vec4(0.0f);
+					unsigned int count = 0;
+					for (int dy = -1; dy <= 1; ++dy)
+					{
+						for (int dx = -1; dx <= 1; ++dx)
+						{
+							int nx = x + dx, ny = y + dy;
+							if (nx < 0 || ny < 0 || nx >= width || ny >= height || !coverage[ny * width + nx])
+								continue;
+
+							sum += texels[ny * width + nx];
+							++count;
+						}
+					}
+
+					if (count > 0)
+					{
+						texels[y * width + x] = sum / (float)count;
+						newCoverage[y * width + x] = true;
+					}
+				}
+			}
+
+			coverage = newCoverage;
+		}
+	}
+}
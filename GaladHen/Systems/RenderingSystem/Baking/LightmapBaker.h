@@ -0,0 +1,94 @@
+// Offline baker of ambient occlusion and static direct lighting into a lightmap texture, using the BVHs of the scene meshes for ray casting
+// The lightmap is laid out on the first uv channel of the baked mesh, so the mesh needs a non-overlapping uv unwrap
+
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <Math/AABB/AABB.h>
+
+namespace GaladHen
+{
+	class Scene;
+	class SceneObject;
+	class Model;
+	struct Ray;
+	struct RayTriangleMeshHitInfo;
+
+	struct LightmapBakeSettings
+	{
+		LightmapBakeSettings();
+
+		unsigned int Width;
+		unsigned int Height;
+		unsigned int AOSamples; // Number of hemisphere rays per texel
+		float AODistance; // Maximum distance of an occluder (in world units)
+		float RayBias; // Offset along the surface normal to avoid self intersections
+		unsigned int DilationPasses; // Number of passes used to fill texels outside the uv islands, to avoid seams when sampling
+		unsigned int NumberOfThreads; // 0 = use all the available hardware threads
+	};
+
+	// A scene object prepared for ray casting in world space
+	struct BakeInstance
+	{
+		const SceneObject* InstanceObject;
+		const Model* InstanceModel;
+		glm::mat4 ObjectToWorld;
+		glm::mat4 WorldToObject;
+		AABB WorldBounds;
+	};
+
+	class LightmapBaker
+	{
+	public:
+
+		LightmapBaker();
+
+		// @brief
+		// Bake ambient occlusion and direct lighting of the directional lights for a scene object
+		// The BVHs of all the meshes in the scene must be already built
+		// @param scene: the scene casting rays against
+		// @param sceneObjectIndex: the index of the scene object to bake
+		// @param meshIndex: the index of the mesh (inside the scene object model) to bake
+		// @returns RGBA8 texture data (rgb = direct lighting, alpha = ambient occlusion), owned by the caller; nullptr if baking failed
+		unsigned char* Bake(const Scene& scene, unsigned int sceneObjectIndex, unsigned int meshIndex);
+
+		// @brief
+		// Prepare scene objects for ray casting in world space (bounds and matrices are calculated once)
+		static void BuildBakeInstances(const Scene& scene, std::vector<BakeInstance>& outInstances);
+
+		// @brief
+		// Check if a world space ray hits any of the instances before its length
+		static bool IsOccluded(const Ray& ray, const std::vector<BakeInstance>& instances);
+
+		// @brief
+		// Find the closest hit of a world space ray against the instances
+		// @param[out] outInstanceIndex: the index of the instance hit
+		// @param[out] outMeshIndex: the index of the mesh hit inside the instance model
+		// @param[out] outHit: the hit primitive info, in the object space of the instance
+		// @returns the hit distance, or a negative value if nothing was hit
+		static float ClosestHit(const Ray& ray, const std::vector<BakeInstance>& instances, unsigned int& outInstanceIndex, unsigned int& outMeshIndex, RayTriangleMeshHitInfo& outHit);
+
+		LightmapBakeSettings Settings;
+
+	protected:
+
+		struct LightmapTexel
+		{
+			glm::vec3 WPosition;
+			glm::vec3 WNormal;
+			unsigned int TexelIndex;
+		};
+
+		// @brief
+		// Rasterize the mesh triangles in uv space, collecting world position and normal for each covered texel
+		void RasterizeTexels(const Model& model, unsigned int meshIndex, const glm::mat4& objectToWorld, std::vector<LightmapTexel>& outTexels, std::vector<bool>& outCoverage) const;
+
+		// @brief
+		// Fill uncovered texels with the average of their covered neighbours
+		void Dilate(std::vector<glm::vec4>& texels, std::vector<bool>& coverage) const;
+
+	};
+}
@@ -7,29 +7,145 @@
 #include <string>
 
 #include <Systems/RenderingSystem/Entities/Material.h>
+#include <Utils/LinearArena.h>
+#include <Utils/Log.h>
+
+#define GH_MAX_COMMAND_BUFFER_BINDINGS 16 // the scene pass binds 12 buffers
+#define GH_MAX_COMMAND_RENDER_BUFFER_BINDINGS 4
+#define GH_MAX_COMMAND_MAT4_BINDINGS 4
+#define GH_MAX_COMMAND_IMAGE_BINDINGS 4
 
 namespace GaladHen
 {
 	class RenderBuffer;
+	class Texture;
+	enum class TextureAccessType;
 
+	// Built on a LinearArena it does not allocate from the heap (ex: commands built every frame on the frame arena)
 	template <class T>
-	class CommandBuffer : public std::vector<T>
+	class CommandBuffer : public std::vector<T, ArenaAllocator<T>>
 	{
 	public:
 
+		CommandBuffer()
+		{}
+
+		explicit CommandBuffer(LinearArena& arena)
+			: std::vector<T, ArenaAllocator<T>>(ArenaAllocator<T>(arena))
+		{}
+
+	};
+
+	// Named values stored inside a command, in a fixed number of slots so that commands stay plain data
+	template <class T, unsigned int Capacity>
+	struct CommandBindings
+	{
+		unsigned int Number;
+		unsigned int NameIDs[Capacity]; // ShaderParameterName ids
+		T Values[Capacity];
+
+		// @returns false if all the slots are used: the binding is dropped and an error is logged
+		bool Add(const ShaderParameterName& name, T value)
+		{
+			if (Number >= Capacity)
+			{
+				Log::Error("CommandBuffer", "Too many bindings in a command, " + name.GetName() + " is not bound");
+				return false;
+			}
 
+			NameIDs[Number] = name.GetID();
+			Values[Number] = value;
+			++Number;
+
+			return true;
+		}
+	};
+
+	// Draws whose arguments are written in gpu buffers (ex: by a culling compute shader), submitted with a single multi draw call
+	// Buffers are read at the moment of the draw, after the commands issued before it; the instance indices of the command are read from the base instance of each draw
+	struct IndirectDrawData
+	{
+		IBuffer* Arguments; // DrawCommandBufferData of the draws, nullptr for a direct draw
+		unsigned int FirstArguments; // index of the first draw arguments inside Arguments
+		unsigned int MaxDraws;
+		IBuffer* Count; // number of draws actually submitted, at most MaxDraws
+		size_t CountOffset; // in bytes
+	};
+
+	// A color attachment of a render buffer, sampled by a shader
+	struct RenderBufferAttachment
+	{
+		RenderBuffer* RenderBuffer;
+		unsigned int Attachment; // index of the color attachment
 	};
 
 	// A RenderCommand targets resource ids: must be already transferred into gpu, or the RenderCommand will fail
+	// It is plain data, value initialize it (RenderCommand command{}) to start with empty bindings
 	struct RenderCommand
 	{
 		unsigned int DataSourceID;
-		// unsigned int InstanceCount; TODO: instanced rendering
+		unsigned int InstanceCount; // Number of instances drawn with a single draw call
+		unsigned int FirstInstance; // Offset of the first instance inside the per-instance buffers, or inside InstanceIndices if given
+		IBuffer* InstanceIndices; // Indices of the drawn instances inside the per-instance buffers (ex: the visible ones), nullptr to draw consecutive instances
 		unsigned int ShaderSourceID;
 		Material* Material;
-		std::unordered_map<std::string, glm::mat4> AdditionalMat4Data; // Temp, consider using a MaterialData struct, such that can be used here in a variable named AdditionalMaterialData
-		std::unordered_map<std::string, IBuffer*> AdditionalBufferData; // Like buffers managed by renderer (camera data, transform data, ...)
-		std::unordered_map<std::string, RenderBuffer*> AdditionalRenderBufferData; // Like render buffers managed by renderer (shadow maps, ...)
+		CommandBindings<const glm::mat4*, GH_MAX_COMMAND_MAT4_BINDINGS> AdditionalMat4Data; // Values must live until the command is drawn
+		CommandBindings<IBuffer*, GH_MAX_COMMAND_BUFFER_BINDINGS> AdditionalBufferData; // Like buffers managed by renderer (camera data, transform data, ...)
+		CommandBindings<RenderBuffer*, GH_MAX_COMMAND_RENDER_BUFFER_BINDINGS> AdditionalRenderBufferData; // Like render buffers managed by renderer (shadow maps, ...)
+		CommandBindings<RenderBufferAttachment, GH_MAX_COMMAND_RENDER_BUFFER_BINDINGS> AdditionalAttachmentData; // Color attachments of render buffers (ex: the g-buffer)
+		IndirectDrawData Indirect; // DataSourceID only gives the primitive type of the indirect draws, their meshes must share it
+		unsigned int OcclusionQueryID; // query counting the samples of the draw that pass the depth test, 0 for none
+	};
+
+	// Memory written by shaders is visible to the following commands only after a barrier on the way they read it
+	// Values can be combined (ex: MemoryBarrierType::ShaderStorage | MemoryBarrierType::Command)
+	enum class MemoryBarrierType : unsigned int
+	{
+		None = 0,
+		ShaderStorage = 1 << 0, // shader storage buffers read by shaders
+		Uniform = 1 << 1, // buffers read as uniform buffers
+		VertexAttribute = 1 << 2, // buffers read as vertex or per-instance attributes
+		Index = 1 << 3, // buffers read as index buffers
+		Command = 1 << 4, // buffers read as indirect draw and dispatch arguments, or as draw counts
+		BufferUpdate = 1 << 5, // buffers read or written by the cpu (ex: ReadBuffer)
+		TextureFetch = 1 << 6, // textures sampled by shaders
+		ShaderImage = 1 << 7, // images loaded or stored by shaders
+		Framebuffer = 1 << 8, // textures rendered to or read as render targets
+		All = 0xFFFFFFFF
+	};
+
+	inline MemoryBarrierType operator|(MemoryBarrierType a, MemoryBarrierType b)
+	{
+		return (MemoryBarrierType)((unsigned int)a | (unsigned int)b);
+	}
+
+	inline bool HasMemoryBarrier(MemoryBarrierType barriers, MemoryBarrierType barrier)
+	{
+		return ((unsigned int)barriers & (unsigned int)barrier) != 0;
+	}
+
+	// A texture level loaded or stored by a compute shader, either a texture or the color of a render buffer
+	// The format of the texture must support image load and store (srgb formats don't)
+	struct ComputeImageData
+	{
+		Texture* Texture; // nullptr to use RenderBuffer
+		RenderBuffer* RenderBuffer;
+		unsigned int Level; // mipmap level
+		TextureAccessType Access;
+	};
+
+	// A ComputeCommand targets resource ids: the compute pipeline and the buffers must be already transferred into gpu
+	// It is plain data, value initialize it (ComputeCommand command{}) to start with empty bindings and no barrier
+	struct ComputeCommand
+	{
+		unsigned int ShaderSourceID;
+		glm::uvec3 GroupCount; // Number of work groups dispatched along each dimension, ignored by indirect dispatches
+		IBuffer* IndirectArguments; // DispatchCommandBufferData written by the gpu (ex: the number of work groups needed by a previous dispatch), nullptr for a direct dispatch
+		size_t IndirectOffset; // in bytes
+		CommandBindings<IBuffer*, GH_MAX_COMMAND_BUFFER_BINDINGS> AdditionalBufferData; // Buffers read or written by the compute shader
+		CommandBindings<RenderBuffer*, GH_MAX_COMMAND_RENDER_BUFFER_BINDINGS> AdditionalRenderBufferData; // Depth of render buffers, sampled by the compute shader
+		CommandBindings<ComputeImageData, GH_MAX_COMMAND_IMAGE_BINDINGS> AdditionalImageData; // Images loaded or stored by the compute shader
+		MemoryBarrierType Barriers; // Issued after the dispatch, for the ways the commands after it read its results
 	};
 
 	enum class MemoryTargetType
@@ -10,6 +10,9 @@
 #define GH_GLSL_VERSION_MAJOR 4
 #define GH_GLSL_VERSION_MINOR 5
 
+#define GH_INSTANCE_INDEX_ATTRIBUTE_LOCATION 6 // per-instance vertex attribute, must match the location declared in InstanceTransforms.glsl
+#define GH_MATERIAL_BLOCK_NAME "MaterialData" // uniform block holding the value parameters of a material, packed by the renderer
+
 namespace GaladHen
 {
     enum class API
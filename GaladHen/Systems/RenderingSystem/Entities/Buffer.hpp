@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <memory>
+#include <algorithm>
 
 #include "IGPUResource.h"
 
@@ -23,7 +24,8 @@ namespace GaladHen
 	enum class BufferAccessType
 	{
 		StaticRead,
-		StaticWrite
+		StaticWrite,
+		StreamWrite // rewritten by the cpu at every frame it is used: the renderer places it in per-frame memory, so it must be loaded again before each use in a new frame
 	};
 
 	class IBuffer : public IGPUResource
@@ -82,30 +84,30 @@ namespace GaladHen
 		}
 
 		FixedBuffer(const FixedBuffer& source)
+			: IBuffer(source.Type, source.AccessType)
 		{
-			Type = source.Type;
-			AccessType = source.AccessType;
-			Data = source.Data;
+			AllocationType = BufferAllocationType::Fixed;
+			std::copy(source.Data, source.Data + ItemNumber, Data);
 		}
 		FixedBuffer& operator=(FixedBuffer& source)
 		{
 			Type = source.Type;
 			AccessType = source.AccessType;
-			Data = source.Data;
+			std::copy(source.Data, source.Data + ItemNumber, Data);
 
 			return *this;
 		}
 		FixedBuffer(FixedBuffer&& source) noexcept
+			: IBuffer(source.Type, source.AccessType)
 		{
-			Type = source.Type;
-			AccessType = source.AccessType;
-			Data = source.Data;
+			AllocationType = BufferAllocationType::Fixed;
+			std::copy(source.Data, source.Data + ItemNumber, Data);
 		}
 		FixedBuffer& operator=(FixedBuffer&& source) noexcept
 		{
 			Type = source.Type;
 			AccessType = source.AccessType;
-			Data = source.Data;
+			std::copy(source.Data, source.Data + ItemNumber, Data);
 
 			return *this;
 		}
@@ -144,9 +146,9 @@ namespace GaladHen
 		}
 
 		DynamicBuffer(const DynamicBuffer& source)
+			: IBuffer(source.Type, source.AccessType)
 		{
-			Type = source.Type;
-			AccessType = source.AccessType;
+			AllocationType = BufferAllocationType::Dynamic;
 			Data = source.Data;
 		}
 		DynamicBuffer& operator=(DynamicBuffer& source)
@@ -158,9 +160,9 @@ namespace GaladHen
 			return *this;
 		}
 		DynamicBuffer(DynamicBuffer&& source) noexcept
+			: IBuffer(source.Type, source.AccessType)
 		{
-			Type = source.Type;
-			AccessType = source.AccessType;
+			AllocationType = BufferAllocationType::Dynamic;
 			Data = source.Data;
 		}
 		DynamicBuffer& operator=(DynamicBuffer&& source) noexcept
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#define GH_CULLING_NO_GROUP 0xFFFFFFFFu // group of the batches culled but not drawn, must match the culling shaders
+
+namespace GaladHen
+{
+	// World bounds of an instance, in the same order of the instance transforms
+	struct InstanceBoundsBufferData
+	{
+		glm::vec3 MinBound; // 12 byte
+		unsigned int DrawIndex; // 4 byte, index of the instance batch in the draw buffer
+		glm::vec3 MaxBound; // 12 byte
+		float Padding; // 4 byte padding for structure alignment at multiple of vec4 size
+	};
+
+	// An instance batch to cull: its visible instances are counted by the culling shader
+	struct CullingDrawBufferData
+	{
+		unsigned int IndexCount; // 4 byte
+		unsigned int FirstIndex; // 4 byte
+		int BaseVertex; // 4 byte
+		unsigned int FirstInstance; // 4 byte, first slot of the batch in the visible instance buffer
+		unsigned int Group; // 4 byte, multi draw receiving the draw command of the batch (GH_CULLING_NO_GROUP if not drawn)
+		unsigned int VisibleInstances; // 4 byte, zero before culling
+		glm::uvec2 Padding; // 8 byte padding for structure alignment at multiple of vec4 size
+	};
+
+	// Batches drawn by the same multi draw call: their commands are written from FirstCommand on
+	struct CullingGroupBufferData
+	{
+		unsigned int FirstCommand; // 4 byte
+		unsigned int DrawCount; // 4 byte, zero before culling: read as draw count by the multi draw
+	};
+
+	struct CullingBufferData
+	{
+		glm::vec4 FrustumPlanes[6]; // 96 byte
+		glm::vec3 ViewPosition; // 12 byte
+		float ScreenScale; // 4 byte, cotangent of half the vertical field of view
+		unsigned int InstanceNumber; // 4 byte
+		unsigned int DrawNumber; // 4 byte
+		float MinScreenSize; // 4 byte, fraction of the viewport height (0 to keep all the instances inside the frustum)
+		float Padding; // 4 byte padding for structure alignment at multiple of vec4 size
+	};
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+namespace GaladHen
+{
+	// Arguments of an indexed draw written by the gpu, laid out as the api expects them
+	struct DrawCommandBufferData
+	{
+		unsigned int IndexCount; // 4 byte
+		unsigned int InstanceCount; // 4 byte
+		unsigned int FirstIndex; // 4 byte
+		int BaseVertex; // 4 byte
+		unsigned int BaseInstance; // 4 byte
+	};
+
+	// Arguments of a dispatch written by the gpu, laid out as the api expects them
+	struct DispatchCommandBufferData
+	{
+		unsigned int GroupCountX; // 4 byte
+		unsigned int GroupCountY; // 4 byte
+		unsigned int GroupCountZ; // 4 byte
+	};
+}
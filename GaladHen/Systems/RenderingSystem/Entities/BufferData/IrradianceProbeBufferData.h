@@ -0,0 +1,21 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace GaladHen
+{
+	struct IrradianceProbeBufferData
+	{
+		glm::vec4 PackedCoefficients[7]; // 112 byte: the 27 floats of the L2 spherical harmonics (rgb for each of the 9 coefficients) packed one after the other, last float unused
+	};
+
+	struct IrradianceVolumeBufferData
+	{
+		glm::vec3 MinBound; // 12 byte
+		int Enabled; // 4 byte
+		glm::vec3 CellSize; // 12 byte
+		float Padding0; // 4 byte
+		glm::ivec3 ProbeCount; // 12 byte
+		float Padding1; // 4 byte padding for vec3 alignment at 16 byte (std140)
+	};
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace GaladHen
+{
+	// Layout of the clusters the view frustum is divided in, to find the cluster of a fragment
+	struct LightClusterBufferData
+	{
+		glm::uvec4 GridSize; // 16 byte, clusters along the screen x, the screen y and the view depth (w unused)
+		glm::vec2 TileSize; // 8 byte, pixels of the screen tile of a cluster
+		float DepthSliceScale; // 4 byte, depth slice of a view depth d = log(d) * scale + bias
+		float DepthSliceBias; // 4 byte
+	};
+
+	// Point lights of a cluster, stored contiguously in the light index buffer
+	struct LightClusterGridBufferData
+	{
+		unsigned int FirstLight; // 4 byte, position of the first index of the cluster inside the light index buffer
+		unsigned int LightNumber; // 4 byte
+	};
+}
@@ -12,7 +12,8 @@ namespace GaladHen
 		float Intensity; // 8 byte
 		float BulbSize; // 8 byte
 		float Radius; // 8 byte
-		glm::vec2 Padding; // 16 byte padding for structure alignment at multiple of biggest member size (Color, 32 byte)
+		int ShadowIndex; // 8 byte, of the light shadow in the shadow atlas buffer, -1 without shadow
+		float Padding; // 4 byte padding for structure alignment at multiple of biggest member size (Color, 32 byte)
 		// TODO: padding could be different basing on low level api, implement a mechanism to calculate final size and alignment needed basing on api (with reflection?)
 	};
 }
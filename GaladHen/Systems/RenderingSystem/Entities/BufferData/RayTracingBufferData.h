@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace GaladHen
+{
+	// Flattened BVH node of a mesh: children are at LeftOrFirst and LeftOrFirst + 1 for inner nodes, leaves reference TriangleCount triangles starting from LeftOrFirst
+	// Indices are global, so the nodes and the triangles of all the meshes live in the same buffers
+	struct BVHNodeBufferData
+	{
+		glm::vec3 MinBound; // 12 byte
+		unsigned int LeftOrFirst; // 4 byte
+		glm::vec3 MaxBound; // 12 byte
+		unsigned int TriangleCount; // 4 byte (0 for inner nodes)
+	};
+
+	struct TriangleBufferData
+	{
+		glm::vec4 Vertex0; // 16 byte (w unused)
+		glm::vec4 Vertex1; // 16 byte (w unused)
+		glm::vec4 Vertex2; // 16 byte (w unused)
+	};
+
+	// A mesh placed in the scene
+	struct RayInstanceBufferData
+	{
+		glm::mat4 WorldToObject; // 64 byte
+		glm::vec3 WorldMinBound; // 12 byte
+		unsigned int RootNode; // 4 byte
+		glm::vec3 WorldMaxBound; // 12 byte
+		unsigned int FirstTriangle; // 4 byte
+	};
+
+	struct RayBufferData
+	{
+		glm::vec3 Origin; // 12 byte
+		float Length; // 4 byte
+		glm::vec3 Direction; // 12 byte
+		float Padding; // 4 byte padding for structure alignment at multiple of vec4 size
+	};
+
+	struct RayHitBufferData
+	{
+		float HitDistance; // 4 byte
+		int InstanceIndex; // 4 byte (-1 if nothing was hit)
+		unsigned int TriangleIndex; // 4 byte, relative to the first triangle of the instance mesh
+		unsigned int Overflow; // 4 byte (1 if the traversal stack was too small for the BVH depth)
+		glm::vec2 Barycentrics; // 8 byte (weights of the second and third vertex)
+		glm::vec2 Padding1; // 8 byte padding for structure alignment at multiple of vec4 size
+	};
+}
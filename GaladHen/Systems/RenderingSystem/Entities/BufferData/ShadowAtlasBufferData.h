@@ -0,0 +1,19 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#define GH_POINT_SHADOW_FACES 6 // cube faces of a point light shadow, +x -x +y -y +z -z
+
+namespace GaladHen
+{
+	// Shadow of a point light, a tile of the shadow atlas for each cube face (same layout of ShadowMapping.glsl)
+	struct PointShadowBufferData
+	{
+		glm::mat4 FaceMatrices[GH_POINT_SHADOW_FACES]; // 384 byte, from world space to the clip space of each face
+		glm::vec4 FaceRects[GH_POINT_SHADOW_FACES]; // 96 byte, offset (xy) and size (zw) of each face in the atlas uv coords, size 0 while the face was never rendered
+		float Near; // 4 byte, of the face projections
+		float Far; // 4 byte
+		float BiasTexels; // 4 byte, depth bias in texels of the face
+		float Padding; // 4 byte padding for structure alignment at multiple of vec4 size
+	};
+}
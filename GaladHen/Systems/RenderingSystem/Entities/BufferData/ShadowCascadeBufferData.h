@@ -0,0 +1,18 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#define GH_MAX_SHADOW_CASCADES 4 // must match ShadowMapping.glsl
+
+namespace GaladHen
+{
+	// Cascades of the directional light shadow map, stored as layers of the same texture array
+	struct ShadowCascadeBufferData
+	{
+		glm::mat4 CascadeMatrices[GH_MAX_SHADOW_CASCADES]; // 256 byte, from world space to the clip space of each cascade
+		glm::vec4 CascadeSplits; // 16 byte, view depth where each cascade ends
+		glm::vec4 CascadeBiases; // 16 byte, depth bias of each cascade, covering the same world distance in all of them
+		int CascadeNumber; // 4 byte
+		glm::vec3 Padding; // 12 byte padding for structure alignment at multiple of vec4 size
+	};
+}
@@ -1,6 +1,8 @@
 
 #include "Camera.h"
 
+#include <Math/Ray.h>
+
 #include <glm/gtx/transform.hpp> // for lookat() and perspective()
 #include <glm/gtx/quaternion.hpp>
 #include <glm/ext/quaternion_trigonometric.hpp>
@@ -66,26 +68,40 @@ namespace GaladHen
         return ProjectionMatrix;
     }
 
-    float Camera::GetFovY()
+    float Camera::GetFovY() const
     {
         return FovY;
     }
 
-    float Camera::GetAspectRatio()
+    float Camera::GetAspectRatio() const
     {
         return AspectRatio;
     }
 
-    float Camera::GetNear()
+    float Camera::GetNear() const
     {
         return Near;
     }
 
-    float Camera::GetFar()
+    float Camera::GetFar() const
     {
         return Far;
     }
 
+    Ray Camera::ViewportPointToRay(const glm::vec2& viewportPoint) const
+    {
+        // from viewport to NDC, then back to world space on near and far planes
+        glm::vec2 ndc = viewportPoint * 2.0f - 1.0f;
+        glm::mat4 inverseViewProjection = glm::inverse(ProjectionMatrix * GetViewMatrix());
+
+        glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc, -1.0f, 1.0f);
+        glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+        glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+        glm::vec3 end = glm::vec3(farPoint) / farPoint.w;
+
+        return Ray{ origin, end - origin, glm::length(end - origin) };
+    }
+
     void Camera::UpdateProjectionMatrix()
     {
         ProjectionMatrix = glm::perspective(glm::radians(FovY), AspectRatio, Near, Far);
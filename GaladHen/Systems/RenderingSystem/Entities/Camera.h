@@ -11,6 +11,8 @@
 
 namespace GaladHen
 {
+    struct Ray;
+
     class Camera
     {
     public:
@@ -33,10 +35,16 @@ namespace GaladHen
         glm::mat4 GetViewMatrix() const; // the transform is used to calculate the view matrix
         glm::mat4 GetProjectionMatrix() const;
 
-        float GetFovY();
-        float GetAspectRatio();
-        float GetNear();
-        float GetFar();
+        float GetFovY() const;
+        float GetAspectRatio() const;
+        float GetNear() const;
+        float GetFar() const;
+
+        // @brief
+        // Build the world space ray starting from the near plane and passing through a point of the viewport
+        // @param viewportPoint: point in normalized viewport coordinates ([0,1] range, origin at the bottom left corner)
+        // @returns a ray long up to the far plane
+        Ray ViewportPointToRay(const glm::vec2& viewportPoint) const;
 
         Transform Transform;
 
@@ -3,24 +3,107 @@
 #include "ShaderPipeline.h"
 
 #include <utility>
+#include <atomic>
 
 namespace GaladHen
 {
+	// Incremented at every material creation, so that material ids are unique
+	static std::atomic<unsigned int> LastMaterialID{ 0 };
+
+	// Incremented at every modification of any material, so that the versions are unique
+	static std::atomic<unsigned int> LastMaterialVersion{ 0 };
+
 	Material::Material()
 		: Pipeline(std::weak_ptr<ShaderPipeline>{})
+		, MaterialID(++LastMaterialID)
+		, Version(++LastMaterialVersion)
 	{}
 
 	Material::Material(std::weak_ptr<ShaderPipeline> pipeline)
 		: Pipeline(pipeline)
+		, MaterialID(++LastMaterialID)
+		, Version(++LastMaterialVersion)
 	{}
 
+	unsigned int Material::GetMaterialID() const
+	{
+		return MaterialID;
+	}
+
 	void Material::SetPipeline(std::weak_ptr<ShaderPipeline> pipeline)
 	{
 		Pipeline = pipeline;
+
+		// the layout of the material block depends on the pipeline
+		ParameterBlock.MarkDirty();
+		Version = ++LastMaterialVersion;
 	}
 
 	std::weak_ptr<ShaderPipeline> Material::GetPipeline()
 	{
 		return Pipeline;
 	}
+
+	void Material::SetScalar(const ShaderParameterName& name, float value)
+	{
+		ScalarData[name] = value;
+		ParameterBlock.MarkDirty();
+		Version = ++LastMaterialVersion;
+	}
+
+	void Material::SetVec2(const ShaderParameterName& name, const glm::vec2& value)
+	{
+		Vec2Data[name] = value;
+		ParameterBlock.MarkDirty();
+		Version = ++LastMaterialVersion;
+	}
+
+	void Material::SetVec3(const ShaderParameterName& name, const glm::vec3& value)
+	{
+		Vec3Data[name] = value;
+		ParameterBlock.MarkDirty();
+		Version = ++LastMaterialVersion;
+	}
+
+	void Material::SetVec4(const ShaderParameterName& name, const glm::vec4& value)
+	{
+		Vec4Data[name] = value;
+		ParameterBlock.MarkDirty();
+		Version = ++LastMaterialVersion;
+	}
+
+	void Material::SetMat3(const ShaderParameterName& name, const glm::mat3& value)
+	{
+		Mat3Data[name] = value;
+		ParameterBlock.MarkDirty();
+		Version = ++LastMaterialVersion;
+	}
+
+	void Material::SetMat4(const ShaderParameterName& name, const glm::mat4& value)
+	{
+		Mat4Data[name] = value;
+		ParameterBlock.MarkDirty();
+		Version = ++LastMaterialVersion;
+	}
+
+	void Material::MarkParametersDirty()
+	{
+		ParameterBlock.MarkDirty();
+		Version = ++LastMaterialVersion;
+	}
+
+	unsigned int Material::GetVersion() const
+	{
+		return Version;
+	}
+
+	unsigned int Material::GetLastVersion()
+	{
+		return LastMaterialVersion;
+	}
+
+	MaterialParameterBlock& Material::GetParameterBlock()
+	{
+		return ParameterBlock;
+	}
 }
@@ -7,6 +7,8 @@
 #include <glm/glm.hpp>
 
 #include "Buffer.hpp"
+#include "ShaderParameterName.h"
+#include "MaterialParameterBlock.h"
 
 namespace GaladHen
 {
@@ -28,18 +30,47 @@ namespace GaladHen
 		void SetPipeline(std::weak_ptr<ShaderPipeline> pipeline);
 		std::weak_ptr<ShaderPipeline> GetPipeline();
 
-		std::unordered_map<std::string, float> ScalarData;
-		std::unordered_map<std::string, glm::vec2> Vec2Data;
-		std::unordered_map<std::string, glm::vec3> Vec3Data;
-		std::unordered_map<std::string, glm::vec4> Vec4Data;
-		std::unordered_map<std::string, glm::mat3> Mat3Data;
-		std::unordered_map<std::string, glm::mat4> Mat4Data;
-		std::unordered_map<std::string, std::weak_ptr<Texture>> TextureData;
-		std::unordered_map<std::string, std::weak_ptr<IBuffer>> BufferData;
+		// @returns an id unique among all the materials, used to sort draws by material
+		unsigned int GetMaterialID() const;
+
+		// @brief
+		// Set a value parameter, marking the material block to be packed and uploaded again
+		// Writing the maps directly (textures and buffers included) after the first draw is not tracked: call MarkParametersDirty() in that case
+		void SetScalar(const ShaderParameterName& name, float value);
+		void SetVec2(const ShaderParameterName& name, const glm::vec2& value);
+		void SetVec3(const ShaderParameterName& name, const glm::vec3& value);
+		void SetVec4(const ShaderParameterName& name, const glm::vec4& value);
+		void SetMat3(const ShaderParameterName& name, const glm::mat3& value);
+		void SetMat4(const ShaderParameterName& name, const glm::mat4& value);
+
+		void MarkParametersDirty();
+
+		// @brief
+		// Get the version of the parameters, changed by every setter and by MarkParametersDirty()
+		// Versions are unique among all the materials
+		unsigned int GetVersion() const;
+
+		// @returns the version of the last modification of any material, to know when the resident materials must be checked
+		static unsigned int GetLastVersion();
+
+		// Value parameters packed for pipelines declaring a material block
+		MaterialParameterBlock& GetParameterBlock();
+
+		std::unordered_map<ShaderParameterName, float> ScalarData;
+		std::unordered_map<ShaderParameterName, glm::vec2> Vec2Data;
+		std::unordered_map<ShaderParameterName, glm::vec3> Vec3Data;
+		std::unordered_map<ShaderParameterName, glm::vec4> Vec4Data;
+		std::unordered_map<ShaderParameterName, glm::mat3> Mat3Data;
+		std::unordered_map<ShaderParameterName, glm::mat4> Mat4Data;
+		std::unordered_map<ShaderParameterName, std::weak_ptr<Texture>> TextureData;
+		std::unordered_map<ShaderParameterName, std::weak_ptr<IBuffer>> BufferData;
 
 	protected:
 
 		std::weak_ptr<ShaderPipeline> Pipeline;
+		MaterialParameterBlock ParameterBlock;
+		unsigned int MaterialID;
+		unsigned int Version;
 
 	};
 }
@@ -0,0 +1,98 @@
+#include "MaterialParameterBlock.h"
+#include "Material.h"
+
+#include <cstring>
+
+namespace GaladHen
+{
+	template <class T>
+	static const T* FindParameter(const std::unordered_map<ShaderParameterName, T>& parameters, const ShaderParameterName& name)
+	{
+		typename std::unordered_map<ShaderParameterName, T>::const_iterator it = parameters.find(name);
+		return it != parameters.end() ? &it->second : nullptr;
+	}
+
+	MaterialParameterBlock::MaterialParameterBlock()
+		: IBuffer(BufferType::Uniform, BufferAccessType::StaticRead)
+		, PackedPipelineID(0)
+	{
+		AllocationType = BufferAllocationType::Dynamic;
+	}
+
+	void MaterialParameterBlock::Pack(const Material& material, const ShaderBlockLayout& layout, unsigned int pipelineID)
+	{
+		Data.assign(layout.BytesSize, 0);
+
+		for (const ShaderBlockMember& member : layout.Members)
+		{
+			unsigned char* destination = Data.data() + member.Offset;
+
+			switch (member.Type)
+			{
+			case ShaderBlockMemberType::Scalar:
+				if (const float* value = FindParameter(material.ScalarData, member.Name))
+					memcpy(destination, value, sizeof(float));
+				break;
+
+			case ShaderBlockMemberType::Vec2:
+				if (const glm::vec2* value = FindParameter(material.Vec2Data, member.Name))
+					memcpy(destination, value, sizeof(glm::vec2));
+				break;
+
+			case ShaderBlockMemberType::Vec3:
+				if (const glm::vec3* value = FindParameter(material.Vec3Data, member.Name))
+					memcpy(destination, value, sizeof(glm::vec3));
+				break;
+
+			case ShaderBlockMemberType::Vec4:
+				if (const glm::vec4* value = FindParameter(material.Vec4Data, member.Name))
+					memcpy(destination, value, sizeof(glm::vec4));
+				break;
+
+			case ShaderBlockMemberType::Mat3:
+				// std140 pads each column to a vec4
+				if (const glm::mat3* value = FindParameter(material.Mat3Data, member.Name))
+				{
+					for (unsigned int c = 0; c < 3; ++c)
+						memcpy(destination + c * member.MatrixStride, &(*value)[c], sizeof(glm::vec3));
+				}
+				break;
+
+			case ShaderBlockMemberType::Mat4:
+				if (const glm::mat4* value = FindParameter(material.Mat4Data, member.Name))
+				{
+					for (unsigned int c = 0; c < 4; ++c)
+						memcpy(destination + c * member.MatrixStride, &(*value)[c], sizeof(glm::vec4));
+				}
+				break;
+
+			default:
+				break;
+			}
+		}
+
+		PackedPipelineID = pipelineID;
+
+		InvalidateResource();
+	}
+
+	void MaterialParameterBlock::MarkDirty()
+	{
+		InvalidateResource();
+	}
+
+	unsigned int MaterialParameterBlock::GetPackedPipelineID() const
+	{
+		return PackedPipelineID;
+	}
+
+	const void* MaterialParameterBlock::GetData() const
+	{
+		return Data.data();
+	}
+
+	size_t MaterialParameterBlock::GetBytesSize() const
+	{
+		return Data.size();
+	}
+}
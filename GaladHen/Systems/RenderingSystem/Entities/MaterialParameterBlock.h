@@ -0,0 +1,70 @@
+// Value parameters of a material packed into a uniform buffer (std140), laid out as the material block declared by the material pipeline
+// The buffer is packed and uploaded again only when a parameter changes, so drawing a material just binds it
+
+#pragma once
+
+#include <vector>
+
+#include "Buffer.hpp"
+#include "ShaderParameterName.h"
+
+namespace GaladHen
+{
+	class Material;
+
+	enum class ShaderBlockMemberType
+	{
+		Scalar,
+		Vec2,
+		Vec3,
+		Vec4,
+		Mat3,
+		Mat4,
+		Unsupported
+	};
+
+	struct ShaderBlockMember
+	{
+		ShaderParameterName Name;
+		ShaderBlockMemberType Type;
+		unsigned int Offset; // In bytes from the start of the block
+		unsigned int MatrixStride; // In bytes between two columns, only for matrices
+	};
+
+	// Layout of a uniform block as reflected from a compiled pipeline
+	struct ShaderBlockLayout
+	{
+		size_t BytesSize;
+		std::vector<ShaderBlockMember> Members;
+	};
+
+	class MaterialParameterBlock : public IBuffer
+	{
+	public:
+
+		MaterialParameterBlock();
+
+		// @brief
+		// Copy the value parameters of a material into the block, following the layout of the pipeline
+		// Members without a parameter in the material are zero
+		// @param pipelineID: id of the pipeline the layout comes from, to know when the block must be packed again
+		void Pack(const Material& material, const ShaderBlockLayout& layout, unsigned int pipelineID);
+
+		// @brief
+		// Mark the block to be packed and uploaded again before the next draw
+		void MarkDirty();
+
+		// @returns the id of the pipeline used by the last Pack (0 if never packed)
+		unsigned int GetPackedPipelineID() const;
+
+		virtual const void* GetData() const override;
+
+		virtual size_t GetBytesSize() const override;
+
+	protected:
+
+		std::vector<unsigned char> Data;
+		unsigned int PackedPipelineID;
+
+	};
+}
@@ -1,15 +1,24 @@
 
 #include "Mesh.h"
 
+#include <atomic>
+
 namespace GaladHen
 {
+	static std::atomic<unsigned int> LastMeshID{ 0 };
+	static std::atomic<unsigned int> LastMeshVersion{ 0 };
+
 	Mesh::Mesh(const std::vector<MeshVertexData>& vertices, const std::vector<unsigned int>& indices, MeshPrimitive primitive)
 		: Vertices(vertices)
 		, Indices(indices)
 		, PrimitiveType(primitive)
+		, ID(++LastMeshID)
+		, Version(++LastMeshVersion)
 	{}
 
 	Mesh::Mesh(const Mesh& source)
+		: ID(++LastMeshID)
+		, Version(++LastMeshVersion)
 	{
 		Vertices = source.Vertices;
 		Indices = source.Indices;
@@ -23,6 +32,7 @@ namespace GaladHen
 		Vertices = source.Vertices;
 		Indices = source.Indices;
 		PrimitiveType = source.PrimitiveType;
+		UpdateVersion();
 
 		InvalidateResource();
 
@@ -30,10 +40,14 @@ namespace GaladHen
 	}
 
 	Mesh::Mesh(Mesh&& source) noexcept
+		: ID(source.ID)
+		, Version(source.Version)
 	{
 		Vertices = std::move(source.Vertices);
 		Indices = std::move(source.Indices);
 		PrimitiveType = source.PrimitiveType;
+
+		source.ID = ++LastMeshID; // the emptied source is another mesh now
 	}
 
 	Mesh& Mesh::operator=(Mesh&& source) noexcept
@@ -41,6 +55,7 @@ namespace GaladHen
 		Vertices = std::move(source.Vertices);
 		Indices = std::move(source.Indices);
 		PrimitiveType = source.PrimitiveType;
+		UpdateVersion();
 
 		return *this;
 	}
@@ -59,4 +74,24 @@ namespace GaladHen
 	{
 		return PrimitiveType;
 	}
+
+	unsigned int Mesh::GetID() const
+	{
+		return ID;
+	}
+
+	unsigned int Mesh::GetVersion() const
+	{
+		return Version;
+	}
+
+	unsigned int Mesh::GetLastVersion()
+	{
+		return LastMeshVersion;
+	}
+
+	void Mesh::UpdateVersion()
+	{
+		Version = ++LastMeshVersion;
+	}
 }
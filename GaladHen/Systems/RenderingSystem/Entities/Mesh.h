@@ -44,13 +44,28 @@ namespace GaladHen
         const std::vector<unsigned int>& GetIndices() const;
         MeshPrimitive GetPrimitive() const;
 
+        // @returns an id unique among all the meshes, that follows the mesh when it is moved
+        unsigned int GetID() const;
+
+        // @brief
+        // Get the version of the mesh, changed when the geometry or the BVH change
+        // Versions are unique among all the meshes
+        unsigned int GetVersion() const;
+
+        // @returns the version of the last modification of any mesh, to know when the loaded meshes must be checked
+        static unsigned int GetLastVersion();
+
         BVH BVH;
 
     protected:
 
+        void UpdateVersion();
+
         std::vector<MeshVertexData> Vertices;
         std::vector<unsigned int> Indices;
         MeshPrimitive PrimitiveType;
+        unsigned int ID;
+        unsigned int Version;
 
 	};
 }
@@ -6,11 +6,13 @@ namespace GaladHen
 	PointLight::PointLight()
 		: BulbSize(1.0f)
 		, Radius(10.0f)
+		, CastShadows(false)
 	{}
 
 	PointLight::PointLight(const glm::vec4& color, float intensity, float bulbSize, float radius)
 		: Light(color, intensity)
 		, BulbSize(bulbSize)
 		, Radius(radius)
+		, CastShadows(false)
 	{}
 }
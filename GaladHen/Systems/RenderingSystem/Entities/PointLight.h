@@ -15,6 +15,7 @@ namespace GaladHen
 
 		float BulbSize; // The (fake) "physical" size of the light bulb
 		float Radius; // Of the illuminated area (sphere)
+		bool CastShadows; // Rendered in the shadow atlas, with a tile for each cube face
 
 	};
 }
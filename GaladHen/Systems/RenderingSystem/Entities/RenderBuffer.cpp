@@ -1,13 +1,39 @@
 
 #include "RenderBuffer.h"
 
+#include <algorithm>
+
 namespace GaladHen
 {
 	RenderBuffer::RenderBuffer(unsigned int width, unsigned int height, TextureFormat format, bool enableDepth)
 		: Size(glm::uvec2(width, height))
 		, ClearColor(GH_DEFAULT_RENDER_CLEAR_COLOR)
-		, Format(format)
+		, Formats()
+		, ColorAttachments(1)
 		, DepthBufferAttached(enableDepth)
+		, Layers(0)
+	{
+		Formats[0] = format;
+	}
+
+	RenderBuffer::RenderBuffer(unsigned int width, unsigned int height, const std::vector<TextureFormat>& formats, bool enableDepth)
+		: Size(glm::uvec2(width, height))
+		, ClearColor(GH_DEFAULT_RENDER_CLEAR_COLOR)
+		, Formats()
+		, ColorAttachments(std::min((unsigned int)formats.size(), (unsigned int)GH_MAX_RENDER_BUFFER_ATTACHMENTS))
+		, DepthBufferAttached(enableDepth)
+		, Layers(0)
+	{
+		std::copy(formats.begin(), formats.begin() + ColorAttachments, Formats);
+	}
+
+	RenderBuffer::RenderBuffer(unsigned int width, unsigned int height, unsigned int layers)
+		: Size(glm::uvec2(width, height))
+		, ClearColor(GH_DEFAULT_RENDER_CLEAR_COLOR)
+		, Formats()
+		, ColorAttachments(0)
+		, DepthBufferAttached(true)
+		, Layers(layers)
 	{}
 
 	glm::uvec2 RenderBuffer::GetSize() const
@@ -27,8 +53,23 @@ namespace GaladHen
 		return DepthBufferAttached;
 	}
 
-	TextureFormat RenderBuffer::GetFormat() const
+	bool RenderBuffer::IsColorBufferAttached() const
+	{
+		return ColorAttachments > 0;
+	}
+
+	TextureFormat RenderBuffer::GetFormat(unsigned int attachment) const
+	{
+		return Formats[attachment];
+	}
+
+	unsigned int RenderBuffer::GetColorAttachments() const
+	{
+		return ColorAttachments;
+	}
+
+	unsigned int RenderBuffer::GetLayers() const
 	{
-		return Format;
+		return Layers;
 	}
 }
@@ -9,7 +9,10 @@
 #include "IGPUResource.h"
 #include <glm/glm.hpp>
 
+#include <vector>
+
 #define GH_DEFAULT_RENDER_CLEAR_COLOR glm::vec4{ 0.1f, 0.1f, 0.1f, 1.0f }
+#define GH_MAX_RENDER_BUFFER_ATTACHMENTS 4 // color attachments written by the same draws
 
 namespace GaladHen
 {
@@ -21,19 +24,33 @@ namespace GaladHen
 
 		RenderBuffer(unsigned int width, unsigned int height, TextureFormat format, bool enableDepth = true);
 
+		// @brief
+		// Render buffer with several color attachments, written at once by the outputs of the fragment shaders (ex: a g-buffer)
+		// @param formats: format of each attachment, the ones after GH_MAX_RENDER_BUFFER_ATTACHMENTS are ignored
+		RenderBuffer(unsigned int width, unsigned int height, const std::vector<TextureFormat>& formats, bool enableDepth = true);
+
+		// @brief
+		// Depth only render buffer made of layers of the same size (ex: the cascades of a shadow map)
+		RenderBuffer(unsigned int width, unsigned int height, unsigned int layers);
+
 		glm::uvec2 GetSize() const;
 		void SetSize(const glm::uvec2& size);
 
 		bool IsDepthBufferAttached() const;
-		TextureFormat GetFormat() const;
+		bool IsColorBufferAttached() const;
+		TextureFormat GetFormat(unsigned int attachment = 0) const; // meaningless without color buffer
+		unsigned int GetColorAttachments() const;
+		unsigned int GetLayers() const; // 0 if the render buffer is not layered
 
 		glm::vec4 ClearColor;
 
 	protected:
 
-		TextureFormat Format;
+		TextureFormat Formats[GH_MAX_RENDER_BUFFER_ATTACHMENTS];
+		unsigned int ColorAttachments;
 		glm::uvec2 Size;
 		bool DepthBufferAttached;
+		unsigned int Layers;
 
 	};
 }
@@ -7,6 +7,7 @@
 #include "SceneObject.h"
 #include "PointLight.h"
 #include "DirectionalLight.h"
+#include <Systems/RenderingSystem/Baking/IrradianceVolume.h>
 
 namespace GaladHen
 {
@@ -27,5 +28,11 @@ namespace GaladHen
 
         std::vector<SceneObject> SceneObjects;
 
+        // baked indirect diffuse lighting
+        IrradianceVolume IrradianceVolume;
+
+        // draw the depth of the scene objects front to back before shading them, so that each pixel is shaded once (forward path only, disabled by default)
+        bool DepthPrePass;
+
     };
 }
@@ -3,12 +3,19 @@
 #include "Model.h"
 #include <utils/Log.h>
 #include <utility>
+#include <atomic>
 
 namespace GaladHen
 {
+    // Incremented at every modification of any scene object, so that the versions are unique
+    static std::atomic<unsigned int> LastSceneObjectVersion{ 0 };
+
     SceneObject::SceneObject(std::weak_ptr<Model> model)
         : Transform(GaladHen::Transform{})
         , SceneObjectModel(model)
+        , Occluder(false)
+        , Static(false)
+        , Version(++LastSceneObjectVersion)
     {
         // Number of materials = number of meshes
         if (model.expired())
@@ -34,6 +41,7 @@ namespace GaladHen
 
         // We are sure the size of SceneObjectMaterials is always equal to the number of SceneObjectModel's meshes
         SceneObjectMaterials[meshIndex] = material;
+        Version = ++LastSceneObjectVersion;
     }
 
     std::weak_ptr<Material> SceneObject::GetMaterial(unsigned int meshIndex) const
@@ -47,7 +55,7 @@ namespace GaladHen
         return SceneObjectMaterials[meshIndex];
     }
 
-    std::vector<std::weak_ptr<Material>> SceneObject::GetSceneObjectMaterials() const
+    const std::vector<std::weak_ptr<Material>>& SceneObject::GetSceneObjectMaterials() const
     {
         return SceneObjectMaterials;
     }
@@ -60,5 +68,39 @@ namespace GaladHen
     void SceneObject::ClearSceneObjectModel()
     {
         SceneObjectModel.reset();
+        Version = ++LastSceneObjectVersion;
+    }
+
+    void SceneObject::SetOccluder(bool occluder, std::weak_ptr<Model> occluderModel)
+    {
+        Occluder = occluder;
+        OccluderModel = occluderModel;
+        Version = ++LastSceneObjectVersion;
+    }
+
+    bool SceneObject::IsOccluder() const
+    {
+        return Occluder;
+    }
+
+    std::weak_ptr<Model> SceneObject::GetOccluderModel() const
+    {
+        return OccluderModel.expired() ? SceneObjectModel : OccluderModel;
+    }
+
+    void SceneObject::SetStatic(bool isStatic)
+    {
+        Static = isStatic;
+        Version = ++LastSceneObjectVersion;
+    }
+
+    bool SceneObject::IsStatic() const
+    {
+        return Static;
+    }
+
+    unsigned int SceneObject::GetVersion() const
+    {
+        return Version;
     }
 }
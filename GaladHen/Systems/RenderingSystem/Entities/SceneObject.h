@@ -31,7 +31,7 @@ namespace GaladHen
 
         // @brief
         // Get scene object materials
-        std::vector<std::weak_ptr<Material>> GetSceneObjectMaterials() const;
+        const std::vector<std::weak_ptr<Material>>& GetSceneObjectMaterials() const;
 
         std::weak_ptr<Model> GetSceneObjectModel() const;
 
@@ -39,12 +39,40 @@ namespace GaladHen
         // Delete the association between the scene object and its model
         void ClearSceneObjectModel();
 
+        // @brief
+        // Make the scene object hide the scene objects behind it, when occlusion culling is enabled
+        // @param occluderModel: simplified geometry rasterized in place of the scene object model (ex: few boxes for a building); it must stay inside the
+        // scene object model, or visible objects can be culled. Expired to rasterize the scene object model itself
+        void SetOccluder(bool occluder, std::weak_ptr<Model> occluderModel = std::weak_ptr<Model>{});
+
+        bool IsOccluder() const;
+
+        // @brief
+        // Get the geometry hiding the scene objects behind this one: the simplified occluder model if set, the scene object model otherwise
+        std::weak_ptr<Model> GetOccluderModel() const;
+
+        // @brief
+        // Mark the scene object as not moving: its shadow depth is cached, and rendered again only when a static scene object changes or the shadow view moves
+        // Moving a static scene object is allowed, but it renders the shadows of all the static ones again
+        void SetStatic(bool isStatic);
+
+        bool IsStatic() const;
+
+        // @brief
+        // Get the version of the model, materials and occluder links, changed by every modification (transform changes are tracked by the transform)
+        // Versions are unique among all the scene objects, so a copy has the same version only if it has the same links
+        unsigned int GetVersion() const;
+
         Transform Transform;
 
     protected:
 
         std::weak_ptr<Model> SceneObjectModel;
         std::vector<std::weak_ptr<Material>> SceneObjectMaterials; // the number of materials and the number of meshes inside the model are always the same: mesh <-> material
+        bool Occluder;
+        std::weak_ptr<Model> OccluderModel;
+        bool Static;
+        unsigned int Version;
 
     };
 }
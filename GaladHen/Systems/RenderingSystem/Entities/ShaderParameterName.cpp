@@ -0,0 +1,58 @@
+#include "ShaderParameterName.h"
+
+#include <unordered_map>
+
+namespace GaladHen
+{
+	// Function-local statics: names can be registered during static initialization of other translation units
+	static std::unordered_map<std::string, unsigned int>& GetNameToID()
+	{
+		static std::unordered_map<std::string, unsigned int> nameToID;
+		return nameToID;
+	}
+
+	static std::vector<std::string>& GetIDToName()
+	{
+		static std::vector<std::string> idToName;
+		return idToName;
+	}
+
+	ShaderParameterName::ShaderParameterName(const char* name)
+		: ID(Register(name))
+	{}
+
+	ShaderParameterName::ShaderParameterName(const std::string& name)
+		: ID(Register(name))
+	{}
+
+	unsigned int ShaderParameterName::GetID() const
+	{
+		return ID;
+	}
+
+	const std::string& ShaderParameterName::GetName() const
+	{
+		return GetIDToName()[ID];
+	}
+
+	unsigned int ShaderParameterName::Register(const std::string& name)
+	{
+		std::unordered_map<std::string, unsigned int>& nameToID = GetNameToID();
+
+		std::unordered_map<std::string, unsigned int>::const_iterator it = nameToID.find(name);
+		if (it != nameToID.end())
+			return it->second;
+
+		std::vector<std::string>& idToName = GetIDToName();
+		unsigned int id = (unsigned int)idToName.size();
+		idToName.push_back(name);
+		nameToID.emplace(name, id);
+
+		return id;
+	}
+
+	unsigned int ShaderParameterName::GetRegisteredNumber()
+	{
+		return (unsigned int)GetIDToName().size();
+	}
+}
@@ -0,0 +1,52 @@
+// Name of a shader parameter (uniform, sampler or buffer block) interned into a small integer id
+// Ids are assigned on first use and never change, so renderers can index per-pipeline tables by id instead of hashing strings at every draw
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace GaladHen
+{
+	class ShaderParameterName
+	{
+	public:
+
+		// Implicit on purpose: strings can be used everywhere a parameter name is expected (ex: material.ScalarData.emplace("Roughness", 0.5f))
+		ShaderParameterName(const char* name);
+		ShaderParameterName(const std::string& name);
+
+		unsigned int GetID() const;
+
+		const std::string& GetName() const;
+
+		bool operator==(const ShaderParameterName& other) const { return ID == other.ID; }
+		bool operator!=(const ShaderParameterName& other) const { return ID != other.ID; }
+
+		// @brief
+		// Get the id of a name, registering it if it is the first time
+		// Registration is not thread safe: names should be registered from the rendering thread
+		static unsigned int Register(const std::string& name);
+
+		// @returns the number of names registered so far (ids are in the range [0, number))
+		static unsigned int GetRegisteredNumber();
+
+	protected:
+
+		unsigned int ID;
+
+	};
+}
+
+namespace std
+{
+	template <>
+	struct hash<GaladHen::ShaderParameterName>
+	{
+		size_t operator()(const GaladHen::ShaderParameterName& name) const
+		{
+			return name.GetID();
+		}
+	};
+}
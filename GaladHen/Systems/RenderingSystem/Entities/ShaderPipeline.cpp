@@ -3,12 +3,13 @@
 
 namespace GaladHen
 {
-	ShaderPipeline::ShaderPipeline(const std::string vertexPath, const std::string tessContPath, const std::string tessEvalPath, const std::string geometryPath, const std::string fragmentPath)
+	ShaderPipeline::ShaderPipeline(const std::string vertexPath, const std::string tessContPath, const std::string tessEvalPath, const std::string geometryPath, const std::string fragmentPath, const std::string defines)
 		: VertexShaderPath(vertexPath)
 		, TessContShaderPath(tessContPath)
 		, TessEvalShaderPath(tessEvalPath)
 		, GeometryShaderPath(geometryPath)
 		, FragmentShaderPath(fragmentPath)
+		, Defines(defines)
 		, Type(ShaderPipelineType::ShaderPipeline)
 	{}
 
@@ -47,6 +48,11 @@ namespace GaladHen
 		return ComputeShaderPath;
 	}
 
+	std::string ShaderPipeline::GetDefines() const
+	{
+		return Defines;
+	}
+
 	ShaderPipelineType ShaderPipeline::GetType() const
 	{
 		return Type;
@@ -17,7 +17,8 @@ namespace GaladHen
 	{
 	public:
 
-		ShaderPipeline(const std::string vertexPath, const std::string tessContPath, const std::string tessEvalPath, const std::string geometryPath, const std::string fragmentPath);
+		// @param defines: preprocessor directives added on top of each shader (ex: "#define NAME"), to compile variants of the same shaders
+		ShaderPipeline(const std::string vertexPath, const std::string tessContPath, const std::string tessEvalPath, const std::string geometryPath, const std::string fragmentPath, const std::string defines = std::string{});
 
 		ShaderPipeline(const std::string computePath);
 
@@ -32,6 +33,7 @@ namespace GaladHen
 		std::string GetGeometryShaderPath() const;
 		std::string GetFragmentShaderPath() const;
 		std::string GetComputeShaderPath() const;
+		std::string GetDefines() const;
 
 		ShaderPipelineType GetType() const;
 
@@ -43,6 +45,7 @@ namespace GaladHen
 		std::string GeometryShaderPath;
 		std::string FragmentShaderPath;
 		std::string ComputeShaderPath;
+		std::string Defines;
 
 		ShaderPipelineType Type;
 	};
@@ -1,9 +1,13 @@
 
 #include "Texture.h"
 #include <glm/glm.hpp>
+#include <atomic>
 
 namespace GaladHen
 {
+	// Incremented at every modification of any texture
+	static std::atomic<unsigned int> LastTextureVersion{ 0 };
+
 	Texture::Texture(unsigned char* data, unsigned int width, unsigned int height, unsigned int numberOfMipMaps, TextureFormat format)
 		: Width(width)
 		, Height(height)
@@ -50,6 +54,7 @@ namespace GaladHen
 		Wrapping = wrapping;
 
 		InvalidateResource();
+		++LastTextureVersion;
 	}
 
 	void Texture::SetFiltering(TextureFiltering filtering)
@@ -57,6 +62,7 @@ namespace GaladHen
 		Filtering = filtering;
 
 		InvalidateResource();
+		++LastTextureVersion;
 	}
 
 	void Texture::SetNumberOfMipMaps(unsigned int numberOfMipMaps)
@@ -64,6 +70,12 @@ namespace GaladHen
 		NumberOfMipMaps = numberOfMipMaps;
 
 		InvalidateResource();
+		++LastTextureVersion;
+	}
+
+	unsigned int Texture::GetLastVersion()
+	{
+		return LastTextureVersion;
 	}
 
 	Texture::~Texture()
@@ -15,7 +15,8 @@ namespace GaladHen
 		RGB8,
 		RGBA8,
 		SRGB8,
-		SRGBA8
+		SRGBA8,
+		RGBA16F // half float channels, for render buffers only (ex: the normals of a g-buffer)
 	};
 
 	enum class TextureWrapping
@@ -64,6 +65,9 @@ namespace GaladHen
 		void SetFiltering(TextureFiltering filtering);
 		void SetNumberOfMipMaps(unsigned int numberOfMipMaps);
 
+		// @returns a number changed by every modification of any texture, to know when the loaded textures must be checked
+		static unsigned int GetLastVersion();
+
 		~Texture();
 
 	protected:
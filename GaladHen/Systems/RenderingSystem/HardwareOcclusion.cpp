@@ -0,0 +1,156 @@
+#include "HardwareOcclusion.h"
+
+#include "RenderList.h"
+#include "Entities/Camera.h"
+#include "LayerAPI/IRendererAPI.h"
+#include <Math/AABB/AABB.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+
+namespace GaladHen
+{
+	HardwareOcclusion::HardwareOcclusion()
+		: BoxTransformBuffer(DynamicBuffer<TransformBufferData>{ BufferType::ShaderStorage, BufferAccessType::StreamWrite })
+		, Stats()
+		, Frame(0)
+		, CameraPosition(0.0f)
+		, CameraMargin(0.0f)
+	{}
+
+	void HardwareOcclusion::BeginFrame(const RenderList& renderList, const Camera& camera, IRendererAPI& api)
+	{
+		++Frame;
+		Stats = HardwareOcclusionStats{};
+
+		unsigned int instanceNumber = (unsigned int)renderList.GetInstanceBounds().size();
+		if (renderList.WasRebuilt() || Instances.size() != instanceNumber)
+			ResetInstances(instanceNumber);
+
+		// queries finish in order most of the times, but all of them are checked: the ones still running are kept for the next frames
+		unsigned int stillPending = 0;
+		for (unsigned int slot : PendingInstances)
+		{
+			InstanceQuery& instance = Instances[slot];
+
+			bool samplesPassed = true;
+			if (!api.GetOcclusionQueryResult(instance.QueryID, false, samplesPassed))
+			{
+				PendingInstances[stillPending++] = slot;
+				continue;
+			}
+
+			instance.Visible = samplesPassed;
+			FreeQueries.push_back(instance.QueryID);
+			instance.QueryID = 0;
+			++Stats.ReadQueries;
+		}
+		PendingInstances.resize(stillPending);
+		Stats.PendingQueries = stillPending;
+
+		ScheduledInstances.clear();
+		ScheduledBounds.clear();
+
+		// farthest point of the near plane from the camera: boxes closer than that can be clipped, and hidden even if they are in front of everything
+		float tanHalfFovY = std::tan(glm::radians(camera.GetFovY()) * 0.5f);
+		CameraPosition = camera.Transform.GetPosition();
+		CameraMargin = camera.GetNear() * std::sqrt(1.0f + tanHalfFovY * tanHalfFovY * (1.0f + camera.GetAspectRatio() * camera.GetAspectRatio()));
+	}
+
+	bool HardwareOcclusion::TestInstance(unsigned int slot, const AABB& bounds)
+	{
+		InstanceQuery& instance = Instances[slot];
+
+		// the camera is inside the box, or so close that the box is clipped: always visible, without query
+		if (glm::all(glm::greaterThanEqual(CameraPosition, bounds.MinBound - CameraMargin)) && glm::all(glm::lessThanEqual(CameraPosition, bounds.MaxBound + CameraMargin)))
+		{
+			instance.Visible = true;
+			return false;
+		}
+
+		// old results (ex: of instances out of the view for a while) can't hide an instance, it is drawn until a new query tells it is hidden
+		bool recent = Frame - instance.TestedFrame <= GH_OCCLUSION_QUERY_MAX_LATENCY;
+		bool occluded = !instance.Visible && recent;
+
+		// hidden instances are tested as soon as the previous result is read, visible ones at intervals spread among the instances
+		if (!instance.QueryID && !instance.Scheduled && (occluded || (Frame + slot) % GH_OCCLUSION_QUERY_VISIBLE_INTERVAL == 0))
+		{
+			instance.Scheduled = true;
+			ScheduledInstances.push_back(slot);
+			ScheduledBounds.push_back(bounds);
+		}
+
+		return occluded;
+	}
+
+	const std::vector<unsigned int>& HardwareOcclusion::PrepareQueries(IRendererAPI& api)
+	{
+		PreparedQueries.clear();
+		BoxTransformBuffer.ClearData();
+
+		for (unsigned int s = 0; s < ScheduledInstances.size(); ++s)
+		{
+			unsigned int slot = ScheduledInstances[s];
+			InstanceQuery& instance = Instances[slot];
+
+			if (FreeQueries.empty())
+				FreeQueries.push_back(api.CreateOcclusionQuery());
+
+			instance.QueryID = FreeQueries.back();
+			instance.TestedFrame = Frame;
+			instance.Scheduled = false;
+			FreeQueries.pop_back();
+			PendingInstances.push_back(slot);
+			PreparedQueries.push_back(instance.QueryID);
+
+			const AABB& bounds = ScheduledBounds[s];
+			glm::vec3 center = (bounds.MinBound + bounds.MaxBound) * 0.5f;
+			glm::vec3 size = (bounds.MaxBound - bounds.MinBound) * GH_OCCLUSION_QUERY_BOX_SCALE;
+
+			TransformBufferData box{};
+			box.ModelMatrix = glm::scale(glm::translate(glm::mat4(1.0f), center), size);
+			box.NormalMatrix = glm::mat4(1.0f);
+			BoxTransformBuffer.AddData(box);
+		}
+
+		ScheduledInstances.clear();
+		ScheduledBounds.clear();
+		Stats.IssuedQueries = (unsigned int)PreparedQueries.size();
+
+		return PreparedQueries;
+	}
+
+	DynamicBuffer<TransformBufferData>& HardwareOcclusion::GetBoxTransformBuffer()
+	{
+		return BoxTransformBuffer;
+	}
+
+	void HardwareOcclusion::Release(IRendererAPI& api)
+	{
+		ResetInstances(0);
+
+		for (unsigned int query : FreeQueries)
+			api.FreeOcclusionQuery(query);
+
+		FreeQueries.clear();
+	}
+
+	const HardwareOcclusionStats& HardwareOcclusion::GetStats() const
+	{
+		return Stats;
+	}
+
+	void HardwareOcclusion::ResetInstances(unsigned int instanceNumber)
+	{
+		// a query can be issued again before its result is read: the old result is discarded
+		for (unsigned int slot : PendingInstances)
+			FreeQueries.push_back(Instances[slot].QueryID);
+
+		PendingInstances.clear();
+		ScheduledInstances.clear();
+		ScheduledBounds.clear();
+
+		Instances.assign(instanceNumber, InstanceQuery{ 0, 0, true, false });
+	}
+}
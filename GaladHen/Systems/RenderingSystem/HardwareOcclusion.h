@@ -0,0 +1,94 @@
+// Occlusion culling on gpu with occlusion queries: the bounding boxes of the instances are drawn against the depth of the scene pass, and the instances whose
+// boxes have no visible sample are skipped by the next frames
+// Results are read only when already available, so the cpu never waits for the gpu: the visibility of a frame comes from the queries of the previous ones
+// (temporal coherence), and instances revealed by the camera movement are drawn a frame late
+// Visible instances are tested again only every few frames, hidden ones every frame
+
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Entities/Buffer.hpp"
+#include "Entities/BufferData/TransformBufferData.h"
+
+#define GH_OCCLUSION_QUERY_VISIBLE_INTERVAL 8 // frames between the queries of a visible instance
+#define GH_OCCLUSION_QUERY_MAX_LATENCY 4 // frames after which the result of a query is too old to hide an instance
+#define GH_OCCLUSION_QUERY_BOX_SCALE 1.01f // boxes are enlarged, so that the faces of box shaped objects don't hide their own box
+
+namespace GaladHen
+{
+	class RenderList;
+	class Camera;
+	class IRendererAPI;
+	struct AABB;
+
+	struct HardwareOcclusionStats
+	{
+		unsigned int IssuedQueries; // boxes drawn in the frame
+		unsigned int ReadQueries; // results available in the frame
+		unsigned int PendingQueries; // queries whose results are not available yet
+	};
+
+	class HardwareOcclusion
+	{
+	public:
+
+		HardwareOcclusion();
+
+		HardwareOcclusion(const HardwareOcclusion& source) = delete;
+		HardwareOcclusion& operator=(const HardwareOcclusion& source) = delete;
+
+		// @brief
+		// Start a frame: read the results of the queries finished by the gpu, without waiting for the others
+		// Results are forgotten when the render list regroups its batches, since the instances move to other slots
+		void BeginFrame(const RenderList& renderList, const Camera& camera, IRendererAPI& api);
+
+		// @brief
+		// Check if an instance was hidden at its last query, and schedule a new query for it if needed
+		// To call for the instances inside the view only: the others are not queried, and their results get too old to hide them
+		// @param slot: index of the instance inside the per-instance buffers
+		// @param bounds: world bounds of the instance
+		bool TestInstance(unsigned int slot, const AABB& bounds);
+
+		// @brief
+		// Get a query for each instance scheduled in the frame, and write the transforms of their boxes (unit cubes centered in the origin, scaled on the instance bounds)
+		// @returns the queries, indexed as the boxes
+		const std::vector<unsigned int>& PrepareQueries(IRendererAPI& api);
+
+		// @returns the transforms of the boxes of the queries prepared in the frame
+		DynamicBuffer<TransformBufferData>& GetBoxTransformBuffer();
+
+		// @brief
+		// Free all the queries
+		void Release(IRendererAPI& api);
+
+		const HardwareOcclusionStats& GetStats() const;
+
+	protected:
+
+		struct InstanceQuery
+		{
+			unsigned int QueryID; // 0 if no query is pending
+			unsigned int TestedFrame; // frame of the last query issued
+			bool Visible; // result of the last query read
+			bool Scheduled;
+		};
+
+		void ResetInstances(unsigned int instanceNumber);
+
+		std::vector<InstanceQuery> Instances; // indexed as the instance slots
+		std::vector<unsigned int> PendingInstances;
+		std::vector<unsigned int> ScheduledInstances;
+		std::vector<AABB> ScheduledBounds;
+		std::vector<unsigned int> FreeQueries; // created queries without pending results, reused by the next queries
+		std::vector<unsigned int> PreparedQueries;
+		DynamicBuffer<TransformBufferData> BoxTransformBuffer;
+		HardwareOcclusionStats Stats;
+		unsigned int Frame;
+		glm::vec3 CameraPosition;
+		float CameraMargin; // distance from the camera at which boxes can be clipped by the near plane
+
+	};
+}
@@ -22,8 +22,45 @@ namespace GaladHen
 	class Camera;
 	class TransformQuat;
 	class RenderBuffer;
+	struct ShaderBlockLayout;
 	enum class TextureFormat;
 
+	// State changing api calls (pipelines, vertex arrays, textures, buffers and render buffers bindings)
+	struct StateCallStats
+	{
+		unsigned int Issued;
+		unsigned int Elided; // skipped because the state was already set
+	};
+
+	// Gpu memory holding the vertices and indices of the meshes
+	struct GeometryMemoryStats
+	{
+		unsigned int Meshes;
+		unsigned int BufferAllocations; // gpu buffers allocated for geometry since the start, growths included
+		unsigned int FreeRanges; // holes left by freed meshes, merged when adjacent
+		size_t VertexBytesUsed;
+		size_t VertexBytesCapacity;
+		size_t IndexBytesUsed;
+		size_t IndexBytesCapacity;
+	};
+
+	// Comparison passing the fragments against the depth already in the render buffer
+	enum class DepthFunction
+	{
+		Less,
+		LessEqual,
+		Equal,
+		Always
+	};
+
+	// Indices of a mesh inside the gpu geometry memory, to fill the arguments of indirect draws
+	struct MeshDrawRange
+	{
+		unsigned int IndexCount;
+		unsigned int FirstIndex;
+		int BaseVertex;
+	};
+
 	class IRendererAPI
 	{
 	public:
@@ -32,29 +69,97 @@ namespace GaladHen
 
 		virtual void InitUI() = 0;
 
-		virtual unsigned int CreateRenderBuffer(unsigned int width, unsigned int height, TextureFormat format, bool enableDepth, bool clampDepthToBorder = false) = 0;
+		// @param formats: format of each color attachment, written by the fragment shader output at the same location
+		virtual unsigned int CreateRenderBuffer(unsigned int width, unsigned int height, const TextureFormat* formats, unsigned int colorAttachments, bool enableDepth, bool clampDepthToBorder = false) = 0;
+
+		// Render buffer with a layered depth texture and no color (ex: the cascades of a shadow map), sampled by shaders as a texture array
+		virtual unsigned int CreateDepthRenderBuffer(unsigned int width, unsigned int height, unsigned int layers, bool clampDepthToBorder = false) = 0;
+
+		virtual void FreeRenderBuffer(unsigned int renderBufferID) = 0;
 
+		// Copy a layer of the depth of a render buffer into the same layer of another one, with the same size and layers
+		virtual void CopyRenderBufferDepth(unsigned int sourceRenderBufferID, unsigned int destinationRenderBufferID, unsigned int layer = 0) = 0;
+
+		// Only the layer bound last is cleared, for layered render buffers
 		virtual void ClearRenderBuffer(unsigned int renderBufferID, glm::vec4 clearColor) = 0;
 
-		virtual void BindRenderBuffer(unsigned int renderBufferID) = 0;
+		// Clear the depth of a rectangle of a render buffer alone (ex: a tile of a shadow atlas), leaving the rest as it is
+		virtual void ClearRenderBufferDepth(unsigned int renderBufferID, const glm::uvec2& position, const glm::uvec2& size) = 0;
+
+		// @param layer: layer drawn by the next draws, for layered render buffers
+		virtual void BindRenderBuffer(unsigned int renderBufferID, unsigned int layer = 0) = 0;
 
 		virtual void UnbindActiveRenderBuffer() = 0;
 
+		// Indirect draws need SupportsIndirectDrawCount()
 		virtual void Draw(CommandBuffer<RenderCommand>& renderCommandBuffer) = 0;
 
+		// Results written by the compute shaders are visible to the commands issued after the dispatch only through the barriers of each command
+		virtual void Dispatch(CommandBuffer<ComputeCommand>& computeCommandBuffer) = 0;
+
+		// Barrier for memory written by shaders of previous commands, when it is not placed by the dispatch writing it (ex: images stored by fragment shaders)
+		virtual void InsertMemoryBarrier(MemoryBarrierType barriers) = 0;
+
 		// This function should write on each MemoryTransferCommand the new id of eventually created resource, in MemoryTargetID field
 		virtual void TransferData(CommandBuffer<MemoryTransferCommand>& memoryCommandBuffer) = 0;
 
 		virtual bool Compile(CommandBuffer<CompileCommand>& compileCommandBuffer) = 0; // TODO: CompileResult instead of bool as return type
 
+		// Layout of the material block (GH_MATERIAL_BLOCK_NAME) of a compiled pipeline, valid until the next compilation
+		// nullptr if the pipeline does not declare it: material parameters are then set one by one at each draw
+		virtual const ShaderBlockLayout* GetMaterialBlockLayout(unsigned int shaderID) = 0;
+
+		// Copy the content of a gpu buffer into cpu memory: it stalls until the gpu finishes writing the buffer, so check a fence before reading to avoid waiting
+		virtual bool ReadBuffer(unsigned int bufferID, void* outData, size_t bytesSize) = 0;
+
+		// Insert a fence after all the commands issued so far, to know when the gpu finishes them
+		virtual unsigned int CreateFence() = 0;
+
+		// @param wait: block until the fence is signaled
+		virtual bool IsFenceSignaled(unsigned int fenceID, bool wait) = 0;
+
+		virtual void FreeFence(unsigned int fenceID) = 0;
+
+		// Occlusion query telling whether any sample of the draws issued with it passes the depth test (ex: bounding boxes drawn without writes, see RenderCommand::OcclusionQueryID)
+		// The answer can be conservative: samples may be reported as passed when they don't
+		virtual unsigned int CreateOcclusionQuery() = 0;
+
+		// @param wait: block until the result is available, stalling on the gpu
+		// @param outSamplesPassed: written only when the result is available
+		// @returns false if the gpu has not finished the draws of the query yet
+		virtual bool GetOcclusionQueryResult(unsigned int queryID, bool wait, bool& outSamplesPassed) = 0;
+
+		virtual void FreeOcclusionQuery(unsigned int queryID) = 0;
+
 		virtual void EnableDepthTest(bool enable) = 0;
 
+		virtual void EnableDepthWrite(bool enable) = 0;
+
+		virtual void SetDepthFunction(DepthFunction function) = 0;
+
+		virtual void EnableColorWrite(bool enable) = 0;
+
 		virtual void EnableBackFaceCulling(bool enable) = 0;
 
 		virtual unsigned int GetRenderBufferColorApiID(unsigned int renderBufferID) = 0; // Probably it shouldn't exist, but for now i need it for ImGui usage
 
 		virtual void SetViewport(const glm::uvec2& position, const glm::uvec2& size) = 0;
 
+		// Mark the end of the commands of a frame: memory of StreamWrite buffers loaded during the frame is reused once the gpu completes them
+		virtual void EndFrame() = 0;
+
+		virtual MeshDrawRange GetMeshDrawRange(unsigned int meshID) = 0;
+
+		// Whether indirect draws can read their draw count from a gpu buffer
+		virtual bool SupportsIndirectDrawCount() const = 0;
+
+		virtual GeometryMemoryStats GetGeometryMemoryStats() const = 0;
+
+		// Counters of the state changing calls since the last reset
+		virtual const StateCallStats& GetStateCallStats() const = 0;
+
+		virtual void ResetStateCallStats() = 0;
+
 		// WINDOW FUNCTIONALITIES ------------------------------------------------------------------------------------------------------------------
 
 		virtual void CreateRenderingWindow(const char* name, glm::uvec2 size) = 0;
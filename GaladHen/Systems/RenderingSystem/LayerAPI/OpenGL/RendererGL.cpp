@@ -16,14 +16,110 @@
 #include <Systems/RenderingSystem/Entities/Mesh.h>
 #include <Systems/RenderingSystem/Entities/Buffer.hpp>
 #include <Systems/RenderingSystem/Entities/RenderBuffer.h>
+#include <Systems/RenderingSystem/Entities/ShaderParameterName.h>
+#include <Systems/RenderingSystem/Entities/BufferData/IndirectCommandBufferData.h>
 
 #include <imgui/imgui.h>
 #include <imgui/imgui_internal.h>
 #include <imgui/backends/imgui_impl_glfw.h>
 #include <imgui/backends/imgui_impl_opengl3.h>
 
+#include <cstring>
+#include <algorithm>
+
+#define GH_SHADER_PARAMETER_NAME_MAX_LENGTH 256
+#define GH_GL_UNKNOWN_BINDING ((GLuint)-1) // cached binding value forcing the next call to be issued
+
 namespace GaladHen
 {
+	static bool IsSamplerType(GLenum type)
+	{
+		switch (type)
+		{
+		case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+		case GL_SAMPLER_1D_SHADOW: case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_CUBE_SHADOW:
+		case GL_SAMPLER_1D_ARRAY: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_1D_ARRAY_SHADOW: case GL_SAMPLER_2D_ARRAY_SHADOW:
+		case GL_SAMPLER_CUBE_MAP_ARRAY: case GL_SAMPLER_CUBE_MAP_ARRAY_SHADOW:
+		case GL_SAMPLER_2D_MULTISAMPLE: case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+		case GL_SAMPLER_BUFFER: case GL_SAMPLER_2D_RECT: case GL_SAMPLER_2D_RECT_SHADOW:
+		case GL_INT_SAMPLER_1D: case GL_INT_SAMPLER_2D: case GL_INT_SAMPLER_3D: case GL_INT_SAMPLER_CUBE:
+		case GL_INT_SAMPLER_1D_ARRAY: case GL_INT_SAMPLER_2D_ARRAY: case GL_INT_SAMPLER_CUBE_MAP_ARRAY:
+		case GL_INT_SAMPLER_2D_MULTISAMPLE: case GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY: case GL_INT_SAMPLER_BUFFER: case GL_INT_SAMPLER_2D_RECT:
+		case GL_UNSIGNED_INT_SAMPLER_1D: case GL_UNSIGNED_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_3D: case GL_UNSIGNED_INT_SAMPLER_CUBE:
+		case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY: case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY: case GL_UNSIGNED_INT_SAMPLER_CUBE_MAP_ARRAY:
+		case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE: case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY: case GL_UNSIGNED_INT_SAMPLER_BUFFER: case GL_UNSIGNED_INT_SAMPLER_2D_RECT:
+			return true;
+
+		default:
+			return false;
+		}
+	}
+
+	static bool IsImageType(GLenum type)
+	{
+		switch (type)
+		{
+		case GL_IMAGE_1D: case GL_IMAGE_2D: case GL_IMAGE_3D: case GL_IMAGE_CUBE: case GL_IMAGE_1D_ARRAY: case GL_IMAGE_2D_ARRAY: case GL_IMAGE_CUBE_MAP_ARRAY: case GL_IMAGE_BUFFER:
+		case GL_INT_IMAGE_1D: case GL_INT_IMAGE_2D: case GL_INT_IMAGE_3D: case GL_INT_IMAGE_CUBE: case GL_INT_IMAGE_1D_ARRAY: case GL_INT_IMAGE_2D_ARRAY: case GL_INT_IMAGE_CUBE_MAP_ARRAY: case GL_INT_IMAGE_BUFFER:
+		case GL_UNSIGNED_INT_IMAGE_1D: case GL_UNSIGNED_INT_IMAGE_2D: case GL_UNSIGNED_INT_IMAGE_3D: case GL_UNSIGNED_INT_IMAGE_CUBE:
+		case GL_UNSIGNED_INT_IMAGE_1D_ARRAY: case GL_UNSIGNED_INT_IMAGE_2D_ARRAY: case GL_UNSIGNED_INT_IMAGE_CUBE_MAP_ARRAY: case GL_UNSIGNED_INT_IMAGE_BUFFER:
+			return true;
+
+		default:
+			return false;
+		}
+	}
+
+	static GLbitfield GetMemoryBarrierBits(MemoryBarrierType barriers)
+	{
+		if (barriers == MemoryBarrierType::All)
+			return GL_ALL_BARRIER_BITS;
+
+		GLbitfield bits = 0;
+		if (HasMemoryBarrier(barriers, MemoryBarrierType::ShaderStorage))
+			bits |= GL_SHADER_STORAGE_BARRIER_BIT;
+		if (HasMemoryBarrier(barriers, MemoryBarrierType::Uniform))
+			bits |= GL_UNIFORM_BARRIER_BIT;
+		if (HasMemoryBarrier(barriers, MemoryBarrierType::VertexAttribute))
+			bits |= GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
+		if (HasMemoryBarrier(barriers, MemoryBarrierType::Index))
+			bits |= GL_ELEMENT_ARRAY_BARRIER_BIT;
+		if (HasMemoryBarrier(barriers, MemoryBarrierType::Command))
+			bits |= GL_COMMAND_BARRIER_BIT;
+		if (HasMemoryBarrier(barriers, MemoryBarrierType::BufferUpdate))
+			bits |= GL_BUFFER_UPDATE_BARRIER_BIT;
+		if (HasMemoryBarrier(barriers, MemoryBarrierType::TextureFetch))
+			bits |= GL_TEXTURE_FETCH_BARRIER_BIT;
+		if (HasMemoryBarrier(barriers, MemoryBarrierType::ShaderImage))
+			bits |= GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+		if (HasMemoryBarrier(barriers, MemoryBarrierType::Framebuffer))
+			bits |= GL_FRAMEBUFFER_BARRIER_BIT;
+
+		return bits;
+	}
+
+	static ShaderBlockMemberType GetShaderBlockMemberType(GLenum type)
+	{
+		switch (type)
+		{
+		case GL_FLOAT: return ShaderBlockMemberType::Scalar;
+		case GL_FLOAT_VEC2: return ShaderBlockMemberType::Vec2;
+		case GL_FLOAT_VEC3: return ShaderBlockMemberType::Vec3;
+		case GL_FLOAT_VEC4: return ShaderBlockMemberType::Vec4;
+		case GL_FLOAT_MAT3: return ShaderBlockMemberType::Mat3;
+		case GL_FLOAT_MAT4: return ShaderBlockMemberType::Mat4;
+		default: return ShaderBlockMemberType::Unsupported;
+		}
+	}
+
+	// Arrays are reported by their first element (ex: "Lights[0]"), but they are referenced by name only
+	static void StripArraySuffix(char* name)
+	{
+		char* bracket = strchr(name, '[');
+		if (bracket)
+			*bracket = '\0';
+	}
+
 	GLenum RendererGL::PrimitiveTypes[3] =
 	{
 		GL_POINTS,
@@ -39,6 +135,7 @@ namespace GaladHen
 		GL_RGBA8, // (int)TextureFormat::RGBA8
 		GL_SRGB8, // (int)TextureFormat::SRGB8
 		GL_SRGB8_ALPHA8, // (int)TextureFormat::SRGBA8
+		GL_RGBA16F, // (int)TextureFormat::RGBA16F
 	};
 
 	GLenum RendererGL::TextureChannelsAssociations[61] =
@@ -48,7 +145,8 @@ namespace GaladHen
 		GL_RGB, // (int)TextureFormat::RGB8
 		GL_RGBA, // (int)TextureFormat::RGBA8
 		GL_RGB, // (int)TextureFormat::SRGB8
-		GL_RGBA // (int)TextureFormat::SRGBA8
+		GL_RGBA, // (int)TextureFormat::SRGBA8
+		GL_RGBA // (int)TextureFormat::RGBA16F
 	};
 
 	GLenum RendererGL::PixelDataTypeAssociations[19] =
@@ -91,6 +189,7 @@ namespace GaladHen
 		GL_TEXTURE12,
 		GL_TEXTURE13,
 		GL_TEXTURE14,
+		GL_TEXTURE15,
 		GL_TEXTURE16,
 		GL_TEXTURE17,
 		GL_TEXTURE18,
@@ -109,6 +208,21 @@ namespace GaladHen
 		GL_TEXTURE31
 	};
 
+	GLenum RendererGL::ImageAccessAssociations[3]
+	{
+		GL_READ_ONLY,
+		GL_WRITE_ONLY,
+		GL_READ_WRITE
+	};
+
+	GLenum RendererGL::DepthFunctionAssociations[4]
+	{
+		GL_LESS,
+		GL_LEQUAL,
+		GL_EQUAL,
+		GL_ALWAYS
+	};
+
 	GLenum RendererGL::BufferTypesAssociations[14]
 	{
 		GL_UNIFORM_BUFFER,
@@ -141,9 +255,15 @@ namespace GaladHen
 	};
 
 	RendererGL::RendererGL()
-		: Window(nullptr)
+		: StreamBuffer()
+		, MultiDrawElementsIndirectCount(nullptr)
+		, StateCache()
+		, CallStats()
+		, Window(nullptr)
 		, ImGuiContext(nullptr)
-	{}
+	{
+		InvalidateStateCache();
+	}
 
 	void RendererGL::Init()
 	{
@@ -170,6 +290,24 @@ namespace GaladHen
 
 			return;
 		}
+
+		// the draw count read from a buffer is core from 4.6, before it is in ARB_indirect_parameters with its own entry point
+		GLint major = 0;
+		GLint minor = 0;
+		GLint extensionsNumber = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		glGetIntegerv(GL_NUM_EXTENSIONS, &extensionsNumber);
+		if (major > 4 || (major == 4 && minor >= 6))
+			MultiDrawElementsIndirectCount = glMultiDrawElementsIndirectCount;
+		for (GLint e = 0; e < extensionsNumber && !MultiDrawElementsIndirectCount; ++e)
+		{
+			if (strcmp((const char*)glGetStringi(GL_EXTENSIONS, e), "GL_ARB_indirect_parameters") == 0)
+				MultiDrawElementsIndirectCount = (PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTARBPROC)gl3wGetProcAddress("glMultiDrawElementsIndirectCountARB");
+		}
+
+		CreateStreamBuffer();
+		CreateGeometryArena();
 	}
 
 	void RendererGL::InitUI()
@@ -196,28 +334,41 @@ namespace GaladHen
 		{
 			Log::Error("RendererGL", "ImGui failed to setup backends for OpenGL and GLFW");
 		}
+
+		InvalidateStateCache();
 	}
 
-	unsigned int RendererGL::CreateRenderBuffer(unsigned int width, unsigned int height, TextureFormat format, bool enableDepth, bool clampDepthToBorder)
+	unsigned int RendererGL::CreateRenderBuffer(unsigned int width, unsigned int height, const TextureFormat* formats, unsigned int colorAttachments, bool enableDepth, bool clampDepthToBorder)
 	{
 		unsigned int id = RenderBuffers.AddWithId();
 		RenderBufferGL& rb = RenderBuffers.GetObjectWithId(id);
 
-		glGenFramebuffers(1, &rb.FrameBufferID);
-		glBindFramebuffer(GL_FRAMEBUFFER, rb.FrameBufferID);
+		glCreateFramebuffers(1, &rb.FrameBufferID);
+		rb.Layers = 0;
+		rb.AttachedLayer = 0;
+		rb.Size = glm::uvec2(width, height);
+		rb.ColorAttachments = std::min(colorAttachments, (unsigned int)GH_MAX_RENDER_BUFFER_ATTACHMENTS);
 
-		Texture texture{ nullptr, width, height, 0, format };
+		// fragment shader outputs are written to the attachments at their locations
+		GLenum drawBuffers[GH_MAX_RENDER_BUFFER_ATTACHMENTS];
+		for (unsigned int a = 0; a < rb.ColorAttachments; ++a)
+		{
+			Texture texture{ nullptr, width, height, 0, formats[a] };
 
-		rb.ColorTextureID = CreateTexture(texture, TextureAllocationType::Dynamic); // dynamic allocation for render buffers
-		TextureGL& colorTexture = Textures.GetObjectWithId(rb.ColorTextureID);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture.TextureID, 0);
+			rb.ColorTextureIDs[a] = CreateTexture(texture, TextureAllocationType::Dynamic); // dynamic allocation for render buffers
+			TextureGL& colorTexture = Textures.GetObjectWithId(rb.ColorTextureIDs[a]);
+			glNamedFramebufferTexture(rb.FrameBufferID, GL_COLOR_ATTACHMENT0 + a, colorTexture.TextureID, 0);
+			drawBuffers[a] = GL_COLOR_ATTACHMENT0 + a;
+		}
+		if (rb.ColorAttachments > 1)
+			glNamedFramebufferDrawBuffers(rb.FrameBufferID, rb.ColorAttachments, drawBuffers);
 
 		// Create and attach depth buffer, if requested
 		if (enableDepth)
 		{
 			rb.DepthTextureID = CreateDepthTexture(width, height, clampDepthToBorder);
 			TextureGL& depthTexture = Textures.GetObjectWithId(rb.DepthTextureID);
-			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture.TextureID, 0);
+			glNamedFramebufferTexture(rb.FrameBufferID, GL_DEPTH_ATTACHMENT, depthTexture.TextureID, 0);
 		}
 		else
 		{
@@ -225,43 +376,121 @@ namespace GaladHen
 		}
 
 		// Check status
-		glBindFramebuffer(GL_FRAMEBUFFER, rb.FrameBufferID);
-		GLenum result = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		GLenum result = glCheckNamedFramebufferStatus(rb.FrameBufferID, GL_FRAMEBUFFER);
 		if (result != GL_FRAMEBUFFER_COMPLETE)
 		{
 			Log::Error("RendererGL", "Framebuffer is not complete!\n");
 		}
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		return id;
+	}
+
+	unsigned int RendererGL::CreateDepthRenderBuffer(unsigned int width, unsigned int height, unsigned int layers, bool clampDepthToBorder)
+	{
+		unsigned int id = RenderBuffers.AddWithId();
+		RenderBufferGL& rb = RenderBuffers.GetObjectWithId(id);
+
+		glCreateFramebuffers(1, &rb.FrameBufferID);
+		rb.ColorAttachments = 0;
+		rb.Layers = std::max(layers, 1u);
+		rb.AttachedLayer = 0;
+		rb.Size = glm::uvec2(width, height);
+
+		rb.DepthTextureID = CreateDepthTexture(width, height, clampDepthToBorder, rb.Layers);
+		TextureGL& depthTexture = Textures.GetObjectWithId(rb.DepthTextureID);
+		glNamedFramebufferTextureLayer(rb.FrameBufferID, GL_DEPTH_ATTACHMENT, depthTexture.TextureID, 0, rb.AttachedLayer);
+
+		// no color is written nor read
+		glNamedFramebufferDrawBuffer(rb.FrameBufferID, GL_NONE);
+		glNamedFramebufferReadBuffer(rb.FrameBufferID, GL_NONE);
+
+		// Check status
+		GLenum result = glCheckNamedFramebufferStatus(rb.FrameBufferID, GL_FRAMEBUFFER);
+		if (result != GL_FRAMEBUFFER_COMPLETE)
+		{
+			Log::Error("RendererGL", "Framebuffer is not complete!\n");
+		}
 
 		return id;
 	}
 
+	void RendererGL::FreeRenderBuffer(unsigned int renderBufferID)
+	{
+		RenderBufferGL& rb = RenderBuffers.GetObjectWithId(renderBufferID);
+
+		if (StateCache.FrameBuffer == rb.FrameBufferID)
+			StateCache.FrameBuffer = GH_GL_UNKNOWN_BINDING;
+		glDeleteFramebuffers(1, &rb.FrameBufferID);
+
+		for (unsigned int a = 0; a < rb.ColorAttachments; ++a)
+			FreeTexture(rb.ColorTextureIDs[a]);
+		if (rb.DepthTextureID)
+			FreeTexture(rb.DepthTextureID);
+
+		RenderBuffers.RemoveWithId(renderBufferID);
+	}
+
+	void RendererGL::CopyRenderBufferDepth(unsigned int sourceRenderBufferID, unsigned int destinationRenderBufferID, unsigned int layer)
+	{
+		RenderBufferGL& source = RenderBuffers.GetObjectWithId(sourceRenderBufferID);
+		RenderBufferGL& destination = RenderBuffers.GetObjectWithId(destinationRenderBufferID);
+		if (!source.DepthTextureID || !destination.DepthTextureID)
+			return;
+
+		// copied between the textures, without binding the frame buffers
+		GLenum sourceTarget = source.Layers ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+		GLenum destinationTarget = destination.Layers ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+		glCopyImageSubData(Textures.GetObjectWithId(source.DepthTextureID).TextureID, sourceTarget, 0, 0, 0, source.Layers ? layer : 0,
+			Textures.GetObjectWithId(destination.DepthTextureID).TextureID, destinationTarget, 0, 0, 0, destination.Layers ? layer : 0,
+			std::min(source.Size.x, destination.Size.x), std::min(source.Size.y, destination.Size.y), 1);
+	}
+
 	void RendererGL::ClearRenderBuffer(unsigned int renderBufferID, glm::vec4 clearColor)
 	{
 		RenderBufferGL& rb = RenderBuffers.GetObjectWithId(renderBufferID);
-		TextureGL& colorTexture = Textures.GetObjectWithId(rb.ColorTextureID);
 
-		glBindTexture(GL_TEXTURE_2D, colorTexture.TextureID);
-		glClearColor(clearColor.x, clearColor.y, clearColor.z, clearColor.w);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		// cleared without binding it, the render buffer is bound right after to draw on it
+		for (unsigned int a = 0; a < rb.ColorAttachments; ++a)
+			glClearNamedFramebufferfv(rb.FrameBufferID, GL_COLOR, a, &clearColor.x);
+
+		if (rb.DepthTextureID)
+		{
+			const GLfloat clearDepth = 1.0f;
+			glClearNamedFramebufferfv(rb.FrameBufferID, GL_DEPTH, 0, &clearDepth);
+		}
+	}
+
+	void RendererGL::ClearRenderBufferDepth(unsigned int renderBufferID, const glm::uvec2& position, const glm::uvec2& size)
+	{
+		RenderBufferGL& rb = RenderBuffers.GetObjectWithId(renderBufferID);
+		if (!rb.DepthTextureID)
+			return;
 
-		glBindFramebuffer(GL_FRAMEBUFFER, rb.FrameBufferID);
-		GLbitfield mask = GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
-		glClear(mask);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		// clears are limited by the scissor box only
+		const GLfloat clearDepth = 1.0f;
+		glEnable(GL_SCISSOR_TEST);
+		glScissor(position.x, position.y, size.x, size.y);
+		glClearNamedFramebufferfv(rb.FrameBufferID, GL_DEPTH, 0, &clearDepth);
+		glDisable(GL_SCISSOR_TEST);
 	}
 
-	void RendererGL::BindRenderBuffer(unsigned int renderBufferID)
+	void RendererGL::BindRenderBuffer(unsigned int renderBufferID, unsigned int layer)
 	{
 		RenderBufferGL& rb = RenderBuffers.GetObjectWithId(renderBufferID);
-		glBindFramebuffer(GL_FRAMEBUFFER, rb.FrameBufferID);
+
+		// layers share the frame buffer, attached one at a time
+		if (rb.Layers && layer != rb.AttachedLayer && layer < rb.Layers)
+		{
+			glNamedFramebufferTextureLayer(rb.FrameBufferID, GL_DEPTH_ATTACHMENT, Textures.GetObjectWithId(rb.DepthTextureID).TextureID, 0, layer);
+			rb.AttachedLayer = layer;
+		}
+
+		BindFrameBuffer(rb.FrameBufferID);
 	}
 
 	void RendererGL::UnbindActiveRenderBuffer()
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		BindFrameBuffer(0);
 	}
 
 	void RendererGL::Draw(CommandBuffer<RenderCommand>& renderCommandBuffer)
@@ -276,39 +505,59 @@ namespace GaladHen
 				continue;
 
 			GLuint program = Shaders.GetObjectWithId(rc.ShaderSourceID);
-			glUseProgram(program);
+			UseProgram(program);
 
 			if (!rc.Material)
 				continue;
 
+			const ShaderReflectionGL& reflection = ShaderReflections[rc.ShaderSourceID - 1];
+			const ShaderParameterGL* parameter;
+
+			// value parameters packed into the material block are bound at once, the others are set one by one
+			if (reflection.MaterialBlockBinding != -1)
+			{
+				unsigned int blockID = GPUResourceInspector::GetResourceID(&rc.Material->GetParameterBlock());
+				if (blockID)
+				{
+					BufferGL& blockGL = Buffers.GetObjectWithId(blockID);
+					BindBufferRange(GL_UNIFORM_BUFFER, reflection.MaterialBlockBinding, blockGL.BufferID, 0, blockGL.BytesSize);
+				}
+			}
+
 			for (auto& scalar : rc.Material->ScalarData)
 			{
-				glProgramUniform1f(program, glGetUniformLocation(program, scalar.first.data()), scalar.second);
+				if ((parameter = GetShaderParameter(reflection, scalar.first.GetID())) && parameter->Location != -1)
+					glProgramUniform1f(program, parameter->Location, scalar.second);
 			}
 
 			for (auto& vec2 : rc.Material->Vec2Data)
 			{
-				glProgramUniform2f(program, glGetUniformLocation(program, vec2.first.data()), vec2.second.x, vec2.second.y);
+				if ((parameter = GetShaderParameter(reflection, vec2.first.GetID())) && parameter->Location != -1)
+					glProgramUniform2f(program, parameter->Location, vec2.second.x, vec2.second.y);
 			}
 
 			for (auto& vec3 : rc.Material->Vec3Data)
 			{
-				glProgramUniform3f(program, glGetUniformLocation(program, vec3.first.data()), vec3.second.x, vec3.second.y, vec3.second.z);
+				if ((parameter = GetShaderParameter(reflection, vec3.first.GetID())) && parameter->Location != -1)
+					glProgramUniform3f(program, parameter->Location, vec3.second.x, vec3.second.y, vec3.second.z);
 			}
 
 			for (auto& vec4 : rc.Material->Vec4Data)
 			{
-				glProgramUniform4f(program, glGetUniformLocation(program, vec4.first.data()), vec4.second.x, vec4.second.y, vec4.second.z, vec4.second.w);
+				if ((parameter = GetShaderParameter(reflection, vec4.first.GetID())) && parameter->Location != -1)
+					glProgramUniform4f(program, parameter->Location, vec4.second.x, vec4.second.y, vec4.second.z, vec4.second.w);
 			}
 
-			for (auto& mat3 : rc.Material->Mat4Data)
+			for (auto& mat3 : rc.Material->Mat3Data)
 			{
-				glProgramUniformMatrix3fv(program, glGetUniformLocation(program, mat3.first.data()), 1, GL_FALSE, (GLfloat*)&mat3.second);
+				if ((parameter = GetShaderParameter(reflection, mat3.first.GetID())) && parameter->Location != -1)
+					glProgramUniformMatrix3fv(program, parameter->Location, 1, GL_FALSE, (GLfloat*)&mat3.second);
 			}
 
 			for (auto& mat4 : rc.Material->Mat4Data)
 			{
-				glProgramUniformMatrix4fv(program, glGetUniformLocation(program, mat4.first.data()), 1, GL_FALSE, (GLfloat*)&mat4.second);
+				if ((parameter = GetShaderParameter(reflection, mat4.first.GetID())) && parameter->Location != -1)
+					glProgramUniformMatrix4fv(program, parameter->Location, 1, GL_FALSE, (GLfloat*)&mat4.second);
 			}
 
 			//for (ShaderIntegerData& data : rc.ShaderData.IntegerData)
@@ -316,21 +565,25 @@ namespace GaladHen
 			//	glProgramUniform1i(program, glGetUniformLocation(program, data.DataName.data()), data.Integer);
 			//}
 
-			for (auto& mat4Data : rc.AdditionalMat4Data)
+			for (unsigned int m = 0; m < rc.AdditionalMat4Data.Number; ++m)
 			{
-				glProgramUniformMatrix4fv(program, glGetUniformLocation(program, mat4Data.first.data()), 1, GL_FALSE, (GLfloat*)&mat4Data.second);
+				if ((parameter = GetShaderParameter(reflection, rc.AdditionalMat4Data.NameIDs[m])) && parameter->Location != -1)
+					glProgramUniformMatrix4fv(program, parameter->Location, 1, GL_FALSE, (GLfloat*)rc.AdditionalMat4Data.Values[m]);
 			}
 
-			unsigned int unit = 0;
+			// samplers have a fixed unit assigned after linking, only the texture needs to be bound
 			for (auto& texture : rc.Material->TextureData)
 			{
+				parameter = GetShaderParameter(reflection, texture.first.GetID());
+				if (!parameter || parameter->SamplerUnit == -1)
+					continue;
+
 				if (texture.second.expired())
 				{
 					// texture not valid
 					continue;
 				}
 
-				// select texture unit for the binded texture
 				std::shared_ptr<Texture> shTexture = texture.second.lock();
 				unsigned int textureID = GPUResourceInspector::GetResourceID(shTexture.get());
 				// we need to check id here, because texture is an external resource that can arrive as invalid here
@@ -338,36 +591,18 @@ namespace GaladHen
 					continue;
 
 				TextureGL& textureGL = Textures.GetObjectWithId(textureID);
-				glActiveTexture(TextureUnits[unit]);
-				glBindTexture(GL_TEXTURE_2D, textureGL.TextureID);
-				// create uniform sampler
-				int loc = glGetUniformLocation(program, texture.first.data());
-				glUniform1i(loc, unit);
-
-				++unit;
+				BindTextureUnit(parameter->SamplerUnit, textureGL.TextureID);
 			}
-			for (auto& renderBufferData : rc.AdditionalRenderBufferData)
+			for (unsigned int r = 0; r < rc.AdditionalRenderBufferData.Number; ++r)
 			{
-				if (renderBufferData.second == nullptr)
-				{
-					// render buffer not valid
-					continue;
-				}
-
-				unsigned int renderBufferID = GPUResourceInspector::GetResourceID(renderBufferData.second);
-				RenderBufferGL& renderBufferGL = RenderBuffers.GetObjectWithId(renderBufferID);
-				TextureGL& textureGL = Textures.GetObjectWithId(renderBufferGL.DepthTextureID);
-				glActiveTexture(TextureUnits[unit]);
-				glBindTexture(GL_TEXTURE_2D, textureGL.TextureID);
-				// create uniform sampler
-				int loc = glGetUniformLocation(program, renderBufferData.first.data());
-				glUniform1i(loc, unit);
-
-				++unit;
+				BindShaderRenderBuffer(reflection, rc.AdditionalRenderBufferData.NameIDs[r], rc.AdditionalRenderBufferData.Values[r]);
+			}
+			for (unsigned int a = 0; a < rc.AdditionalAttachmentData.Number; ++a)
+			{
+				BindShaderRenderBufferAttachment(reflection, rc.AdditionalAttachmentData.NameIDs[a], rc.AdditionalAttachmentData.Values[a]);
 			}
 
 			// Bind buffer data to shader pipeline
-			const GLenum props[] = { GL_BUFFER_BINDING };
 			for (auto& buffer : rc.Material->BufferData)
 			{
 				if (buffer.second.expired())
@@ -377,46 +612,99 @@ namespace GaladHen
 				}
 
 				std::shared_ptr<IBuffer> shBuffer = buffer.second.lock();
-				unsigned int bufferID = GPUResourceInspector::GetResourceID(shBuffer.get());
-				// we need to check id here, because buffer is an external resource that can arrive as invalid here
-				if (!bufferID)
+				BindShaderBuffer(reflection, buffer.first.GetID(), shBuffer.get());
+			}
+			for (unsigned int b = 0; b < rc.AdditionalBufferData.Number; ++b)
+			{
+				BindShaderBuffer(reflection, rc.AdditionalBufferData.NameIDs[b], rc.AdditionalBufferData.Values[b]);
+			}
+
+			// draw; all the meshes share the vertex array of the geometry arena, so it is bound once
+			BindVertexArray(GeometryArena.VAO);
+
+			// per-instance data of this draw starts from FirstInstance: the base instance offsets the instance index attribute (gl_InstanceID always starts from zero)
+			if (rc.InstanceIndices)
+			{
+				unsigned int instanceIndicesID = GPUResourceInspector::GetResourceID(rc.InstanceIndices);
+				if (!instanceIndicesID)
 					continue;
 
-				BufferGL& bufferGL = Buffers.GetObjectWithId(bufferID);
-				GLuint resourceIndex = glGetProgramResourceIndex(program, bufferGL.ResourceProgramInterface, buffer.first.data());
+				// streamed buffers live at an offset of the stream buffer
+				const BufferGL& instanceIndices = Buffers.GetObjectWithId(instanceIndicesID);
+				BindInstanceIndices(instanceIndices.BufferID, instanceIndices.Offset);
+			}
+			else if (!rc.Indirect.Arguments)
+			{
+				ReserveInstanceIdentity(rc.FirstInstance + rc.InstanceCount);
+				BindInstanceIndices(GeometryArena.InstanceIdentityBuffer, 0);
+			}
+
+			if (rc.OcclusionQueryID)
+				glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, OcclusionQueries.GetObjectWithId(rc.OcclusionQueryID));
 
-				if (resourceIndex != GL_INVALID_INDEX)
-				{
-					GLint bufferIndex;
-					glGetProgramResourceiv(program, bufferGL.ResourceProgramInterface, resourceIndex, 1, props, 1, NULL, &bufferIndex);
-					glBindBufferBase(bufferGL.Target, bufferIndex, bufferGL.BufferID);
-				}
+			if (rc.Indirect.Arguments)
+				DrawIndirect(mesh, rc.Indirect);
+			else
+				glDrawElementsInstancedBaseVertexBaseInstance(mesh.PrimitiveType, mesh.NumberOfIndices, GL_UNSIGNED_INT, (void*)(uintptr_t)(mesh.FirstIndex * sizeof(GLuint)), rc.InstanceCount, mesh.FirstVertex, rc.FirstInstance);
+
+			if (rc.OcclusionQueryID)
+				glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+		}
+	}
+
+	void RendererGL::Dispatch(CommandBuffer<ComputeCommand>& computeCommandBuffer)
+	{
+		for (ComputeCommand& cc : computeCommandBuffer)
+		{
+			if (!cc.ShaderSourceID)
+				continue;
+
+			GLuint program = Shaders.GetObjectWithId(cc.ShaderSourceID);
+			UseProgram(program);
+
+			const ShaderReflectionGL& reflection = ShaderReflections[cc.ShaderSourceID - 1];
+
+			// Bind buffer data to compute pipeline
+			for (unsigned int b = 0; b < cc.AdditionalBufferData.Number; ++b)
+			{
+				BindShaderBuffer(reflection, cc.AdditionalBufferData.NameIDs[b], cc.AdditionalBufferData.Values[b]);
 			}
-			for (auto& buffer : rc.AdditionalBufferData)
+			for (unsigned int r = 0; r < cc.AdditionalRenderBufferData.Number; ++r)
 			{
-				unsigned int bufferID = GPUResourceInspector::GetResourceID(buffer.second);
-				// we need to check id here, because buffer is an external resource that can arrive as invalid here
-				if (!bufferID)
-					continue;
+				BindShaderRenderBuffer(reflection, cc.AdditionalRenderBufferData.NameIDs[r], cc.AdditionalRenderBufferData.Values[r]);
+			}
+			for (unsigned int i = 0; i < cc.AdditionalImageData.Number; ++i)
+			{
+				BindShaderImage(reflection, cc.AdditionalImageData.NameIDs[i], cc.AdditionalImageData.Values[i]);
+			}
 
-				BufferGL& bufferGL = Buffers.GetObjectWithId(bufferID);
-				GLuint resourceIndex = glGetProgramResourceIndex(program, bufferGL.ResourceProgramInterface, buffer.first.data());
+			if (cc.IndirectArguments)
+			{
+				unsigned int argumentsID = GPUResourceInspector::GetResourceID(cc.IndirectArguments);
+				if (!argumentsID)
+					continue;
 
-				if (resourceIndex != GL_INVALID_INDEX)
-				{
-					GLint bufferIndex;
-					glGetProgramResourceiv(program, bufferGL.ResourceProgramInterface, resourceIndex, 1, props, 1, NULL, &bufferIndex);
-					glBindBufferBase(bufferGL.Target, bufferIndex, bufferGL.BufferID);
-				}
+				// streamed buffers live at an offset of the stream buffer
+				const BufferGL& arguments = Buffers.GetObjectWithId(argumentsID);
+				BindBuffer(GL_DISPATCH_INDIRECT_BUFFER, arguments.BufferID);
+				glDispatchComputeIndirect(arguments.Offset + (GLintptr)cc.IndirectOffset);
+			}
+			else
+			{
+				glDispatchCompute(cc.GroupCount.x, cc.GroupCount.y, cc.GroupCount.z);
 			}
 
-			// draw
-			glBindVertexArray(mesh.VAO);
-			glDrawElements(mesh.PrimitiveType, mesh.NumberOfIndices, GL_UNSIGNED_INT, 0);
-			glBindVertexArray(0);
+			if (cc.Barriers != MemoryBarrierType::None)
+				glMemoryBarrier(GetMemoryBarrierBits(cc.Barriers));
 		}
 	}
 
+	void RendererGL::InsertMemoryBarrier(MemoryBarrierType barriers)
+	{
+		if (barriers != MemoryBarrierType::None)
+			glMemoryBarrier(GetMemoryBarrierBits(barriers));
+	}
+
 	void RendererGL::TransferData(CommandBuffer<MemoryTransferCommand>& memoryCommandBuffer)
 	{
 		for (MemoryTransferCommand& mtc : memoryCommandBuffer)
@@ -537,6 +825,82 @@ namespace GaladHen
 		return success;
 	}
 
+	bool RendererGL::ReadBuffer(unsigned int bufferID, void* outData, size_t bytesSize)
+	{
+		BufferGL& bufferGL = Buffers.GetObjectWithId(bufferID);
+
+		if (bytesSize > bufferGL.BytesSize)
+		{
+			Log::Error("RendererGL", "Tried to read more bytes than the buffer size");
+			return false;
+		}
+
+		glGetNamedBufferSubData(bufferGL.BufferID, bufferGL.Offset, bytesSize, outData);
+
+		return true;
+	}
+
+	unsigned int RendererGL::CreateFence()
+	{
+		return Fences.AddWithId(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+	}
+
+	bool RendererGL::IsFenceSignaled(unsigned int fenceID, bool wait)
+	{
+		GLsync fence = Fences.GetObjectWithId(fenceID);
+
+		// flushing makes sure the fence is submitted, otherwise it could never be signaled
+		GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		while (wait && result == GL_TIMEOUT_EXPIRED)
+		{
+			result = glClientWaitSync(fence, 0, 1000000); // 1 ms
+		}
+
+		return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+	}
+
+	void RendererGL::FreeFence(unsigned int fenceID)
+	{
+		glDeleteSync(Fences.GetObjectWithId(fenceID));
+
+		Fences.RemoveWithId(fenceID);
+	}
+
+	unsigned int RendererGL::CreateOcclusionQuery()
+	{
+		GLuint query = 0;
+		glGenQueries(1, &query);
+
+		return OcclusionQueries.AddWithId(query);
+	}
+
+	bool RendererGL::GetOcclusionQueryResult(unsigned int queryID, bool wait, bool& outSamplesPassed)
+	{
+		GLuint query = OcclusionQueries.GetObjectWithId(queryID);
+
+		GLuint available = GL_FALSE;
+		if (!wait)
+		{
+			glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				return false;
+		}
+
+		GLuint samplesPassed = GL_FALSE;
+		glGetQueryObjectuiv(query, GL_QUERY_RESULT, &samplesPassed);
+		outSamplesPassed = samplesPassed != GL_FALSE;
+
+		return true;
+	}
+
+	void RendererGL::FreeOcclusionQuery(unsigned int queryID)
+	{
+		GLuint query = OcclusionQueries.GetObjectWithId(queryID);
+		glDeleteQueries(1, &query);
+
+		OcclusionQueries.RemoveWithId(queryID);
+	}
+
 	void RendererGL::EnableDepthTest(bool enable)
 	{
 		if (enable)
@@ -545,6 +909,22 @@ namespace GaladHen
 			glDisable(GL_DEPTH_TEST);
 	}
 
+	void RendererGL::EnableDepthWrite(bool enable)
+	{
+		glDepthMask(enable ? GL_TRUE : GL_FALSE);
+	}
+
+	void RendererGL::SetDepthFunction(DepthFunction function)
+	{
+		glDepthFunc(DepthFunctionAssociations[(int)function]);
+	}
+
+	void RendererGL::EnableColorWrite(bool enable)
+	{
+		GLboolean write = enable ? GL_TRUE : GL_FALSE;
+		glColorMask(write, write, write, write);
+	}
+
 	void RendererGL::EnableBackFaceCulling(bool enable)
 	{
 		glEnable(GL_CULL_FACE);
@@ -555,7 +935,10 @@ namespace GaladHen
 	unsigned int RendererGL::GetRenderBufferColorApiID(unsigned int renderBufferID)
 	{
 		RenderBufferGL& renderBuffer = RenderBuffers.GetObjectWithId(renderBufferID);
-		TextureGL& colorTexture = Textures.GetObjectWithId(renderBuffer.ColorTextureID);
+		if (!renderBuffer.ColorAttachments)
+			return 0;
+
+		TextureGL& colorTexture = Textures.GetObjectWithId(renderBuffer.ColorTextureIDs[0]);
 		return colorTexture.TextureID;
 	}
 
@@ -564,6 +947,53 @@ namespace GaladHen
 		glViewport(position.x, position.y, size.x, size.y);
 	}
 
+	void RendererGL::EndFrame()
+	{
+		// a region never written by the frame can be kept by the next one
+		if (!StreamBuffer.FrameReady)
+			return;
+
+		StreamBuffer.FrameFences[StreamBuffer.Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		StreamBuffer.Frame = (StreamBuffer.Frame + 1) % GH_GL_STREAM_FRAMES;
+		StreamBuffer.FrameReady = false;
+	}
+
+	MeshDrawRange RendererGL::GetMeshDrawRange(unsigned int meshID)
+	{
+		MeshGL& mesh = Meshes.GetObjectWithId(meshID);
+
+		return MeshDrawRange{ mesh.NumberOfIndices, mesh.FirstIndex, (int)mesh.FirstVertex };
+	}
+
+	bool RendererGL::SupportsIndirectDrawCount() const
+	{
+		return MultiDrawElementsIndirectCount != nullptr;
+	}
+
+	GeometryMemoryStats RendererGL::GetGeometryMemoryStats() const
+	{
+		GeometryMemoryStats stats{};
+		stats.Meshes = GeometryArena.Vertices.GetAllocationsNumber();
+		stats.BufferAllocations = GeometryArena.BufferAllocations;
+		stats.FreeRanges = GeometryArena.Vertices.GetFreeRangesNumber() + GeometryArena.Indices.GetFreeRangesNumber();
+		stats.VertexBytesUsed = GeometryArena.Vertices.GetUsedSize() * sizeof(MeshVertexData);
+		stats.VertexBytesCapacity = GeometryArena.Vertices.GetCapacity() * sizeof(MeshVertexData);
+		stats.IndexBytesUsed = GeometryArena.Indices.GetUsedSize() * sizeof(GLuint);
+		stats.IndexBytesCapacity = GeometryArena.Indices.GetCapacity() * sizeof(GLuint);
+
+		return stats;
+	}
+
+	const StateCallStats& RendererGL::GetStateCallStats() const
+	{
+		return CallStats;
+	}
+
+	void RendererGL::ResetStateCallStats()
+	{
+		CallStats = StateCallStats{};
+	}
+
 	void RendererGL::CreateRenderingWindow(const char* name, glm::uvec2 size)
 	{
 		if (Window)
@@ -606,12 +1036,17 @@ namespace GaladHen
 	{
 		ImGui::Render();
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+		// ImGui binds its own objects
+		InvalidateStateCache();
 	}
 
 	RendererGL::~RendererGL()
 	{
 		// TODO
 
+		FreeStreamBuffer();
+
 		QuitUI();
 	}
 
@@ -619,34 +1054,39 @@ namespace GaladHen
 	{
 		unsigned int id = Textures.AddWithId();
 		TextureGL& textureGL = Textures.GetObjectWithId(id);
-
-		// create new texture object
-		glGenTextures(1, &textureGL.TextureID);
+		textureGL.TextureID = 0; // the texture object is created when loading
 
 		LoadTexture(id, texture, allocationType);
 
 		return id;
 	}
 
-	unsigned int RendererGL::CreateDepthTexture(unsigned int width, unsigned int height, bool clampToBorder)
+	unsigned int RendererGL::CreateDepthTexture(unsigned int width, unsigned int height, bool clampToBorder, unsigned int layers)
 	{
 		unsigned int id = Textures.AddWithId();
 		TextureGL& texture = Textures.GetObjectWithId(id);
 
-		glGenTextures(1, &texture.TextureID);
-		glBindTexture(GL_TEXTURE_2D, texture.TextureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, width, height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		if (layers)
+		{
+			glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &texture.TextureID);
+			glTextureStorage3D(texture.TextureID, 1, GL_DEPTH_COMPONENT24, width, height, layers);
+		}
+		else
+		{
+			glCreateTextures(GL_TEXTURE_2D, 1, &texture.TextureID);
+			glTextureStorage2D(texture.TextureID, 1, GL_DEPTH_COMPONENT24, width, height);
+		}
+		glTextureParameteri(texture.TextureID, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTextureParameteri(texture.TextureID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
 		if (clampToBorder)
 		{
 			// Clamp the border and manually set maximum depth (1.0) on the border itself
 			// This way we can avoid some shadow specific problems
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+			glTextureParameteri(texture.TextureID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+			glTextureParameteri(texture.TextureID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
 			float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-			glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+			glTextureParameterfv(texture.TextureID, GL_TEXTURE_BORDER_COLOR, borderColor);
 		}
 
 		return id;
@@ -656,6 +1096,7 @@ namespace GaladHen
 	{
 		TextureGL& texture = Textures.GetObjectWithId(textureID);
 
+		ForgetTexture(texture.TextureID);
 		glDeleteTextures(1, &texture.TextureID);
 
 		Textures.RemoveWithId(textureID);
@@ -673,24 +1114,29 @@ namespace GaladHen
 		textureGL.TextureChannels = TextureChannelsAssociations[(int)texture.GetFormat()];
 		textureGL.PixelDataType = PixelDataTypeAssociations[0];
 
-		// bind new texture object to texture target
-		glBindTexture(GL_TEXTURE_2D, textureGL.TextureID);
+		// immutable storage can't be reallocated: a reloaded texture gets a new texture object
+		if (textureGL.TextureID)
+		{
+			ForgetTexture(textureGL.TextureID);
+			glDeleteTextures(1, &textureGL.TextureID);
+		}
+		glCreateTextures(GL_TEXTURE_2D, 1, &textureGL.TextureID);
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, textureGL.Wrapping);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, textureGL.Wrapping);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, textureGL.Filtering);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, textureGL.Filtering);
+		glTextureParameteri(textureGL.TextureID, GL_TEXTURE_WRAP_S, textureGL.Wrapping);
+		glTextureParameteri(textureGL.TextureID, GL_TEXTURE_WRAP_T, textureGL.Wrapping);
+		glTextureParameteri(textureGL.TextureID, GL_TEXTURE_MIN_FILTER, textureGL.Filtering);
+		glTextureParameteri(textureGL.TextureID, GL_TEXTURE_MAG_FILTER, textureGL.Filtering);
 
 		switch (allocationType)
 		{
 		case TextureAllocationType::Dynamic:
 		{
-			textureGL.Levels = texture.GetNumberOfMipMaps();
+			// base level only: dynamic textures are render targets, whose content is written by the gpu
+			textureGL.Levels = 1;
 
 			glm::uvec2 textureSize;
 			texture.GetSize(textureSize);
-			unsigned char* data = texture.GetData();
-			glTexImage2D(GL_TEXTURE_2D, textureGL.Levels, textureGL.TextureFormat, textureSize.x, textureSize.y, 0, textureGL.TextureChannels, textureGL.PixelDataType, data);
+			glTextureStorage2D(textureGL.TextureID, textureGL.Levels, textureGL.TextureFormat, textureSize.x, textureSize.y);
 			
 			if (glGetError() != GL_NO_ERROR)
 			{
@@ -699,6 +1145,10 @@ namespace GaladHen
 				return;
 			}
 
+			unsigned char* data = texture.GetData();
+			if (data)
+				glTextureSubImage2D(textureGL.TextureID, 0, 0, 0, textureSize.x, textureSize.y, textureGL.TextureChannels, textureGL.PixelDataType, data);
+
 			break;
 		}
 		case TextureAllocationType::Constant:
@@ -710,7 +1160,7 @@ namespace GaladHen
 			// levels are the number of mipmaps
 			glm::uvec2 textureSize;
 			texture.GetSize(textureSize);
-			glTexStorage2D(GL_TEXTURE_2D, textureGL.Levels, textureGL.TextureFormat, textureSize.x, textureSize.y);
+			glTextureStorage2D(textureGL.TextureID, textureGL.Levels, textureGL.TextureFormat, textureSize.x, textureSize.y);
 
 			if (glGetError() != GL_NO_ERROR)
 			{
@@ -721,7 +1171,7 @@ namespace GaladHen
 
 			// copy texture data to texture object
 			unsigned char* data = texture.GetData();
-			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, textureSize.x, textureSize.y, textureGL.TextureChannels, textureGL.PixelDataType, data);
+			glTextureSubImage2D(textureGL.TextureID, 0, 0, 0, textureSize.x, textureSize.y, textureGL.TextureChannels, textureGL.PixelDataType, data);
 		}
 		default:
 			break;
@@ -735,11 +1185,8 @@ namespace GaladHen
 	{
 		unsigned int id = Meshes.AddWithId();
 		MeshGL& meshGL = Meshes.GetObjectWithId(id);
-
-		// we create the buffers
-		glGenVertexArrays(1, &meshGL.VAO);
-		glGenBuffers(1, &meshGL.VBO);
-		glGenBuffers(1, &meshGL.EBO);
+		meshGL.NumberOfVertices = 0;
+		meshGL.NumberOfIndices = 0;
 
 		LoadMesh(id, mesh);
 
@@ -749,83 +1196,214 @@ namespace GaladHen
 	void RendererGL::LoadMesh(unsigned int meshID, const Mesh& mesh)
 	{
 		MeshGL& meshGL = Meshes.GetObjectWithId(meshID);
-		
-		// Copy mesh data to opengl mesh data
-		meshGL.NumberOfIndices = mesh.GetIndices().size();
+
+		// same sizes are written in place, otherwise the mesh moves to new ranges
+		unsigned int verticesNumber = (unsigned int)mesh.GetVertices().size();
+		unsigned int indicesNumber = (unsigned int)mesh.GetIndices().size();
+		if (meshGL.NumberOfVertices != verticesNumber || meshGL.NumberOfIndices != indicesNumber)
+		{
+			FreeGeometry(meshGL);
+			AllocateGeometry(meshGL, verticesNumber, indicesNumber);
+		}
+
 		meshGL.PrimitiveType = PrimitiveTypes[(int)mesh.GetPrimitive()];
 
-		// VAO is made "active"
-		glBindVertexArray(meshGL.VAO);
-		// we copy data in the VBO - we must set the data dimension, and the pointer to the structure cointaining the data
-		glBindBuffer(GL_ARRAY_BUFFER, meshGL.VBO);
-		glBufferData(GL_ARRAY_BUFFER, mesh.GetVertices().size() * sizeof(MeshVertexData), &mesh.GetVertices()[0], GL_STATIC_DRAW);
-		// we copy data in the EBO - we must set the data dimension, and the pointer to the structure cointaining the data
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshGL.EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.GetIndices().size() * sizeof(GLuint), &mesh.GetIndices()[0], GL_STATIC_DRAW);
-
-		// we set in the VAO the pointers to the different vertex attributes (with the relative offsets inside the data structure)
-		// vertex positions
-		// these will be the positions to use in the layout qualifiers in the shaders ("layout (location = ...)"")
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertexData), (GLvoid*)0);
-		// Normals
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertexData), (GLvoid*)offsetof(MeshVertexData, Normal));
-		// Texture Coordinates
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertexData), (GLvoid*)offsetof(MeshVertexData, UV));
-		// Tangent
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertexData), (GLvoid*)offsetof(MeshVertexData, Tangent));
-		// Bitangent
-		glEnableVertexAttribArray(4);
-		glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertexData), (GLvoid*)offsetof(MeshVertexData, Bitangent));
-		// Vertex color
-		glEnableVertexAttribArray(5);
-		glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(MeshVertexData), (GLvoid*)offsetof(MeshVertexData, Color));
-
-		glBindVertexArray(0);
+		if (verticesNumber > 0)
+			glNamedBufferSubData(GeometryArena.VBO, meshGL.FirstVertex * sizeof(MeshVertexData), verticesNumber * sizeof(MeshVertexData), &mesh.GetVertices()[0]);
+		if (indicesNumber > 0)
+			glNamedBufferSubData(GeometryArena.EBO, meshGL.FirstIndex * sizeof(GLuint), indicesNumber * sizeof(GLuint), &mesh.GetIndices()[0]);
 	}
 
 	void RendererGL::FreeMesh(unsigned int meshID)
 	{
-		MeshGL& mesh = Meshes.GetObjectWithId(meshID);
-
-		glDeleteVertexArrays(1, &mesh.VAO);
-		glDeleteBuffers(1, &mesh.VBO);
-		glDeleteBuffers(1, &mesh.EBO);
+		FreeGeometry(Meshes.GetObjectWithId(meshID));
 
 		Meshes.RemoveWithId(meshID);
 	}
 
-	unsigned int RendererGL::CreateShaderPipeline(CompileCommand& compileCommand)
+	void RendererGL::CreateGeometryArena()
 	{
-		unsigned int id = Shaders.AddWithId();
-		
-		CompileShaderPipeline(id, compileCommand);
+		glCreateBuffers(1, &GeometryArena.VBO);
+		glNamedBufferStorage(GeometryArena.VBO, GeometryArena.Vertices.GetCapacity() * sizeof(MeshVertexData), nullptr, GL_DYNAMIC_STORAGE_BIT);
+		glCreateBuffers(1, &GeometryArena.EBO);
+		glNamedBufferStorage(GeometryArena.EBO, GeometryArena.Indices.GetCapacity() * sizeof(GLuint), nullptr, GL_DYNAMIC_STORAGE_BIT);
+		GeometryArena.BufferAllocations += 2;
+
+		// the vertex format never changes, so it is set once: meshes only write their ranges of the buffers
+		glCreateVertexArrays(1, &GeometryArena.VAO);
+		glVertexArrayVertexBuffer(GeometryArena.VAO, 0, GeometryArena.VBO, 0, sizeof(MeshVertexData));
+		glVertexArrayElementBuffer(GeometryArena.VAO, GeometryArena.EBO);
+
+		// we set in the VAO the format of the different vertex attributes (with the relative offsets inside the data structure)
+		// these will be the positions to use in the layout qualifiers in the shaders ("layout (location = ...)"")
+		struct VertexAttributeFormat
+		{
+			GLint Size;
+			GLuint Offset;
+		};
+		const VertexAttributeFormat attributes[] =
+		{
+			{ 3, 0 }, // vertex positions
+			{ 3, offsetof(MeshVertexData, Normal) },
+			{ 2, offsetof(MeshVertexData, UV) }, // Texture Coordinates
+			{ 3, offsetof(MeshVertexData, Tangent) },
+			{ 3, offsetof(MeshVertexData, Bitangent) },
+			{ 4, offsetof(MeshVertexData, Color) } // Vertex color
+		};
+		for (GLuint a = 0; a < sizeof(attributes) / sizeof(VertexAttributeFormat); ++a)
+		{
+			glEnableVertexArrayAttrib(GeometryArena.VAO, a);
+			glVertexArrayAttribFormat(GeometryArena.VAO, a, attributes[a].Size, GL_FLOAT, GL_FALSE, attributes[a].Offset);
+			glVertexArrayAttribBinding(GeometryArena.VAO, a, 0);
+		}
 
-		return id;
+		// the instance index advances once per instance, starting from the base instance of the draw
+		glEnableVertexArrayAttrib(GeometryArena.VAO, GH_INSTANCE_INDEX_ATTRIBUTE_LOCATION);
+		glVertexArrayAttribIFormat(GeometryArena.VAO, GH_INSTANCE_INDEX_ATTRIBUTE_LOCATION, 1, GL_UNSIGNED_INT, 0);
+		glVertexArrayAttribBinding(GeometryArena.VAO, GH_INSTANCE_INDEX_ATTRIBUTE_LOCATION, 1);
+		glVertexArrayBindingDivisor(GeometryArena.VAO, 1, 1);
 	}
 
-	bool RendererGL::CompileShaderPipeline(unsigned int shaderID, CompileCommand& compileCommand)
+	void RendererGL::AllocateGeometry(MeshGL& meshGL, unsigned int verticesNumber, unsigned int indicesNumber)
 	{
-		// Compilation results
-		char log[1000];
-		compileCommand.Result.Succeed = true;
+		size_t firstVertex = 0;
+		size_t firstIndex = 0;
 
-		GLuint& program = Shaders.GetObjectWithId(shaderID);
+		if (verticesNumber > 0)
+		{
+			while (!GeometryArena.Vertices.Allocate(verticesNumber, firstVertex))
+			{
+				size_t capacity = GeometryArena.Vertices.GetCapacity();
+				GrowGeometryBuffer(GeometryArena.VBO, capacity * sizeof(MeshVertexData), std::max(capacity * 2, capacity + verticesNumber) * sizeof(MeshVertexData));
+				GeometryArena.Vertices.Grow(std::max(capacity * 2, capacity + verticesNumber));
+				glVertexArrayVertexBuffer(GeometryArena.VAO, 0, GeometryArena.VBO, 0, sizeof(MeshVertexData));
+			}
+		}
 
-		const char* vCode = compileCommand.VertexCode.c_str();
-		const char* tcCode = compileCommand.TessContCode.c_str();
-		const char* teCode = compileCommand.TessEvalCode.c_str();
-		const char* gCode = compileCommand.GeometryCode.c_str();
-		const char* fCode = compileCommand.FragmentCode.c_str();
+		if (indicesNumber > 0)
+		{
+			while (!GeometryArena.Indices.Allocate(indicesNumber, firstIndex))
+			{
+				size_t capacity = GeometryArena.Indices.GetCapacity();
+				GrowGeometryBuffer(GeometryArena.EBO, capacity * sizeof(GLuint), std::max(capacity * 2, capacity + indicesNumber) * sizeof(GLuint));
+				GeometryArena.Indices.Grow(std::max(capacity * 2, capacity + indicesNumber));
+				glVertexArrayElementBuffer(GeometryArena.VAO, GeometryArena.EBO);
+			}
+		}
+
+		meshGL.FirstVertex = (unsigned int)firstVertex;
+		meshGL.NumberOfVertices = verticesNumber;
+		meshGL.FirstIndex = (unsigned int)firstIndex;
+		meshGL.NumberOfIndices = indicesNumber;
+	}
+
+	void RendererGL::FreeGeometry(MeshGL& meshGL)
+	{
+		GeometryArena.Vertices.Free(meshGL.FirstVertex, meshGL.NumberOfVertices);
+		GeometryArena.Indices.Free(meshGL.FirstIndex, meshGL.NumberOfIndices);
+
+		meshGL.NumberOfVertices = 0;
+		meshGL.NumberOfIndices = 0;
+	}
+
+	void RendererGL::GrowGeometryBuffer(GLuint& buffer, size_t previousBytes, size_t bytes)
+	{
+		GLuint grownBuffer;
+		glCreateBuffers(1, &grownBuffer);
+		glNamedBufferStorage(grownBuffer, bytes, nullptr, GL_DYNAMIC_STORAGE_BIT);
+		glCopyNamedBufferSubData(buffer, grownBuffer, 0, 0, previousBytes);
+
+		ForgetBuffer(buffer);
+		glDeleteBuffers(1, &buffer);
+		buffer = grownBuffer;
+		++GeometryArena.BufferAllocations;
+	}
+
+	void RendererGL::ReserveInstanceIdentity(unsigned int instancesNumber)
+	{
+		if (instancesNumber <= GeometryArena.InstanceIdentityCapacity)
+			return;
+
+		if (GeometryArena.InstanceIdentityBuffer)
+		{
+			ForgetBuffer(GeometryArena.InstanceIdentityBuffer);
+			glDeleteBuffers(1, &GeometryArena.InstanceIdentityBuffer);
+		}
+
+		GeometryArena.InstanceIdentityCapacity = std::max(GeometryArena.InstanceIdentityCapacity * 2, instancesNumber);
+
+		// written once through a mapping, it never changes afterwards
+		GLsizeiptr bytes = GeometryArena.InstanceIdentityCapacity * sizeof(GLuint);
+		glCreateBuffers(1, &GeometryArena.InstanceIdentityBuffer);
+		glNamedBufferStorage(GeometryArena.InstanceIdentityBuffer, bytes, nullptr, GL_MAP_WRITE_BIT);
+		GLuint* identity = static_cast<GLuint*>(glMapNamedBufferRange(GeometryArena.InstanceIdentityBuffer, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+		if (identity)
+		{
+			for (GLuint i = 0; i < GeometryArena.InstanceIdentityCapacity; ++i)
+				identity[i] = i;
+
+			glUnmapNamedBuffer(GeometryArena.InstanceIdentityBuffer);
+		}
+	}
+
+	void RendererGL::DrawIndirect(const MeshGL& mesh, const IndirectDrawData& indirect)
+	{
+		if (!MultiDrawElementsIndirectCount)
+		{
+			Log::Error("RendererGL", "Indirect draws with a draw count are not supported by the context");
+			return;
+		}
+
+		unsigned int argumentsID = GPUResourceInspector::GetResourceID(indirect.Arguments);
+		unsigned int countID = GPUResourceInspector::GetResourceID(indirect.Count);
+		if (!argumentsID || !countID)
+			return;
+
+		// streamed buffers live at an offset of the stream buffer
+		const BufferGL& arguments = Buffers.GetObjectWithId(argumentsID);
+		const BufferGL& count = Buffers.GetObjectWithId(countID);
+
+		BindBuffer(GL_DRAW_INDIRECT_BUFFER, arguments.BufferID);
+		BindBuffer(GL_PARAMETER_BUFFER, count.BufferID);
+
+		MultiDrawElementsIndirectCount(mesh.PrimitiveType, GL_UNSIGNED_INT, (void*)(uintptr_t)(arguments.Offset + indirect.FirstArguments * sizeof(DrawCommandBufferData)),
+			count.Offset + (GLintptr)indirect.CountOffset, indirect.MaxDraws, sizeof(DrawCommandBufferData));
+	}
+
+	unsigned int RendererGL::CreateShaderPipeline(CompileCommand& compileCommand)
+	{
+		unsigned int id = Shaders.AddWithId();
+		
+		CompileShaderPipeline(id, compileCommand);
+
+		return id;
+	}
+
+	bool RendererGL::CompileShaderPipeline(unsigned int shaderID, CompileCommand& compileCommand)
+	{
+		// Compilation results
+		char log[1000];
+		compileCommand.Result.Succeed = true;
+
+		GLuint& program = Shaders.GetObjectWithId(shaderID);
+
+		// a pipeline that fails to link has no active parameters
+		if (ShaderReflections.size() < shaderID)
+			ShaderReflections.resize(shaderID);
+		ShaderReflections[shaderID - 1] = ShaderReflectionGL{};
+
+		const char* vCode = compileCommand.VertexCode.c_str();
+		const char* tcCode = compileCommand.TessContCode.c_str();
+		const char* teCode = compileCommand.TessEvalCode.c_str();
+		const char* gCode = compileCommand.GeometryCode.c_str();
+		const char* fCode = compileCommand.FragmentCode.c_str();
+		const char* cCode = compileCommand.ComputeCode.c_str();
 
 		// shader program creation
 		program = glCreateProgram();
 
 		// compile the shaders
-		GLuint vShader, tcShader, teShader, gShader, fShader;
+		GLuint vShader = 0, tcShader = 0, teShader = 0, gShader = 0, fShader = 0, cShader = 0;
 
 		// Vertex Shader
 		if (compileCommand.VertexCode.length() > 0)
@@ -932,6 +1510,27 @@ namespace GaladHen
 			glAttachShader(program, fShader);
 		}
 
+		// Compute Shader
+		if (compileCommand.ComputeCode.length() > 0)
+		{
+			cShader = glCreateShader(GL_COMPUTE_SHADER);
+			glShaderSource(cShader, 1, &cCode, NULL);
+			glCompileShader(cShader);
+
+			// check compilation errors
+			if (!CheckShaderPipelineCompilation(cShader, log, 1000))
+			{
+				std::string error = "[ERROR] Compilation error in compute shader: ";
+				error.append(log);
+				error.append("\n");
+
+				compileCommand.Result.Succeed = false;
+				compileCommand.Result.Description.append(error);
+			}
+
+			glAttachShader(program, cShader);
+		}
+
 		// link
 		glLinkProgram(program);
 
@@ -945,6 +1544,10 @@ namespace GaladHen
 			compileCommand.Result.Succeed = false;
 			compileCommand.Result.Description.append(error);
 		}
+		else
+		{
+			ReflectShaderPipeline(shaderID);
+		}
 
 		// delete the shaders because they are linked to the Shader Program, and we do not need them anymore
 		if (compileCommand.VertexCode.length() > 0)
@@ -967,6 +1570,10 @@ namespace GaladHen
 		{
 			glDeleteShader(fShader);
 		}
+		if (compileCommand.ComputeCode.length() > 0)
+		{
+			glDeleteShader(cShader);
+		}
 
 		return compileCommand.Result.Succeed;
 	}
@@ -999,11 +1606,396 @@ namespace GaladHen
 
 	void RendererGL::FreeShaderPipeline(unsigned int shaderID)
 	{
+		ForgetProgram(Shaders.GetObjectWithId(shaderID));
 		glDeleteProgram(Shaders.GetObjectWithId(shaderID));
 
+		ShaderReflections[shaderID - 1] = ShaderReflectionGL{};
+
 		Shaders.RemoveWithId(shaderID);
 	}
 
+	void RendererGL::ReflectShaderPipeline(unsigned int shaderID)
+	{
+		GLuint program = Shaders.GetObjectWithId(shaderID);
+		ShaderReflectionGL& reflection = ShaderReflections[shaderID - 1];
+
+		char name[GH_SHADER_PARAMETER_NAME_MAX_LENGTH];
+
+		auto addParameter = [&reflection](const char* parameterName) -> ShaderParameterGL&
+		{
+			unsigned int id = ShaderParameterName::Register(parameterName);
+			if (reflection.Parameters.size() <= id)
+				reflection.Parameters.resize(id + 1, ShaderParameterGL{ -1, -1, -1, -1, -1 });
+
+			return reflection.Parameters[id];
+		};
+
+		// Material block, whose layout is used to pack material parameters
+		GLuint materialBlockIndex = glGetProgramResourceIndex(program, GL_UNIFORM_BLOCK, GH_MATERIAL_BLOCK_NAME);
+		if (materialBlockIndex != GL_INVALID_INDEX)
+		{
+			const GLenum materialBlockProps[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+			GLint values[2];
+			glGetProgramResourceiv(program, GL_UNIFORM_BLOCK, materialBlockIndex, 2, materialBlockProps, 2, NULL, values);
+
+			reflection.MaterialBlockBinding = values[0];
+			reflection.MaterialBlock.BytesSize = (size_t)values[1];
+		}
+
+		// Default block uniforms (members of uniform blocks are bound through their block)
+		GLint uniformsNumber = 0;
+		glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniformsNumber);
+
+		const GLenum uniformProps[] = { GL_BLOCK_INDEX, GL_TYPE, GL_LOCATION, GL_ARRAY_SIZE, GL_OFFSET, GL_MATRIX_STRIDE };
+		GLint samplerUnit = 0;
+		for (GLint i = 0; i < uniformsNumber; ++i)
+		{
+			GLint values[6];
+			glGetProgramResourceiv(program, GL_UNIFORM, i, 6, uniformProps, 6, NULL, values);
+
+			if (materialBlockIndex != GL_INVALID_INDEX && values[0] == (GLint)materialBlockIndex)
+			{
+				glGetProgramResourceName(program, GL_UNIFORM, i, GH_SHADER_PARAMETER_NAME_MAX_LENGTH, NULL, name);
+				StripArraySuffix(name);
+
+				ShaderBlockMemberType type = GetShaderBlockMemberType(values[1]);
+				if (type == ShaderBlockMemberType::Unsupported)
+				{
+					Log::Warning("RendererGL", std::string("Unsupported type of material block member ") + name);
+					continue;
+				}
+
+				reflection.MaterialBlock.Members.push_back(ShaderBlockMember{ ShaderParameterName{ name }, type, (unsigned int)values[4], (unsigned int)values[5] });
+				continue;
+			}
+
+			if (values[0] != -1 || values[2] == -1)
+				continue;
+
+			glGetProgramResourceName(program, GL_UNIFORM, i, GH_SHADER_PARAMETER_NAME_MAX_LENGTH, NULL, name);
+			StripArraySuffix(name);
+
+			ShaderParameterGL& parameter = addParameter(name);
+			parameter.Location = values[2];
+
+			if (IsSamplerType(values[1]))
+			{
+				// Samplers get a fixed texture unit, so that draws only need to bind the textures
+				if (samplerUnit + values[3] > (GLint)(sizeof(TextureUnits) / sizeof(GLenum)))
+				{
+					Log::Error("RendererGL", std::string("Too many samplers in shader pipeline, ignoring ") + name);
+					continue;
+				}
+
+				parameter.SamplerUnit = samplerUnit;
+				for (GLint e = 0; e < values[3]; ++e)
+					glProgramUniform1i(program, values[2] + e, samplerUnit + e);
+
+				samplerUnit += values[3];
+			}
+			else if (IsImageType(values[1]))
+			{
+				// Images keep the unit of their binding layout, bound by the dispatches
+				glGetUniformiv(program, values[2], &parameter.ImageUnit);
+			}
+		}
+
+		// Uniform and shader storage blocks
+		const GLenum blockProps[] = { GL_BUFFER_BINDING };
+		const GLenum blockInterfaces[] = { GL_UNIFORM_BLOCK, GL_SHADER_STORAGE_BLOCK };
+		for (GLenum blockInterface : blockInterfaces)
+		{
+			GLint blocksNumber = 0;
+			glGetProgramInterfaceiv(program, blockInterface, GL_ACTIVE_RESOURCES, &blocksNumber);
+
+			for (GLint i = 0; i < blocksNumber; ++i)
+			{
+				GLint binding;
+				glGetProgramResourceiv(program, blockInterface, i, 1, blockProps, 1, NULL, &binding);
+
+				glGetProgramResourceName(program, blockInterface, i, GH_SHADER_PARAMETER_NAME_MAX_LENGTH, NULL, name);
+				StripArraySuffix(name);
+
+				ShaderParameterGL& parameter = addParameter(name);
+				if (blockInterface == GL_UNIFORM_BLOCK)
+					parameter.UniformBlockBinding = binding;
+				else
+					parameter.StorageBlockBinding = binding;
+			}
+		}
+
+	}
+
+	const ShaderBlockLayout* RendererGL::GetMaterialBlockLayout(unsigned int shaderID)
+	{
+		if (shaderID == 0 || shaderID > ShaderReflections.size())
+			return nullptr;
+
+		const ShaderReflectionGL& reflection = ShaderReflections[shaderID - 1];
+		return reflection.MaterialBlockBinding != -1 ? &reflection.MaterialBlock : nullptr;
+	}
+
+	const RendererGL::ShaderParameterGL* RendererGL::GetShaderParameter(const ShaderReflectionGL& reflection, unsigned int nameID) const
+	{
+		// names registered after the reflection are not active in the program
+		return nameID < reflection.Parameters.size() ? &reflection.Parameters[nameID] : nullptr;
+	}
+
+	void RendererGL::BindShaderBuffer(const ShaderReflectionGL& reflection, unsigned int nameID, const IBuffer* buffer)
+	{
+		const ShaderParameterGL* parameter = GetShaderParameter(reflection, nameID);
+		if (!parameter)
+			return;
+
+		unsigned int bufferID = GPUResourceInspector::GetResourceID(buffer);
+		// we need to check id here, because buffer is an external resource that can arrive as invalid here
+		if (!bufferID)
+			return;
+
+		BufferGL& bufferGL = Buffers.GetObjectWithId(bufferID);
+		GLint binding = bufferGL.ResourceProgramInterface == GL_SHADER_STORAGE_BLOCK ? parameter->StorageBlockBinding : parameter->UniformBlockBinding;
+		if (binding == -1)
+			return;
+
+		if (bufferGL.Streamed)
+			BindBufferRange(bufferGL.Target, binding, bufferGL.BufferID, bufferGL.Offset, bufferGL.BytesSize ? bufferGL.BytesSize : StreamBuffer.Alignment); // empty buffers still reserve an aligned range
+		else
+			BindBufferRange(bufferGL.Target, binding, bufferGL.BufferID, 0, 0);
+	}
+
+	void RendererGL::BindShaderRenderBuffer(const ShaderReflectionGL& reflection, unsigned int nameID, const RenderBuffer* renderBuffer)
+	{
+		const ShaderParameterGL* parameter = GetShaderParameter(reflection, nameID);
+		if (!parameter || parameter->SamplerUnit == -1)
+			return;
+
+		unsigned int renderBufferID = GPUResourceInspector::GetResourceID(renderBuffer);
+		// render buffer not valid
+		if (!renderBufferID)
+			return;
+
+		RenderBufferGL& renderBufferGL = RenderBuffers.GetObjectWithId(renderBufferID);
+		TextureGL& textureGL = Textures.GetObjectWithId(renderBufferGL.DepthTextureID);
+		BindTextureUnit(parameter->SamplerUnit, textureGL.TextureID);
+	}
+
+	void RendererGL::BindShaderRenderBufferAttachment(const ShaderReflectionGL& reflection, unsigned int nameID, const RenderBufferAttachment& attachment)
+	{
+		const ShaderParameterGL* parameter = GetShaderParameter(reflection, nameID);
+		if (!parameter || parameter->SamplerUnit == -1)
+			return;
+
+		unsigned int renderBufferID = GPUResourceInspector::GetResourceID(attachment.RenderBuffer);
+		// render buffer not valid
+		if (!renderBufferID)
+			return;
+
+		RenderBufferGL& renderBufferGL = RenderBuffers.GetObjectWithId(renderBufferID);
+		if (attachment.Attachment >= renderBufferGL.ColorAttachments)
+			return;
+
+		TextureGL& textureGL = Textures.GetObjectWithId(renderBufferGL.ColorTextureIDs[attachment.Attachment]);
+		BindTextureUnit(parameter->SamplerUnit, textureGL.TextureID);
+	}
+
+	void RendererGL::BindShaderImage(const ShaderReflectionGL& reflection, unsigned int nameID, const ComputeImageData& image)
+	{
+		const ShaderParameterGL* parameter = GetShaderParameter(reflection, nameID);
+		if (!parameter || parameter->ImageUnit == -1)
+			return;
+
+		unsigned int textureID = 0;
+		if (image.Texture)
+		{
+			textureID = GPUResourceInspector::GetResourceID(image.Texture);
+		}
+		else
+		{
+			unsigned int renderBufferID = GPUResourceInspector::GetResourceID(image.RenderBuffer);
+			const RenderBufferGL* renderBufferGL = renderBufferID ? &RenderBuffers.GetObjectWithId(renderBufferID) : nullptr;
+			if (renderBufferGL && renderBufferGL->ColorAttachments)
+				textureID = renderBufferGL->ColorTextureIDs[0];
+		}
+
+		// texture or render buffer not valid
+		if (!textureID)
+			return;
+
+		// images are only bound by dispatches, they are not worth a cached state
+		const TextureGL& textureGL = Textures.GetObjectWithId(textureID);
+		glBindImageTexture(parameter->ImageUnit, textureGL.TextureID, image.Level, GL_FALSE, 0, ImageAccessAssociations[(int)image.Access], textureGL.TextureFormat);
+		++CallStats.Issued;
+	}
+
+	void RendererGL::UseProgram(GLuint program)
+	{
+		if (StateCache.Program == program)
+		{
+			++CallStats.Elided;
+			return;
+		}
+
+		glUseProgram(program);
+		StateCache.Program = program;
+		++CallStats.Issued;
+	}
+
+	void RendererGL::BindVertexArray(GLuint vertexArray)
+	{
+		if (StateCache.VertexArray == vertexArray)
+		{
+			++CallStats.Elided;
+			return;
+		}
+
+		glBindVertexArray(vertexArray);
+		StateCache.VertexArray = vertexArray;
+		++CallStats.Issued;
+	}
+
+	void RendererGL::BindFrameBuffer(GLuint frameBuffer)
+	{
+		if (StateCache.FrameBuffer == frameBuffer)
+		{
+			++CallStats.Elided;
+			return;
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
+		StateCache.FrameBuffer = frameBuffer;
+		++CallStats.Issued;
+	}
+
+	void RendererGL::BindTextureUnit(GLuint unit, GLuint texture)
+	{
+		if (unit < GH_GL_CACHED_TEXTURE_UNITS)
+		{
+			if (StateCache.TextureUnits[unit] == texture)
+			{
+				++CallStats.Elided;
+				return;
+			}
+
+			StateCache.TextureUnits[unit] = texture;
+		}
+
+		glBindTextureUnit(unit, texture);
+		++CallStats.Issued;
+	}
+
+	void RendererGL::BindBufferRange(GLenum target, GLuint binding, GLuint buffer, GLintptr offset, GLsizeiptr size)
+	{
+		BufferBindingGL* cached = nullptr;
+		if (binding < GH_GL_CACHED_BUFFER_BINDINGS)
+		{
+			if (target == GL_UNIFORM_BUFFER)
+				cached = &StateCache.UniformBuffers[binding];
+			else if (target == GL_SHADER_STORAGE_BUFFER)
+				cached = &StateCache.StorageBuffers[binding];
+		}
+
+		if (cached)
+		{
+			if (cached->BufferID == buffer && cached->Offset == offset && cached->Size == size)
+			{
+				++CallStats.Elided;
+				return;
+			}
+
+			*cached = BufferBindingGL{ buffer, offset, size };
+		}
+
+		if (size == 0)
+			glBindBufferBase(target, binding, buffer);
+		else
+			glBindBufferRange(target, binding, buffer, offset, size);
+		++CallStats.Issued;
+	}
+
+	void RendererGL::BindBuffer(GLenum target, GLuint buffer)
+	{
+		GLuint& cached = target == GL_DRAW_INDIRECT_BUFFER ? StateCache.DrawIndirectBuffer
+			: target == GL_DISPATCH_INDIRECT_BUFFER ? StateCache.DispatchIndirectBuffer
+			: StateCache.ParameterBuffer;
+		if (cached == buffer)
+		{
+			++CallStats.Elided;
+			return;
+		}
+
+		glBindBuffer(target, buffer);
+		cached = buffer;
+		++CallStats.Issued;
+	}
+
+	void RendererGL::BindInstanceIndices(GLuint buffer, GLintptr offset)
+	{
+		if (StateCache.InstanceIndices.BufferID == buffer && StateCache.InstanceIndices.Offset == offset)
+		{
+			++CallStats.Elided;
+			return;
+		}
+
+		glVertexArrayVertexBuffer(GeometryArena.VAO, 1, buffer, offset, sizeof(GLuint));
+		StateCache.InstanceIndices = BufferBindingGL{ buffer, offset, 0 };
+		++CallStats.Issued;
+	}
+
+	void RendererGL::InvalidateStateCache()
+	{
+		StateCache.Program = GH_GL_UNKNOWN_BINDING;
+		StateCache.VertexArray = GH_GL_UNKNOWN_BINDING;
+		StateCache.FrameBuffer = GH_GL_UNKNOWN_BINDING;
+		StateCache.DrawIndirectBuffer = GH_GL_UNKNOWN_BINDING;
+		StateCache.DispatchIndirectBuffer = GH_GL_UNKNOWN_BINDING;
+		StateCache.ParameterBuffer = GH_GL_UNKNOWN_BINDING;
+		StateCache.InstanceIndices = BufferBindingGL{ GH_GL_UNKNOWN_BINDING, 0, 0 };
+
+		for (GLuint& texture : StateCache.TextureUnits)
+			texture = GH_GL_UNKNOWN_BINDING;
+
+		for (unsigned int b = 0; b < GH_GL_CACHED_BUFFER_BINDINGS; ++b)
+		{
+			StateCache.UniformBuffers[b] = BufferBindingGL{ GH_GL_UNKNOWN_BINDING, 0, 0 };
+			StateCache.StorageBuffers[b] = BufferBindingGL{ GH_GL_UNKNOWN_BINDING, 0, 0 };
+		}
+	}
+
+	void RendererGL::ForgetTexture(GLuint texture)
+	{
+		for (GLuint& cached : StateCache.TextureUnits)
+		{
+			if (cached == texture)
+				cached = GH_GL_UNKNOWN_BINDING;
+		}
+	}
+
+	void RendererGL::ForgetBuffer(GLuint buffer)
+	{
+		for (unsigned int b = 0; b < GH_GL_CACHED_BUFFER_BINDINGS; ++b)
+		{
+			if (StateCache.UniformBuffers[b].BufferID == buffer)
+				StateCache.UniformBuffers[b].BufferID = GH_GL_UNKNOWN_BINDING;
+			if (StateCache.StorageBuffers[b].BufferID == buffer)
+				StateCache.StorageBuffers[b].BufferID = GH_GL_UNKNOWN_BINDING;
+		}
+
+		if (StateCache.DrawIndirectBuffer == buffer)
+			StateCache.DrawIndirectBuffer = GH_GL_UNKNOWN_BINDING;
+		if (StateCache.DispatchIndirectBuffer == buffer)
+			StateCache.DispatchIndirectBuffer = GH_GL_UNKNOWN_BINDING;
+		if (StateCache.ParameterBuffer == buffer)
+			StateCache.ParameterBuffer = GH_GL_UNKNOWN_BINDING;
+		if (StateCache.InstanceIndices.BufferID == buffer)
+			StateCache.InstanceIndices.BufferID = GH_GL_UNKNOWN_BINDING;
+	}
+
+	void RendererGL::ForgetProgram(GLuint program)
+	{
+		if (StateCache.Program == program)
+			StateCache.Program = GH_GL_UNKNOWN_BINDING;
+	}
+
 	void RendererGL::QuitUI()
 	{
 		ImGui::SetCurrentContext(ImGuiContext);
@@ -1018,7 +2010,12 @@ namespace GaladHen
 		unsigned int id = Buffers.AddWithId();
 		BufferGL& bufferGL = Buffers.GetObjectWithId(id);
 		bufferGL.BytesSize = 0;
-		glCreateBuffers(1, &bufferGL.BufferID);
+		bufferGL.Offset = 0;
+		bufferGL.Streamed = buffer->GetAccessType() == BufferAccessType::StreamWrite && StreamBuffer.MappedData;
+		if (bufferGL.Streamed)
+			bufferGL.BufferID = StreamBuffer.BufferID;
+		else
+			glCreateBuffers(1, &bufferGL.BufferID);
 		LoadBuffer(id, buffer);
 
 		return id;
@@ -1046,21 +2043,41 @@ namespace GaladHen
 			break;
 		}
 
-		glBindBuffer(bufferGL.Target, bufferGL.BufferID);
-
 		// We need to calculate for each data its gpu occupancy (using std430 OpenGL buffer layout: https://www.oreilly.com/library/view/opengl-programming-guide/9780132748445/app09lev1sec3.html)
 		// Assuming the order of the data inside Datas array matches gpu buffer data order
 		const void* data = buffer->GetData();
 		const size_t size = buffer->GetBytesSize();
 
+		if (bufferGL.Streamed)
+		{
+			// A new range at every load: the gpu can still be reading the previous one, so it is never overwritten
+			GLintptr offset = 0;
+			if (AllocateStream(size, offset))
+			{
+				if (size > 0)
+					std::memcpy(StreamBuffer.MappedData + offset, data, size);
+
+				bufferGL.Offset = offset;
+				bufferGL.BytesSize = size;
+				return;
+			}
+
+			Log::Warning("RendererGL", "Stream buffer memory of the frame is full: the buffer is moved to its own storage");
+			bufferGL.Streamed = false;
+			bufferGL.Offset = 0;
+			bufferGL.BytesSize = 0;
+			glCreateBuffers(1, &bufferGL.BufferID);
+		}
+
 		if (bufferGL.BytesSize != size)
 		{
 			// Size is changed, we need to reallocate buffer
-			glBufferData(bufferGL.Target, size, data, BufferUsageAssociations[(int)buffer->GetAccessType()]); // reallocation of memory
+			GLenum usage = buffer->GetAccessType() == BufferAccessType::StreamWrite ? GL_STREAM_DRAW : BufferUsageAssociations[(int)buffer->GetAccessType()];
+			glNamedBufferData(bufferGL.BufferID, size, data, usage); // reallocation of memory
 		}
 		else
 		{
-			glBufferSubData(bufferGL.Target, 0, size, data); // writing only
+			glNamedBufferSubData(bufferGL.BufferID, 0, size, data); // writing only
 		}
 
 		bufferGL.BytesSize = size;
@@ -1069,9 +2086,89 @@ namespace GaladHen
 	void RendererGL::FreeBuffer(unsigned int bufferID)
 	{
 		BufferGL& buffer = Buffers.GetObjectWithId(bufferID);
-		glDeleteBuffers(1, &buffer.BufferID);
+		if (!buffer.Streamed)
+		{
+			ForgetBuffer(buffer.BufferID);
+			glDeleteBuffers(1, &buffer.BufferID);
+		}
 
 		Buffers.RemoveWithId(bufferID);
 	}
+
+	void RendererGL::CreateStreamBuffer()
+	{
+		GLint uniformAlignment = 0;
+		GLint storageAlignment = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+		StreamBuffer.Alignment = std::max(std::max(uniformAlignment, storageAlignment), 1);
+
+		// regions start aligned, so that the offsets aligned inside a region are aligned inside the buffer
+		StreamBuffer.FrameBytes = (GH_GL_STREAM_BUFFER_BYTES / GH_GL_STREAM_FRAMES) / StreamBuffer.Alignment * StreamBuffer.Alignment;
+
+		// coherent mapping: writes are visible to the commands issued after them without flushing
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glCreateBuffers(1, &StreamBuffer.BufferID);
+		glNamedBufferStorage(StreamBuffer.BufferID, StreamBuffer.FrameBytes * GH_GL_STREAM_FRAMES, nullptr, flags);
+		StreamBuffer.MappedData = static_cast<unsigned char*>(glMapNamedBufferRange(StreamBuffer.BufferID, 0, StreamBuffer.FrameBytes * GH_GL_STREAM_FRAMES, flags));
+
+		if (!StreamBuffer.MappedData)
+		{
+			Log::Error("RendererGL", "Failed to map the stream buffer: StreamWrite buffers get their own storage");
+
+			glDeleteBuffers(1, &StreamBuffer.BufferID);
+			StreamBuffer.BufferID = 0;
+		}
+	}
+
+	bool RendererGL::AllocateStream(GLsizeiptr size, GLintptr& outOffset)
+	{
+		if (!StreamBuffer.FrameReady)
+		{
+			// the region was last written GH_GL_STREAM_FRAMES frames ago: usually its fence is already signaled
+			if (GLsync fence = StreamBuffer.FrameFences[StreamBuffer.Frame])
+			{
+				GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+				while (result == GL_TIMEOUT_EXPIRED)
+				{
+					result = glClientWaitSync(fence, 0, 1000000); // 1 ms
+				}
+
+				glDeleteSync(fence);
+				StreamBuffer.FrameFences[StreamBuffer.Frame] = nullptr;
+			}
+
+			StreamBuffer.Head = 0;
+			StreamBuffer.FrameReady = true;
+		}
+
+		GLsizeiptr alignedSize = (std::max(size, (GLsizeiptr)1) + StreamBuffer.Alignment - 1) / StreamBuffer.Alignment * StreamBuffer.Alignment;
+		if (StreamBuffer.Head + alignedSize > StreamBuffer.FrameBytes)
+			return false;
+
+		outOffset = StreamBuffer.Frame * StreamBuffer.FrameBytes + StreamBuffer.Head;
+		StreamBuffer.Head += alignedSize;
+
+		return true;
+	}
+
+	void RendererGL::FreeStreamBuffer()
+	{
+		if (!StreamBuffer.MappedData)
+			return;
+
+		for (GLsync& fence : StreamBuffer.FrameFences)
+		{
+			if (fence)
+				glDeleteSync(fence);
+
+			fence = nullptr;
+		}
+
+		ForgetBuffer(StreamBuffer.BufferID);
+		glUnmapNamedBuffer(StreamBuffer.BufferID);
+		glDeleteBuffers(1, &StreamBuffer.BufferID);
+		StreamBuffer.MappedData = nullptr;
+	}
 }
 
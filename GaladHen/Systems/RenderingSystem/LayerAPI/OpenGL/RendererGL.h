@@ -4,12 +4,24 @@
 #pragma once
 
 #include <Systems/RenderingSystem/LayerAPI/IRendererAPI.h>
+#include <Systems/RenderingSystem/Entities/MaterialParameterBlock.h>
+#include <Systems/RenderingSystem/Entities/RenderBuffer.h>
 
 #include <Utils/IdList.hpp>
+#include <Utils/RangeAllocator.h>
+
+#include <vector>
 
 // gl3w MUST be included before any other OpenGL-related header
 #include <GL/gl3w.h>
 
+#define GH_GL_CACHED_TEXTURE_UNITS 32 // texture units whose bindings are tracked by the state cache
+#define GH_GL_CACHED_BUFFER_BINDINGS 16 // uniform and shader storage binding points tracked by the state cache
+#define GH_GL_STREAM_BUFFER_BYTES (4 * 1024 * 1024) // persistently mapped memory for StreamWrite buffers, split among the frames in flight
+#define GH_GL_STREAM_FRAMES 3 // frames the cpu can write ahead of the gpu
+#define GH_GL_GEOMETRY_INITIAL_VERTICES (64 * 1024) // initial capacity of the geometry arena, doubled when it is full
+#define GH_GL_GEOMETRY_INITIAL_INDICES (192 * 1024)
+
 struct GLFWwindow;
 class ImGuiContext;
 
@@ -30,28 +42,74 @@ namespace GaladHen
 
 		virtual void InitUI() override;
 
-		virtual unsigned int CreateRenderBuffer(unsigned int width, unsigned int height, TextureFormat format, bool enableDepth, bool clampDepthToBorder) override;
+		virtual unsigned int CreateRenderBuffer(unsigned int width, unsigned int height, const TextureFormat* formats, unsigned int colorAttachments, bool enableDepth, bool clampDepthToBorder) override;
+
+		virtual unsigned int CreateDepthRenderBuffer(unsigned int width, unsigned int height, unsigned int layers, bool clampDepthToBorder) override;
+
+		virtual void FreeRenderBuffer(unsigned int renderBufferID) override;
+
+		virtual void CopyRenderBufferDepth(unsigned int sourceRenderBufferID, unsigned int destinationRenderBufferID, unsigned int layer) override;
 
 		virtual void ClearRenderBuffer(unsigned int renderBufferID, glm::vec4 clearColor) override;
 
-		virtual void BindRenderBuffer(unsigned int renderBufferID) override;
+		virtual void ClearRenderBufferDepth(unsigned int renderBufferID, const glm::uvec2& position, const glm::uvec2& size) override;
+
+		virtual void BindRenderBuffer(unsigned int renderBufferID, unsigned int layer) override;
 
 		virtual void UnbindActiveRenderBuffer() override;
 
 		virtual void Draw(CommandBuffer<RenderCommand>& renderCommandBuffer) override;
 
+		virtual void Dispatch(CommandBuffer<ComputeCommand>& computeCommandBuffer) override;
+
+		virtual void InsertMemoryBarrier(MemoryBarrierType barriers) override;
+
 		virtual void TransferData(CommandBuffer<MemoryTransferCommand>& memoryCommandBuffer) override;
 
 		virtual bool Compile(CommandBuffer<CompileCommand>& compileCommandBuffer) override; // TODO: CompileResult instead of bool as return type
 
+		virtual const ShaderBlockLayout* GetMaterialBlockLayout(unsigned int shaderID) override;
+
+		virtual bool ReadBuffer(unsigned int bufferID, void* outData, size_t bytesSize) override;
+
+		virtual unsigned int CreateFence() override;
+
+		virtual bool IsFenceSignaled(unsigned int fenceID, bool wait) override;
+
+		virtual void FreeFence(unsigned int fenceID) override;
+
+		virtual unsigned int CreateOcclusionQuery() override;
+
+		virtual bool GetOcclusionQueryResult(unsigned int queryID, bool wait, bool& outSamplesPassed) override;
+
+		virtual void FreeOcclusionQuery(unsigned int queryID) override;
+
 		virtual void EnableDepthTest(bool enable) override;
 
+		virtual void EnableDepthWrite(bool enable) override;
+
+		virtual void SetDepthFunction(DepthFunction function) override;
+
+		virtual void EnableColorWrite(bool enable) override;
+
 		virtual void EnableBackFaceCulling(bool enable) override;
 
 		virtual unsigned int GetRenderBufferColorApiID(unsigned int renderBufferID) override;
 
 		virtual void SetViewport(const glm::uvec2& position, const glm::uvec2& size) override;
 
+		virtual void EndFrame() override;
+
+		virtual MeshDrawRange GetMeshDrawRange(unsigned int meshID) override;
+
+		virtual bool SupportsIndirectDrawCount() const override;
+
+		virtual GeometryMemoryStats GetGeometryMemoryStats() const override;
+
+		virtual const StateCallStats& GetStateCallStats() const override;
+
+		virtual void ResetStateCallStats() override;
+
 		virtual void CreateRenderingWindow(const char* name, glm::uvec2 size) override;
 
 		virtual void SwapWindowBuffers() override;
@@ -71,13 +129,40 @@ namespace GaladHen
 	protected:
 
 		static GLenum RendererGL::PrimitiveTypes[3];
+		// Ranges of a mesh inside the geometry arena, drawn with base vertex offsets
 		struct MeshGL
 		{
-			GLuint VAO, VBO, EBO;
+			unsigned int FirstVertex;
+			unsigned int NumberOfVertices;
+			unsigned int FirstIndex;
 			unsigned int NumberOfIndices;
 			GLenum PrimitiveType;
 		};
 
+		// Vertices and indices of all the meshes, sub-allocated from two large buffers sharing a single vertex array
+		// (there is one vertex format, MeshVertexData)
+		// The vertex array also reads the per-instance index, from the buffer of the indirect draw or from the identity buffer for direct draws
+		struct GeometryArenaGL
+		{
+			GeometryArenaGL()
+				: VAO(0)
+				, VBO(0)
+				, EBO(0)
+				, Vertices(GH_GL_GEOMETRY_INITIAL_VERTICES)
+				, Indices(GH_GL_GEOMETRY_INITIAL_INDICES)
+				, BufferAllocations(0)
+				, InstanceIdentityBuffer(0)
+				, InstanceIdentityCapacity(0)
+			{}
+
+			GLuint VAO, VBO, EBO;
+			RangeAllocator Vertices; // in vertices
+			RangeAllocator Indices; // in indices
+			unsigned int BufferAllocations;
+			GLuint InstanceIdentityBuffer; // i at position i: with the base instance, direct draws read their instances from FirstInstance on
+			unsigned int InstanceIdentityCapacity;
+		};
+
 		// OpenGL texture formats are called Sized Internal Formats
 		// https://www.khronos.org/opengl/wiki/Image_Format
 		// https://registry.khronos.org/OpenGL-Refpages/gl4/html/glTexStorage2D.xhtml
@@ -92,6 +177,8 @@ namespace GaladHen
 		static GLint WrappingAssociations[4];
 		static GLint FilteringAssociations[6];
 		static GLenum TextureUnits[32];
+		static GLenum ImageAccessAssociations[3];
+		static GLenum DepthFunctionAssociations[4];
 		enum class TextureAllocationType
 		{
 			Dynamic,
@@ -113,8 +200,12 @@ namespace GaladHen
 		struct RenderBufferGL
 		{
 			GLuint FrameBufferID;
-			unsigned int ColorTextureID;
+			unsigned int ColorTextureIDs[GH_MAX_RENDER_BUFFER_ATTACHMENTS];
+			unsigned int ColorAttachments; // zero if no color is attached
 			unsigned int DepthTextureID; // zero if it is not attached
+			unsigned int Layers; // layers of the depth texture array, zero if the depth is a single texture
+			unsigned int AttachedLayer;
+			glm::uvec2 Size;
 		};
 
 		// https://registry.khronos.org/OpenGL-Refpages/gl4/html/glBufferData.xhtml
@@ -129,28 +220,119 @@ namespace GaladHen
 
 			// Cache of previous allocation size, to know whether to reallocate a dynamic buffer or not
 			size_t BytesSize;
+
+			bool Streamed; // data lives in the stream buffer, at Offset: BufferID is the stream buffer and it is not owned
+			GLintptr Offset;
+		};
+
+		// Ring of frame regions inside a persistently mapped buffer: each frame writes its region with plain copies,
+		// and a region is written again only after the fence of the frame that used it is signaled
+		struct StreamBufferGL
+		{
+			GLuint BufferID;
+			unsigned char* MappedData; // nullptr if the buffer could not be created
+			GLsizeiptr FrameBytes; // size of each frame region
+			GLintptr Alignment; // offset alignment of uniform and shader storage ranges
+			GLsync FrameFences[GH_GL_STREAM_FRAMES]; // placed at the end of the frame that wrote the region
+			unsigned int Frame; // region of the current frame
+			GLintptr Head; // next free byte inside the current region
+			bool FrameReady; // the region was waited for and can be written by the current frame
+		};
+
+		// Location and bindings of a shader parameter inside a linked program (-1 = not active in the program)
+		struct ShaderParameterGL
+		{
+			GLint Location;
+			GLint SamplerUnit; // Texture unit assigned to the sampler once after linking
+			GLint ImageUnit; // Image unit declared by the image binding layout
+			GLint UniformBlockBinding;
+			GLint StorageBlockBinding;
+		};
+
+		// Active parameters of a linked program, indexed by ShaderParameterName id
+		// Built once after linking, so that draws and dispatches never query the program by name
+		struct ShaderReflectionGL
+		{
+			ShaderReflectionGL()
+				: MaterialBlock()
+				, MaterialBlockBinding(-1)
+			{}
+
+			std::vector<ShaderParameterGL> Parameters;
+			ShaderBlockLayout MaterialBlock;
+			GLint MaterialBlockBinding; // -1 if the program does not declare the material block
+		};
+
+		struct BufferBindingGL
+		{
+			GLuint BufferID;
+			GLintptr Offset;
+			GLsizeiptr Size; // zero if the whole buffer is bound
+		};
+
+		// Shadow copy of the GL state set by the renderer, so that calls not changing it are skipped
+		struct StateCacheGL
+		{
+			GLuint Program;
+			GLuint VertexArray;
+			GLuint FrameBuffer;
+			GLuint TextureUnits[GH_GL_CACHED_TEXTURE_UNITS];
+			BufferBindingGL UniformBuffers[GH_GL_CACHED_BUFFER_BINDINGS];
+			BufferBindingGL StorageBuffers[GH_GL_CACHED_BUFFER_BINDINGS];
+			GLuint DrawIndirectBuffer;
+			GLuint DispatchIndirectBuffer;
+			GLuint ParameterBuffer;
+			BufferBindingGL InstanceIndices; // per-instance vertex buffer of the geometry arena vertex array
 		};
 
 		// OPENGL -----------------------------------------------------------------------------------------------------------------------------------------
 
 		unsigned int CreateTexture(const Texture& texture, TextureAllocationType allocationType = TextureAllocationType::Constant);
-		unsigned int CreateDepthTexture(unsigned int width, unsigned int height, bool clampToBorder = false);
+		unsigned int CreateDepthTexture(unsigned int width, unsigned int height, bool clampToBorder = false, unsigned int layers = 0); // layers = 0 for a single texture
 		void FreeTexture(unsigned int textureID);
 		void LoadTexture(unsigned int textureID, const Texture& texture, TextureAllocationType allocationType = TextureAllocationType::Constant);
 
 		unsigned int CreateMesh(const Mesh& mesh);
 		void LoadMesh(unsigned int meshID, const Mesh& mesh);
 		void FreeMesh(unsigned int meshID);
+		void CreateGeometryArena();
+		void AllocateGeometry(MeshGL& meshGL, unsigned int verticesNumber, unsigned int indicesNumber);
+		void FreeGeometry(MeshGL& meshGL);
+		void GrowGeometryBuffer(GLuint& buffer, size_t previousBytes, size_t bytes); // copies the content into a new, larger buffer
+		void ReserveInstanceIdentity(unsigned int instancesNumber);
+		void DrawIndirect(const MeshGL& mesh, const IndirectDrawData& indirect);
 
 		unsigned int CreateBuffer(const IBuffer* buffer);
 		void LoadBuffer(unsigned int bufferID, const IBuffer* buffer);
 		void FreeBuffer(unsigned int bufferID);
+		void CreateStreamBuffer();
+		bool AllocateStream(GLsizeiptr size, GLintptr& outOffset); // false if the region of the current frame is full
+		void FreeStreamBuffer();
 
 		unsigned int CreateShaderPipeline(CompileCommand& compileCommand);
 		bool CompileShaderPipeline(unsigned int shaderID, CompileCommand& compileCommand);
 		bool CheckShaderPipelineCompilation(GLuint shaderProgram, char* outLog, unsigned int outLogLength);
 		bool CheckShaderPipelineLinking(GLuint shaderProgram, char* outLog, unsigned int outLogLength);
 		void FreeShaderPipeline(unsigned int shaderID);
+		void ReflectShaderPipeline(unsigned int shaderID);
+		const ShaderParameterGL* GetShaderParameter(const ShaderReflectionGL& reflection, unsigned int nameID) const; // nameID: ShaderParameterName id
+		void BindShaderBuffer(const ShaderReflectionGL& reflection, unsigned int nameID, const IBuffer* buffer);
+		void BindShaderRenderBuffer(const ShaderReflectionGL& reflection, unsigned int nameID, const RenderBuffer* renderBuffer); // depth texture of the render buffer
+		void BindShaderRenderBufferAttachment(const ShaderReflectionGL& reflection, unsigned int nameID, const RenderBufferAttachment& attachment);
+		void BindShaderImage(const ShaderReflectionGL& reflection, unsigned int nameID, const ComputeImageData& image);
+
+		// State cache: every binding of the renderer goes through these functions
+		void UseProgram(GLuint program);
+		void BindVertexArray(GLuint vertexArray);
+		void BindFrameBuffer(GLuint frameBuffer);
+		void BindTextureUnit(GLuint unit, GLuint texture);
+		void BindBufferRange(GLenum target, GLuint binding, GLuint buffer, GLintptr offset, GLsizeiptr size); // size zero = bind the whole buffer
+		void BindBuffer(GLenum target, GLuint buffer); // indirect draw, indirect dispatch and parameter buffers only
+		void BindInstanceIndices(GLuint buffer, GLintptr offset);
+		void InvalidateStateCache(); // to call when the GL state is changed outside the renderer
+		void ForgetTexture(GLuint texture); // deleted objects can't be assumed bound anymore, since their names can be reused
+		void ForgetBuffer(GLuint buffer);
+		void ForgetProgram(GLuint program);
 
 		// UI
 		void QuitUI();
@@ -158,8 +340,18 @@ namespace GaladHen
 		IdList<MeshGL> Meshes;
 		IdList<BufferGL> Buffers;
 		IdList<GLuint> Shaders;
+		std::vector<ShaderReflectionGL> ShaderReflections; // Indexed by shader id - 1 (not stored in the IdList because it owns memory)
 		IdList<TextureGL> Textures;
 		IdList<RenderBufferGL> RenderBuffers;
+		IdList<GLsync> Fences;
+		IdList<GLuint> OcclusionQueries;
+
+		StreamBufferGL StreamBuffer;
+		GeometryArenaGL GeometryArena;
+		PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC MultiDrawElementsIndirectCount; // core or ARB_indirect_parameters entry point, nullptr if not supported
+
+		StateCacheGL StateCache;
+		StateCallStats CallStats;
 
 		GLFWwindow* Window;
 
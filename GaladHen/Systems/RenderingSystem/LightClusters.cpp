@@ -0,0 +1,176 @@
+#include "LightClusters.h"
+
+#include "Entities/Camera.h"
+#include "Entities/PointLight.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#define GH_LIGHT_CLUSTER_NUMBER (GH_LIGHT_CLUSTERS_X * GH_LIGHT_CLUSTERS_Y * GH_LIGHT_CLUSTERS_Z)
+
+namespace GaladHen
+{
+	LightClusters::LightClusters()
+		: ClusterDataBuffer(FixedBuffer<LightClusterBufferData, 1>{ BufferType::Uniform, BufferAccessType::StreamWrite })
+		, GridBuffer(DynamicBuffer<LightClusterGridBufferData>{ BufferType::ShaderStorage, BufferAccessType::StreamWrite })
+		, LightIndexBuffer(DynamicBuffer<unsigned int>{ BufferType::ShaderStorage, BufferAccessType::StreamWrite })
+		, ClusterData()
+		, SliceDepths()
+		, TileSlopesX()
+		, TileSlopesY()
+		, Stats()
+	{}
+
+	void LightClusters::Update(const Camera& camera, const std::vector<PointLight>& pointLights, const glm::uvec2& viewportSize)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		Stats = LightClusterStats{};
+		Stats.Lights = (unsigned int)pointLights.size();
+
+		// exponential slices: a cluster covers about the same screen size along the three axes at any depth
+		const float nearDistance = camera.GetNear();
+		const float farDistance = std::max(camera.GetFar(), nearDistance * 1.001f);
+		const float depthRatioLog = std::log(farDistance / nearDistance);
+
+		ClusterData.GridSize = glm::uvec4(GH_LIGHT_CLUSTERS_X, GH_LIGHT_CLUSTERS_Y, GH_LIGHT_CLUSTERS_Z, 0);
+		ClusterData.TileSize = glm::vec2(viewportSize) / glm::vec2(GH_LIGHT_CLUSTERS_X, GH_LIGHT_CLUSTERS_Y);
+		ClusterData.DepthSliceScale = GH_LIGHT_CLUSTERS_Z / depthRatioLog;
+		ClusterData.DepthSliceBias = -GH_LIGHT_CLUSTERS_Z * std::log(nearDistance) / depthRatioLog;
+
+		for (unsigned int z = 0; z <= GH_LIGHT_CLUSTERS_Z; ++z)
+			SliceDepths[z] = nearDistance * std::pow(farDistance / nearDistance, (float)z / GH_LIGHT_CLUSTERS_Z);
+
+		// the projection is symmetric: a tile border at ndc n has view x / view depth = n / projection scale
+		const glm::mat4 projection = camera.GetProjectionMatrix();
+		for (unsigned int x = 0; x <= GH_LIGHT_CLUSTERS_X; ++x)
+			TileSlopesX[x] = (2.0f * x / GH_LIGHT_CLUSTERS_X - 1.0f) / projection[0][0];
+		for (unsigned int y = 0; y <= GH_LIGHT_CLUSTERS_Y; ++y)
+			TileSlopesY[y] = (2.0f * y / GH_LIGHT_CLUSTERS_Y - 1.0f) / projection[1][1];
+
+		ClusterLights.clear();
+		ClusterCursors.assign(GH_LIGHT_CLUSTER_NUMBER, 0);
+
+		const glm::mat4 view = camera.GetViewMatrix();
+		for (unsigned int l = 0; l < pointLights.size(); ++l)
+		{
+			const PointLight& light = pointLights[l];
+			float radius = light.Radius;
+			if (radius <= 0.0f)
+				continue;
+
+			// view space, with the depth growing away from the camera
+			glm::vec3 center = glm::vec3(view * glm::vec4(light.Transform.GetPosition(), 1.0f));
+			center.z = -center.z;
+
+			if (center.z + radius < nearDistance || center.z - radius > farDistance)
+				continue;
+
+			float minDepth = std::max(center.z - radius, nearDistance);
+			float maxDepth = std::min(center.z + radius, farDistance);
+			unsigned int firstSlice = GetDepthSlice(minDepth);
+			unsigned int lastSlice = GetDepthSlice(maxDepth);
+
+			// tiles covered by the box around the sphere between its depths: its slopes are the widest at the nearest or at the farthest depth
+			float minSlopeX = std::min((center.x - radius) / minDepth, (center.x - radius) / maxDepth);
+			float maxSlopeX = std::max((center.x + radius) / minDepth, (center.x + radius) / maxDepth);
+			float minSlopeY = std::min((center.y - radius) / minDepth, (center.y - radius) / maxDepth);
+			float maxSlopeY = std::max((center.y + radius) / minDepth, (center.y + radius) / maxDepth);
+
+			if (maxSlopeX < TileSlopesX[0] || minSlopeX > TileSlopesX[GH_LIGHT_CLUSTERS_X] || maxSlopeY < TileSlopesY[0] || minSlopeY > TileSlopesY[GH_LIGHT_CLUSTERS_Y])
+				continue;
+
+			unsigned int firstTileX = (unsigned int)(std::upper_bound(TileSlopesX + 1, TileSlopesX + GH_LIGHT_CLUSTERS_X, minSlopeX) - (TileSlopesX + 1));
+			unsigned int lastTileX = (unsigned int)(std::lower_bound(TileSlopesX + 1, TileSlopesX + GH_LIGHT_CLUSTERS_X, maxSlopeX) - (TileSlopesX + 1));
+			unsigned int firstTileY = (unsigned int)(std::upper_bound(TileSlopesY + 1, TileSlopesY + GH_LIGHT_CLUSTERS_Y, minSlopeY) - (TileSlopesY + 1));
+			unsigned int lastTileY = (unsigned int)(std::lower_bound(TileSlopesY + 1, TileSlopesY + GH_LIGHT_CLUSTERS_Y, maxSlopeY) - (TileSlopesY + 1));
+
+			bool visible = false;
+			for (unsigned int z = firstSlice; z <= lastSlice; ++z)
+			{
+				float sliceNear = SliceDepths[z];
+				float sliceFar = SliceDepths[z + 1];
+				float depthDistance = std::max(std::max(sliceNear - center.z, center.z - sliceFar), 0.0f);
+
+				for (unsigned int y = firstTileY; y <= lastTileY; ++y)
+				{
+					// bounds of the cluster: each side is the farthest from the view axis at one of the slice depths
+					float minY = std::min(TileSlopesY[y] * sliceNear, TileSlopesY[y] * sliceFar);
+					float maxY = std::max(TileSlopesY[y + 1] * sliceNear, TileSlopesY[y + 1] * sliceFar);
+					float yDistance = std::max(std::max(minY - center.y, center.y - maxY), 0.0f);
+
+					for (unsigned int x = firstTileX; x <= lastTileX; ++x)
+					{
+						float minX = std::min(TileSlopesX[x] * sliceNear, TileSlopesX[x] * sliceFar);
+						float maxX = std::max(TileSlopesX[x + 1] * sliceNear, TileSlopesX[x + 1] * sliceFar);
+						float xDistance = std::max(std::max(minX - center.x, center.x - maxX), 0.0f);
+
+						if (xDistance * xDistance + yDistance * yDistance + depthDistance * depthDistance > radius * radius)
+							continue;
+
+						unsigned int cluster = x + y * GH_LIGHT_CLUSTERS_X + z * GH_LIGHT_CLUSTERS_X * GH_LIGHT_CLUSTERS_Y;
+						ClusterLights.push_back(ClusterLight{ cluster, l });
+						++ClusterCursors[cluster];
+						visible = true;
+					}
+				}
+			}
+
+			if (visible)
+				++Stats.VisibleLights;
+		}
+
+		// compact lists: the cursors turn from the light numbers of the clusters to the positions of their lists
+		GridBuffer.ClearData();
+		unsigned int firstLight = 0;
+		for (unsigned int c = 0; c < GH_LIGHT_CLUSTER_NUMBER; ++c)
+		{
+			unsigned int lightNumber = ClusterCursors[c];
+			GridBuffer.AddData(LightClusterGridBufferData{ firstLight, lightNumber });
+			Stats.MaxClusterLights = std::max(Stats.MaxClusterLights, lightNumber);
+
+			ClusterCursors[c] = firstLight;
+			firstLight += lightNumber;
+		}
+
+		LightIndexBuffer.ClearData();
+		for (unsigned int i = 0; i < firstLight; ++i)
+			LightIndexBuffer.AddData(0);
+
+		for (const ClusterLight& clusterLight : ClusterLights)
+			LightIndexBuffer.SetData(clusterLight.Light, ClusterCursors[clusterLight.Cluster]++);
+
+		ClusterDataBuffer.SetData(ClusterData, 0);
+
+		Stats.LightIndices = firstLight;
+		Stats.Milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	FixedBuffer<LightClusterBufferData, 1>& LightClusters::GetClusterDataBuffer()
+	{
+		return ClusterDataBuffer;
+	}
+
+	DynamicBuffer<LightClusterGridBufferData>& LightClusters::GetGridBuffer()
+	{
+		return GridBuffer;
+	}
+
+	DynamicBuffer<unsigned int>& LightClusters::GetLightIndexBuffer()
+	{
+		return LightIndexBuffer;
+	}
+
+	const LightClusterStats& LightClusters::GetStats() const
+	{
+		return Stats;
+	}
+
+	unsigned int LightClusters::GetDepthSlice(float viewDepth) const
+	{
+		// same mapping of the shaders
+		float slice = std::log(viewDepth) * ClusterData.DepthSliceScale + ClusterData.DepthSliceBias;
+		return (unsigned int)std::min(std::max(slice, 0.0f), GH_LIGHT_CLUSTERS_Z - 1.0f);
+	}
+}
@@ -0,0 +1,80 @@
+// Clustered forward shading of the point lights: the view frustum is divided in a grid of clusters (screen tiles by exponential depth slices), and the
+// spheres lit by the point lights are assigned on cpu to the clusters they touch
+// The shaders find the cluster of each fragment and shade it with the lights of the cluster only, instead of looping over all the lights of the scene
+// Lights of a cluster are stored as a compact list of indices into the point light buffer, in the same order as the point lights of the scene
+
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Entities/Buffer.hpp"
+#include "Entities/BufferData/LightClusterBufferData.h"
+
+#define GH_LIGHT_CLUSTERS_X 16
+#define GH_LIGHT_CLUSTERS_Y 9
+#define GH_LIGHT_CLUSTERS_Z 24 // depth slices between the camera near and far planes
+
+namespace GaladHen
+{
+	class Camera;
+	class PointLight;
+
+	struct LightClusterStats
+	{
+		unsigned int Lights; // point lights of the scene
+		unsigned int VisibleLights; // point lights touching at least a cluster
+		unsigned int LightIndices; // light indices stored in the clusters
+		unsigned int MaxClusterLights; // lights of the most crowded cluster
+		float Milliseconds; // cpu time to assign the lights to the clusters
+	};
+
+	class LightClusters
+	{
+	public:
+
+		LightClusters();
+
+		LightClusters(const LightClusters& source) = delete;
+		LightClusters& operator=(const LightClusters& source) = delete;
+
+		// @brief
+		// Assign the point lights to the clusters of the camera view, and write the cluster buffers
+		// @param viewportSize: pixels of the render buffer the view is drawn on
+		void Update(const Camera& camera, const std::vector<PointLight>& pointLights, const glm::uvec2& viewportSize);
+
+		// @returns the layout of the cluster grid
+		FixedBuffer<LightClusterBufferData, 1>& GetClusterDataBuffer();
+
+		// @returns the first light index and the number of lights of each cluster, indexed as x + y * GH_LIGHT_CLUSTERS_X + z * GH_LIGHT_CLUSTERS_X * GH_LIGHT_CLUSTERS_Y
+		DynamicBuffer<LightClusterGridBufferData>& GetGridBuffer();
+
+		// @returns the lists of the point lights of the clusters, one after the other
+		DynamicBuffer<unsigned int>& GetLightIndexBuffer();
+
+		const LightClusterStats& GetStats() const;
+
+	protected:
+
+		struct ClusterLight
+		{
+			unsigned int Cluster;
+			unsigned int Light;
+		};
+
+		unsigned int GetDepthSlice(float viewDepth) const;
+
+		FixedBuffer<LightClusterBufferData, 1> ClusterDataBuffer;
+		DynamicBuffer<LightClusterGridBufferData> GridBuffer;
+		DynamicBuffer<unsigned int> LightIndexBuffer;
+		LightClusterBufferData ClusterData;
+		float SliceDepths[GH_LIGHT_CLUSTERS_Z + 1]; // view depth of the borders of the depth slices
+		float TileSlopesX[GH_LIGHT_CLUSTERS_X + 1]; // view x / view depth of the borders of the screen tiles
+		float TileSlopesY[GH_LIGHT_CLUSTERS_Y + 1];
+		std::vector<ClusterLight> ClusterLights; // found light by light, so that the lights of each cluster keep the scene order
+		std::vector<unsigned int> ClusterCursors; // next free index of each cluster while filling the lists
+		LightClusterStats Stats;
+
+	};
+}
@@ -0,0 +1,240 @@
+#include "GPURayTracingScene.h"
+
+#include <Systems/RenderingSystem/Entities/Scene.h>
+#include <Systems/RenderingSystem/Entities/Model.h>
+
+#include <limits>
+
+namespace GaladHen
+{
+	GPURayTracingScene::GPURayTracingScene()
+		: NodeBuffer(BufferType::ShaderStorage, BufferAccessType::StaticWrite)
+		, TriangleBuffer(BufferType::ShaderStorage, BufferAccessType::StaticWrite)
+		, InstanceBuffer(BufferType::ShaderStorage, BufferAccessType::StaticWrite)
+		, NodeNumber(0)
+		, TriangleNumber(0)
+		, UpdateNumber(0)
+	{}
+
+	void GPURayTracingScene::Update(const Scene& scene)
+	{
+		bool geometryChanged = UpdateGeometry(scene);
+		if (!geometryChanged && !ObjectsChanged(scene))
+			return; // the buffers keep their gpu copy
+
+		InstanceBuffer.ClearData();
+		InstanceSources.clear();
+		Objects.resize(scene.SceneObjects.size());
+
+		for (unsigned int o = 0; o < scene.SceneObjects.size(); ++o)
+		{
+			const SceneObject& sceneObject = scene.SceneObjects[o];
+			Objects[o] = ObjectRecord{ sceneObject.GetVersion(), sceneObject.Transform.GetVersion() };
+
+			std::shared_ptr<Model> model = sceneObject.GetSceneObjectModel().lock();
+			if (!model)
+				continue;
+
+			glm::mat4 objectToWorld = sceneObject.Transform.ToMatrix();
+			glm::mat4 worldToObject = glm::inverse(objectToWorld);
+
+			for (unsigned int m = 0; m < model->Meshes.size(); ++m)
+			{
+				const Mesh& mesh = model->Meshes[m];
+				if (mesh.BVH.GetNodeNumber() == 0 || mesh.GetPrimitive() != MeshPrimitive::Triangle)
+					continue;
+
+				const MeshRange& range = MeshRanges[mesh.GetID()];
+
+				RayInstanceBufferData instance{};
+				instance.WorldToObject = worldToObject;
+				instance.RootNode = range.RootNode;
+				instance.FirstTriangle = range.FirstTriangle;
+
+				// world space bounds of the mesh, from the 8 corners of its object space aabb
+				AABB worldBounds;
+				worldBounds.MinBound = glm::vec3(std::numeric_limits<float>::max());
+				worldBounds.MaxBound = glm::vec3(std::numeric_limits<float>::lowest());
+				const AABB& bounds = mesh.BVH.GetRootNode().AABoundingBox;
+				for (unsigned int c = 0; c < 8; ++c)
+				{
+					glm::vec3 corner
+					{
+						(c & 1) ? bounds.MaxBound.x : bounds.MinBound.x,
+						(c & 2) ? bounds.MaxBound.y : bounds.MinBound.y,
+						(c & 4) ? bounds.MaxBound.z : bounds.MinBound.z
+					};
+					worldBounds.BoundPoint(glm::vec3(objectToWorld * glm::vec4(corner, 1.0f)));
+				}
+				instance.WorldMinBound = worldBounds.MinBound;
+				instance.WorldMaxBound = worldBounds.MaxBound;
+
+				InstanceBuffer.AddData(instance);
+				InstanceSources.push_back(RayInstanceSource{ o, m });
+			}
+		}
+	}
+
+	void GPURayTracingScene::Clear()
+	{
+		NodeBuffer.ClearData();
+		TriangleBuffer.ClearData();
+		InstanceBuffer.ClearData();
+		MeshRanges.clear();
+		Objects.clear();
+		InstanceSources.clear();
+		NodeNumber = 0;
+		TriangleNumber = 0;
+	}
+
+	SceneRayHit GPURayTracingScene::ResolveHit(const RayHitBufferData& hit, const std::vector<RayInstanceSource>& instanceSources)
+	{
+		SceneRayHit result{};
+		result.Incomplete = hit.Overflow != 0;
+		result.Hit = !result.Incomplete && hit.InstanceIndex >= 0 && (unsigned int)hit.InstanceIndex < instanceSources.size();
+
+		if (result.Hit)
+		{
+			const RayInstanceSource& source = instanceSources[hit.InstanceIndex];
+			result.HitDistance = hit.HitDistance;
+			result.SceneObjectIndex = source.SceneObjectIndex;
+			result.MeshIndex = source.MeshIndex;
+			result.TriangleIndex = hit.TriangleIndex;
+			result.Barycentrics = hit.Barycentrics;
+		}
+
+		return result;
+	}
+
+	const std::vector<RayInstanceSource>& GPURayTracingScene::GetInstanceSources() const
+	{
+		return InstanceSources;
+	}
+
+	DynamicBuffer<BVHNodeBufferData>& GPURayTracingScene::GetNodeBuffer()
+	{
+		return NodeBuffer;
+	}
+
+	DynamicBuffer<TriangleBufferData>& GPURayTracingScene::GetTriangleBuffer()
+	{
+		return TriangleBuffer;
+	}
+
+	DynamicBuffer<RayInstanceBufferData>& GPURayTracingScene::GetInstanceBuffer()
+	{
+		return InstanceBuffer;
+	}
+
+	bool GPURayTracingScene::UpdateGeometry(const Scene& scene)
+	{
+		++UpdateNumber;
+		SceneMeshes.clear();
+
+		// Meshes of the scene, marking the flattened ones that are still valid
+		unsigned int validRanges = 0;
+		for (const SceneObject& sceneObject : scene.SceneObjects)
+		{
+			std::shared_ptr<Model> model = sceneObject.GetSceneObjectModel().lock();
+			if (!model)
+				continue;
+
+			for (const Mesh& mesh : model->Meshes)
+			{
+				if (mesh.BVH.GetNodeNumber() == 0 || mesh.GetPrimitive() != MeshPrimitive::Triangle)
+					continue;
+
+				SceneMeshes.push_back(&mesh);
+
+				auto rangeIt = MeshRanges.find(mesh.GetID());
+				if (rangeIt != MeshRanges.end() && rangeIt->second.MeshVersion == mesh.GetVersion() && rangeIt->second.LastUpdate != UpdateNumber)
+				{
+					rangeIt->second.LastUpdate = UpdateNumber;
+					++validRanges;
+				}
+			}
+		}
+
+		// Changed or released meshes leave holes in the buffers: flatten everything again
+		bool changed = validRanges != MeshRanges.size();
+		if (changed)
+		{
+			NodeBuffer.ClearData();
+			TriangleBuffer.ClearData();
+			MeshRanges.clear();
+			NodeNumber = 0;
+			TriangleNumber = 0;
+		}
+
+		// New meshes are appended
+		for (const Mesh* mesh : SceneMeshes)
+		{
+			if (MeshRanges.find(mesh->GetID()) == MeshRanges.end())
+			{
+				FlattenMesh(*mesh);
+				changed = true;
+			}
+		}
+
+		return changed;
+	}
+
+	bool GPURayTracingScene::ObjectsChanged(const Scene& scene) const
+	{
+		if (Objects.size() != scene.SceneObjects.size())
+			return true;
+
+		for (unsigned int o = 0; o < scene.SceneObjects.size(); ++o)
+		{
+			const SceneObject& sceneObject = scene.SceneObjects[o];
+			if (Objects[o].ObjectVersion != sceneObject.GetVersion() || Objects[o].TransformVersion != sceneObject.Transform.GetVersion())
+				return true;
+		}
+
+		return false;
+	}
+
+	void GPURayTracingScene::FlattenMesh(const Mesh& mesh)
+	{
+		MeshRange range{ mesh.GetVersion(), NodeNumber, TriangleNumber, UpdateNumber };
+
+		// nodes, with child and triangle indices made global
+		for (unsigned int n = 0; n < mesh.BVH.GetNodeNumber(); ++n)
+		{
+			const BVHNode& node = mesh.BVH.GetNode(n);
+
+			BVHNodeBufferData data{};
+			data.MinBound = node.AABoundingBox.MinBound;
+			data.MaxBound = node.AABoundingBox.MaxBound;
+			if (node.IsLeaf())
+			{
+				data.LeftOrFirst = range.FirstTriangle + node.LeftOrFirst / 3;
+				data.TriangleCount = node.IndexCount / 3;
+			}
+			else
+			{
+				data.LeftOrFirst = range.RootNode + node.LeftOrFirst;
+				data.TriangleCount = 0;
+			}
+
+			NodeBuffer.AddData(data);
+		}
+
+		// triangles, in the same order of the indices sorted by the BVH build
+		const std::vector<MeshVertexData>& vertices = mesh.GetVertices();
+		const std::vector<unsigned int>& indices = mesh.GetIndices();
+		for (unsigned int i = 0; i + 2 < indices.size(); i += 3)
+		{
+			TriangleBufferData data{};
+			data.Vertex0 = glm::vec4(vertices[indices[i]].Position, 1.0f);
+			data.Vertex1 = glm::vec4(vertices[indices[i + 1]].Position, 1.0f);
+			data.Vertex2 = glm::vec4(vertices[indices[i + 2]].Position, 1.0f);
+
+			TriangleBuffer.AddData(data);
+		}
+
+		NodeNumber += mesh.BVH.GetNodeNumber();
+		TriangleNumber += (unsigned int)indices.size() / 3;
+		MeshRanges.emplace(mesh.GetID(), range);
+	}
+}
@@ -0,0 +1,92 @@
+// Scene geometry flattened into gpu buffers, to cast rays in compute shaders
+// The BVHs of the meshes are copied as they are (one bottom level hierarchy per mesh), while the mesh instances are tested one after the other
+
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include <Systems/RenderingSystem/Entities/Buffer.hpp>
+#include <Systems/RenderingSystem/Entities/BufferData/RayTracingBufferData.h>
+#include "SceneRayHit.h"
+
+namespace GaladHen
+{
+	class Scene;
+	class Mesh;
+
+	// Scene object and mesh of an instance inside the instance buffer
+	struct RayInstanceSource
+	{
+		unsigned int SceneObjectIndex;
+		unsigned int MeshIndex;
+	};
+
+	class GPURayTracingScene
+	{
+	public:
+
+		GPURayTracingScene();
+
+		// @brief
+		// Flatten the scene into the buffers, changing them only if something changed since the last update
+		// The geometry of a new mesh is appended, while changed or removed meshes make all the geometry flattened again to keep the buffers compact
+		// Meshes without BVH or not made of triangles are ignored
+		void Update(const Scene& scene);
+
+		// @brief
+		// Remove all the flattened data
+		void Clear();
+
+		// @brief
+		// Convert a hit found on gpu into scene indices. A hit whose traversal overflowed is marked as incomplete and not as a hit
+		// @param instanceSources: the instances at the moment of the ray cast
+		static SceneRayHit ResolveHit(const RayHitBufferData& hit, const std::vector<RayInstanceSource>& instanceSources);
+
+		// @returns the instances of the last update
+		const std::vector<RayInstanceSource>& GetInstanceSources() const;
+
+		DynamicBuffer<BVHNodeBufferData>& GetNodeBuffer();
+		DynamicBuffer<TriangleBufferData>& GetTriangleBuffer();
+		DynamicBuffer<RayInstanceBufferData>& GetInstanceBuffer();
+
+	protected:
+
+		void FlattenMesh(const Mesh& mesh);
+
+		struct MeshRange
+		{
+			unsigned int MeshVersion;
+			unsigned int RootNode;
+			unsigned int FirstTriangle;
+			unsigned int LastUpdate; // last update that found the mesh in the scene
+		};
+
+		struct ObjectRecord
+		{
+			unsigned int ObjectVersion;
+			unsigned int TransformVersion;
+		};
+
+		// @returns true if the geometry buffers changed
+		bool UpdateGeometry(const Scene& scene);
+
+		// @returns true if the instances of the scene objects changed
+		bool ObjectsChanged(const Scene& scene) const;
+
+		DynamicBuffer<BVHNodeBufferData> NodeBuffer;
+		DynamicBuffer<TriangleBufferData> TriangleBuffer;
+		DynamicBuffer<RayInstanceBufferData> InstanceBuffer;
+
+		std::unordered_map<unsigned int, MeshRange> MeshRanges; // where the geometry of each flattened mesh starts inside the buffers, by mesh id
+		std::vector<const Mesh*> SceneMeshes; // meshes found by the current update
+		std::vector<ObjectRecord> Objects; // indexed as the scene objects of the last update
+		std::vector<RayInstanceSource> InstanceSources;
+		unsigned int NodeNumber;
+		unsigned int TriangleNumber;
+		unsigned int UpdateNumber;
+
+	};
+}
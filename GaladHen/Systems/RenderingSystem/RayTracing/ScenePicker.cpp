@@ -0,0 +1,307 @@
+#include "ScenePicker.h"
+
+#include <Systems/RenderingSystem/Entities/Scene.h>
+#include <Systems/RenderingSystem/Entities/Model.h>
+#include <Math/Math.h>
+#include <Math/Ray.h>
+#include <Math/BVH/BVH.h>
+#include <Utils/Log.h>
+
+#include <limits>
+#include <algorithm>
+
+#define GH_PICKER_MAX_INSTANCES_PER_LEAF 2
+#define GH_PICKER_STACK_SIZE 64
+
+namespace GaladHen
+{
+	ScenePicker::ScenePicker()
+		: SceneObjectNumber(0)
+	{}
+
+	void ScenePicker::Build(const Scene& scene)
+	{
+		Instances.clear();
+		Nodes.clear();
+		SceneObjectNumber = (unsigned int)scene.SceneObjects.size();
+
+		Instances.reserve(scene.SceneObjects.size());
+		for (unsigned int o = 0; o < scene.SceneObjects.size(); ++o)
+		{
+			PickInstance instance;
+			instance.SceneObjectIndex = o;
+			if (UpdateInstance(scene, instance))
+				Instances.push_back(instance);
+		}
+
+		if (Instances.empty())
+			return;
+
+		// a binary tree has at most 2n - 1 nodes
+		Nodes.reserve(Instances.size() * 2 - 1);
+
+		PickNode root;
+		root.LeftOrFirst = 0;
+		root.Count = (unsigned int)Instances.size();
+		UpdateNodeBounds(root);
+		Nodes.push_back(root);
+
+		Subdivide(0);
+	}
+
+	void ScenePicker::Refit(const Scene& scene)
+	{
+		// added or removed scene objects are not in the hierarchy
+		if (scene.SceneObjects.size() != SceneObjectNumber)
+		{
+			Build(scene);
+			return;
+		}
+
+		for (PickInstance& instance : Instances)
+		{
+			if (!UpdateInstance(scene, instance))
+			{
+				// the scene changed from the last build: the hierarchy is not valid anymore
+				Build(scene);
+				return;
+			}
+		}
+
+		// children are always stored after their parent, so going backward updates them first
+		for (unsigned int i = (unsigned int)Nodes.size(); i-- > 0; )
+		{
+			PickNode& node = Nodes[i];
+			if (node.Count > 0)
+			{
+				UpdateNodeBounds(node);
+			}
+			else
+			{
+				node.AABoundingBox = Nodes[node.LeftOrFirst].AABoundingBox;
+				node.AABoundingBox.BoundAABB(Nodes[node.LeftOrFirst + 1].AABoundingBox);
+			}
+		}
+	}
+
+	void ScenePicker::Clear()
+	{
+		Instances.clear();
+		Nodes.clear();
+		SceneObjectNumber = 0;
+	}
+
+	SceneRayHit ScenePicker::Pick(const Ray& ray) const
+	{
+		SceneRayHit result{};
+		result.Hit = false;
+		result.Incomplete = false;
+		result.HitDistance = std::numeric_limits<float>::max();
+
+		if (Nodes.empty())
+			return result;
+
+		Ray worldRay = ray;
+
+		if (!Math::RayAABBIntersection(worldRay, Nodes[0].AABoundingBox).Hit())
+			return result;
+
+		// front to back traversal with a fixed size stack: no allocations, so it can run every frame
+		unsigned int stack[GH_PICKER_STACK_SIZE];
+		unsigned int stackSize = 0;
+		unsigned int nodeIndex = 0;
+
+		while (true)
+		{
+			const PickNode& node = Nodes[nodeIndex];
+
+			if (node.Count > 0)
+			{
+				for (unsigned int i = node.LeftOrFirst; i < node.LeftOrFirst + node.Count; ++i)
+				{
+					const PickInstance& instance = Instances[i];
+					if (!Math::RayAABBIntersection(worldRay, instance.WorldBounds).Hit())
+						continue;
+
+					// intersect in object space, so the mesh bvh can be reused whatever the transform is
+					float distanceScale;
+					Ray objectRay = Math::TransformRay(worldRay, instance.WorldToObject, distanceScale);
+
+					const std::vector<Mesh>& meshes = instance.InstanceModel->Meshes;
+					for (unsigned int m = 0; m < meshes.size(); ++m)
+					{
+						const Mesh& mesh = meshes[m];
+						if (mesh.BVH.GetNodeNumber() == 0 || mesh.GetPrimitive() != MeshPrimitive::Triangle)
+							continue;
+
+						RayTriangleMeshHitInfo hit = mesh.BVH.CheckTriangleMeshIntersection(objectRay, mesh, BVHTraversalMethod::FrontToBack);
+						if (!hit.Hit())
+							continue;
+
+						float worldDistance = hit.HitDistance / distanceScale;
+						if (worldDistance < result.HitDistance)
+						{
+							result.Hit = true;
+							result.HitDistance = worldDistance;
+							result.SceneObjectIndex = instance.SceneObjectIndex;
+							result.MeshIndex = m;
+							result.TriangleIndex = hit.TriangleIndex;
+							result.Barycentrics = hit.UV;
+
+							// shortening the rays discards everything further than the current hit
+							objectRay.Length = hit.HitDistance;
+							worldRay.Length = worldDistance;
+						}
+					}
+				}
+			}
+			else
+			{
+				unsigned int child1 = node.LeftOrFirst;
+				unsigned int child2 = node.LeftOrFirst + 1;
+
+				RayHitInfo info1 = Math::RayAABBIntersection(worldRay, Nodes[child1].AABoundingBox);
+				RayHitInfo info2 = Math::RayAABBIntersection(worldRay, Nodes[child2].AABoundingBox);
+
+				if (info1.HitDistance > info2.HitDistance)
+				{
+					std::swap(info1, info2);
+					std::swap(child1, child2);
+				}
+
+				if (info1.Hit())
+				{
+					if (info2.Hit())
+					{
+						// the far child is skipped: the hit may not be the closest one
+						if (stackSize < GH_PICKER_STACK_SIZE)
+							stack[stackSize++] = child2;
+						else
+							result.Incomplete = true;
+					}
+
+					nodeIndex = child1;
+					continue;
+				}
+			}
+
+			// next node still worth visiting, skipping the ones further than the closest hit
+			bool found = false;
+			while (stackSize > 0 && !found)
+			{
+				nodeIndex = stack[--stackSize];
+				found = Math::RayAABBIntersection(worldRay, Nodes[nodeIndex].AABoundingBox).Hit();
+			}
+
+			if (!found)
+				break;
+		}
+
+		if (result.Incomplete)
+			Log::Warning("ScenePicker", "The pick overflowed the traversal stack: the hit may not be the closest one");
+
+		return result;
+	}
+
+	unsigned int ScenePicker::GetPickableObjectNumber() const
+	{
+		return (unsigned int)Instances.size();
+	}
+
+	bool ScenePicker::UpdateInstance(const Scene& scene, PickInstance& instance)
+	{
+		const SceneObject& sceneObject = scene.SceneObjects[instance.SceneObjectIndex];
+		std::shared_ptr<Model> model = sceneObject.GetSceneObjectModel().lock();
+		if (!model)
+			return false;
+
+		instance.InstanceModel = model.get(); // models are owned by the asset system and outlive the picker
+		glm::mat4 objectToWorld = sceneObject.Transform.ToMatrix();
+		instance.WorldToObject = glm::inverse(objectToWorld);
+		instance.WorldBounds.MinBound = glm::vec3(std::numeric_limits<float>::max());
+		instance.WorldBounds.MaxBound = glm::vec3(std::numeric_limits<float>::lowest());
+
+		bool hasGeometry = false;
+		for (const Mesh& mesh : model->Meshes)
+		{
+			if (mesh.BVH.GetNodeNumber() == 0 || mesh.GetPrimitive() != MeshPrimitive::Triangle)
+				continue;
+
+			// world space bounds of the mesh, from the 8 corners of its object space aabb
+			const AABB& bounds = mesh.BVH.GetRootNode().AABoundingBox;
+			for (unsigned int c = 0; c < 8; ++c)
+			{
+				glm::vec3 corner
+				{
+					(c & 1) ? bounds.MaxBound.x : bounds.MinBound.x,
+					(c & 2) ? bounds.MaxBound.y : bounds.MinBound.y,
+					(c & 4) ? bounds.MaxBound.z : bounds.MinBound.z
+				};
+				instance.WorldBounds.BoundPoint(glm::vec3(objectToWorld * glm::vec4(corner, 1.0f)));
+			}
+
+			hasGeometry = true;
+		}
+
+		return hasGeometry;
+	}
+
+	void ScenePicker::Subdivide(unsigned int nodeIndex)
+	{
+		if (Nodes[nodeIndex].Count <= GH_PICKER_MAX_INSTANCES_PER_LEAF)
+			return;
+
+		const unsigned int first = Nodes[nodeIndex].LeftOrFirst;
+		const unsigned int count = Nodes[nodeIndex].Count;
+
+		// midpoint split of the centroids bounds along their longest axis
+		AABB centroidBounds;
+		centroidBounds.MinBound = glm::vec3(std::numeric_limits<float>::max());
+		centroidBounds.MaxBound = glm::vec3(std::numeric_limits<float>::lowest());
+		for (unsigned int i = first; i < first + count; ++i)
+			centroidBounds.BoundPoint(Instances[i].WorldBounds.Center());
+
+		unsigned int axis = centroidBounds.LongestAxis();
+		float splitCoordinate = centroidBounds.MidpointSplitAlongAxis(axis);
+
+		std::vector<PickInstance>::iterator begin = Instances.begin() + first;
+		std::vector<PickInstance>::iterator middle = std::partition(begin, begin + count,
+			[axis, splitCoordinate](PickInstance& instance) { return instance.WorldBounds.Center()[axis] < splitCoordinate; });
+
+		unsigned int leftCount = (unsigned int)(middle - begin);
+		if (leftCount == 0 || leftCount == count)
+		{
+			// all the centroids are in the same place: split in half
+			leftCount = count / 2;
+		}
+
+		PickNode left;
+		left.LeftOrFirst = first;
+		left.Count = leftCount;
+		UpdateNodeBounds(left);
+
+		PickNode right;
+		right.LeftOrFirst = first + leftCount;
+		right.Count = count - leftCount;
+		UpdateNodeBounds(right);
+
+		unsigned int leftIndex = (unsigned int)Nodes.size();
+		Nodes.push_back(left);
+		Nodes.push_back(right);
+
+		Nodes[nodeIndex].LeftOrFirst = leftIndex;
+		Nodes[nodeIndex].Count = 0;
+
+		Subdivide(leftIndex);
+		Subdivide(leftIndex + 1);
+	}
+
+	void ScenePicker::UpdateNodeBounds(PickNode& node)
+	{
+		node.AABoundingBox.MinBound = glm::vec3(std::numeric_limits<float>::max());
+		node.AABoundingBox.MaxBound = glm::vec3(std::numeric_limits<float>::lowest());
+
+		for (unsigned int i = node.LeftOrFirst; i < node.LeftOrFirst + node.Count; ++i)
+			node.AABoundingBox.BoundAABB(Instances[i].WorldBounds);
+	}
+}
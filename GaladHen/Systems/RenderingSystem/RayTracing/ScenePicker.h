@@ -0,0 +1,77 @@
+// Cpu ray casting against a whole scene, fast enough to run every frame (ex: editor mouse picking and hovering)
+// A top level BVH bounds the scene objects in world space, then the rays are tested against the BVHs of the meshes in object space
+
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <Math/AABB/AABB.h>
+#include "SceneRayHit.h"
+
+namespace GaladHen
+{
+	class Scene;
+	class Model;
+	struct Ray;
+
+	class ScenePicker
+	{
+	public:
+
+		ScenePicker();
+
+		// @brief
+		// Build the top level hierarchy over the scene objects
+		// Meshes without BVH or not made of triangles are ignored
+		void Build(const Scene& scene);
+
+		// @brief
+		// Update the bounds of the scene objects keeping the current hierarchy, much cheaper than a build
+		// If scene objects were added, removed or lost their model since the last build, the hierarchy is built again
+		void Refit(const Scene& scene);
+
+		// @brief
+		// Remove the hierarchy: nothing will be picked until the next build
+		void Clear();
+
+		// @brief
+		// Find the closest scene object hit by a world space ray
+		// @returns the hit info; indices are meaningful only if Hit is true; Incomplete is true if the hierarchy was too deep for the traversal stack
+		SceneRayHit Pick(const Ray& ray) const;
+
+		unsigned int GetPickableObjectNumber() const;
+
+	protected:
+
+		struct PickInstance
+		{
+			unsigned int SceneObjectIndex;
+			const Model* InstanceModel;
+			glm::mat4 WorldToObject;
+			AABB WorldBounds;
+		};
+
+		struct PickNode
+		{
+			AABB AABoundingBox;
+			unsigned int LeftOrFirst; // first child node if Count == 0, first instance otherwise
+			unsigned int Count;
+		};
+
+		// @brief
+		// Update matrix and world bounds of an instance from its scene object
+		// @returns false if the scene object has nothing to pick
+		static bool UpdateInstance(const Scene& scene, PickInstance& instance);
+
+		void Subdivide(unsigned int nodeIndex);
+
+		void UpdateNodeBounds(PickNode& node);
+
+		std::vector<PickInstance> Instances;
+		std::vector<PickNode> Nodes;
+		unsigned int SceneObjectNumber; // of the scene at the last build
+
+	};
+}
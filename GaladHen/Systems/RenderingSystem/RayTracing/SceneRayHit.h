@@ -0,0 +1,19 @@
+// Result of a ray cast against a whole scene, shared by the cpu and gpu ray casting
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace GaladHen
+{
+	struct SceneRayHit
+	{
+		bool Hit;
+		bool Incomplete; // the traversal could not visit the whole BVH, so the ray must be cast again in another way (e.g. on cpu)
+		float HitDistance;
+		unsigned int SceneObjectIndex;
+		unsigned int MeshIndex;
+		unsigned int TriangleIndex; // triangle made by the indices [3 * TriangleIndex, 3 * TriangleIndex + 2] of the mesh
+		glm::vec2 Barycentrics; // weights of the second and third vertex of the triangle
+	};
+}
@@ -0,0 +1,295 @@
+#include "RenderList.h"
+
+#include "Entities/Scene.h"
+#include "Entities/Model.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace GaladHen
+{
+	RenderList::RenderList(ResidencySet<Mesh>& meshesResidency, ResidencySet<Material>& materialsResidency)
+		: MeshesResidency(meshesResidency)
+		, MaterialsResidency(materialsResidency)
+		, Frame(0)
+		, RecordedScene(nullptr)
+		, InstanceTransformBuffer(DynamicBuffer<TransformBufferData>{ BufferType::ShaderStorage, BufferAccessType::StaticRead })
+		, InstanceBoundsBuffer(DynamicBuffer<InstanceBoundsBufferData>{ BufferType::ShaderStorage, BufferAccessType::StaticRead })
+		, Rebuilt(false)
+		, StaticVersion(0)
+	{}
+
+	unsigned int RenderList::Update(const Scene& scene, unsigned int frame)
+	{
+		Rebuilt = false;
+		Frame = frame;
+
+		// Scene objects are recognized by their position in the scene: adding or removing them regroups everything
+		if (RecordedScene != &scene || Objects.size() != scene.SceneObjects.size())
+		{
+			Rebuild(scene);
+			return (unsigned int)Objects.size();
+		}
+
+		unsigned int changedObjects = 0;
+		for (unsigned int i = 0; i < Objects.size(); ++i)
+		{
+			ObjectRecord& record = Objects[i];
+			const SceneObject& sceneObject = scene.SceneObjects[i];
+
+			if (record.ObjectVersion != sceneObject.GetVersion())
+			{
+				Rebuild(scene);
+				return (unsigned int)Objects.size();
+			}
+
+			if (record.TransformVersion == sceneObject.Transform.GetVersion())
+				continue;
+
+			UpdateTransform(sceneObject, record);
+			record.TransformVersion = sceneObject.Transform.GetVersion();
+			++changedObjects;
+
+			if (record.Static)
+				++StaticVersion;
+		}
+
+		if (changedObjects > 0)
+		{
+			for (unsigned int b = 0; b < Batches.size(); ++b)
+			{
+				if (!BatchesToBound[b])
+					continue;
+
+				UpdateBatchBounds(Batches[b]);
+				BatchesToBound[b] = false;
+			}
+		}
+
+		return changedObjects;
+	}
+
+	void RenderList::UpdateBatchesDepth(const Camera& camera)
+	{
+		const glm::vec3 cameraPosition = camera.Transform.GetPosition();
+		const glm::vec3 cameraFront = camera.Transform.GetFront();
+		const float inverseFar = 1.0f / camera.GetFar();
+
+		for (InstanceBatch& batch : Batches)
+		{
+			// nearest point of the bounds along the view direction
+			glm::vec3 center = (batch.InstancesBounds.MinBound + batch.InstancesBounds.MaxBound) * 0.5f;
+			glm::vec3 extents = (batch.InstancesBounds.MaxBound - batch.InstancesBounds.MinBound) * 0.5f;
+			float depth = glm::dot(center - cameraPosition, cameraFront) - glm::dot(extents, glm::abs(cameraFront));
+			batch.NearestDepth = depth * inverseFar;
+		}
+	}
+
+	const std::vector<InstanceBatch>& RenderList::GetBatches() const
+	{
+		return Batches;
+	}
+
+	DynamicBuffer<TransformBufferData>& RenderList::GetInstanceTransformBuffer()
+	{
+		return InstanceTransformBuffer;
+	}
+
+	const std::vector<AABB>& RenderList::GetInstanceBounds() const
+	{
+		return InstanceBounds;
+	}
+
+	DynamicBuffer<InstanceBoundsBufferData>& RenderList::GetInstanceBoundsBuffer()
+	{
+		return InstanceBoundsBuffer;
+	}
+
+	const glm::mat4& RenderList::GetInstanceModelMatrix(unsigned int slot) const
+	{
+		return static_cast<const TransformBufferData*>(InstanceTransformBuffer.GetData())[slot].ModelMatrix;
+	}
+
+	const std::vector<OccluderRecord>& RenderList::GetOccluders() const
+	{
+		return Occluders;
+	}
+
+	bool RenderList::WasRebuilt() const
+	{
+		return Rebuilt;
+	}
+
+	unsigned int RenderList::GetStaticVersion() const
+	{
+		return StaticVersion;
+	}
+
+	void RenderList::Clear()
+	{
+		ReleaseBatches(Batches);
+
+		RecordedScene = nullptr;
+		Objects.clear();
+		MeshRecords.clear();
+		SortedMeshRecords.clear();
+		InstanceBounds.clear();
+		BatchesToBound.clear();
+		Batches.clear();
+		Occluders.clear();
+		InstanceTransformBuffer.ClearData();
+		InstanceBoundsBuffer.ClearData();
+	}
+
+	void RenderList::Rebuild(const Scene& scene)
+	{
+		// previous batches are released after acquiring the new ones, so that assets still drawn never reach zero references
+		std::vector<InstanceBatch> previousBatches;
+		previousBatches.swap(Batches);
+		Clear();
+
+		RecordedScene = &scene;
+		Rebuilt = true;
+		++StaticVersion;
+
+		Objects.reserve(scene.SceneObjects.size());
+		for (unsigned int i = 0; i < scene.SceneObjects.size(); ++i)
+		{
+			const SceneObject& sceneObject = scene.SceneObjects[i];
+
+			ObjectRecord record{ sceneObject.GetSceneObjectModel().lock(), nullptr, sceneObject.IsStatic(), sceneObject.GetVersion(), sceneObject.Transform.GetVersion(), (unsigned int)MeshRecords.size(), 0 };
+			if (sceneObject.IsOccluder())
+				record.OccluderModel = sceneObject.GetOccluderModel().lock();
+			if (record.ObjectModel)
+			{
+				record.MeshRecordsNumber = (unsigned int)record.ObjectModel->Meshes.size();
+				for (unsigned int m = 0; m < record.MeshRecordsNumber; ++m)
+					MeshRecords.push_back(MeshRecord{ &record.ObjectModel->Meshes[m], sceneObject.GetMaterial(m).lock(), i, m, 0, 0 });
+			}
+
+			Objects.push_back(record);
+		}
+
+		// Same mesh and same material become adjacent, static instances of a mesh before the dynamic ones (shadows draw them separately)
+		SortedMeshRecords.resize(MeshRecords.size());
+		for (unsigned int r = 0; r < MeshRecords.size(); ++r)
+			SortedMeshRecords[r] = r;
+
+		std::sort(SortedMeshRecords.begin(), SortedMeshRecords.end(), [this](unsigned int a, unsigned int b)
+			{
+				const MeshRecord& recordA = MeshRecords[a];
+				const MeshRecord& recordB = MeshRecords[b];
+				if (recordA.RecordMesh != recordB.RecordMesh)
+					return recordA.RecordMesh < recordB.RecordMesh;
+				bool staticA = Objects[recordA.ObjectIndex].Static;
+				bool staticB = Objects[recordB.ObjectIndex].Static;
+				if (staticA != staticB)
+					return staticA;
+				return recordA.RecordMaterial.get() < recordB.RecordMaterial.get();
+			});
+
+		InstanceBounds.resize(MeshRecords.size());
+		for (unsigned int slot = 0; slot < SortedMeshRecords.size(); ++slot)
+		{
+			MeshRecord& record = MeshRecords[SortedMeshRecords[slot]];
+			bool isStatic = Objects[record.ObjectIndex].Static;
+
+			if (Batches.empty() || Batches.back().BatchMesh != record.RecordMesh || Batches.back().BatchMaterial != record.RecordMaterial.get() || Batches.back().Static != isStatic)
+			{
+				Batches.push_back(InstanceBatch{ record.RecordMesh, record.RecordMaterial.get(), slot, 0, AABB{}, AABB{}, 0.0f, isStatic });
+				Batches.back().MeshBounds.BuildAABB(Objects[record.ObjectIndex].ObjectModel->Meshes, record.MeshIndex, 1);
+			}
+
+			++Batches.back().InstanceCount;
+			record.InstanceSlot = slot;
+			record.BatchIndex = (unsigned int)Batches.size() - 1;
+
+			const Transform& transform = scene.SceneObjects[record.ObjectIndex].Transform;
+			TransformBufferData data{};
+			data.ModelMatrix = transform.ToMatrix();
+			data.NormalMatrix = glm::inverse(glm::transpose(data.ModelMatrix));
+			InstanceTransformBuffer.AddData(data);
+			InstanceBoundsBuffer.AddData(InstanceBoundsBufferData{});
+			SetInstanceBounds(slot, record.BatchIndex, data.ModelMatrix);
+		}
+
+		BatchesToBound.assign(Batches.size(), false);
+		for (InstanceBatch& batch : Batches)
+			UpdateBatchBounds(batch);
+
+		// all the instances of a scene object share its transform
+		for (const ObjectRecord& record : Objects)
+		{
+			if (record.OccluderModel && record.MeshRecordsNumber > 0)
+				Occluders.push_back(OccluderRecord{ record.OccluderModel.get(), MeshRecords[record.FirstMeshRecord].InstanceSlot });
+		}
+
+		AcquireBatches();
+		ReleaseBatches(previousBatches);
+	}
+
+	void RenderList::UpdateTransform(const SceneObject& sceneObject, const ObjectRecord& record)
+	{
+		TransformBufferData data{};
+		data.ModelMatrix = sceneObject.Transform.ToMatrix();
+		data.NormalMatrix = glm::inverse(glm::transpose(data.ModelMatrix));
+
+		for (unsigned int m = 0; m < record.MeshRecordsNumber; ++m)
+		{
+			const MeshRecord& meshRecord = MeshRecords[record.FirstMeshRecord + m];
+			InstanceTransformBuffer.SetData(data, meshRecord.InstanceSlot);
+			SetInstanceBounds(meshRecord.InstanceSlot, meshRecord.BatchIndex, data.ModelMatrix);
+			BatchesToBound[meshRecord.BatchIndex] = true;
+		}
+	}
+
+	void RenderList::SetInstanceBounds(unsigned int slot, unsigned int batchIndex, const glm::mat4& modelMatrix)
+	{
+		// the box around the transformed local box: the center moves with the transform, the extents are projected on the world axes
+		const AABB& meshBounds = Batches[batchIndex].MeshBounds;
+		glm::vec3 center = glm::vec3(modelMatrix * glm::vec4((meshBounds.MinBound + meshBounds.MaxBound) * 0.5f, 1.0f));
+		glm::vec3 extents = glm::mat3(glm::abs(glm::vec3(modelMatrix[0])), glm::abs(glm::vec3(modelMatrix[1])), glm::abs(glm::vec3(modelMatrix[2]))) * ((meshBounds.MaxBound - meshBounds.MinBound) * 0.5f);
+
+		AABB& bounds = InstanceBounds[slot];
+		bounds.MinBound = center - extents;
+		bounds.MaxBound = center + extents;
+
+		InstanceBoundsBufferData data{};
+		data.MinBound = bounds.MinBound;
+		data.DrawIndex = batchIndex;
+		data.MaxBound = bounds.MaxBound;
+		InstanceBoundsBuffer.SetData(data, slot);
+	}
+
+	void RenderList::UpdateBatchBounds(InstanceBatch& batch)
+	{
+		batch.InstancesBounds.MinBound = glm::vec3(std::numeric_limits<float>::max());
+		batch.InstancesBounds.MaxBound = glm::vec3(std::numeric_limits<float>::lowest());
+
+		for (unsigned int i = batch.FirstInstance; i < batch.FirstInstance + batch.InstanceCount; ++i)
+			batch.InstancesBounds.BoundAABB(InstanceBounds[i]);
+	}
+
+	void RenderList::AcquireBatches()
+	{
+		for (const InstanceBatch& batch : Batches)
+		{
+			const MeshRecord& record = MeshRecords[SortedMeshRecords[batch.FirstInstance]];
+
+			// the mesh is owned by its model, which is kept alive through the aliasing pointer
+			MeshesResidency.Acquire(std::shared_ptr<Mesh>(Objects[record.ObjectIndex].ObjectModel, record.RecordMesh));
+			if (record.RecordMaterial)
+				MaterialsResidency.Acquire(record.RecordMaterial);
+		}
+	}
+
+	void RenderList::ReleaseBatches(const std::vector<InstanceBatch>& batches)
+	{
+		for (const InstanceBatch& batch : batches)
+		{
+			MeshesResidency.Release(batch.BatchMesh, Frame);
+			if (batch.BatchMaterial)
+				MaterialsResidency.Release(batch.BatchMaterial, Frame);
+		}
+	}
+}
@@ -0,0 +1,135 @@
+// Draw records of the scene objects retained between frames: they are rebuilt only for the scene objects whose model, materials or transform changed
+// Scene objects sharing the same mesh and material are grouped in instance batches, drawn with a single instanced draw call
+
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include <Math/AABB/AABB.h>
+#include "Entities/Buffer.hpp"
+#include "Entities/BufferData/TransformBufferData.h"
+#include "Entities/BufferData/CullingBufferData.h"
+#include "ResidencySet.hpp"
+
+namespace GaladHen
+{
+	class Scene;
+	class SceneObject;
+	class Camera;
+	class Model;
+	class Mesh;
+	class Material;
+
+	struct InstanceBatch
+	{
+		Mesh* BatchMesh;
+		Material* BatchMaterial;
+		unsigned int FirstInstance; // index of the first instance transform inside the instance transform buffer
+		unsigned int InstanceCount;
+		AABB MeshBounds; // local bounds of the mesh
+		AABB InstancesBounds; // world bounds of all the instances
+		float NearestDepth; // view depth of the nearest instance from the camera, normalized by the far plane distance
+		bool Static; // instances of static scene objects only, see SceneObject::SetStatic
+	};
+
+	// A scene object hiding the ones behind it, drawn with the transform of its first instance
+	struct OccluderRecord
+	{
+		const Model* OccluderModel;
+		unsigned int InstanceSlot;
+	};
+
+	class RenderList
+	{
+	public:
+
+		// @param meshesResidency, materialsResidency: meshes and materials drawn by the batches are acquired in these sets, and released when no batch draws them anymore
+		RenderList(ResidencySet<Mesh>& meshesResidency, ResidencySet<Material>& materialsResidency);
+
+		// @brief
+		// Bring the draw records up to date with the scene
+		// Changes of models or materials regroup all the batches, while transform changes only rewrite the transforms of the changed scene objects
+		// Models and materials are kept alive by the list until the scene objects using them change
+		// @param frame: number of the current frame, for the residency releases
+		// @returns the number of scene objects whose records changed
+		unsigned int Update(const Scene& scene, unsigned int frame);
+
+		// @brief
+		// Calculate the view depth of the batches from a camera, to draw them front to back
+		void UpdateBatchesDepth(const Camera& camera);
+
+		// @returns the batches, sorted by mesh, then static before dynamic, then by material
+		const std::vector<InstanceBatch>& GetBatches() const;
+
+		// @returns transforms of all the instances, grouped by batch
+		DynamicBuffer<TransformBufferData>& GetInstanceTransformBuffer();
+
+		// @returns world bounds of all the instances, in the same order of the transforms
+		const std::vector<AABB>& GetInstanceBounds() const;
+
+		// @returns world bounds of all the instances with the index of their batch, in the same order of the transforms
+		DynamicBuffer<InstanceBoundsBufferData>& GetInstanceBoundsBuffer();
+
+		// @returns the model matrix of an instance
+		const glm::mat4& GetInstanceModelMatrix(unsigned int slot) const;
+
+		// @returns the scene objects marked as occluders
+		const std::vector<OccluderRecord>& GetOccluders() const;
+
+		// @returns whether the last update regrouped the batches
+		bool WasRebuilt() const;
+
+		// @returns a number changed by every update moving static instances or regrouping the batches, to know when static shadows must be rendered again
+		unsigned int GetStaticVersion() const;
+
+		void Clear();
+
+	protected:
+
+		struct ObjectRecord
+		{
+			std::shared_ptr<Model> ObjectModel;
+			std::shared_ptr<Model> OccluderModel; // null if the scene object is not an occluder
+			bool Static;
+			unsigned int ObjectVersion;
+			unsigned int TransformVersion;
+			unsigned int FirstMeshRecord;
+			unsigned int MeshRecordsNumber;
+		};
+
+		struct MeshRecord
+		{
+			Mesh* RecordMesh;
+			std::shared_ptr<Material> RecordMaterial;
+			unsigned int ObjectIndex;
+			unsigned int MeshIndex; // index of the mesh inside the model
+			unsigned int InstanceSlot; // index inside the instance transform buffer
+			unsigned int BatchIndex;
+		};
+
+		void Rebuild(const Scene& scene);
+		void UpdateTransform(const SceneObject& sceneObject, const ObjectRecord& record);
+		void SetInstanceBounds(unsigned int slot, unsigned int batchIndex, const glm::mat4& modelMatrix);
+		void UpdateBatchBounds(InstanceBatch& batch);
+		void AcquireBatches();
+		void ReleaseBatches(const std::vector<InstanceBatch>& batches);
+
+		ResidencySet<Mesh>& MeshesResidency;
+		ResidencySet<Material>& MaterialsResidency;
+		unsigned int Frame;
+		const Scene* RecordedScene;
+		std::vector<ObjectRecord> Objects; // indexed as the scene objects of the scene
+		std::vector<MeshRecord> MeshRecords;
+		std::vector<unsigned int> SortedMeshRecords;
+		std::vector<AABB> InstanceBounds; // indexed as the instance transforms
+		std::vector<bool> BatchesToBound;
+		std::vector<InstanceBatch> Batches;
+		std::vector<OccluderRecord> Occluders;
+		DynamicBuffer<TransformBufferData> InstanceTransformBuffer;
+		DynamicBuffer<InstanceBoundsBufferData> InstanceBoundsBuffer;
+		bool Rebuilt;
+		unsigned int StaticVersion;
+
+	};
+}
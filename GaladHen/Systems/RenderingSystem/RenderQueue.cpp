@@ -0,0 +1,143 @@
+#include "RenderQueue.h"
+
+#include <glm/glm.hpp>
+
+#define GH_SORT_KEY_PASS_BITS 4
+#define GH_SORT_KEY_PIPELINE_BITS 12
+#define GH_SORT_KEY_MATERIAL_BITS 16
+#define GH_SORT_KEY_MESH_BITS 16
+#define GH_SORT_KEY_DEPTH_BITS 16
+#define GH_RADIX_BITS 8
+#define GH_RADIX_BUCKETS (1 << GH_RADIX_BITS)
+
+namespace GaladHen
+{
+	static uint64_t KeyField(unsigned int value, unsigned int bits, unsigned int shift)
+	{
+		return ((uint64_t)value & ((1ull << bits) - 1)) << shift;
+	}
+
+	RenderQueue::RenderQueue(LinearArena& arena)
+		: Arena(arena)
+		, Commands(arena)
+		, Entries(ArenaAllocator<SortEntry>{ arena })
+	{}
+
+	uint64_t RenderQueue::MakeSortKey(unsigned int pass, unsigned int pipelineID, unsigned int materialID, unsigned int meshID, float normalizedDepth)
+	{
+		unsigned int depth = (unsigned int)(glm::clamp(normalizedDepth, 0.0f, 1.0f) * ((1 << GH_SORT_KEY_DEPTH_BITS) - 1));
+
+		unsigned int shift = 0;
+		uint64_t key = KeyField(depth, GH_SORT_KEY_DEPTH_BITS, shift);
+		shift += GH_SORT_KEY_DEPTH_BITS;
+		key |= KeyField(meshID, GH_SORT_KEY_MESH_BITS, shift);
+		shift += GH_SORT_KEY_MESH_BITS;
+		key |= KeyField(materialID, GH_SORT_KEY_MATERIAL_BITS, shift);
+		shift += GH_SORT_KEY_MATERIAL_BITS;
+		key |= KeyField(pipelineID, GH_SORT_KEY_PIPELINE_BITS, shift);
+		shift += GH_SORT_KEY_PIPELINE_BITS;
+		key |= KeyField(pass, GH_SORT_KEY_PASS_BITS, shift);
+
+		return key;
+	}
+
+	void RenderQueue::Reserve(unsigned int commandsNumber)
+	{
+		Commands.reserve(commandsNumber);
+		Entries.reserve(commandsNumber);
+	}
+
+	void RenderQueue::Add(uint64_t sortKey, const RenderCommand& command)
+	{
+		Entries.push_back(SortEntry{ sortKey, (unsigned int)Commands.size() });
+		Commands.push_back(command);
+	}
+
+	void RenderQueue::Sort()
+	{
+		const size_t number = Entries.size();
+		if (number < 2)
+			return;
+
+		// LSD radix sort, one byte at a time; bytes equal in all the keys are skipped
+		std::vector<SortEntry, ArenaAllocator<SortEntry>> scratch{ number, SortEntry{}, ArenaAllocator<SortEntry>{ Arena } };
+		SortEntry* source = Entries.data();
+		SortEntry* destination = scratch.data();
+
+		for (unsigned int shift = 0; shift < 64; shift += GH_RADIX_BITS)
+		{
+			size_t counts[GH_RADIX_BUCKETS] = {};
+			for (size_t i = 0; i < number; ++i)
+				++counts[(source[i].Key >> shift) & (GH_RADIX_BUCKETS - 1)];
+
+			if (counts[(source[0].Key >> shift) & (GH_RADIX_BUCKETS - 1)] == number)
+				continue;
+
+			size_t offset = 0;
+			for (unsigned int b = 0; b < GH_RADIX_BUCKETS; ++b)
+			{
+				size_t count = counts[b];
+				counts[b] = offset;
+				offset += count;
+			}
+
+			for (size_t i = 0; i < number; ++i)
+				destination[counts[(source[i].Key >> shift) & (GH_RADIX_BUCKETS - 1)]++] = source[i];
+
+			std::swap(source, destination);
+		}
+
+		// Reorder the commands following the sorted entries
+		CommandBuffer<RenderCommand> sorted{ Arena };
+		sorted.reserve(number);
+		for (size_t i = 0; i < number; ++i)
+		{
+			sorted.push_back(Commands[source[i].CommandIndex]);
+			source[i].CommandIndex = (unsigned int)i;
+		}
+
+		if (source != Entries.data())
+			std::copy(source, source + number, Entries.data());
+
+		Commands.swap(sorted);
+	}
+
+	void RenderQueue::Clear()
+	{
+		Commands.clear();
+		Entries.clear();
+	}
+
+	CommandBuffer<RenderCommand>& RenderQueue::GetCommands()
+	{
+		return Commands;
+	}
+
+	float RenderQueue::GetNormalizedDepth(unsigned int command) const
+	{
+		// entries and commands share the order, before and after sorting
+		uint64_t depth = Entries[command].Key & ((1ull << GH_SORT_KEY_DEPTH_BITS) - 1);
+		return (float)depth / ((1 << GH_SORT_KEY_DEPTH_BITS) - 1);
+	}
+
+	RenderStateChanges RenderQueue::CountStateChanges(const CommandBuffer<RenderCommand>& commands)
+	{
+		RenderStateChanges changes{};
+		changes.Commands = (unsigned int)commands.size();
+
+		const RenderCommand* previous = nullptr;
+		for (const RenderCommand& command : commands)
+		{
+			if (!previous || previous->ShaderSourceID != command.ShaderSourceID)
+				++changes.PipelineChanges;
+			if (!previous || previous->Material != command.Material)
+				++changes.MaterialChanges;
+			if (!previous || previous->DataSourceID != command.DataSourceID)
+				++changes.MeshChanges;
+
+			previous = &command;
+		}
+
+		return changes;
+	}
+}
@@ -0,0 +1,67 @@
+// Draws of a frame with a 64-bit sort key each, sorted before the submission to the renderer to minimize render state changes
+// Key layout, from the most significant bits: pass (4) | pipeline (12) | material (16) | mesh (16) | depth (16)
+// so that draws are grouped by pass, then by pipeline, material and mesh, and finally ordered front to back
+
+#pragma once
+
+#include <cstdint>
+
+#include "CommandBuffer.h"
+
+namespace GaladHen
+{
+	// Render state changes between consecutive commands of a submission
+	struct RenderStateChanges
+	{
+		unsigned int Commands;
+		unsigned int PipelineChanges;
+		unsigned int MaterialChanges;
+		unsigned int MeshChanges;
+	};
+
+	class RenderQueue
+	{
+	public:
+
+		// @param arena: memory of the commands and of the sort, valid until the arena is reset
+		RenderQueue(LinearArena& arena);
+
+		// @brief
+		// Pack the sort key of a draw. Ids are truncated to the bits available for them
+		// @param normalizedDepth: view depth in [0, 1] range (0 = near), used to draw front to back
+		static uint64_t MakeSortKey(unsigned int pass, unsigned int pipelineID, unsigned int materialID, unsigned int meshID, float normalizedDepth);
+
+		void Reserve(unsigned int commandsNumber);
+
+		void Add(uint64_t sortKey, const RenderCommand& command);
+
+		// @brief
+		// Sort the commands by key (radix sort, stable)
+		void Sort();
+
+		void Clear();
+
+		// @returns the commands, in sorted order after Sort()
+		CommandBuffer<RenderCommand>& GetCommands();
+
+		// @returns the view depth packed into the sort key of a command (ex: to sort the same draws again for another pass)
+		float GetNormalizedDepth(unsigned int command) const;
+
+		// @brief
+		// Count the state changes that submitting the commands in their current order would cause
+		static RenderStateChanges CountStateChanges(const CommandBuffer<RenderCommand>& commands);
+
+	protected:
+
+		struct SortEntry
+		{
+			uint64_t Key;
+			unsigned int CommandIndex;
+		};
+
+		LinearArena& Arena;
+		CommandBuffer<RenderCommand> Commands;
+		std::vector<SortEntry, ArenaAllocator<SortEntry>> Entries;
+
+	};
+}
@@ -14,29 +14,124 @@
 #include "Entities/Model.h"
 #include "Entities/ShaderPipeline.h"
 #include "Entities/Texture.h"
+#include <Math/Ray.h>
+#include <Math/Frustum.h>
+
+#include <algorithm>
 
 #define GH_DEFAULT_RENDER_BUFFER_WIDTH 1920
 #define GH_DEFAULT_RENDER_BUFFER_HEIGHT 1080
+#define GH_FRAME_ARENA_BYTES (1024 * 1024) // initial size, it grows to the peak usage of a frame
+#define GH_RESIDENCY_FREE_DELAY_FRAMES 3 // frames a released resource stays in gpu memory, so that short detachments do not reload it
 #define GH_CAMERA_DATA_BUFFER_NAME "CameraData"
-#define GH_TRANSFORM_DATA_BUFFER_NAME "TransformData"
+#define GH_INSTANCE_TRANSFORM_BUFFER_NAME "InstanceTransformBuffer"
 #define GH_LIGHTING_DATA_BUFFER_NAME "LightingData"
 #define GH_POINTLIGHT_DATA_BUFFER_NAME "PointLightBuffer"
 #define GH_DIRLIGHT_DATA_BUFFER_NAME "DirectionalLightBuffer"
+#define GH_IRRADIANCE_PROBE_DATA_BUFFER_NAME "IrradianceProbeBuffer"
+#define GH_IRRADIANCE_VOLUME_DATA_BUFFER_NAME "IrradianceVolumeData"
+#define GH_BVH_NODE_BUFFER_NAME "BVHNodeBuffer"
+#define GH_TRIANGLE_BUFFER_NAME "TriangleBuffer"
+#define GH_RAY_INSTANCE_BUFFER_NAME "RayInstanceBuffer"
+#define GH_RAY_BUFFER_NAME "RayBuffer"
+#define GH_RAY_HIT_BUFFER_NAME "RayHitBuffer"
+#define GH_RAY_CAST_GROUP_SIZE 64 // must match local_size_x of the ray cast compute shader
+#define GH_CULLING_DATA_BUFFER_NAME "CullingData"
+#define GH_INSTANCE_BOUNDS_BUFFER_NAME "InstanceBoundsBuffer"
+#define GH_CULLING_DRAW_BUFFER_NAME "CullingDrawBuffer"
+#define GH_CULLING_GROUP_BUFFER_NAME "CullingGroupBuffer"
+#define GH_DRAW_COMMAND_BUFFER_NAME "DrawCommandBuffer"
+#define GH_VISIBLE_INSTANCE_BUFFER_NAME "VisibleInstanceBuffer"
+#define GH_CULLING_GROUP_SIZE 64 // must match local_size_x of the culling compute shaders
 #define GH_SHADOW_MAP_SAMPLER_NAME "ShadowMap"
-#define GH_LIGHTSPACEMATRIX_UNIFORM_NAME "LightSpaceMatrix"
+#define GH_SHADOW_CASCADE_DATA_BUFFER_NAME "ShadowCascadeData"
+#define GH_SHADOW_ATLAS_SAMPLER_NAME "ShadowAtlas"
+#define GH_POINT_LIGHT_SHADOW_BUFFER_NAME "PointLightShadowBuffer"
+
+#define GH_LIGHT_CLUSTER_DATA_BUFFER_NAME "LightClusterData"
+#define GH_LIGHT_CLUSTER_GRID_BUFFER_NAME "ClusterLightGridBuffer"
+#define GH_LIGHT_CLUSTER_INDEX_BUFFER_NAME "ClusterLightIndexBuffer"
+
+#define GH_GBUFFER_PASS_DEFINE "#define GH_GBUFFER_PASS" // compiles the variant of a scene pipeline writing the g-buffer
+#define GH_GBUFFER_DIFFUSE_SAMPLER_NAME "GBufferDiffuse"
+#define GH_GBUFFER_NORMAL_SAMPLER_NAME "GBufferNormal"
+#define GH_GBUFFER_MATERIAL_SAMPLER_NAME "GBufferMaterial"
+#define GH_GBUFFER_DEPTH_SAMPLER_NAME "GBufferDepth"
+#define GH_INVERSE_VIEW_PROJECTION_NAME "InverseViewProjection"
+#define GH_SHADOW_PASS 0 // sort key passes, in drawing order
+#define GH_SCENE_PASS 1
+#define GH_DEPTH_PREPASS 2
 
 namespace GaladHen
 {
+    // Parameter names interned once, so that building the commands does not register strings at every frame
+    static const ShaderParameterName CameraDataName(GH_CAMERA_DATA_BUFFER_NAME);
+    static const ShaderParameterName InstanceTransformBufferName(GH_INSTANCE_TRANSFORM_BUFFER_NAME);
+    static const ShaderParameterName LightingDataName(GH_LIGHTING_DATA_BUFFER_NAME);
+    static const ShaderParameterName PointLightBufferName(GH_POINTLIGHT_DATA_BUFFER_NAME);
+    static const ShaderParameterName DirLightBufferName(GH_DIRLIGHT_DATA_BUFFER_NAME);
+    static const ShaderParameterName IrradianceProbeBufferName(GH_IRRADIANCE_PROBE_DATA_BUFFER_NAME);
+    static const ShaderParameterName IrradianceVolumeDataName(GH_IRRADIANCE_VOLUME_DATA_BUFFER_NAME);
+    static const ShaderParameterName BVHNodeBufferName(GH_BVH_NODE_BUFFER_NAME);
+    static const ShaderParameterName TriangleBufferName(GH_TRIANGLE_BUFFER_NAME);
+    static const ShaderParameterName RayInstanceBufferName(GH_RAY_INSTANCE_BUFFER_NAME);
+    static const ShaderParameterName RayBufferName(GH_RAY_BUFFER_NAME);
+    static const ShaderParameterName RayHitBufferName(GH_RAY_HIT_BUFFER_NAME);
+    static const ShaderParameterName CullingDataName(GH_CULLING_DATA_BUFFER_NAME);
+    static const ShaderParameterName InstanceBoundsBufferName(GH_INSTANCE_BOUNDS_BUFFER_NAME);
+    static const ShaderParameterName CullingDrawBufferName(GH_CULLING_DRAW_BUFFER_NAME);
+    static const ShaderParameterName CullingGroupBufferName(GH_CULLING_GROUP_BUFFER_NAME);
+    static const ShaderParameterName DrawCommandBufferName(GH_DRAW_COMMAND_BUFFER_NAME);
+    static const ShaderParameterName VisibleInstanceBufferName(GH_VISIBLE_INSTANCE_BUFFER_NAME);
+    static const ShaderParameterName ShadowMapName(GH_SHADOW_MAP_SAMPLER_NAME);
+    static const ShaderParameterName ShadowCascadeDataName(GH_SHADOW_CASCADE_DATA_BUFFER_NAME);
+    static const ShaderParameterName ShadowAtlasName(GH_SHADOW_ATLAS_SAMPLER_NAME);
+    static const ShaderParameterName PointLightShadowBufferName(GH_POINT_LIGHT_SHADOW_BUFFER_NAME);
+    static const ShaderParameterName LightClusterDataName(GH_LIGHT_CLUSTER_DATA_BUFFER_NAME);
+    static const ShaderParameterName LightClusterGridBufferName(GH_LIGHT_CLUSTER_GRID_BUFFER_NAME);
+    static const ShaderParameterName LightClusterIndexBufferName(GH_LIGHT_CLUSTER_INDEX_BUFFER_NAME);
+    static const ShaderParameterName GBufferDiffuseName(GH_GBUFFER_DIFFUSE_SAMPLER_NAME);
+    static const ShaderParameterName GBufferNormalName(GH_GBUFFER_NORMAL_SAMPLER_NAME);
+    static const ShaderParameterName GBufferMaterialName(GH_GBUFFER_MATERIAL_SAMPLER_NAME);
+    static const ShaderParameterName GBufferDepthName(GH_GBUFFER_DEPTH_SAMPLER_NAME);
+    static const ShaderParameterName InverseViewProjectionName(GH_INVERSE_VIEW_PROJECTION_NAME);
+
+    // Attachments of the g-buffer, in the order of GBuffer.glsl
+    static const TextureFormat GBufferFormats[] = { TextureFormat::RGBA8, TextureFormat::RGBA16F, TextureFormat::RGBA8 };
+
     RenderingSystem::RenderingSystem()
         : CurrentAPI(GH_CURRENT_API)
         , RendererAPI(nullptr)
         , Initialized(false)
+        , FrameArena(GH_FRAME_ARENA_BYTES)
+        , LoadedMeshesVersion(0)
+        , LoadedMaterialsVersion(0)
+        , LoadedTexturesVersion(0)
+        , FrameNumber(0)
+        , CameraBuffer(FixedBuffer<CameraBufferData, 1>{ BufferType::Uniform, BufferAccessType::StreamWrite }) // TODO: populate buffer basing on API (to match shader data structure)
+        , LightingBuffer(FixedBuffer<LightingBufferData, 1>{ BufferType::Uniform, BufferAccessType::StreamWrite }) // TODO: populate buffer basing on API (to match shader data structure)s
+        , PointLightBuffer(DynamicBuffer<PointLightBufferData>{ BufferType::ShaderStorage, BufferAccessType::StreamWrite }) // TODO: populate buffer basing on API (to match shader data structure)
+        , DirLightBuffer(DynamicBuffer<DirLightBufferData>{ BufferType::ShaderStorage, BufferAccessType::StreamWrite }) // TODO: populate buffer basing on API (to match shader data structure)
+        , IrradianceProbeBuffer(DynamicBuffer<IrradianceProbeBufferData>{ BufferType::ShaderStorage, BufferAccessType::StaticRead })
+        , IrradianceVolumeBuffer(FixedBuffer<IrradianceVolumeBufferData, 1>{ BufferType::Uniform, BufferAccessType::StaticRead })
+        , LoadedIrradianceVolumeVersion(0)
+        , ShadowCascadeBuffer(FixedBuffer<ShadowCascadeBufferData, 1>{ BufferType::Uniform, BufferAccessType::StreamWrite })
+        , StaticShadowCaches()
+        , SceneRenderList(MeshResidency, MaterialResidency)
+        , FrustumCulling(true)
+        , MinScreenSize(0.0f)
+        , OcclusionCulling(false)
+        , OcclusionQueries(false)
+        , InverseViewProjection(1.0f)
+        , GPUDrivenDrawing(false)
+        , CullingBuffer(FixedBuffer<CullingBufferData, 1>{ BufferType::Uniform, BufferAccessType::StreamWrite })
+        , CullingDrawBuffer(DynamicBuffer<CullingDrawBufferData>{ BufferType::ShaderStorage, BufferAccessType::StreamWrite })
+        , CullingGroupBuffer(DynamicBuffer<CullingGroupBufferData>{ BufferType::ShaderStorage, BufferAccessType::StreamWrite })
+        , DrawCommandBuffer(DynamicBuffer<DrawCommandBufferData>{ BufferType::ShaderStorage, BufferAccessType::StaticRead })
+        , VisibleInstanceBuffer(DynamicBuffer<unsigned int>{ BufferType::ShaderStorage, BufferAccessType::StaticRead })
+        , Stats()
+        , LastRayQueryID(0)
         , CurrentUIPage(nullptr)
-        , CameraBuffer(FixedBuffer<CameraBufferData, 1>{ BufferType::Uniform, BufferAccessType::StaticRead }) // TODO: populate buffer basing on API (to match shader data structure)
-        , TransformBuffer(FixedBuffer<TransformBufferData, 1>{ BufferType::Uniform, BufferAccessType::StaticRead }) // TODO: populate buffer basing on API (to match shader data structure)
-        , LightingBuffer(FixedBuffer<LightingBufferData, 1>{ BufferType::Uniform, BufferAccessType::StaticRead }) // TODO: populate buffer basing on API (to match shader data structure)s
-        , PointLightBuffer(DynamicBuffer<PointLightBufferData>{ BufferType::ShaderStorage, BufferAccessType::StaticRead }) // TODO: populate buffer basing on API (to match shader data structure)
-        , DirLightBuffer(DynamicBuffer<DirLightBufferData>{ BufferType::ShaderStorage, BufferAccessType::StaticRead }) // TODO: populate buffer basing on API (to match shader data structure)
     {}
 
     std::weak_ptr<RenderBuffer> RenderingSystem::CreateRenderBuffer(unsigned int width, unsigned int height, TextureFormat format, bool enableDepth)
@@ -44,6 +139,11 @@ namespace GaladHen
         return CreateRenderBuffer_Internal(width, height, format, enableDepth);
     }
 
+    std::weak_ptr<RenderBuffer> RenderingSystem::CreateRenderBuffer(unsigned int width, unsigned int height, const std::vector<TextureFormat>& formats, bool enableDepth)
+    {
+        return CreateRenderBuffer_Internal(width, height, formats, enableDepth);
+    }
+
     std::weak_ptr<RenderBuffer> RenderingSystem::GetFrontRenderBuffer()
     {
         return GetDefaultRenderContext().GetFrontBuffer();
@@ -63,125 +163,380 @@ namespace GaladHen
     {
         RenderContext& DefaultRenderContext = GetDefaultRenderContext();
         std::shared_ptr<RenderBuffer> shadowBuffer = DefaultRenderContext.GetShadowDepthBuffer().lock();
+        std::shared_ptr<RenderBuffer> staticShadowBuffer = DefaultRenderContext.GetStaticShadowDepthBuffer().lock();
+        std::shared_ptr<RenderBuffer> shadowAtlasBuffer = DefaultRenderContext.GetShadowAtlasBuffer().lock();
         std::shared_ptr<RenderBuffer> backBuffer = DefaultRenderContext.GetBackBuffer().lock();
 
-        if (!shadowBuffer || !backBuffer)
+        if (!shadowBuffer || !staticShadowBuffer || !shadowAtlasBuffer || !backBuffer)
             return;
 
+        // Nothing allocated from the arena by the previous frame is alive anymore
+        FrameArena.Reset();
+        RendererAPI->ResetStateCallStats();
+        ++FrameNumber;
+
         // common operations
 
-        std::unordered_set<unsigned int> loadedMeshesIDs;
-        LoadModels(scene, loadedMeshesIDs);
+        // Update the draw records of the changed scene objects, acquiring and releasing the residency of their meshes and materials
+        LoadInstanceData(scene);
+        const std::vector<InstanceBatch>& instanceBatches = SceneRenderList.GetBatches();
 
-        // Draw shadow map
+        LoadModels();
 
-        // Use light orientation as camera to render shadow depth
-        Camera shadowCamera{};
-        // Take first directional light to start
-        shadowCamera.Transform = (scene.DirectionalLights[0].Transform);
-        shadowCamera.Transform.SetPosition(shadowCamera.Transform.GetPosition() - shadowCamera.Transform.GetFront() * 10.0f);
-        LoadCameraData(shadowCamera);
+        // Draw shadow maps
 
-        BeforeDraw(*shadowBuffer);
+        // Draws are sorted by key before the submission, grouping them by pipeline, material and mesh
+        RenderQueue renderQueue{ FrameArena };
+        renderQueue.Reserve(instanceBatches.size());
 
-        // TODO: instanced draw
+        Stats.ShadowPass = RenderStateChanges{};
+        Stats.ShadowCulling = CullingStats{};
+        Stats.StaticShadowUpdates = 0;
+        Stats.SkippedShadowCascades = 0;
 
-        for (const SceneObject& sceneObject : scene.SceneObjects)
+        // Only the first directional light casts shadows, in cascades fitted to the slices of the camera view
+        if (!scene.DirectionalLights.empty())
         {
-            CommandBuffer<RenderCommand> renderCommandBuffer;
-
-            std::weak_ptr<Model> model = sceneObject.GetSceneObjectModel();
-            std::shared_ptr<Model> shModel = model.lock();
-            if (!shModel)
-                continue;
+            SceneShadowCascades.Update(scene.MainCamera, scene.DirectionalLights[0].GetLightDirection());
 
-            unsigned int index = 0;
-            for (Mesh& mesh : shModel->Meshes)
+            for (unsigned int c = 0; c < SceneShadowCascades.GetSettings().CascadeNumber; ++c)
             {
-                RenderCommand command;
-                command.DataSourceID = GPUResourceInspector::GetResourceID(&mesh);
-                command.Material = &ShadowDepthMaterial; // Use shadow depth material to render scene objects
-                command.ShaderSourceID = GPUResourceInspector::GetResourceID(command.Material->GetPipeline().lock().get());
+                const ShadowCascade& cascade = SceneShadowCascades.GetCascade(c);
+                StaticShadowCache& cache = StaticShadowCaches[c];
+
+                // Static casters are rendered in their own depth only when they moved, or the cascade stepped to another light space placement
+                bool staticChanged = !cache.Valid || cache.StaticVersion != SceneRenderList.GetStaticVersion() || cache.ViewProjection != cascade.ViewProjection;
+                if (staticChanged)
+                {
+                    LoadCameraData(cascade.ViewMatrix, cascade.ProjectionMatrix, glm::vec3(glm::inverse(cascade.ViewMatrix)[3]));
+                    BeforeDraw(*staticShadowBuffer, c);
+                    DynamicBuffer<unsigned int>* staticInstanceIndices = CullInstances(StaticCascadeVisibility[c], cascade.ViewProjection, BatchSelection::Static);
+                    AddShadowCullingStats(StaticCascadeVisibility[c].GetStats());
+                    DrawShadowCasters(renderQueue, StaticCascadeVisibility[c], staticInstanceIndices);
+                    AfterDraw(*staticShadowBuffer);
+
+                    cache.ViewProjection = cascade.ViewProjection;
+                    cache.StaticVersion = SceneRenderList.GetStaticVersion();
+                    cache.Valid = true;
+                    cache.HasCasters = StaticCascadeVisibility[c].GetStats().VisibleInstances > 0;
+                    ++Stats.StaticShadowUpdates;
+                }
 
-                // Add scene depth rendering data
-                command.AdditionalBufferData.emplace(GH_CAMERA_DATA_BUFFER_NAME, &CameraBuffer);
-                LoadTransformData(sceneObject.Transform);
-                command.AdditionalBufferData.emplace(GH_TRANSFORM_DATA_BUFFER_NAME, &TransformBuffer);
+                // Only the instances inside the cascade volume can cast shadows on it
+                DynamicBuffer<unsigned int>* shadowInstanceIndices = CullInstances(CascadeVisibility[c], cascade.ViewProjection, BatchSelection::Dynamic);
+                AddShadowCullingStats(CascadeVisibility[c].GetStats());
+                bool dynamicCasters = CascadeVisibility[c].GetStats().VisibleInstances > 0;
 
-                renderCommandBuffer.emplace_back(command);
+                // The cascade already holds the static depth alone
+                if (!staticChanged && !dynamicCasters && cache.ShadowMapCurrent)
+                {
+                    ++Stats.SkippedShadowCascades;
+                    continue;
+                }
+
+                // Dynamic casters are drawn on top of a copy of the static depth
+                LoadCameraData(cascade.ViewMatrix, cascade.ProjectionMatrix, glm::vec3(glm::inverse(cascade.ViewMatrix)[3]));
+                SetRenderBufferTarget(*shadowBuffer, c);
+                if (cache.HasCasters)
+                    RendererAPI->CopyRenderBufferDepth(GPUResourceInspector::GetResourceID(staticShadowBuffer.get()), GPUResourceInspector::GetResourceID(shadowBuffer.get()), c);
+                else
+                    ClearRenderBuffer(*shadowBuffer);
+                RendererAPI->SetViewport(glm::uvec2(0, 0), shadowBuffer->GetSize());
+
+                DrawShadowCasters(renderQueue, CascadeVisibility[c], shadowInstanceIndices);
+                cache.ShadowMapCurrent = !dynamicCasters;
             }
 
-            RendererAPI->Draw(renderCommandBuffer);
-            // A single Render Command at time because at the moment we use a TransformDataBuffer that invalidates itself when changing data ->
-            // passing the same TransformDataBuffer inside the AdditionalBufferData means using the same buffer but also the latest same data stored inside it
-            // (we should have instead a different buffer for each Render Command)
+            AfterDraw(*shadowBuffer);
+        }
+
+        ShadowCascadeBuffer.SetData(SceneShadowCascades.GetBufferData(), 0);
+        LoadBuffer(&ShadowCascadeBuffer);
+
+        // Point lights casting shadows get tiles of the shadow atlas: only the faces picked by the atlas budget are rendered, the others keep their depth
+        SceneShadowAtlas.Update(scene.MainCamera, scene.PointLights, SceneRenderList.GetStaticVersion());
+        Stats.ShadowAtlas = SceneShadowAtlas.GetStats();
+
+        const std::vector<ShadowAtlasFace>& atlasFaces = SceneShadowAtlas.GetRenderedFaces();
+        if (!atlasFaces.empty())
+        {
+            SetRenderBufferTarget(*shadowAtlasBuffer);
+            for (const ShadowAtlasFace& face : atlasFaces)
+            {
+                glm::uvec2 tileSize{ face.TileSize, face.TileSize };
+                LoadCameraData(face.ViewMatrix, face.ProjectionMatrix, face.LightPosition);
+                RendererAPI->ClearRenderBufferDepth(GPUResourceInspector::GetResourceID(shadowAtlasBuffer.get()), face.TilePosition, tileSize);
+                RendererAPI->SetViewport(face.TilePosition, tileSize);
+
+                DynamicBuffer<unsigned int>* faceInstanceIndices = CullInstances(ShadowAtlasVisibility, face.ViewProjection, BatchSelection::All);
+                AddShadowCullingStats(ShadowAtlasVisibility.GetStats());
+                DrawShadowCasters(renderQueue, ShadowAtlasVisibility, faceInstanceIndices);
+            }
+            AfterDraw(*shadowAtlasBuffer);
         }
 
-        AfterDraw(*shadowBuffer);
+        LoadBuffer(&SceneShadowAtlas.GetShadowBuffer());
 
         // Draw scene
 
         BeforeDraw(*backBuffer);
 
-        CompileShaders(scene);
-        std::unordered_set<unsigned int> loadedTexturesIDs, loadedBuffersIDs;
-        LoadMaterialsData(scene, loadedTexturesIDs, loadedBuffersIDs);
+        LoadMaterialsData();
         LoadCameraData(scene.MainCamera);
 
         LoadLightingData(scene);
         LoadPointLightData(scene.PointLights);
+        LoadLightClusterData(scene.MainCamera, scene.PointLights, backBuffer->GetSize());
         LoadDirLightData(scene.DirectionalLights);
+        LoadIrradianceVolumeData(scene.IrradianceVolume);
 
-        // TODO: instanced draw
+        Stats.IndirectDraws = 0;
+        Stats.IndirectMaxDraws = 0;
 
-        for (const SceneObject& sceneObject : scene.SceneObjects)
+        if (GPUDrivenDrawing)
+        {
+            // instances are culled by the gpu, their counts are not read back
+            Stats.SceneCulling = CullingStats{};
+            Stats.Occlusion = SoftwareOcclusionStats{};
+            Stats.OcclusionQueries = HardwareOcclusionStats{};
+            Stats.OcclusionCulledPercentage = 0.0f;
+            AddIndirectSceneDraws(renderQueue, scene.MainCamera, *shadowBuffer, *shadowAtlasBuffer);
+        }
+        else
         {
-            CommandBuffer<RenderCommand> renderCommandBuffer;
+            // occluders are rendered from the camera before the visibility tests that read them
+            const SoftwareOcclusion* occlusion = nullptr;
+            Stats.Occlusion = SoftwareOcclusionStats{};
+            if (FrustumCulling && OcclusionCulling)
+            {
+                SceneOcclusion.RenderOccluders(SceneRenderList, scene.MainCamera);
+                Stats.Occlusion = SceneOcclusion.GetStats();
+                occlusion = &SceneOcclusion;
+            }
 
-            std::weak_ptr<Model> model = sceneObject.GetSceneObjectModel();
-            std::shared_ptr<Model> shModel = model.lock();
-            if (!shModel)
-                continue;
+            // results of the previous frames are read first, the new queries are drawn after the scene pass
+            HardwareOcclusion* queries = nullptr;
+            if (FrustumCulling && OcclusionQueries)
+            {
+                SceneQueries.BeginFrame(SceneRenderList, scene.MainCamera, *RendererAPI);
+                queries = &SceneQueries;
+            }
+
+            DynamicBuffer<unsigned int>* sceneInstanceIndices = CullInstances(SceneVisibility, scene.MainCamera, MinScreenSize, occlusion, queries);
+            const std::vector<BatchVisibility>& sceneBatches = SceneVisibility.GetBatches();
+            Stats.SceneCulling = SceneVisibility.GetStats();
+
+            unsigned int occludedInstances = Stats.SceneCulling.OcclusionCulledInstances + Stats.SceneCulling.QueryCulledInstances;
+            unsigned int occlusionTested = Stats.SceneCulling.VisibleInstances + occludedInstances;
+            Stats.OcclusionCulledPercentage = occlusionTested > 0 ? occludedInstances * 100.0f / occlusionTested : 0.0f;
 
-            unsigned int index = 0;
-            for (Mesh& mesh : shModel->Meshes)
+            for (unsigned int b = 0; b < instanceBatches.size(); ++b)
             {
-                RenderCommand command;
-                command.DataSourceID = GPUResourceInspector::GetResourceID(&mesh);
-                command.Material = sceneObject.GetMaterial(index).lock().get();
+                const InstanceBatch& batch = instanceBatches[b];
+                if (!batch.BatchMaterial || sceneBatches[b].VisibleCount == 0)
+                    continue;
+
+                RenderCommand command{};
+                command.DataSourceID = GPUResourceInspector::GetResourceID(batch.BatchMesh);
+                command.FirstInstance = sceneBatches[b].FirstVisible;
+                command.InstanceCount = sceneBatches[b].VisibleCount;
+                command.InstanceIndices = sceneInstanceIndices;
+                command.Material = batch.BatchMaterial;
                 command.ShaderSourceID = GPUResourceInspector::GetResourceID(command.Material->GetPipeline().lock().get());
+                AddScenePassData(command, *shadowBuffer, *shadowAtlasBuffer);
 
-                // Add common rendering data
-                command.AdditionalBufferData.emplace(GH_CAMERA_DATA_BUFFER_NAME, &CameraBuffer);
-                LoadTransformData(sceneObject.Transform);
-                command.AdditionalBufferData.emplace(GH_TRANSFORM_DATA_BUFFER_NAME, &TransformBuffer);
-                command.AdditionalBufferData.emplace(GH_LIGHTING_DATA_BUFFER_NAME, &LightingBuffer);
-                command.AdditionalBufferData.emplace(GH_POINTLIGHT_DATA_BUFFER_NAME, &PointLightBuffer);
-                command.AdditionalBufferData.emplace(GH_DIRLIGHT_DATA_BUFFER_NAME, &DirLightBuffer);
-                command.AdditionalRenderBufferData.emplace(GH_SHADOW_MAP_SAMPLER_NAME, shadowBuffer.get());
-                command.AdditionalMat4Data.emplace(GH_LIGHTSPACEMATRIX_UNIFORM_NAME, shadowCamera.GetProjectionMatrix() * shadowCamera.GetViewMatrix());
-
-                renderCommandBuffer.emplace_back(command);
+                renderQueue.Add(RenderQueue::MakeSortKey(GH_SCENE_PASS, command.ShaderSourceID, batch.BatchMaterial->GetMaterialID(), command.DataSourceID, batch.NearestDepth), command);
             }
-
-            RendererAPI->Draw(renderCommandBuffer);
-            // A single Render Command at time because at the moment we use a TransformDataBuffer that invalidates itself when changing data ->
-            // passing the same TransformDataBuffer inside the AdditionalBufferData means using the same buffer but also the latest same data stored inside it
-            // (we should have instead a different buffer for each Render Command)
         }
 
-        // Free unused gpu data
-        FreeUnusedMeshes(loadedMeshesIDs);
-        FreeUnusedTextures(loadedTexturesIDs);
-        FreeUnusedBuffers(loadedBuffersIDs);
+        Stats.ScenePassUnsorted = RenderQueue::CountStateChanges(renderQueue.GetCommands());
+        renderQueue.Sort();
+        Stats.ScenePass = RenderQueue::CountStateChanges(renderQueue.GetCommands());
+
+        Stats.GBufferCommands = 0;
+        Stats.ForwardFallbackCommands = 0;
+        Stats.DepthPrePass = RenderStateChanges{};
+        Stats.DepthPrePassFallbackCommands = 0;
+        std::shared_ptr<RenderBuffer> gBuffer = DefaultRenderContext.GetGBuffer().lock();
+        if (DefaultRenderContext.GetRenderPath() == RenderPath::Deferred && gBuffer)
+            DrawDeferredScenePass(renderQueue.GetCommands(), *gBuffer, *backBuffer, *shadowBuffer, *shadowAtlasBuffer, scene.MainCamera);
+        else if (scene.DepthPrePass)
+            DrawWithDepthPrePass(renderQueue);
+        else
+            RendererAPI->Draw(renderQueue.GetCommands());
+
+        // Boxes are tested against the depth of the whole scene pass
+        Stats.OcclusionQueries = HardwareOcclusionStats{};
+        if (!GPUDrivenDrawing && FrustumCulling && OcclusionQueries)
+            DrawOcclusionQueries();
+
+        // Free gpu data released long enough ago
+        FreeEvictedResources();
 
         AfterDraw(*backBuffer);
 
+        RendererAPI->EndFrame();
+
+        Stats.StateCalls = RendererAPI->GetStateCallStats();
+        Stats.Geometry = RendererAPI->GetGeometryMemoryStats();
+
         // Swap buffers
         DefaultRenderContext.SwapBuffers();
         SwapMainWindowBuffers();
     }
 
+    const RenderingStats& RenderingSystem::GetRenderingStats() const
+    {
+        return Stats;
+    }
+
+    void RenderingSystem::SetShadowCascades(const ShadowCascadeSettings& settings)
+    {
+        ShadowCascadeSettings previous = SceneShadowCascades.GetSettings();
+        SceneShadowCascades.SetSettings(settings);
+
+        const ShadowCascadeSettings& current = SceneShadowCascades.GetSettings();
+        if (!Initialized || (current.CascadeNumber == previous.CascadeNumber && current.Resolution == previous.Resolution))
+            return;
+
+        // the shadow maps of the default context are replaced by ones with the new layers and size
+        RenderContext& defaultRenderContext = GetDefaultRenderContext();
+        std::shared_ptr<RenderBuffer> shadowBuffer = defaultRenderContext.GetShadowDepthBuffer().lock();
+        std::shared_ptr<RenderBuffer> staticShadowBuffer = defaultRenderContext.GetStaticShadowDepthBuffer().lock();
+        defaultRenderContext.SetShadowDepthBuffers(std::weak_ptr<RenderBuffer>{}, std::weak_ptr<RenderBuffer>{});
+        if (shadowBuffer)
+            FreeRenderBuffer_Internal(*shadowBuffer);
+        if (staticShadowBuffer)
+            FreeRenderBuffer_Internal(*staticShadowBuffer);
+        defaultRenderContext.SetShadowDepthBuffers(CreateShadowDepthBuffer_Internal(), CreateShadowDepthBuffer_Internal());
+
+        // nothing cached is in the new shadow maps
+        for (StaticShadowCache& cache : StaticShadowCaches)
+            cache = StaticShadowCache{};
+    }
+
+    const ShadowCascadeSettings& RenderingSystem::GetShadowCascades() const
+    {
+        return SceneShadowCascades.GetSettings();
+    }
+
+    void RenderingSystem::SetShadowAtlas(const ShadowAtlasSettings& settings)
+    {
+        // tiles are placed again from scratch, and all the faces rendered again
+        unsigned int previousResolution = SceneShadowAtlas.GetSettings().Resolution;
+        SceneShadowAtlas.SetSettings(settings);
+
+        if (!Initialized || SceneShadowAtlas.GetSettings().Resolution == previousResolution)
+            return;
+
+        RenderContext& defaultRenderContext = GetDefaultRenderContext();
+        std::shared_ptr<RenderBuffer> shadowAtlasBuffer = defaultRenderContext.GetShadowAtlasBuffer().lock();
+        defaultRenderContext.SetShadowAtlasBuffer(std::weak_ptr<RenderBuffer>{});
+        if (shadowAtlasBuffer)
+            FreeRenderBuffer_Internal(*shadowAtlasBuffer);
+        defaultRenderContext.SetShadowAtlasBuffer(CreateShadowAtlasBuffer_Internal());
+    }
+
+    const ShadowAtlasSettings& RenderingSystem::GetShadowAtlas() const
+    {
+        return SceneShadowAtlas.GetSettings();
+    }
+
+    void RenderingSystem::SetGPUDrivenDrawing(bool enable)
+    {
+        if (enable && (!RendererAPI || !RendererAPI->SupportsIndirectDrawCount()))
+        {
+            Log::Warning("RenderingSystem", "Indirect draws with a gpu draw count are not supported: the scene is drawn from cpu");
+            enable = false;
+        }
+
+        std::shared_ptr<ShaderPipeline> cullPipeline = CullInstancesPipeline.lock();
+        std::shared_ptr<ShaderPipeline> buildPipeline = BuildDrawCommandsPipeline.lock();
+        if (enable && (!cullPipeline || !cullPipeline->IsResourceValid() || !buildPipeline || !buildPipeline->IsResourceValid()))
+        {
+            Log::Warning("RenderingSystem", "Culling pipelines are not compiled: the scene is drawn from cpu");
+            enable = false;
+        }
+
+        GPUDrivenDrawing = enable;
+    }
+
+    bool RenderingSystem::IsGPUDrivenDrawingEnabled() const
+    {
+        return GPUDrivenDrawing;
+    }
+
+    void RenderingSystem::SetFrustumCulling(bool enable)
+    {
+        FrustumCulling = enable;
+    }
+
+    bool RenderingSystem::IsFrustumCullingEnabled() const
+    {
+        return FrustumCulling;
+    }
+
+    void RenderingSystem::SetMinScreenSize(float minScreenSize)
+    {
+        MinScreenSize = std::max(minScreenSize, 0.0f);
+    }
+
+    float RenderingSystem::GetMinScreenSize() const
+    {
+        return MinScreenSize;
+    }
+
+    void RenderingSystem::SetOcclusionCulling(bool enable)
+    {
+        OcclusionCulling = enable;
+    }
+
+    bool RenderingSystem::IsOcclusionCullingEnabled() const
+    {
+        return OcclusionCulling;
+    }
+
+    const SoftwareOcclusion& RenderingSystem::GetSceneOcclusion() const
+    {
+        return SceneOcclusion;
+    }
+
+    void RenderingSystem::SetOcclusionQueries(bool enable)
+    {
+        OcclusionQueries = enable;
+    }
+
+    bool RenderingSystem::AreOcclusionQueriesEnabled() const
+    {
+        return OcclusionQueries;
+    }
+
+    void RenderingSystem::SetRenderPath(RenderPath path)
+    {
+        RenderContext& defaultRenderContext = GetDefaultRenderContext();
+        if (path == defaultRenderContext.GetRenderPath())
+            return;
+
+        std::shared_ptr<RenderBuffer> gBuffer = defaultRenderContext.GetGBuffer().lock();
+        defaultRenderContext.SetRenderPath(path, std::weak_ptr<RenderBuffer>{});
+        if (gBuffer)
+            FreeRenderBuffer_Internal(*gBuffer);
+
+        // the g-buffer exists only while the deferred path is used
+        if (path == RenderPath::Deferred)
+        {
+            std::shared_ptr<RenderBuffer> backBuffer = defaultRenderContext.GetBackBuffer().lock();
+            glm::uvec2 size = backBuffer->GetSize();
+            std::vector<TextureFormat> formats{ std::begin(GBufferFormats), std::end(GBufferFormats) };
+            defaultRenderContext.SetRenderPath(path, CreateRenderBuffer_Internal(size.x, size.y, formats));
+        }
+    }
+
+    RenderPath RenderingSystem::GetRenderPath()
+    {
+        return GetDefaultRenderContext().GetRenderPath();
+    }
+
     void RenderingSystem::DrawUI()
     {
         // First call new frame functionalities for UI
@@ -200,9 +555,9 @@ namespace GaladHen
 
         for (const SceneObject& sceneObj : scene.SceneObjects)
         {
-            std::vector<std::weak_ptr<Material>> materials = sceneObj.GetSceneObjectMaterials();
+            const std::vector<std::weak_ptr<Material>>& materials = sceneObj.GetSceneObjectMaterials();
 
-            for (std::weak_ptr<Material>& material : materials)
+            for (const std::weak_ptr<Material>& material : materials)
             {
                 if (std::shared_ptr<Material> shMaterial = material.lock())
                 {
@@ -237,15 +592,16 @@ namespace GaladHen
 
         if (program.GetType() == ShaderPipelineType::ShaderPipeline)
         {
-            command.VertexCode = ShaderPreprocessor::PreprocessShader(program.GetVertexShaderPath().data(), CurrentAPI);
-            command.TessContCode = ShaderPreprocessor::PreprocessShader(program.GetTessContShaderPath().data(), CurrentAPI);
-            command.TessEvalCode = ShaderPreprocessor::PreprocessShader(program.GetTessEvalShaderPath().data(), CurrentAPI);
-            command.GeometryCode = ShaderPreprocessor::PreprocessShader(program.GetGeometryShaderPath().data(), CurrentAPI);
-            command.FragmentCode = ShaderPreprocessor::PreprocessShader(program.GetFragmentShaderPath().data(), CurrentAPI);
+            std::string defines = program.GetDefines();
+            command.VertexCode = ShaderPreprocessor::PreprocessShader(program.GetVertexShaderPath().data(), CurrentAPI, defines);
+            command.TessContCode = ShaderPreprocessor::PreprocessShader(program.GetTessContShaderPath().data(), CurrentAPI, defines);
+            command.TessEvalCode = ShaderPreprocessor::PreprocessShader(program.GetTessEvalShaderPath().data(), CurrentAPI, defines);
+            command.GeometryCode = ShaderPreprocessor::PreprocessShader(program.GetGeometryShaderPath().data(), CurrentAPI, defines);
+            command.FragmentCode = ShaderPreprocessor::PreprocessShader(program.GetFragmentShaderPath().data(), CurrentAPI, defines);
         }
         else
         {
-            command.ComputeCode = FileLoader::ReadTextFile(program.GetComputeShaderPath().data());
+            command.ComputeCode = ShaderPreprocessor::PreprocessShader(program.GetComputeShaderPath().data(), CurrentAPI);
         }
 
         command.ShaderPipelineID = 0;
@@ -275,6 +631,110 @@ namespace GaladHen
         return false;
     }
 
+    unsigned int RenderingSystem::SubmitRayQuery(const Scene& scene, const std::vector<Ray>& rays)
+    {
+        std::shared_ptr<ShaderPipeline> pipeline = RayCastPipeline.lock();
+        if (!pipeline || !pipeline->IsResourceValid() || rays.empty())
+            return 0;
+
+        // Scene geometry: the buffers are uploaded again only if something changed
+        RayTracingScene.Update(scene);
+        if (RayTracingScene.GetInstanceSources().empty())
+            return 0;
+
+        // Not cached like the materials buffers, otherwise they would be freed at the end of the next draw
+        IBuffer* sceneBuffers[] = { &RayTracingScene.GetNodeBuffer(), &RayTracingScene.GetTriangleBuffer(), &RayTracingScene.GetInstanceBuffer() };
+        for (IBuffer* buffer : sceneBuffers)
+        {
+            if (!GPUResourceInspector::GetResourceID(buffer) || !buffer->IsResourceValid())
+                LoadBuffer(buffer);
+        }
+
+        // Query buffers
+        RayQuery query{};
+        query.Rays = std::make_shared<DynamicBuffer<RayBufferData>>(BufferType::ShaderStorage, BufferAccessType::StaticWrite);
+        query.Hits = std::make_shared<DynamicBuffer<RayHitBufferData>>(BufferType::ShaderStorage, BufferAccessType::StaticRead);
+        query.InstanceSources = RayTracingScene.GetInstanceSources();
+
+        for (const Ray& ray : rays)
+        {
+            RayBufferData data{};
+            data.Origin = ray.Origin;
+            data.Length = ray.Length;
+            data.Direction = ray.Direction;
+            query.Rays->AddData(data);
+            query.Hits->AddData(RayHitBufferData{}); // allocates the results
+        }
+
+        LoadBuffer(query.Rays.get());
+        LoadBuffer(query.Hits.get());
+
+        // One thread per ray
+        CommandBuffer<ComputeCommand> computeCommands;
+        computeCommands.emplace_back(ComputeCommand{});
+
+        ComputeCommand& command = computeCommands[0];
+        command.ShaderSourceID = GPUResourceInspector::GetResourceID(pipeline.get());
+        command.GroupCount = glm::uvec3(((unsigned int)rays.size() + GH_RAY_CAST_GROUP_SIZE - 1) / GH_RAY_CAST_GROUP_SIZE, 1, 1);
+        command.AdditionalBufferData.Add(BVHNodeBufferName, &RayTracingScene.GetNodeBuffer());
+        command.AdditionalBufferData.Add(TriangleBufferName, &RayTracingScene.GetTriangleBuffer());
+        command.AdditionalBufferData.Add(RayInstanceBufferName, &RayTracingScene.GetInstanceBuffer());
+        command.AdditionalBufferData.Add(RayBufferName, query.Rays.get());
+        command.AdditionalBufferData.Add(RayHitBufferName, query.Hits.get());
+        command.Barriers = MemoryBarrierType::BufferUpdate; // hits are only read back by the cpu
+
+        RendererAPI->Dispatch(computeCommands);
+
+        // The results can be read without stalling once the fence is signaled
+        query.FenceID = RendererAPI->CreateFence();
+
+        RayQueries.emplace(++LastRayQueryID, query);
+
+        return LastRayQueryID;
+    }
+
+    bool RenderingSystem::RetrieveRayQuery(unsigned int queryID, std::vector<SceneRayHit>& outHits, bool wait)
+    {
+        auto queryIt = RayQueries.find(queryID);
+        if (queryIt == RayQueries.end())
+        {
+            Log::Warning("RenderingSystem", "Tried to retrieve an unknown ray query");
+            return false;
+        }
+
+        RayQuery& query = queryIt->second;
+        if (!RendererAPI->IsFenceSignaled(query.FenceID, wait))
+            return false;
+
+        size_t hitNumber = query.Hits->GetBytesSize() / sizeof(RayHitBufferData);
+        std::vector<RayHitBufferData> hits;
+        hits.resize(hitNumber);
+        bool success = RendererAPI->ReadBuffer(GPUResourceInspector::GetResourceID(query.Hits.get()), hits.data(), hitNumber * sizeof(RayHitBufferData));
+
+        outHits.clear();
+        if (success)
+        {
+            outHits.reserve(hitNumber);
+            unsigned int incompleteHits = 0;
+            for (const RayHitBufferData& hit : hits)
+            {
+                outHits.push_back(GPURayTracingScene::ResolveHit(hit, query.InstanceSources));
+                incompleteHits += outHits.back().Incomplete ? 1 : 0;
+            }
+
+            if (incompleteHits > 0)
+                Log::Warning("RenderingSystem", std::to_string(incompleteHits) + " rays of a ray query overflowed the traversal stack and have no reliable hit");
+        }
+
+        // Release the query
+        RendererAPI->FreeFence(query.FenceID);
+        FreeUncachedBuffer(GPUResourceInspector::GetResourceID(query.Rays.get()));
+        FreeUncachedBuffer(GPUResourceInspector::GetResourceID(query.Hits.get()));
+        RayQueries.erase(queryIt);
+
+        return success;
+    }
+
     void RenderingSystem::CreateMainWindow(const std::string& name, const glm::uvec2 size)
     {
         RendererAPI->CreateRenderingWindow(name.data(), size);
@@ -321,11 +781,23 @@ namespace GaladHen
 
         // Load default buffers
         LoadCameraData(Camera{});
-        LoadTransformData(Transform{});
+        LoadBuffer(&SceneRenderList.GetInstanceTransformBuffer());
 
         // Load, compile and setup shadow maps material
         SetupShadowDepthMaterial();
 
+        // Load and compile gpu ray casting pipeline
+        SetupRayCastPipeline();
+
+        // Load and compile gpu culling pipelines
+        SetupCullingPipelines();
+
+        // Load the box drawn by occlusion queries
+        SetupOcclusionBoxMesh();
+
+        // Load and compile the screen space lighting of the deferred path
+        SetupDeferredLighting();
+
         Initialized = true;
     }
 
@@ -335,6 +807,8 @@ namespace GaladHen
         if (CurrentUIPage)
             delete CurrentUIPage;
 
+        SceneQueries.Release(*RendererAPI);
+
         delete RendererAPI;
     }
 
@@ -342,7 +816,10 @@ namespace GaladHen
         : FrontBuffer(renderingSys.CreateRenderBuffer_Internal(width, height, TextureFormat::RGB8))
         , BackBuffer(std::shared_ptr<RenderBuffer>{})
         , RenderContextType(renderContextType)
-        , ShadowDepthBuffer(renderingSys.CreateRenderBuffer_Internal(width, height, TextureFormat::RGB8, true, true)) // TODO: aggiungere selezione risoluzione shadow depth
+        , ShadowDepthBuffer(renderingSys.CreateShadowDepthBuffer_Internal())
+        , StaticShadowDepthBuffer(renderingSys.CreateShadowDepthBuffer_Internal())
+        , ShadowAtlasBuffer(renderingSys.CreateShadowAtlasBuffer_Internal())
+        , Path(RenderPath::Forward)
     {
         if (RenderContextType == RenderContextType::DoubleBuffering)
         {
@@ -358,6 +835,7 @@ namespace GaladHen
         : FrontBuffer(renderBuffer)
         , BackBuffer(std::shared_ptr<RenderBuffer>{})
         , RenderContextType(RenderContextType::SingleBuffering)
+        , Path(RenderPath::Forward)
     {}
 
     RenderingSystem::RenderContextType RenderingSystem::RenderContext::GetRenderContextType()
@@ -380,6 +858,43 @@ namespace GaladHen
         return ShadowDepthBuffer;
     }
 
+    std::weak_ptr<RenderBuffer> RenderingSystem::RenderContext::GetStaticShadowDepthBuffer() const
+    {
+        return StaticShadowDepthBuffer;
+    }
+
+    void RenderingSystem::RenderContext::SetShadowDepthBuffers(std::weak_ptr<RenderBuffer> shadowDepthBuffer, std::weak_ptr<RenderBuffer> staticShadowDepthBuffer)
+    {
+        ShadowDepthBuffer = shadowDepthBuffer.lock();
+        StaticShadowDepthBuffer = staticShadowDepthBuffer.lock();
+    }
+
+    std::weak_ptr<RenderBuffer> RenderingSystem::RenderContext::GetShadowAtlasBuffer() const
+    {
+        return ShadowAtlasBuffer;
+    }
+
+    void RenderingSystem::RenderContext::SetShadowAtlasBuffer(std::weak_ptr<RenderBuffer> shadowAtlasBuffer)
+    {
+        ShadowAtlasBuffer = shadowAtlasBuffer.lock();
+    }
+
+    RenderPath RenderingSystem::RenderContext::GetRenderPath() const
+    {
+        return Path;
+    }
+
+    std::weak_ptr<RenderBuffer> RenderingSystem::RenderContext::GetGBuffer() const
+    {
+        return GBuffer;
+    }
+
+    void RenderingSystem::RenderContext::SetRenderPath(RenderPath path, std::weak_ptr<RenderBuffer> gBuffer)
+    {
+        Path = path;
+        GBuffer = gBuffer.lock();
+    }
+
     void RenderingSystem::RenderContext::SwapBuffers()
     {
         if (RenderContextType == RenderContextType::DoubleBuffering)
@@ -392,16 +907,16 @@ namespace GaladHen
         return RenderContexts.GetObjectWithId(1);
     }
 
-    void RenderingSystem::BeforeDraw(const RenderBuffer& renderBuffer)
+    void RenderingSystem::BeforeDraw(const RenderBuffer& renderBuffer, unsigned int layer)
     {
         // Operations needed before drawing to a render buffer
 
+        // Set render context's back buffer as target for next draw calls (layers are attached by the binding, before clearing them)
+        SetRenderBufferTarget(renderBuffer, layer);
+
         // Clear back render buffer
         ClearRenderBuffer(renderBuffer);
 
-        // Set render context's back buffer as target for next draw calls
-        SetRenderBufferTarget(renderBuffer);
-
         // Set viewport basing on render buffer resolution
         RendererAPI->SetViewport(glm::uvec2(0, 0), renderBuffer.GetSize());
     }
@@ -414,26 +929,6 @@ namespace GaladHen
         UnsetRenderBufferTarget(renderBuffer);
     }
 
-    bool RenderingSystem::IsMeshCached(unsigned int meshID)
-    {
-        if (LoadedMeshesCache.find(meshID) != LoadedMeshesCache.end())
-        {
-            return true;
-        }
-
-        return false;
-    }
-
-    void RenderingSystem::CacheMesh(unsigned int meshID)
-    {
-        LoadedMeshesCache.insert(meshID);
-    }
-
-    void RenderingSystem::UncacheMesh(unsigned int meshID)
-    {
-        LoadedMeshesCache.erase(meshID);
-    }
-
     bool RenderingSystem::IsShaderCached(unsigned int shaderID)
     {
         if (CompiledShadersCache.find(shaderID) != CompiledShadersCache.end())
@@ -454,80 +949,38 @@ namespace GaladHen
         CompiledShadersCache.erase(shaderID);
     }
 
-    bool RenderingSystem::IsTextureCached(unsigned int textureID)
-    {
-        if (LoadedTexturesCache.find(textureID) != LoadedTexturesCache.end())
-        {
-            return true;
-        }
-
-        return false;
-    }
-
-    void RenderingSystem::CacheTexture(unsigned int textureID)
-    {
-        LoadedTexturesCache.insert(textureID);
-    }
-
-    void RenderingSystem::UncacheTexture(unsigned int textureID)
-    {
-        LoadedTexturesCache.erase(textureID);
-    }
-
-    bool RenderingSystem::IsBufferCached(unsigned int bufferID)
-    {
-        if (LoadedBuffersCache.find(bufferID) != LoadedBuffersCache.end())
-        {
-            return true;
-        }
-
-        return false;
-    }
-
-    void RenderingSystem::CacheBuffer(unsigned int bufferID)
-    {
-        LoadedBuffersCache.insert(bufferID);
-    }
-
-    void RenderingSystem::UncacheBuffer(unsigned int bufferID)
+    void RenderingSystem::LoadModels()
     {
-        LoadedBuffersCache.erase(bufferID);
-    }
+        // New resident meshes are loaded
+        MeshResidency.ForEachAdded([this](const std::shared_ptr<Mesh>& mesh)
+            {
+                LoadMeshIfInvalid(*mesh);
+            });
 
-    void RenderingSystem::LoadModels(const Scene& scene, std::unordered_set<unsigned int>& outLoadedMeshesIDs)
-    {
-        for (const SceneObject& sceneObject : scene.SceneObjects)
+        // The resident ones are checked only in the frames after some mesh was modified
+        unsigned int lastMeshVersion = Mesh::GetLastVersion();
+        if (lastMeshVersion != LoadedMeshesVersion)
         {
-            std::weak_ptr<Model> model = sceneObject.GetSceneObjectModel();
-            if (std::shared_ptr<Model> shModel = model.lock())
-            {
-                for (Mesh& mesh : shModel->Meshes)
+            MeshResidency.ForEach([this](const std::shared_ptr<Mesh>& mesh)
                 {
-                    LoadMeshAndCache(mesh);
+                    LoadMeshIfInvalid(*mesh);
+                });
 
-                    unsigned int meshID = GPUResourceInspector::GetResourceID(&mesh);
-                    outLoadedMeshesIDs.insert(meshID);
-                }
-            }
+            LoadedMeshesVersion = lastMeshVersion;
         }
     }
 
-    void RenderingSystem::LoadMeshAndCache(Mesh& mesh)
+    void RenderingSystem::LoadMeshIfInvalid(Mesh& mesh)
     {
-        unsigned int meshID = GPUResourceInspector::GetResourceID(&mesh);
-
-        if (IsMeshCached(meshID) && mesh.IsResourceValid())
-        {
+        if (GPUResourceInspector::GetResourceID(&mesh) && mesh.IsResourceValid())
             return;
-        }
 
-        unsigned int newId = LoadMesh(mesh);
-        CacheMesh(newId);
+        LoadMesh(mesh);
     }
 
     unsigned int RenderingSystem::LoadMesh(Mesh& mesh)
     {
-        CommandBuffer<MemoryTransferCommand> memoryCommands;
+        CommandBuffer<MemoryTransferCommand> memoryCommands{ FrameArena };
         memoryCommands.emplace_back(MemoryTransferCommand{});
 
         MemoryTransferCommand& command = memoryCommands[0];
@@ -545,101 +998,117 @@ namespace GaladHen
         return command.MemoryTargetID;
     }
 
-    void RenderingSystem::FreeUnusedMeshes(const std::unordered_set<unsigned int>& usedMeshesIDs)
+    void RenderingSystem::LoadMaterialsData()
     {
-        std::unordered_set<unsigned int> meshesToFree;
-        for (unsigned int id : LoadedMeshesCache)
+        // Dependencies of the new resident materials
+        MaterialResidency.ForEachAdded([this](const std::shared_ptr<Material>& material)
+            {
+                LoadMaterialData(*material, ResidentMaterialsDependencies[material.get()]);
+            });
+
+        // Dependencies of the resident materials modified since the last frame
+        unsigned int lastMaterialVersion = Material::GetLastVersion();
+        if (lastMaterialVersion != LoadedMaterialsVersion)
         {
-            if (usedMeshesIDs.find(id) == usedMeshesIDs.end())
+            for (std::pair<const Material* const, MaterialDependencies>& materialDependencies : ResidentMaterialsDependencies)
             {
-                meshesToFree.insert(id);
+                Material* material = const_cast<Material*>(materialDependencies.first); // kept alive by the residency set
+                if (materialDependencies.second.MaterialVersion != material->GetVersion())
+                    LoadMaterialData(*material, materialDependencies.second);
             }
-        }
 
-        FreeMeshes(meshesToFree);
-    }
-
-    void RenderingSystem::FreeMeshes(const std::unordered_set<unsigned int>& meshesToFree)
-    {
-        for (unsigned int meshID : meshesToFree)
-        {
-            FreeMesh(meshID);
+            LoadedMaterialsVersion = lastMaterialVersion;
         }
-    }
 
-    void RenderingSystem::FreeMesh(unsigned int meshID)
-    {
-        if (!IsMeshCached(meshID))
-            return;
+        // Textures and buffers acquired by the materials above are already loaded
+        TextureResidency.ClearAdded();
+        BufferResidency.ClearAdded();
 
-        CommandBuffer<MemoryTransferCommand> memoryCommands;
-        memoryCommands.emplace_back(MemoryTransferCommand{});
+        // Resident textures are loaded again only in the frames after some texture was modified
+        unsigned int lastTextureVersion = Texture::GetLastVersion();
+        if (lastTextureVersion != LoadedTexturesVersion)
+        {
+            TextureResidency.ForEach([this](const std::shared_ptr<Texture>& texture)
+                {
+                    LoadTextureIfInvalid(*texture);
+                });
 
-        MemoryTransferCommand& command = memoryCommands[0];
-        command.MemoryTargetID = meshID;
-        command.TargetType = MemoryTargetType::Mesh;
-        command.TransferType = MemoryTransferType::Free;
+            LoadedTexturesVersion = lastTextureVersion;
+        }
 
-        // Free and remove from cache
-        RendererAPI->TransferData(memoryCommands);
-        LoadedMeshesCache.erase(meshID);
+        // Buffers have no modification version and are often written every frame: only their validity is checked
+        BufferResidency.ForEach([this](const std::shared_ptr<IBuffer>& buffer)
+            {
+                LoadBufferIfInvalid(buffer.get());
+            });
     }
 
-    void RenderingSystem::LoadMaterialsData(const Scene& scene, std::unordered_set<unsigned int>& outLoadedTexturesIDs, std::unordered_set<unsigned int>& outLoadedBuffersIDs)
+    void RenderingSystem::LoadMaterialData(Material& material, MaterialDependencies& dependencies)
     {
-        for (const SceneObject& sceneObject : scene.SceneObjects)
-        {
-            std::vector<std::weak_ptr<Material>> materials = sceneObject.GetSceneObjectMaterials();
+        dependencies.MaterialVersion = material.GetVersion();
 
-            for (std::weak_ptr<Material>& material : materials)
-            {
-                if (std::shared_ptr<Material> shMaterial = material.lock())
-                    LoadMaterialData(*shMaterial, outLoadedTexturesIDs, outLoadedBuffersIDs);
-            }
-        }
-    }
+        if (ShaderPipeline* pipeline = material.GetPipeline().lock().get())
+            CompileShader(*pipeline);
 
-    void RenderingSystem::LoadMaterialData(Material& material, std::unordered_set<unsigned int>& outLoadedTextures, std::unordered_set<unsigned int>& outLoadedBuffers)
-    {
-        CommandBuffer<MemoryTransferCommand> commandBuffer; // TODO: send all with one request?
+        // Textures and buffers are acquired again before releasing the previous ones, so that only the ones not used anymore by the material are released
+        DependenciesScratch.Textures.clear();
+        DependenciesScratch.Buffers.clear();
 
         // Load textures
-        for (std::pair<const std::string, std::weak_ptr<Texture>>& textureData : material.TextureData)
+        for (std::pair<const ShaderParameterName, std::weak_ptr<Texture>>& textureData : material.TextureData)
         {
             if (std::shared_ptr<Texture> shTexture = textureData.second.lock())
             {
-                LoadTextureAndCache(*shTexture);
-                outLoadedTextures.insert(GPUResourceInspector::GetResourceID(shTexture.get()));
+                LoadTextureIfInvalid(*shTexture);
+                TextureResidency.Acquire(shTexture);
+                DependenciesScratch.Textures.push_back(shTexture.get());
             }
         }
 
         // Load buffers
-        for (std::pair<const std::string, std::weak_ptr<IBuffer>>& bufferData : material.BufferData)
+        for (std::pair<const ShaderParameterName, std::weak_ptr<IBuffer>>& bufferData : material.BufferData)
         {
             if (std::shared_ptr<IBuffer> shBuffer = bufferData.second.lock())
             {
-                LoadBufferAndCache(shBuffer.get());
-                outLoadedBuffers.insert(GPUResourceInspector::GetResourceID(shBuffer.get()));
+                LoadBufferIfInvalid(shBuffer.get());
+                BufferResidency.Acquire(shBuffer);
+                DependenciesScratch.Buffers.push_back(shBuffer.get());
             }
         }
-    }
 
-    void RenderingSystem::LoadTextureAndCache(Texture& texture)
-    {
-        unsigned int textureID = GPUResourceInspector::GetResourceID(&texture);
+        for (const Texture* texture : dependencies.Textures)
+            TextureResidency.Release(texture, FrameNumber);
+        for (const IBuffer* buffer : dependencies.Buffers)
+            BufferResidency.Release(buffer, FrameNumber);
+
+        dependencies.Textures.swap(DependenciesScratch.Textures);
+        dependencies.Buffers.swap(DependenciesScratch.Buffers);
 
-        if (IsTextureCached(textureID) && texture.IsResourceValid())
+        // Pack value parameters into the material block, only if they changed since the last upload
+        // The block is owned by the material: it is freed with the material, not tracked as a dependency
+        unsigned int shaderID = GPUResourceInspector::GetResourceID(material.GetPipeline().lock().get());
+        if (const ShaderBlockLayout* layout = shaderID ? RendererAPI->GetMaterialBlockLayout(shaderID) : nullptr)
         {
-            return;
+            MaterialParameterBlock& parameterBlock = material.GetParameterBlock();
+
+            if (!parameterBlock.IsResourceValid() || parameterBlock.GetPackedPipelineID() != shaderID)
+                parameterBlock.Pack(material, *layout, shaderID);
+
+            LoadBufferIfInvalid(&parameterBlock);
         }
+    }
+
+    void RenderingSystem::LoadTextureIfInvalid(Texture& texture)
+    {
+        if (GPUResourceInspector::GetResourceID(&texture) && texture.IsResourceValid())
+            return;
 
-        unsigned int newId = LoadTexture(texture);
-        CacheTexture(newId);
+        LoadTexture(texture);
     }
 
     unsigned int RenderingSystem::LoadTexture(Texture& texture)
     {
-        CommandBuffer<MemoryTransferCommand> commandBuffer;
+        CommandBuffer<MemoryTransferCommand> commandBuffer{ FrameArena };
         commandBuffer.emplace_back(MemoryTransferCommand{});
 
         MemoryTransferCommand& command = commandBuffer[0];
@@ -657,22 +1126,17 @@ namespace GaladHen
         return command.MemoryTargetID;
     }
 
-    void RenderingSystem::LoadBufferAndCache(IBuffer* buffer)
+    void RenderingSystem::LoadBufferIfInvalid(IBuffer* buffer)
     {
-        unsigned int bufferID = GPUResourceInspector::GetResourceID(buffer);
-
-        if (IsBufferCached(bufferID) && buffer->IsResourceValid())
-        {
+        if (GPUResourceInspector::GetResourceID(buffer) && buffer->IsResourceValid())
             return;
-        }
 
-        unsigned int newId = LoadBuffer(buffer);
-        CacheBuffer(newId);
+        LoadBuffer(buffer);
     }
 
     unsigned int RenderingSystem::LoadBuffer(IBuffer* buffer)
     {
-        CommandBuffer<MemoryTransferCommand> commandBuffer;
+        CommandBuffer<MemoryTransferCommand> commandBuffer{ FrameArena };
         commandBuffer.emplace_back(MemoryTransferCommand{});
 
         MemoryTransferCommand& command = commandBuffer[0];
@@ -690,103 +1154,111 @@ namespace GaladHen
         return command.MemoryTargetID;
     }
 
-    void RenderingSystem::FreeUnusedTextures(const std::unordered_set<unsigned int>& usedTexturesIDs)
+    void RenderingSystem::FreeUncachedBuffer(unsigned int bufferID)
     {
-        std::unordered_set<unsigned int> texturesToFree;
-        for (unsigned int id : LoadedTexturesCache)
-        {
-            if (usedTexturesIDs.find(id) == usedTexturesIDs.end())
-            {
-                texturesToFree.insert(id);
-            }
-        }
-        FreeTextures(texturesToFree);
-    }
-
-    void RenderingSystem::FreeTextures(const std::unordered_set<unsigned int>& texturesToFree)
-    {
-        for (unsigned int textureID : texturesToFree)
-        {
-            FreeTexture(textureID);
-        }
-    }
-
-    void RenderingSystem::FreeTexture(unsigned int textureID)
-    {
-        if (!IsTextureCached(textureID))
-            return;
-
-        CommandBuffer<MemoryTransferCommand> memoryCommands;
+        CommandBuffer<MemoryTransferCommand> memoryCommands{ FrameArena };
         memoryCommands.emplace_back(MemoryTransferCommand{});
 
         MemoryTransferCommand& command = memoryCommands[0];
-        command.MemoryTargetID = textureID;
-        command.TargetType = MemoryTargetType::Texture;
+        command.MemoryTargetID = bufferID;
+        command.TargetType = MemoryTargetType::Buffer;
         command.TransferType = MemoryTransferType::Free;
 
-        // Free and remove from cache
         RendererAPI->TransferData(memoryCommands);
-        LoadedTexturesCache.erase(textureID);
     }
 
-    void RenderingSystem::FreeUnusedBuffers(const std::unordered_set<unsigned int>& usedBuffersIDs)
+    void RenderingSystem::FreeEvictedResources()
     {
-        std::unordered_set<unsigned int> buffersToFree;
-        for (unsigned int id : LoadedBuffersCache)
-        {
-            if (usedBuffersIDs.find(id) == usedBuffersIDs.end())
+        // All the frees of the frame are submitted together
+        CommandBuffer<MemoryTransferCommand> memoryCommands{ FrameArena };
+
+        // Materials first, releasing their textures and buffers: these are evicted after their own delay
+        MaterialResidency.Evict(FrameNumber, GH_RESIDENCY_FREE_DELAY_FRAMES, [this, &memoryCommands](std::shared_ptr<Material>& material)
             {
-                buffersToFree.insert(id);
-            }
-        }
-        FreeBuffers(buffersToFree);
-    }
+                std::unordered_map<const Material*, MaterialDependencies>::iterator it = ResidentMaterialsDependencies.find(material.get());
+                if (it != ResidentMaterialsDependencies.end())
+                {
+                    for (const Texture* texture : it->second.Textures)
+                        TextureResidency.Release(texture, FrameNumber);
+                    for (const IBuffer* buffer : it->second.Buffers)
+                        BufferResidency.Release(buffer, FrameNumber);
 
-    void RenderingSystem::FreeBuffers(const std::unordered_set<unsigned int>& buffersToFree)
-    {
-        for (unsigned int bufferID : buffersToFree)
-        {
-            FreeBuffer(bufferID);
-        }
+                    ResidentMaterialsDependencies.erase(it);
+                }
+
+                AddFreeCommand(memoryCommands, &material->GetParameterBlock(), MemoryTargetType::Buffer);
+            });
+
+        MeshResidency.Evict(FrameNumber, GH_RESIDENCY_FREE_DELAY_FRAMES, [this, &memoryCommands](std::shared_ptr<Mesh>& mesh)
+            {
+                AddFreeCommand(memoryCommands, mesh.get(), MemoryTargetType::Mesh);
+            });
+
+        TextureResidency.Evict(FrameNumber, GH_RESIDENCY_FREE_DELAY_FRAMES, [this, &memoryCommands](std::shared_ptr<Texture>& texture)
+            {
+                AddFreeCommand(memoryCommands, texture.get(), MemoryTargetType::Texture);
+            });
+
+        BufferResidency.Evict(FrameNumber, GH_RESIDENCY_FREE_DELAY_FRAMES, [this, &memoryCommands](std::shared_ptr<IBuffer>& buffer)
+            {
+                AddFreeCommand(memoryCommands, buffer.get(), MemoryTargetType::Buffer);
+            });
+
+        if (!memoryCommands.empty())
+            RendererAPI->TransferData(memoryCommands);
+
+        Stats.ResidentMeshes = MeshResidency.GetResidentsNumber();
+        Stats.ResidentMaterials = MaterialResidency.GetResidentsNumber();
+        Stats.ResidentTextures = TextureResidency.GetResidentsNumber();
+        Stats.ResidentBuffers = BufferResidency.GetResidentsNumber();
+        Stats.PendingEvictions = MeshResidency.GetPendingEvictionsNumber() + MaterialResidency.GetPendingEvictionsNumber() + TextureResidency.GetPendingEvictionsNumber() + BufferResidency.GetPendingEvictionsNumber();
+        Stats.FreedResources = (unsigned int)memoryCommands.size();
     }
 
-    void RenderingSystem::FreeBuffer(unsigned int bufferID)
+    void RenderingSystem::AddFreeCommand(CommandBuffer<MemoryTransferCommand>& memoryCommands, IGPUResource* resource, MemoryTargetType targetType)
     {
-        if (!IsBufferCached(bufferID))
+        // never loaded
+        unsigned int resourceID = GPUResourceInspector::GetResourceID(resource);
+        if (!resourceID)
             return;
 
-        CommandBuffer<MemoryTransferCommand> memoryCommands;
         memoryCommands.emplace_back(MemoryTransferCommand{});
-
-        MemoryTransferCommand& command = memoryCommands[0];
-        command.MemoryTargetID = bufferID;
-        command.TargetType = MemoryTargetType::Buffer;
+        MemoryTransferCommand& command = memoryCommands.back();
+        command.MemoryTargetID = resourceID;
+        command.TargetType = targetType;
         command.TransferType = MemoryTransferType::Free;
 
-        // Free and remove from cache
-        RendererAPI->TransferData(memoryCommands);
-        LoadedBuffersCache.erase(bufferID);
+        // The resource can be acquired again later: it will be loaded as a new one
+        GPUResourceInspector::SetResourceID(resource, 0);
     }
 
     void RenderingSystem::LoadCameraData(const Camera& camera)
+    {
+        LoadCameraData(camera.GetViewMatrix(), camera.GetProjectionMatrix(), camera.Transform.GetPosition());
+    }
+
+    void RenderingSystem::LoadCameraData(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, const glm::vec3& position)
     {
         CameraBufferData data{};
-        data.ViewMatrix = camera.GetViewMatrix();
-        data.ProjectionMatrix = camera.GetProjectionMatrix();
-        data.CameraPosition = camera.Transform.GetPosition();
+        data.ViewMatrix = viewMatrix;
+        data.ProjectionMatrix = projectionMatrix;
+        data.CameraPosition = position;
         CameraBuffer.SetData(data, 0);
 
         LoadBuffer(&CameraBuffer);
     }
 
-    void RenderingSystem::LoadTransformData(const Transform& transform)
+    void RenderingSystem::LoadInstanceData(const Scene& scene)
     {
-        TransformBufferData data{};
-        data.ModelMatrix = transform.ToMatrix();
-        data.NormalMatrix = glm::inverse(glm::transpose(data.ModelMatrix));
-        TransformBuffer.SetData(data, 0);
+        Stats.ChangedObjects = SceneRenderList.Update(scene, FrameNumber);
+        Stats.RenderListRebuilt = SceneRenderList.WasRebuilt();
 
-        LoadBuffer(&TransformBuffer);
+        // batches depth changes with the camera even if the scene is static
+        SceneRenderList.UpdateBatchesDepth(scene.MainCamera);
+
+        DynamicBuffer<TransformBufferData>& instanceTransformBuffer = SceneRenderList.GetInstanceTransformBuffer();
+        if (!instanceTransformBuffer.IsResourceValid())
+            LoadBuffer(&instanceTransformBuffer);
     }
 
     void RenderingSystem::LoadLightingData(const Scene& scene)
@@ -803,14 +1275,17 @@ namespace GaladHen
     {
         PointLightBuffer.ClearData();
 
-        for (const PointLight& light : pointLights)
+        for (unsigned int l = 0; l < pointLights.size(); ++l)
         {
+            const PointLight& light = pointLights[l];
+
             PointLightBufferData data{};
             data.Color = light.Color;
             data.Position = light.Transform.GetPosition();
             data.Intensity = light.Intensity;
             data.BulbSize = light.BulbSize;
             data.Radius = light.Radius;
+            data.ShadowIndex = SceneShadowAtlas.GetLightShadowIndex(l);
 
             PointLightBuffer.AddData(data);
         }
@@ -818,6 +1293,16 @@ namespace GaladHen
         LoadBuffer(&PointLightBuffer);
     }
 
+    void RenderingSystem::LoadLightClusterData(const Camera& camera, const std::vector<PointLight>& pointLights, const glm::uvec2& viewportSize)
+    {
+        SceneLightClusters.Update(camera, pointLights, viewportSize);
+        Stats.LightClusters = SceneLightClusters.GetStats();
+
+        LoadBuffer(&SceneLightClusters.GetClusterDataBuffer());
+        LoadBuffer(&SceneLightClusters.GetGridBuffer());
+        LoadBuffer(&SceneLightClusters.GetLightIndexBuffer());
+    }
+
     void RenderingSystem::LoadDirLightData(const std::vector<DirectionalLight>& dirLights)
     {
         DirLightBuffer.ClearData();
@@ -836,9 +1321,528 @@ namespace GaladHen
         LoadBuffer(&DirLightBuffer);
     }
 
-    void RenderingSystem::SetRenderBufferTarget(const RenderBuffer& renderBuffer)
+    void RenderingSystem::LoadIrradianceVolumeData(const IrradianceVolume& irradianceVolume)
+    {
+        // Probes are static: upload them again only after a new bake
+        if (LoadedIrradianceVolumeVersion == irradianceVolume.GetBakeVersion() && IrradianceProbeBuffer.IsResourceValid() && IrradianceVolumeBuffer.IsResourceValid())
+            return;
+
+        IrradianceProbeBuffer.ClearData();
+
+        for (const IrradianceProbe& probe : irradianceVolume.GetProbes())
+        {
+            IrradianceProbeBufferData data{};
+            float* packed = &data.PackedCoefficients[0].x;
+            for (unsigned int c = 0; c < 9; ++c)
+            {
+                packed[c * 3] = probe.Coefficients[c].r;
+                packed[c * 3 + 1] = probe.Coefficients[c].g;
+                packed[c * 3 + 2] = probe.Coefficients[c].b;
+            }
+
+            IrradianceProbeBuffer.AddData(data);
+        }
+
+        // Keep at least one probe, so that the shader storage buffer is never empty
+        if (!irradianceVolume.IsBaked())
+            IrradianceProbeBuffer.AddData(IrradianceProbeBufferData{});
+
+        IrradianceVolumeBufferData data{};
+        data.MinBound = irradianceVolume.GetMinBound();
+        data.Enabled = irradianceVolume.IsBaked() ? 1 : 0;
+        data.CellSize = irradianceVolume.GetCellSize();
+        data.ProbeCount = glm::ivec3(irradianceVolume.GetProbeCount());
+        IrradianceVolumeBuffer.SetData(data, 0);
+
+        LoadBuffer(&IrradianceProbeBuffer);
+        LoadBuffer(&IrradianceVolumeBuffer);
+
+        LoadedIrradianceVolumeVersion = irradianceVolume.GetBakeVersion();
+    }
+
+    DynamicBuffer<unsigned int>* RenderingSystem::CullInstances(VisibilityList& visibility, const Camera& camera, float minScreenSize, const SoftwareOcclusion* occlusion, HardwareOcclusion* queries)
+    {
+        if (!FrustumCulling)
+        {
+            visibility.ShowAll(SceneRenderList);
+            return nullptr;
+        }
+
+        visibility.Cull(SceneRenderList, camera, minScreenSize, occlusion, queries);
+
+        // the indices are rewritten every frame: nothing to load if all the instances are culled, since nothing is drawn
+        DynamicBuffer<unsigned int>* instanceIndices = visibility.GetInstanceIndexBuffer();
+        if (instanceIndices->GetBytesSize() > 0)
+            LoadBuffer(instanceIndices);
+
+        return instanceIndices;
+    }
+
+    DynamicBuffer<unsigned int>* RenderingSystem::CullInstances(VisibilityList& visibility, const glm::mat4& viewProjection, BatchSelection selection)
+    {
+        if (!FrustumCulling)
+        {
+            visibility.ShowAll(SceneRenderList, selection);
+            return nullptr;
+        }
+
+        visibility.Cull(SceneRenderList, viewProjection, selection);
+
+        DynamicBuffer<unsigned int>* instanceIndices = visibility.GetInstanceIndexBuffer();
+        if (instanceIndices->GetBytesSize() > 0)
+            LoadBuffer(instanceIndices);
+
+        return instanceIndices;
+    }
+
+    void RenderingSystem::DrawShadowCasters(RenderQueue& renderQueue, const VisibilityList& visibility, DynamicBuffer<unsigned int>* instanceIndices)
+    {
+        const std::vector<InstanceBatch>& instanceBatches = SceneRenderList.GetBatches();
+        const std::vector<BatchVisibility>& shadowBatches = visibility.GetBatches();
+
+        // Batches are sorted by mesh first: consecutive batches of the same mesh are merged, since shadow depth uses a single material
+        // (as long as their visible instances are listed one after the other)
+        for (unsigned int b = 0; b < instanceBatches.size(); )
+        {
+            const InstanceBatch& batch = instanceBatches[b];
+            if (shadowBatches[b].VisibleCount == 0)
+            {
+                ++b;
+                continue;
+            }
+
+            RenderCommand command{};
+            command.DataSourceID = GPUResourceInspector::GetResourceID(batch.BatchMesh);
+            command.FirstInstance = shadowBatches[b].FirstVisible;
+            command.InstanceIndices = instanceIndices;
+            command.InstanceCount = 0;
+            for (; b < instanceBatches.size() && instanceBatches[b].BatchMesh == batch.BatchMesh; ++b)
+            {
+                if (shadowBatches[b].VisibleCount > 0 && shadowBatches[b].FirstVisible != command.FirstInstance + command.InstanceCount)
+                    break;
+                command.InstanceCount += shadowBatches[b].VisibleCount;
+            }
+            command.Material = &ShadowDepthMaterial; // Use shadow depth material to render scene objects
+            command.ShaderSourceID = GPUResourceInspector::GetResourceID(command.Material->GetPipeline().lock().get());
+
+            // Add scene depth rendering data
+            command.AdditionalBufferData.Add(CameraDataName, &CameraBuffer);
+            command.AdditionalBufferData.Add(InstanceTransformBufferName, &SceneRenderList.GetInstanceTransformBuffer());
+
+            // depth from the main camera is meaningless for the light: only the mesh matters
+            renderQueue.Add(RenderQueue::MakeSortKey(GH_SHADOW_PASS, command.ShaderSourceID, 0, command.DataSourceID, 0.0f), command);
+        }
+
+        renderQueue.Sort();
+        RenderStateChanges changes = RenderQueue::CountStateChanges(renderQueue.GetCommands());
+        Stats.ShadowPass.Commands += changes.Commands;
+        Stats.ShadowPass.PipelineChanges += changes.PipelineChanges;
+        Stats.ShadowPass.MaterialChanges += changes.MaterialChanges;
+        Stats.ShadowPass.MeshChanges += changes.MeshChanges;
+        RendererAPI->Draw(renderQueue.GetCommands());
+        renderQueue.Clear();
+    }
+
+    void RenderingSystem::AddShadowCullingStats(const CullingStats& cascadeCulling)
+    {
+        Stats.ShadowCulling.VisibleInstances += cascadeCulling.VisibleInstances;
+        Stats.ShadowCulling.FrustumCulledInstances += cascadeCulling.FrustumCulledInstances;
+        Stats.ShadowCulling.Milliseconds += cascadeCulling.Milliseconds;
+    }
+
+    void RenderingSystem::AddScenePassData(RenderCommand& command, RenderBuffer& shadowBuffer, RenderBuffer& shadowAtlasBuffer)
+    {
+        command.AdditionalBufferData.Add(CameraDataName, &CameraBuffer);
+        command.AdditionalBufferData.Add(InstanceTransformBufferName, &SceneRenderList.GetInstanceTransformBuffer());
+        command.AdditionalBufferData.Add(LightingDataName, &LightingBuffer);
+        command.AdditionalBufferData.Add(PointLightBufferName, &PointLightBuffer);
+        command.AdditionalBufferData.Add(DirLightBufferName, &DirLightBuffer);
+        command.AdditionalBufferData.Add(IrradianceProbeBufferName, &IrradianceProbeBuffer);
+        command.AdditionalBufferData.Add(IrradianceVolumeDataName, &IrradianceVolumeBuffer);
+        command.AdditionalBufferData.Add(ShadowCascadeDataName, &ShadowCascadeBuffer);
+        command.AdditionalBufferData.Add(LightClusterDataName, &SceneLightClusters.GetClusterDataBuffer());
+        command.AdditionalBufferData.Add(LightClusterGridBufferName, &SceneLightClusters.GetGridBuffer());
+        command.AdditionalBufferData.Add(LightClusterIndexBufferName, &SceneLightClusters.GetLightIndexBuffer());
+        command.AdditionalBufferData.Add(PointLightShadowBufferName, &SceneShadowAtlas.GetShadowBuffer());
+        command.AdditionalRenderBufferData.Add(ShadowMapName, &shadowBuffer);
+        command.AdditionalRenderBufferData.Add(ShadowAtlasName, &shadowAtlasBuffer);
+    }
+
+    void RenderingSystem::DrawOcclusionQueries()
+    {
+        const std::vector<unsigned int>& queryIDs = SceneQueries.PrepareQueries(*RendererAPI);
+        Stats.OcclusionQueries = SceneQueries.GetStats();
+        if (queryIDs.empty() || !OcclusionBoxMesh)
+            return;
+
+        DynamicBuffer<TransformBufferData>& boxTransformBuffer = SceneQueries.GetBoxTransformBuffer();
+        LoadBuffer(&boxTransformBuffer);
+
+        CommandBuffer<RenderCommand> queryCommands{ FrameArena };
+        queryCommands.reserve(queryIDs.size());
+
+        // each box is an instance of the box transforms, drawn with its own query
+        for (unsigned int q = 0; q < queryIDs.size(); ++q)
+        {
+            RenderCommand command{};
+            command.DataSourceID = GPUResourceInspector::GetResourceID(OcclusionBoxMesh.get());
+            command.FirstInstance = q;
+            command.InstanceCount = 1;
+            command.Material = &ShadowDepthMaterial; // depth only
+            command.ShaderSourceID = GPUResourceInspector::GetResourceID(command.Material->GetPipeline().lock().get());
+            command.AdditionalBufferData.Add(CameraDataName, &CameraBuffer);
+            command.AdditionalBufferData.Add(InstanceTransformBufferName, &boxTransformBuffer);
+            command.OcclusionQueryID = queryIDs[q];
+
+            queryCommands.push_back(command);
+        }
+
+        // boxes must not change the image nor hide each other; faces touching the depth of their own object pass
+        RendererAPI->EnableColorWrite(false);
+        RendererAPI->EnableDepthWrite(false);
+        RendererAPI->SetDepthFunction(DepthFunction::LessEqual);
+
+        RendererAPI->Draw(queryCommands);
+
+        RendererAPI->SetDepthFunction(DepthFunction::Less);
+        RendererAPI->EnableDepthWrite(true);
+        RendererAPI->EnableColorWrite(true);
+    }
+
+    void RenderingSystem::DrawDeferredScenePass(CommandBuffer<RenderCommand>& sceneCommands, RenderBuffer& gBuffer, RenderBuffer& backBuffer, RenderBuffer& shadowBuffer, RenderBuffer& shadowAtlasBuffer, const Camera& camera)
     {
-        RendererAPI->BindRenderBuffer(GPUResourceInspector::GetResourceID(&renderBuffer));
+        // Commands keep their sorted order: the ones with a g-buffer variant are drawn into the g-buffer, the others forward after the lighting
+        CommandBuffer<RenderCommand> gBufferCommands{ FrameArena };
+        CommandBuffer<RenderCommand> forwardCommands{ FrameArena };
+        gBufferCommands.reserve(sceneCommands.size());
+        forwardCommands.reserve(sceneCommands.size());
+
+        for (const RenderCommand& command : sceneCommands)
+        {
+            unsigned int gBufferPipelineID = GetGBufferPipelineID(command);
+            if (gBufferPipelineID)
+            {
+                gBufferCommands.push_back(command);
+                gBufferCommands.back().ShaderSourceID = gBufferPipelineID;
+            }
+            else
+            {
+                forwardCommands.push_back(command);
+            }
+        }
+
+        Stats.GBufferCommands = (unsigned int)gBufferCommands.size();
+        Stats.ForwardFallbackCommands = (unsigned int)forwardCommands.size();
+
+        BeforeDraw(gBuffer);
+        RendererAPI->Draw(gBufferCommands);
+        AfterDraw(gBuffer);
+
+        // the depth of the g-buffer is kept for the forward draws and the occlusion queries
+        RendererAPI->CopyRenderBufferDepth(GPUResourceInspector::GetResourceID(&gBuffer), GPUResourceInspector::GetResourceID(&backBuffer), 0);
+        SetRenderBufferTarget(backBuffer);
+        RendererAPI->SetViewport(glm::uvec2(0, 0), backBuffer.GetSize());
+
+        std::shared_ptr<ShaderPipeline> lightingPipeline = DeferredLightingMaterial.GetPipeline().lock();
+        if (FullScreenTriangleMesh && lightingPipeline && lightingPipeline->IsResourceValid())
+        {
+            InverseViewProjection = glm::inverse(camera.GetProjectionMatrix() * camera.GetViewMatrix());
+
+            CommandBuffer<RenderCommand> lightingCommands{ FrameArena };
+            lightingCommands.emplace_back(RenderCommand{});
+            RenderCommand& command = lightingCommands.back();
+            command.DataSourceID = GPUResourceInspector::GetResourceID(FullScreenTriangleMesh.get());
+            command.InstanceCount = 1;
+            command.Material = &DeferredLightingMaterial;
+            command.ShaderSourceID = GPUResourceInspector::GetResourceID(lightingPipeline.get());
+            AddScenePassData(command, shadowBuffer, shadowAtlasBuffer);
+            command.AdditionalAttachmentData.Add(GBufferDiffuseName, RenderBufferAttachment{ &gBuffer, 0 });
+            command.AdditionalAttachmentData.Add(GBufferNormalName, RenderBufferAttachment{ &gBuffer, 1 });
+            command.AdditionalAttachmentData.Add(GBufferMaterialName, RenderBufferAttachment{ &gBuffer, 2 });
+            command.AdditionalRenderBufferData.Add(GBufferDepthName, &gBuffer);
+            command.AdditionalMat4Data.Add(InverseViewProjectionName, &InverseViewProjection);
+
+            // the triangle covers every pixel once, without touching the copied depth
+            RendererAPI->EnableDepthTest(false);
+            RendererAPI->Draw(lightingCommands);
+            RendererAPI->EnableDepthTest(true);
+        }
+
+        RendererAPI->Draw(forwardCommands);
+    }
+
+    unsigned int RenderingSystem::GetGBufferPipelineID(const RenderCommand& command)
+    {
+        std::unordered_map<unsigned int, std::shared_ptr<ShaderPipeline>>::iterator it = GBufferPipelines.find(command.ShaderSourceID);
+        if (it == GBufferPipelines.end())
+        {
+            // the variant is compiled the first time the pipeline is drawn, only if its fragment shader handles the g-buffer pass
+            std::shared_ptr<ShaderPipeline> variant;
+            std::shared_ptr<ShaderPipeline> pipeline = command.Material ? command.Material->GetPipeline().lock() : std::shared_ptr<ShaderPipeline>{};
+            if (pipeline && pipeline->GetType() == ShaderPipelineType::ShaderPipeline &&
+                ShaderPreprocessor::PreprocessShader(pipeline->GetFragmentShaderPath().data(), CurrentAPI).find("GH_GBUFFER_PASS") != std::string::npos)
+            {
+                variant = std::shared_ptr<ShaderPipeline>{ new ShaderPipeline{ pipeline->GetVertexShaderPath(), pipeline->GetTessContShaderPath(), pipeline->GetTessEvalShaderPath(),
+                    pipeline->GetGeometryShaderPath(), pipeline->GetFragmentShaderPath(), GH_GBUFFER_PASS_DEFINE } };
+
+                if (!CompileShader(*variant))
+                    variant.reset();
+            }
+
+            it = GBufferPipelines.emplace(command.ShaderSourceID, variant).first;
+        }
+
+        return it->second ? GPUResourceInspector::GetResourceID(it->second.get()) : 0;
+    }
+
+    void RenderingSystem::DrawWithDepthPrePass(RenderQueue& sceneQueue)
+    {
+        CommandBuffer<RenderCommand>& sceneCommands = sceneQueue.GetCommands();
+
+        // The same draws, with the vertex stage of their pipelines alone: grouped by pipeline, then front to back so that the nearest surfaces hide the others early
+        RenderQueue prePassQueue{ FrameArena };
+        prePassQueue.Reserve((unsigned int)sceneCommands.size());
+        CommandBuffer<RenderCommand> equalCommands{ FrameArena };
+        equalCommands.reserve(sceneCommands.size());
+        CommandBuffer<RenderCommand> fallbackCommands{ FrameArena };
+        for (unsigned int c = 0; c < sceneCommands.size(); ++c)
+        {
+            RenderCommand command = sceneCommands[c];
+            command.ShaderSourceID = GetDepthOnlyPipelineID(command);
+
+            // a draw missing from the pre-pass would fail the equal depth test
+            if (!command.ShaderSourceID)
+            {
+                fallbackCommands.push_back(sceneCommands[c]);
+                continue;
+            }
+
+            equalCommands.push_back(sceneCommands[c]);
+            prePassQueue.Add(RenderQueue::MakeSortKey(GH_DEPTH_PREPASS, command.ShaderSourceID, 0, 0, sceneQueue.GetNormalizedDepth(c)), command);
+        }
+
+        Stats.DepthPrePassFallbackCommands = (unsigned int)fallbackCommands.size();
+        if (equalCommands.empty())
+        {
+            RendererAPI->Draw(sceneCommands);
+            return;
+        }
+
+        prePassQueue.Sort();
+        Stats.DepthPrePass = RenderQueue::CountStateChanges(prePassQueue.GetCommands());
+
+        RendererAPI->EnableColorWrite(false);
+        RendererAPI->Draw(prePassQueue.GetCommands());
+        RendererAPI->EnableColorWrite(true);
+
+        // only the fragments of the visible surfaces are shaded, the depth is already complete
+        RendererAPI->EnableDepthWrite(false);
+        RendererAPI->SetDepthFunction(DepthFunction::Equal);
+
+        RendererAPI->Draw(equalCommands);
+
+        RendererAPI->EnableDepthWrite(true);
+
+        // draws without depth only variant are tested against the depth of the others, keeping the surfaces coplanar to them
+        if (!fallbackCommands.empty())
+        {
+            RendererAPI->SetDepthFunction(DepthFunction::LessEqual);
+            RendererAPI->Draw(fallbackCommands);
+        }
+
+        RendererAPI->SetDepthFunction(DepthFunction::Less);
+    }
+
+    unsigned int RenderingSystem::GetDepthOnlyPipelineID(const RenderCommand& command)
+    {
+        std::unordered_map<unsigned int, std::shared_ptr<ShaderPipeline>>::iterator it = DepthOnlyPipelines.find(command.ShaderSourceID);
+        if (it == DepthOnlyPipelines.end())
+        {
+            // the same vertex shader computes the same positions without the cost of the fragment shader, but only if gl_Position is invariant
+            std::shared_ptr<ShaderPipeline> variant;
+            std::shared_ptr<ShaderPipeline> pipeline = command.Material ? command.Material->GetPipeline().lock() : std::shared_ptr<ShaderPipeline>{};
+            if (pipeline && pipeline->GetType() == ShaderPipelineType::ShaderPipeline && HasInvariantPosition(*pipeline))
+            {
+                variant = std::shared_ptr<ShaderPipeline>{ new ShaderPipeline{ pipeline->GetVertexShaderPath(), pipeline->GetTessContShaderPath(), pipeline->GetTessEvalShaderPath(),
+                    pipeline->GetGeometryShaderPath(), "", pipeline->GetDefines() } };
+
+                if (!CompileShader(*variant))
+                    variant.reset();
+            }
+
+            it = DepthOnlyPipelines.emplace(command.ShaderSourceID, variant).first;
+        }
+
+        return it->second ? GPUResourceInspector::GetResourceID(it->second.get()) : 0;
+    }
+
+    bool RenderingSystem::HasInvariantPosition(const ShaderPipeline& pipeline) const
+    {
+        // the last stage before the rasterization writes the position
+        std::string lastStagePath = pipeline.GetGeometryShaderPath();
+        if (lastStagePath.empty())
+            lastStagePath = pipeline.GetTessEvalShaderPath();
+        if (lastStagePath.empty())
+            lastStagePath = pipeline.GetVertexShaderPath();
+
+        std::string code = ShaderPreprocessor::PreprocessShader(lastStagePath, CurrentAPI, pipeline.GetDefines());
+        return code.find("invariant gl_Position") != std::string::npos;
+    }
+
+    void RenderingSystem::AddIndirectSceneDraws(RenderQueue& renderQueue, const Camera& camera, RenderBuffer& shadowBuffer, RenderBuffer& shadowAtlasBuffer)
+    {
+        const std::vector<InstanceBatch>& instanceBatches = SceneRenderList.GetBatches();
+        if (instanceBatches.empty())
+            return;
+
+        // Batches drawn with the same material and primitive type are submitted by the same multi draw
+        // (materials are bound per draw, so a multi draw can't span more materials of the same pipeline)
+        struct DrawGroup
+        {
+            Material* GroupMaterial;
+            MeshPrimitive Primitive;
+            unsigned int MeshID; // any mesh of the group, for the primitive type
+            unsigned int FirstCommand;
+            unsigned int DrawsNumber;
+            float NearestDepth;
+        };
+        CommandBuffer<DrawGroup> groups{ FrameArena };
+        CommandBuffer<unsigned int> batchGroups{ FrameArena };
+        batchGroups.resize(instanceBatches.size(), GH_CULLING_NO_GROUP);
+
+        for (unsigned int b = 0; b < instanceBatches.size(); ++b)
+        {
+            const InstanceBatch& batch = instanceBatches[b];
+            if (!batch.BatchMaterial)
+                continue;
+
+            unsigned int g = 0;
+            for (; g < groups.size(); ++g)
+            {
+                if (groups[g].GroupMaterial == batch.BatchMaterial && groups[g].Primitive == batch.BatchMesh->GetPrimitive())
+                    break;
+            }
+
+            if (g == groups.size())
+                groups.push_back(DrawGroup{ batch.BatchMaterial, batch.BatchMesh->GetPrimitive(), GPUResourceInspector::GetResourceID(batch.BatchMesh), 0, 0, batch.NearestDepth });
+
+            ++groups[g].DrawsNumber;
+            groups[g].NearestDepth = std::min(groups[g].NearestDepth, batch.NearestDepth);
+            batchGroups[b] = g;
+        }
+
+        if (groups.empty())
+            return;
+
+        // Commands of each group are written one after the other
+        CullingGroupBuffer.ClearData();
+        unsigned int commandsNumber = 0;
+        for (DrawGroup& group : groups)
+        {
+            group.FirstCommand = commandsNumber;
+            CullingGroupBuffer.AddData(CullingGroupBufferData{ group.FirstCommand, 0 });
+            commandsNumber += group.DrawsNumber;
+        }
+
+        // The visible instances of a batch are compacted in its own range of slots, the same of its transforms
+        CullingDrawBuffer.ClearData();
+        for (unsigned int b = 0; b < instanceBatches.size(); ++b)
+        {
+            MeshDrawRange range = RendererAPI->GetMeshDrawRange(GPUResourceInspector::GetResourceID(instanceBatches[b].BatchMesh));
+            CullingDrawBuffer.AddData(CullingDrawBufferData{ range.IndexCount, range.FirstIndex, range.BaseVertex, instanceBatches[b].FirstInstance, batchGroups[b], 0, glm::uvec2(0) });
+        }
+
+        DynamicBuffer<InstanceBoundsBufferData>& instanceBoundsBuffer = SceneRenderList.GetInstanceBoundsBuffer();
+        unsigned int instancesNumber = (unsigned int)(instanceBoundsBuffer.GetBytesSize() / sizeof(InstanceBoundsBufferData));
+
+        // Buffers written by the gpu are reallocated only when the scene changes size
+        if (DrawCommandBuffer.GetBytesSize() != commandsNumber * sizeof(DrawCommandBufferData))
+        {
+            DrawCommandBuffer.ClearData();
+            for (unsigned int c = 0; c < commandsNumber; ++c)
+                DrawCommandBuffer.AddData(DrawCommandBufferData{});
+        }
+        if (VisibleInstanceBuffer.GetBytesSize() != instancesNumber * sizeof(unsigned int))
+        {
+            VisibleInstanceBuffer.ClearData();
+            for (unsigned int i = 0; i < instancesNumber; ++i)
+                VisibleInstanceBuffer.AddData(0);
+        }
+
+        // a frustum without planes contains everything: without frustum culling only the batches without material are skipped
+        glm::mat4 projection = camera.GetProjectionMatrix();
+        Frustum frustum = FrustumCulling ? Frustum{ projection * camera.GetViewMatrix() } : Frustum{};
+        CullingBufferData data{};
+        std::copy(frustum.Planes, frustum.Planes + 6, data.FrustumPlanes);
+        data.ViewPosition = camera.Transform.GetPosition();
+        data.ScreenScale = projection[1][1];
+        data.MinScreenSize = FrustumCulling ? MinScreenSize : 0.0f;
+        data.InstanceNumber = instancesNumber;
+        data.DrawNumber = (unsigned int)instanceBatches.size();
+        CullingBuffer.SetData(data, 0);
+
+        if (!instanceBoundsBuffer.IsResourceValid())
+            LoadBuffer(&instanceBoundsBuffer);
+        if (!DrawCommandBuffer.IsResourceValid())
+            LoadBuffer(&DrawCommandBuffer);
+        if (!VisibleInstanceBuffer.IsResourceValid())
+            LoadBuffer(&VisibleInstanceBuffer);
+        LoadBuffer(&CullingBuffer);
+        LoadBuffer(&CullingDrawBuffer);
+        LoadBuffer(&CullingGroupBuffer);
+
+        // One thread per instance to cull, then one thread per batch to write the draw commands
+        CommandBuffer<ComputeCommand> computeCommands{ FrameArena };
+        computeCommands.resize(2, ComputeCommand{});
+
+        ComputeCommand& cullCommand = computeCommands[0];
+        cullCommand.ShaderSourceID = GPUResourceInspector::GetResourceID(CullInstancesPipeline.lock().get());
+        cullCommand.GroupCount = glm::uvec3((instancesNumber + GH_CULLING_GROUP_SIZE - 1) / GH_CULLING_GROUP_SIZE, 1, 1);
+        cullCommand.AdditionalBufferData.Add(CullingDataName, &CullingBuffer);
+        cullCommand.AdditionalBufferData.Add(InstanceBoundsBufferName, &instanceBoundsBuffer);
+        cullCommand.AdditionalBufferData.Add(CullingDrawBufferName, &CullingDrawBuffer);
+        cullCommand.AdditionalBufferData.Add(VisibleInstanceBufferName, &VisibleInstanceBuffer);
+        cullCommand.Barriers = MemoryBarrierType::ShaderStorage | MemoryBarrierType::VertexAttribute; // counts read by the next dispatch, indices by the draws
+
+        ComputeCommand& buildCommand = computeCommands[1];
+        buildCommand.ShaderSourceID = GPUResourceInspector::GetResourceID(BuildDrawCommandsPipeline.lock().get());
+        buildCommand.GroupCount = glm::uvec3((data.DrawNumber + GH_CULLING_GROUP_SIZE - 1) / GH_CULLING_GROUP_SIZE, 1, 1);
+        buildCommand.AdditionalBufferData.Add(CullingDataName, &CullingBuffer);
+        buildCommand.AdditionalBufferData.Add(CullingDrawBufferName, &CullingDrawBuffer);
+        buildCommand.AdditionalBufferData.Add(CullingGroupBufferName, &CullingGroupBuffer);
+        buildCommand.AdditionalBufferData.Add(DrawCommandBufferName, &DrawCommandBuffer);
+        buildCommand.Barriers = MemoryBarrierType::Command; // arguments and draw counts read by the multi draws
+
+        RendererAPI->Dispatch(computeCommands);
+
+        // A multi draw for each group, reading the number of its visible batches from the group
+        for (unsigned int g = 0; g < groups.size(); ++g)
+        {
+            const DrawGroup& group = groups[g];
+
+            RenderCommand command{};
+            command.DataSourceID = group.MeshID;
+            command.Material = group.GroupMaterial;
+            command.ShaderSourceID = GPUResourceInspector::GetResourceID(command.Material->GetPipeline().lock().get());
+            AddScenePassData(command, shadowBuffer, shadowAtlasBuffer);
+
+            command.Indirect.Arguments = &DrawCommandBuffer;
+            command.Indirect.FirstArguments = group.FirstCommand;
+            command.Indirect.MaxDraws = group.DrawsNumber;
+            command.Indirect.Count = &CullingGroupBuffer;
+            command.Indirect.CountOffset = g * sizeof(CullingGroupBufferData) + offsetof(CullingGroupBufferData, DrawCount);
+            command.InstanceIndices = &VisibleInstanceBuffer;
+
+            renderQueue.Add(RenderQueue::MakeSortKey(GH_SCENE_PASS, command.ShaderSourceID, group.GroupMaterial->GetMaterialID(), command.DataSourceID, group.NearestDepth), command);
+
+            ++Stats.IndirectDraws;
+            Stats.IndirectMaxDraws += group.DrawsNumber;
+        }
+    }
+
+    void RenderingSystem::SetRenderBufferTarget(const RenderBuffer& renderBuffer, unsigned int layer)
+    {
+        RendererAPI->BindRenderBuffer(GPUResourceInspector::GetResourceID(&renderBuffer), layer);
     }
 
     void RenderingSystem::UnsetRenderBufferTarget(const RenderBuffer& renderBuffer)
@@ -859,7 +1863,7 @@ namespace GaladHen
     void RenderingSystem::SetupShadowDepthMaterial()
     {
         // Load shader pipeline
-        std::weak_ptr<ShaderPipeline> shadowDepthPipeline = AssetSystem::GetInstance()->LoadAndStoreShaderPipeline("GaladHen/Shaders/ShadingModels/ShadowDepth/ShadowDepth.vert", "", "", "", "GaladHen/Shaders/ShadingModels/ShadowDepth/ShadowDepth.frag", "", "ShadowDepth");
+        std::weak_ptr<ShaderPipeline> shadowDepthPipeline = AssetSystem::GetInstance()->LoadAndStoreShaderPipeline("GaladHen/Shaders/ShadingModels/ShadowDepth/ShadowDepth.vert", "", "", "", "", "", "ShadowDepth"); // depth only, without fragment stage
         std::shared_ptr<ShaderPipeline> shShadowDepthPipeline = shadowDepthPipeline.lock();
 
         // Compile shader pipeline
@@ -869,17 +1873,125 @@ namespace GaladHen
         ShadowDepthMaterial.SetPipeline(shadowDepthPipeline);
     }
 
+    void RenderingSystem::SetupOcclusionBoxMesh()
+    {
+        // unit cube centered in the origin, with counter clockwise faces seen from outside
+        std::vector<MeshVertexData> vertices;
+        vertices.reserve(8);
+        for (unsigned int c = 0; c < 8; ++c)
+        {
+            MeshVertexData vertex{};
+            vertex.Position = glm::vec3(c & 1 ? 0.5f : -0.5f, c & 2 ? 0.5f : -0.5f, c & 4 ? 0.5f : -0.5f);
+            vertices.push_back(vertex);
+        }
+
+        std::vector<unsigned int> indices
+        {
+            0, 2, 3, 0, 3, 1, // -z
+            4, 5, 7, 4, 7, 6, // +z
+            0, 4, 6, 0, 6, 2, // -x
+            1, 3, 7, 1, 7, 5, // +x
+            0, 1, 5, 0, 5, 4, // -y
+            2, 6, 7, 2, 7, 3  // +y
+        };
+
+        OcclusionBoxMesh = std::shared_ptr<Mesh>{ new Mesh{ vertices, indices, MeshPrimitive::Triangle } };
+        LoadMeshIfInvalid(*OcclusionBoxMesh);
+    }
+
+    void RenderingSystem::SetupDeferredLighting()
+    {
+        // Load shader pipeline
+        std::weak_ptr<ShaderPipeline> lightingPipeline = AssetSystem::GetInstance()->LoadAndStoreShaderPipeline("GaladHen/Shaders/ShadingModels/Deferred/DeferredLighting.vert", "", "", "",
+            "GaladHen/Shaders/ShadingModels/Deferred/DeferredLighting.frag", "", "DeferredLighting");
+
+        // Compile shader pipeline
+        if (std::shared_ptr<ShaderPipeline> shLightingPipeline = lightingPipeline.lock())
+            CompileShader(*shLightingPipeline);
+
+        // Setup material
+        DeferredLightingMaterial.SetPipeline(lightingPipeline);
+
+        // counter clockwise triangle whose inner part covers the [-1,1] square
+        std::vector<MeshVertexData> vertices(3, MeshVertexData{});
+        vertices[0].Position = glm::vec3(-1.0f, -1.0f, 0.0f);
+        vertices[1].Position = glm::vec3(3.0f, -1.0f, 0.0f);
+        vertices[2].Position = glm::vec3(-1.0f, 3.0f, 0.0f);
+        std::vector<unsigned int> indices{ 0, 1, 2 };
+
+        FullScreenTriangleMesh = std::shared_ptr<Mesh>{ new Mesh{ vertices, indices, MeshPrimitive::Triangle } };
+        LoadMeshIfInvalid(*FullScreenTriangleMesh);
+    }
+
+    void RenderingSystem::SetupRayCastPipeline()
+    {
+        RayCastPipeline = AssetSystem::GetInstance()->LoadAndStoreShaderPipeline("", "", "", "", "", "GaladHen/Shaders/RayTracing/BVHRayCast.comp", "BVHRayCast");
+        std::shared_ptr<ShaderPipeline> shRayCastPipeline = RayCastPipeline.lock();
+
+        // Compile shader pipeline
+        if (shRayCastPipeline)
+            CompileShader(*shRayCastPipeline);
+    }
+
+    void RenderingSystem::SetupCullingPipelines()
+    {
+        CullInstancesPipeline = AssetSystem::GetInstance()->LoadAndStoreShaderPipeline("", "", "", "", "", "GaladHen/Shaders/Culling/CullInstances.comp", "CullInstances");
+        BuildDrawCommandsPipeline = AssetSystem::GetInstance()->LoadAndStoreShaderPipeline("", "", "", "", "", "GaladHen/Shaders/Culling/BuildDrawCommands.comp", "BuildDrawCommands");
+
+        // Compile shader pipelines
+        if (std::shared_ptr<ShaderPipeline> shCullInstancesPipeline = CullInstancesPipeline.lock())
+            CompileShader(*shCullInstancesPipeline);
+        if (std::shared_ptr<ShaderPipeline> shBuildDrawCommandsPipeline = BuildDrawCommandsPipeline.lock())
+            CompileShader(*shBuildDrawCommandsPipeline);
+    }
+
     std::weak_ptr<RenderBuffer> RenderingSystem::CreateRenderBuffer_Internal(unsigned int width, unsigned int height, TextureFormat format, bool enableDepth, bool clampDepthToBorder)
+    {
+        return CreateRenderBuffer_Internal(width, height, std::vector<TextureFormat>{ format }, enableDepth, clampDepthToBorder);
+    }
+
+    std::weak_ptr<RenderBuffer> RenderingSystem::CreateRenderBuffer_Internal(unsigned int width, unsigned int height, const std::vector<TextureFormat>& formats, bool enableDepth, bool clampDepthToBorder)
     {
         // Create object
-        std::shared_ptr<RenderBuffer> renderBuffer = std::shared_ptr<RenderBuffer>{ new RenderBuffer{ width, height, format, enableDepth } };
+        std::shared_ptr<RenderBuffer> renderBuffer = std::shared_ptr<RenderBuffer>{ new RenderBuffer{ width, height, formats, enableDepth } };
         RenderBuffers.emplace_back(renderBuffer); // rendering system ownership
 
         // Create render buffer at api level and assing id
-        unsigned int id = RendererAPI->CreateRenderBuffer(width, height, format, enableDepth, clampDepthToBorder);
+        unsigned int id = RendererAPI->CreateRenderBuffer(width, height, formats.data(), renderBuffer->GetColorAttachments(), enableDepth, clampDepthToBorder);
         GPUResourceInspector::SetResourceID(renderBuffer.get(), id);
         GPUResourceInspector::ValidateResource(renderBuffer.get());
 
         return renderBuffer;
     }
+
+    std::weak_ptr<RenderBuffer> RenderingSystem::CreateShadowDepthBuffer_Internal()
+    {
+        const ShadowCascadeSettings& settings = SceneShadowCascades.GetSettings();
+
+        // Depth only, a layer for each cascade: the border is at maximum depth, so that nothing outside a cascade is in shadow
+        std::shared_ptr<RenderBuffer> renderBuffer = std::shared_ptr<RenderBuffer>{ new RenderBuffer{ settings.Resolution, settings.Resolution, settings.CascadeNumber } };
+        RenderBuffers.emplace_back(renderBuffer); // rendering system ownership
+
+        unsigned int id = RendererAPI->CreateDepthRenderBuffer(settings.Resolution, settings.Resolution, settings.CascadeNumber, true);
+        GPUResourceInspector::SetResourceID(renderBuffer.get(), id);
+        GPUResourceInspector::ValidateResource(renderBuffer.get());
+
+        return renderBuffer;
+    }
+
+    std::weak_ptr<RenderBuffer> RenderingSystem::CreateShadowAtlasBuffer_Internal()
+    {
+        // Depth only, sampled by texel: tiles never read the depth of the tiles beside them
+        unsigned int resolution = SceneShadowAtlas.GetSettings().Resolution;
+        return CreateRenderBuffer_Internal(resolution, resolution, std::vector<TextureFormat>{}, true);
+    }
+
+    void RenderingSystem::FreeRenderBuffer_Internal(const RenderBuffer& renderBuffer)
+    {
+        RendererAPI->FreeRenderBuffer(GPUResourceInspector::GetResourceID(&renderBuffer));
+
+        std::vector<std::shared_ptr<RenderBuffer>>::iterator it = std::find_if(RenderBuffers.begin(), RenderBuffers.end(), [&renderBuffer](const std::shared_ptr<RenderBuffer>& owned) { return owned.get() == &renderBuffer; });
+        if (it != RenderBuffers.end())
+            RenderBuffers.erase(it);
+    }
 }
@@ -11,14 +11,30 @@
 #include "Common.h"
 #include "Entities/Camera.h"
 #include <Utils/IdList.hpp>
+#include <Utils/LinearArena.h>
 #include "Entities/Buffer.hpp"
+#include "RenderQueue.h"
+#include "RenderList.h"
+#include "VisibilityList.h"
+#include "SoftwareOcclusion.h"
+#include "HardwareOcclusion.h"
+#include "ShadowCascades.h"
+#include "ShadowAtlas.h"
+#include "LightClusters.h"
+#include "ResidencySet.hpp"
 #include "Entities/BufferData/CameraBufferData.h"
 #include "Entities/BufferData/TransformBufferData.h"
 #include "Entities/BufferData/LightingBufferData.h"
 #include "Entities/BufferData/PointLightBufferData.h"
 #include "Entities/BufferData/DirLightBufferData.h"
+#include "Entities/BufferData/IrradianceProbeBufferData.h"
+#include "Entities/BufferData/CullingBufferData.h"
+#include "Entities/BufferData/IndirectCommandBufferData.h"
+#include "Entities/BufferData/ShadowCascadeBufferData.h"
+#include "RayTracing/GPURayTracingScene.h"
 #include "UI/Page.h"
 #include <type_traits>
+#include <unordered_map>
 
 namespace GaladHen
 {
@@ -28,10 +44,54 @@ namespace GaladHen
     class Mesh;
     class Material;
     class Texture;
+    class IBuffer;
+    class IGPUResource;
     class PointLight;
     class DirectionalLight;
+    class IrradianceVolume;
+    struct Ray;
     enum class TextureFormat;
 
+    // How the scene pass shades the scene objects
+    enum class RenderPath
+    {
+        Forward, // each draw shades its fragments with all the lights reaching them
+        Deferred // draws write the parameters of their materials into a g-buffer, then a screen space pass shades each pixel once
+    };
+
+    // Statistics of the last drawn frame
+    struct RenderingStats
+    {
+        RenderStateChanges ShadowPass; // summed over the shadow cascades and the faces rendered in the shadow atlas
+        RenderStateChanges ScenePass;
+        RenderStateChanges ScenePassUnsorted; // state changes the scene pass would have caused without sorting the draws
+        RenderStateChanges DepthPrePass; // zero if the scene pass was drawn without depth pre-pass
+        unsigned int DepthPrePassFallbackCommands; // scene pass commands whose pipelines have no depth only variant, drawn after the others with a less equal depth test
+        StateCallStats StateCalls; // state changing api calls of the frame, issued and skipped by the renderer
+        unsigned int ChangedObjects; // scene objects whose draw records were updated
+        bool RenderListRebuilt; // whether the batches were regrouped, because models or materials of the scene objects changed
+        unsigned int ResidentMeshes;
+        unsigned int ResidentMaterials;
+        unsigned int ResidentTextures;
+        unsigned int ResidentBuffers;
+        unsigned int PendingEvictions; // released resources waiting for the free delay
+        unsigned int FreedResources; // resources freed from gpu memory in the frame
+        GeometryMemoryStats Geometry;
+        unsigned int IndirectDraws; // multi draw calls of the gpu driven scene pass
+        unsigned int IndirectMaxDraws; // draws the multi draw calls can submit, before culling
+        CullingStats ShadowCulling; // instances culled against the volumes of the shadow cascades and of the shadow atlas faces, summed over them
+        unsigned int StaticShadowUpdates; // shadow cascades whose static casters were rendered again, because they or the cascade moved
+        unsigned int SkippedShadowCascades; // shadow cascades left as they were: static casters unchanged and no dynamic caster inside
+        ShadowAtlasStats ShadowAtlas; // point light shadows placed in the shadow atlas, and faces rendered in the frame
+        CullingStats SceneCulling; // instances culled against the camera frustum, not counted by the gpu driven scene pass
+        SoftwareOcclusionStats Occlusion; // occluders rasterized for the scene pass, zero without occlusion culling
+        HardwareOcclusionStats OcclusionQueries; // queries of the scene pass, zero without occlusion queries
+        float OcclusionCulledPercentage; // instances hidden by the occluders or by the occlusion queries, out of the ones passing the frustum and screen size tests
+        LightClusterStats LightClusters; // point lights assigned to the clusters of the camera view
+        unsigned int GBufferCommands; // scene pass commands drawn into the g-buffer, zero with the forward path
+        unsigned int ForwardFallbackCommands; // scene pass commands of the deferred path whose pipelines can't write the g-buffer, drawn forward after the lighting pass
+    };
+
 	class RenderingSystem : public ISystem, public WeakSingleton<RenderingSystem>
 	{
         friend SystemsCoordinator;
@@ -45,6 +105,11 @@ namespace GaladHen
         // @param writeDepth: specifies whether writing on a depth buffer is enabled when using the render buffer or not
         std::weak_ptr<RenderBuffer> CreateRenderBuffer(unsigned int width, unsigned int height, TextureFormat format, bool enableDepth = true);
 
+        // @brief
+        // Create a gpu render buffer with several color attachments, written at once by the outputs of the fragment shaders
+        // @param formats: format of each color attachment, up to GH_MAX_RENDER_BUFFER_ATTACHMENTS
+        std::weak_ptr<RenderBuffer> CreateRenderBuffer(unsigned int width, unsigned int height, const std::vector<TextureFormat>& formats, bool enableDepth = true);
+
         // @brief
         // Get default front render buffer
         std::weak_ptr<RenderBuffer> GetFrontRenderBuffer();
@@ -100,10 +165,85 @@ namespace GaladHen
         // @returns: compilation result
         bool CompileShader(ShaderPipeline& shader);
 
+        // @brief
+        // Cast a batch of world space rays against the scene on gpu. The results are read back asynchronously
+        // The BVHs of the scene meshes must be already built
+        // @returns the id of the ray query, 0 if it could not be submitted
+        unsigned int SubmitRayQuery(const Scene& scene, const std::vector<Ray>& rays);
+
+        // @brief
+        // Get the results of a ray query if the gpu completed it, releasing the query
+        // @param queryID: the id returned by SubmitRayQuery()
+        // @param[out] outHits: one hit for each ray of the query, in the same order. The incomplete ones (BVH deeper than the gpu traversal stack) must be cast again on cpu
+        // @param wait: block until the results are available
+        // @returns true if the results were available
+        bool RetrieveRayQuery(unsigned int queryID, std::vector<SceneRayHit>& outHits, bool wait = false);
+
         void CreateMainWindow(const std::string& name, const glm::uvec2 size);
 
         void CloseMainWindow();
 
+        // @brief
+        // Get the statistics of the last frame drawn
+        const RenderingStats& GetRenderingStats() const;
+
+        // @brief
+        // Cull the scene instances against the camera frustum on gpu, and draw the scene pass with a multi draw for each material
+        // It needs indirect draws with a gpu draw count: if they are not supported the draws stay on cpu
+        void SetGPUDrivenDrawing(bool enable);
+
+        bool IsGPUDrivenDrawingEnabled() const;
+
+        // @brief
+        // Set the cascades of the directional light shadows: changing their number or resolution recreates the shadow map
+        void SetShadowCascades(const ShadowCascadeSettings& settings);
+
+        const ShadowCascadeSettings& GetShadowCascades() const;
+
+        // @brief
+        // Set the shadow atlas of the point lights casting shadows (see PointLight::CastShadows): changing its resolution recreates the atlas
+        void SetShadowAtlas(const ShadowAtlasSettings& settings);
+
+        const ShadowAtlasSettings& GetShadowAtlas() const;
+
+        // @brief
+        // Draw only the scene objects inside the view of the camera, and render shadows only for the ones inside the volumes of the shadow cascades (enabled by default)
+        void SetFrustumCulling(bool enable);
+
+        bool IsFrustumCullingEnabled() const;
+
+        // @brief
+        // Skip the scene objects too small to contribute to the image, in the scene pass only (shadows keep them). Needs frustum culling
+        // @param minScreenSize: fraction of the viewport height covered by the bounding sphere of an object, under which it is not drawn (0 to draw all)
+        void SetMinScreenSize(float minScreenSize);
+
+        float GetMinScreenSize() const;
+
+        // @brief
+        // Skip the scene objects hidden behind the occluders (see SceneObject::SetOccluder), rasterized on cpu every frame (disabled by default)
+        // In the scene pass only, when drawing from cpu. Needs frustum culling
+        void SetOcclusionCulling(bool enable);
+
+        bool IsOcclusionCullingEnabled() const;
+
+        // @returns the occluders rasterized for the last scene pass, to inspect their depth hierarchy
+        const SoftwareOcclusion& GetSceneOcclusion() const;
+
+        // @brief
+        // Skip the scene objects whose bounding boxes were hidden by the depth of the previous frames, tested by occlusion queries (disabled by default)
+        // Results are never waited for: objects coming into view can appear a frame late. In the scene pass only, when drawing from cpu. Needs frustum culling
+        void SetOcclusionQueries(bool enable);
+
+        bool AreOcclusionQueriesEnabled() const;
+
+        // @brief
+        // Set the render path of the default render context (forward by default)
+        // The deferred path draws the scene objects into a g-buffer with the variants of their pipelines compiled with GH_GBUFFER_PASS, then shades the
+        // pixels with the PBR shading model; pipelines whose fragment shaders don't handle GH_GBUFFER_PASS are drawn forward after the lighting pass
+        void SetRenderPath(RenderPath path);
+
+        RenderPath GetRenderPath();
+
         // @brief
         // Update texture data into gpu memory -> it is done only if the texture is already in cache
         //void UpdateTexture(Texture& texture);
@@ -126,7 +266,7 @@ namespace GaladHen
         class RenderContext
         {
         public:
-            // TODO: RenderScene -> collection of models and theirs Bounding Volumes + spatial partitioning structure containing all the models (for frustum culling)
+            // TODO: spatial partitioning of the render list instances: frustum culling (VisibilityList) still tests the bounds of every instance
 
             RenderContext(RenderingSystem& renderingSys, unsigned int width, unsigned int height, RenderContextType renderContextType);
 
@@ -140,6 +280,21 @@ namespace GaladHen
 
             std::weak_ptr<RenderBuffer> GetShadowDepthBuffer() const;
 
+            std::weak_ptr<RenderBuffer> GetStaticShadowDepthBuffer() const;
+
+            void SetShadowDepthBuffers(std::weak_ptr<RenderBuffer> shadowDepthBuffer, std::weak_ptr<RenderBuffer> staticShadowDepthBuffer);
+
+            std::weak_ptr<RenderBuffer> GetShadowAtlasBuffer() const;
+
+            void SetShadowAtlasBuffer(std::weak_ptr<RenderBuffer> shadowAtlasBuffer);
+
+            RenderPath GetRenderPath() const;
+
+            std::weak_ptr<RenderBuffer> GetGBuffer() const;
+
+            // @param gBuffer: needed by the deferred path, empty for the forward one
+            void SetRenderPath(RenderPath path, std::weak_ptr<RenderBuffer> gBuffer);
+
             void SwapBuffers();
 
             Camera RenderingCamera;
@@ -151,7 +306,12 @@ namespace GaladHen
             std::shared_ptr<RenderBuffer> FrontBuffer;
             std::shared_ptr<RenderBuffer> BackBuffer;
 
-            std::shared_ptr<RenderBuffer> ShadowDepthBuffer;
+            std::shared_ptr<RenderBuffer> ShadowDepthBuffer; // a layer for each shadow cascade
+            std::shared_ptr<RenderBuffer> StaticShadowDepthBuffer; // depth of the static casters alone, copied in the shadow map before drawing the dynamic ones
+            std::shared_ptr<RenderBuffer> ShadowAtlasBuffer; // depth of the point light shadows, a tile for each cube face
+
+            RenderPath Path;
+            std::shared_ptr<RenderBuffer> GBuffer; // layout of GBuffer.glsl, with the size of the back buffer
 
         };
 
@@ -163,19 +323,109 @@ namespace GaladHen
 
         // Rendering data
         IdList<RenderContext> RenderContexts; // the RenderContext with id 1 is the default one
-        std::unordered_set<unsigned int> LoadedMeshesCache; // cache of already loaded meshes -> for reloading, it requires that a mesh knows when it has been modified
-        std::unordered_set<unsigned int> LoadedTexturesCache; // cache of already loaded textures -> for reloading, it requires that a texture knows when it has been modified
-        std::unordered_set<unsigned int> LoadedBuffersCache; // cache of already loaded buffers -> for reloading, it requires that a buffer knows when it has been modified
         std::unordered_set<unsigned int> CompiledShadersCache; // cache of already compiled shaders -> for reloading, it requires that a shader knows when it has been modified
         std::vector<std::shared_ptr<RenderBuffer>> RenderBuffers; // list of created render buffers
         Material ShadowDepthMaterial; // material to render shadow depth maps
 
+        // Transient containers of a frame allocate from the frame arena, reset at the beginning of each draw
+        LinearArena FrameArena;
+
+        // Resources in gpu memory, acquired when a scene object starts using them and freed some frames after the last one stops
+        // They are loaded when they become resident, and loaded again only when modified
+        struct MaterialDependencies
+        {
+            std::vector<const Texture*> Textures;
+            std::vector<const IBuffer*> Buffers;
+            unsigned int MaterialVersion; // of the material when the dependencies were gathered
+        };
+        ResidencySet<Mesh> MeshResidency;
+        ResidencySet<Material> MaterialResidency;
+        ResidencySet<Texture> TextureResidency;
+        ResidencySet<IBuffer> BufferResidency;
+        std::unordered_map<const Material*, MaterialDependencies> ResidentMaterialsDependencies; // textures and buffers acquired by each resident material
+        MaterialDependencies DependenciesScratch; // reused to refresh the dependencies of a material without allocating
+        unsigned int LoadedMeshesVersion; // last mesh version when the resident meshes were checked
+        unsigned int LoadedMaterialsVersion; // last material version when the resident materials were checked
+        unsigned int LoadedTexturesVersion; // last texture version when the resident textures were checked
+        unsigned int FrameNumber;
+
         // Buffers
         FixedBuffer<CameraBufferData, 1> CameraBuffer;
-        FixedBuffer<TransformBufferData, 1> TransformBuffer;
         FixedBuffer<LightingBufferData, 1> LightingBuffer;
         DynamicBuffer<PointLightBufferData> PointLightBuffer;
         DynamicBuffer<DirLightBufferData> DirLightBuffer;
+        DynamicBuffer<IrradianceProbeBufferData> IrradianceProbeBuffer;
+        FixedBuffer<IrradianceVolumeBufferData, 1> IrradianceVolumeBuffer;
+        unsigned int LoadedIrradianceVolumeVersion; // bake version of the irradiance probes currently in gpu memory
+        FixedBuffer<ShadowCascadeBufferData, 1> ShadowCascadeBuffer;
+
+        // Shadows of the first directional light
+        ShadowCascades SceneShadowCascades;
+        struct StaticShadowCache
+        {
+            glm::mat4 ViewProjection; // of the cascade when its static casters were rendered, changing only when the cascade steps to another placement
+            unsigned int StaticVersion; // of the render list when the static casters were rendered
+            bool Valid;
+            bool HasCasters; // false if no static caster is inside the cascade: the shadow map is cleared instead of copying the static depth
+            bool ShadowMapCurrent; // the shadow map cascade holds the static depth alone, without dynamic casters
+        };
+        StaticShadowCache StaticShadowCaches[GH_MAX_SHADOW_CASCADES];
+
+        // Shadows of the point lights, in the tiles of a single depth texture
+        ShadowAtlas SceneShadowAtlas;
+
+        // Point lights of the clusters of the camera view
+        LightClusters SceneLightClusters;
+
+        // Draw records of the scene objects, retained between frames
+        RenderList SceneRenderList;
+
+        // Instances of the draw records visible from the shadow cascades and from the camera
+        bool FrustumCulling;
+        float MinScreenSize;
+        VisibilityList CascadeVisibility[GH_MAX_SHADOW_CASCADES]; // dynamic casters
+        VisibilityList StaticCascadeVisibility[GH_MAX_SHADOW_CASCADES];
+        VisibilityList ShadowAtlasVisibility; // reused by the faces of the shadow atlas, rendered one after the other
+        VisibilityList SceneVisibility;
+        bool OcclusionCulling;
+        SoftwareOcclusion SceneOcclusion;
+        bool OcclusionQueries;
+        HardwareOcclusion SceneQueries;
+        std::shared_ptr<Mesh> OcclusionBoxMesh; // unit cube drawn by the occlusion queries
+
+        // Deferred path
+        std::unordered_map<unsigned int, std::shared_ptr<ShaderPipeline>> GBufferPipelines; // g-buffer variant of each scene pipeline by id, nullptr if the pipeline has none
+        Material DeferredLightingMaterial;
+        std::shared_ptr<Mesh> FullScreenTriangleMesh; // covers the screen with a single triangle, already in clip coordinates
+        glm::mat4 InverseViewProjection; // of the camera, to reconstruct the world positions of the g-buffer pixels
+
+        // Depth pre-pass
+        std::unordered_map<unsigned int, std::shared_ptr<ShaderPipeline>> DepthOnlyPipelines; // variant without fragment stage of each scene pipeline by id, nullptr if it doesn't compile
+
+        // Gpu driven drawing: instances culled by a compute shader, draw commands written by the gpu
+        bool GPUDrivenDrawing;
+        FixedBuffer<CullingBufferData, 1> CullingBuffer;
+        DynamicBuffer<CullingDrawBufferData> CullingDrawBuffer; // one for each instance batch
+        DynamicBuffer<CullingGroupBufferData> CullingGroupBuffer; // one for each multi draw
+        DynamicBuffer<DrawCommandBufferData> DrawCommandBuffer; // written by the gpu, only sized by the cpu
+        DynamicBuffer<unsigned int> VisibleInstanceBuffer; // written by the gpu, only sized by the cpu
+        std::weak_ptr<ShaderPipeline> CullInstancesPipeline;
+        std::weak_ptr<ShaderPipeline> BuildDrawCommandsPipeline;
+
+        RenderingStats Stats;
+
+        // Ray queries
+        struct RayQuery
+        {
+            std::shared_ptr<DynamicBuffer<RayBufferData>> Rays;
+            std::shared_ptr<DynamicBuffer<RayHitBufferData>> Hits;
+            std::vector<RayInstanceSource> InstanceSources; // instances at the moment of the ray cast, to resolve the hits
+            unsigned int FenceID;
+        };
+        GPURayTracingScene RayTracingScene;
+        std::weak_ptr<ShaderPipeline> RayCastPipeline;
+        std::unordered_map<unsigned int, RayQuery> RayQueries;
+        unsigned int LastRayQueryID;
 
         // UI
         UIPage* CurrentUIPage;
@@ -183,48 +433,56 @@ namespace GaladHen
         // INTERNAL FUNCTIONALITIES ---------------------------------------------------------
 
         RenderContext& GetDefaultRenderContext();
-        void BeforeDraw(const RenderBuffer& renderBuffer);
+        void BeforeDraw(const RenderBuffer& renderBuffer, unsigned int layer = 0);
         void AfterDraw(const RenderBuffer& renderBuffer);
-        bool IsMeshCached(unsigned int meshID);
-        void CacheMesh(unsigned int meshID);
-        void UncacheMesh(unsigned int meshID);
         bool IsShaderCached(unsigned int shaderID);
         void CacheShader(unsigned int shaderID);
         void UncacheShader(unsigned int shaderID);
-        bool IsTextureCached(unsigned int textureID);
-        void CacheTexture(unsigned int textureID);
-        void UncacheTexture(unsigned int textureID);
-        bool IsBufferCached(unsigned int bufferID);
-        void CacheBuffer(unsigned int bufferID);
-        void UncacheBuffer(unsigned int bufferID);
-        void LoadModels(const Scene& scene, std::unordered_set<unsigned int>& outLoadedMeshesIDs);
-        void LoadMeshAndCache(Mesh& mesh);
+        void LoadModels();
+        void LoadMeshIfInvalid(Mesh& mesh); // loads a mesh never loaded or modified after its loading
         unsigned int LoadMesh(Mesh& mesh);
-        void FreeUnusedMeshes(const std::unordered_set<unsigned int>& usedMeshesIDs);
-        void FreeMeshes(const std::unordered_set<unsigned int>& meshesToFree);
-        void FreeMesh(unsigned int meshID);
-        void LoadMaterialsData(const Scene& scene, std::unordered_set<unsigned int>& outLoadedTexturesIDs, std::unordered_set<unsigned int>& outLoadedBuffersIDs);
-        void LoadMaterialData(Material& material, std::unordered_set<unsigned int>& outLoadedTextures, std::unordered_set<unsigned int>& outLoadedBuffers);
-        void LoadTextureAndCache(Texture& texture);
+        void LoadMaterialsData();
+        void LoadMaterialData(Material& material, MaterialDependencies& dependencies);
+        void LoadTextureIfInvalid(Texture& texture);
         unsigned int LoadTexture(Texture& texture);
-        void LoadBufferAndCache(IBuffer* buffer);
+        void LoadBufferIfInvalid(IBuffer* buffer);
         unsigned int LoadBuffer(IBuffer* buffer);
-        void FreeUnusedTextures(const std::unordered_set<unsigned int>& usedTexturesIDs);
-        void FreeTextures(const std::unordered_set<unsigned int>& texturesToFree);
-        void FreeTexture(unsigned int textureID);
-        void FreeUnusedBuffers(const std::unordered_set<unsigned int>& usedBuffersIDs);
-        void FreeBuffers(const std::unordered_set<unsigned int>& buffersToFree);
-        void FreeBuffer(unsigned int bufferID);
+        void FreeUncachedBuffer(unsigned int bufferID);
+        void FreeEvictedResources();
+        void AddFreeCommand(CommandBuffer<MemoryTransferCommand>& memoryCommands, IGPUResource* resource, MemoryTargetType targetType);
         void LoadCameraData(const Camera& camera);
-        void LoadTransformData(const Transform& transform);
+        void LoadCameraData(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, const glm::vec3& position);
+        void LoadInstanceData(const Scene& scene);
         void LoadLightingData(const Scene& scene);
         void LoadPointLightData(const std::vector<PointLight>& pointLights);
+        void LoadLightClusterData(const Camera& camera, const std::vector<PointLight>& pointLights, const glm::uvec2& viewportSize);
         void LoadDirLightData(const std::vector<DirectionalLight>& dirLights);
-        void SetRenderBufferTarget(const RenderBuffer& renderBuffer);
+        void LoadIrradianceVolumeData(const IrradianceVolume& irradianceVolume);
+        DynamicBuffer<unsigned int>* CullInstances(VisibilityList& visibility, const Camera& camera, float minScreenSize, const SoftwareOcclusion* occlusion, HardwareOcclusion* queries); // @returns the instance indices for the draws, nullptr without culling
+        DynamicBuffer<unsigned int>* CullInstances(VisibilityList& visibility, const glm::mat4& viewProjection, BatchSelection selection); // frustum only, ex: of a shadow cascade
+        void DrawShadowCasters(RenderQueue& renderQueue, const VisibilityList& visibility, DynamicBuffer<unsigned int>* instanceIndices);
+        void AddShadowCullingStats(const CullingStats& cascadeCulling);
+        void AddScenePassData(RenderCommand& command, RenderBuffer& shadowBuffer, RenderBuffer& shadowAtlasBuffer);
+        void DrawOcclusionQueries();
+        void DrawDeferredScenePass(CommandBuffer<RenderCommand>& sceneCommands, RenderBuffer& gBuffer, RenderBuffer& backBuffer, RenderBuffer& shadowBuffer, RenderBuffer& shadowAtlasBuffer, const Camera& camera);
+        unsigned int GetGBufferPipelineID(const RenderCommand& command); // @returns 0 if the pipeline of the command can't write the g-buffer
+        void DrawWithDepthPrePass(RenderQueue& sceneQueue);
+        unsigned int GetDepthOnlyPipelineID(const RenderCommand& command); // @returns 0 if the pipeline of the command has no depth only variant (its position is not invariant or it doesn't compile)
+        bool HasInvariantPosition(const ShaderPipeline& pipeline) const; // @returns true if the last stage before the rasterization declares gl_Position as invariant
+        void AddIndirectSceneDraws(RenderQueue& renderQueue, const Camera& camera, RenderBuffer& shadowBuffer, RenderBuffer& shadowAtlasBuffer);
+        void SetRenderBufferTarget(const RenderBuffer& renderBuffer, unsigned int layer = 0);
         void UnsetRenderBufferTarget(const RenderBuffer& renderBuffer);
         void SwapMainWindowBuffers();
         void BeforeDrawUI();
         void SetupShadowDepthMaterial();
+        void SetupRayCastPipeline();
+        void SetupCullingPipelines();
+        void SetupOcclusionBoxMesh();
+        void SetupDeferredLighting();
         std::weak_ptr<RenderBuffer> CreateRenderBuffer_Internal(unsigned int width, unsigned int height, TextureFormat format, bool enableDepth = true, bool clampDepthToBorder = false);
+        std::weak_ptr<RenderBuffer> CreateRenderBuffer_Internal(unsigned int width, unsigned int height, const std::vector<TextureFormat>& formats, bool enableDepth = true, bool clampDepthToBorder = false);
+        std::weak_ptr<RenderBuffer> CreateShadowDepthBuffer_Internal(); // sized by the shadow cascade settings
+        std::weak_ptr<RenderBuffer> CreateShadowAtlasBuffer_Internal(); // sized by the shadow atlas settings
+        void FreeRenderBuffer_Internal(const RenderBuffer& renderBuffer);
 	};
 }
@@ -0,0 +1,145 @@
+// Reference counted set of resources resident in gpu memory
+// A resource enters the set at its first acquisition and leaves it some frames after its last release, so that short detachments do not reload it
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+namespace GaladHen
+{
+	template <class T>
+	class ResidencySet
+	{
+	public:
+
+		// @brief
+		// Add a reference to a resource, keeping it alive while it is resident
+		// @returns true if the resource was not resident
+		bool Acquire(const std::shared_ptr<T>& resource)
+		{
+			Entry& entry = Entries[resource.get()];
+			bool added = !entry.Resource;
+			if (added)
+			{
+				entry.Resource = resource;
+				Added.push_back(resource.get());
+			}
+
+			++entry.References;
+
+			return added;
+		}
+
+		// @brief
+		// Remove a reference to a resource. When no references are left, the resource is evicted after the release delay
+		// @param frame: number of the current frame
+		void Release(const T* resource, unsigned int frame)
+		{
+			typename std::unordered_map<const T*, Entry>::iterator it = Entries.find(resource);
+			if (it == Entries.end() || it->second.References == 0)
+				return;
+
+			if (--it->second.References == 0)
+			{
+				it->second.ReleaseFrame = frame;
+				Released.push_back(resource);
+			}
+		}
+
+		bool IsResident(const T* resource) const
+		{
+			return Entries.find(resource) != Entries.end();
+		}
+
+		// @brief
+		// Remove the resources released at least delay frames ago and not acquired again
+		// @param onEvict: called for each evicted resource, before the set drops its reference
+		template <class F>
+		void Evict(unsigned int frame, unsigned int delay, F onEvict)
+		{
+			unsigned int kept = 0;
+			for (const T* resource : Released)
+			{
+				typename std::unordered_map<const T*, Entry>::iterator it = Entries.find(resource);
+
+				// acquired again, or already evicted (a resource can be released more times)
+				if (it == Entries.end() || it->second.References > 0)
+					continue;
+
+				if (frame - it->second.ReleaseFrame < delay)
+				{
+					Released[kept++] = resource;
+					continue;
+				}
+
+				onEvict(it->second.Resource);
+				Entries.erase(it);
+			}
+
+			Released.resize(kept);
+		}
+
+		// @brief
+		// Call a function for every resident resource, released ones waiting for eviction included
+		template <class F>
+		void ForEach(F function)
+		{
+			for (std::pair<const T* const, Entry>& entry : Entries)
+				function(entry.second.Resource);
+		}
+
+		// @brief
+		// Call a function for every resource that entered the set since the last call, so that only new residents are loaded
+		template <class F>
+		void ForEachAdded(F function)
+		{
+			for (const T* resource : Added)
+			{
+				// already evicted if released in the meantime
+				typename std::unordered_map<const T*, Entry>::iterator it = Entries.find(resource);
+				if (it != Entries.end())
+					function(it->second.Resource);
+			}
+
+			Added.clear();
+		}
+
+		// @brief
+		// Forget the resources that entered the set, for sets whose resources are loaded by the caller before being acquired
+		void ClearAdded()
+		{
+			Added.clear();
+		}
+
+		unsigned int GetResidentsNumber() const
+		{
+			return (unsigned int)Entries.size();
+		}
+
+		unsigned int GetPendingEvictionsNumber() const
+		{
+			return (unsigned int)Released.size();
+		}
+
+	protected:
+
+		struct Entry
+		{
+			Entry()
+				: References(0)
+				, ReleaseFrame(0)
+			{}
+
+			std::shared_ptr<T> Resource;
+			unsigned int References;
+			unsigned int ReleaseFrame;
+		};
+
+		std::unordered_map<const T*, Entry> Entries;
+		std::vector<const T*> Released; // in release order, waiting for eviction
+		std::vector<const T*> Added; // entered the set since the last ForEachAdded()
+
+	};
+}
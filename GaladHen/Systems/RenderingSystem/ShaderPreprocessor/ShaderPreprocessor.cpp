@@ -10,7 +10,7 @@
 
 namespace GaladHen
 {
-	std::string ShaderPreprocessor::PreprocessShader(const std::string& shaderPath, API api)
+	std::string ShaderPreprocessor::PreprocessShader(const std::string& shaderPath, API api, const std::string& defines)
 	{
 		std::string shaderCode = FileLoader::ReadTextFile(shaderPath);
 
@@ -26,6 +26,8 @@ namespace GaladHen
 			outCode = shaderCode;
 			shaderVersion = GH_GLSL_VERSION;
 			shaderVersion += "\n\n";
+			if (!defines.empty())
+				shaderVersion += defines + "\n\n";
 			outCode.insert(0, shaderVersion);
 
 			return PreprocessShader_Recursive(shaderPath, outCode);
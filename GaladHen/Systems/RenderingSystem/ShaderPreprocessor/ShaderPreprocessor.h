@@ -11,7 +11,8 @@ namespace GaladHen
 	{
 	public:
 
-		static std::string PreprocessShader(const std::string& shaderPath, API api);
+		// @param defines: directives inserted right after the version (ex: "#define NAME")
+		static std::string PreprocessShader(const std::string& shaderPath, API api, const std::string& defines = std::string{});
 
 	private:
 
@@ -0,0 +1,337 @@
+#include "ShadowAtlas.h"
+
+#include "Entities/Camera.h"
+#include "Entities/PointLight.h"
+#include <Math/Frustum.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#define GH_POINT_SHADOW_NEAR 0.05f // near plane of the face projections, casters closer to the light are clipped
+#define GH_POINT_SHADOW_BIAS_TEXELS 1.5f // depth bias of the faces, in texels of their tiles
+#define GH_SHADOW_ATLAS_SHRINK_RATIO 0.375f // tiles shrink when the light needs less than this fraction of their side, so that lights at the size boundary don't keep changing tiles
+
+namespace GaladHen
+{
+	// directions and up vectors of the cube faces, as the faces of a cube map
+	static const glm::vec3 FaceDirections[GH_POINT_SHADOW_FACES] =
+	{
+		glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+	};
+	static const glm::vec3 FaceUps[GH_POINT_SHADOW_FACES] =
+	{
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)
+	};
+
+	ShadowAtlasSettings::ShadowAtlasSettings()
+		: Resolution(GH_DEFAULT_SHADOW_ATLAS_RESOLUTION)
+		, MinTileSize(64)
+		, MaxTileSize(1024)
+		, UpdateBudget(12)
+		, RefreshInterval(8)
+	{}
+
+	ShadowAtlas::ShadowAtlas(const ShadowAtlasSettings& settings)
+		: Allocator(settings.Resolution, settings.MinTileSize)
+		, ShadowBuffer(DynamicBuffer<PointShadowBufferData>{ BufferType::ShaderStorage, BufferAccessType::StreamWrite })
+		, Stats()
+		, Frame(0)
+		, StaticVersion(0)
+		, StaticChangedFrame(0)
+	{
+		SetSettings(settings);
+	}
+
+	void ShadowAtlas::Update(const Camera& camera, const std::vector<PointLight>& pointLights, unsigned int staticVersion)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		++Frame;
+		Stats = ShadowAtlasStats{};
+
+		// faces rendered before the static objects changed are refreshed first, their depth is kept meanwhile
+		if (staticVersion != StaticVersion)
+		{
+			StaticVersion = staticVersion;
+			StaticChangedFrame = Frame;
+		}
+
+		for (unsigned int l = (unsigned int)pointLights.size(); l < LightShadows.size(); ++l)
+			ReleaseTiles(LightShadows[l]);
+		LightShadows.resize(pointLights.size(), LightShadow{});
+
+		const Frustum viewFrustum{ camera.GetProjectionMatrix() * camera.GetViewMatrix() };
+		const glm::vec3 cameraPosition = camera.Transform.GetPosition();
+		const float tanHalfFovY = std::tan(glm::radians(camera.GetFovY()) * 0.5f);
+
+		// lights leaving the view or the shadows release their tiles first, so that the others can take their space
+		// (the tiles of the others are kept as long as they are large enough, each new tile has to be rendered again)
+		AllocationOrder.clear();
+		for (unsigned int l = 0; l < pointLights.size(); ++l)
+		{
+			const PointLight& light = pointLights[l];
+			LightShadow& shadow = LightShadows[l];
+			shadow.ShadowIndex = -1;
+
+			glm::vec3 position = light.Transform.GetPosition();
+			bool visible = light.CastShadows && light.Radius > 0.0f;
+			for (unsigned int p = 0; p < 6 && visible; ++p)
+				visible = glm::dot(glm::vec3(viewFrustum.Planes[p]), position) + viewFrustum.Planes[p].w > -light.Radius;
+
+			if (!visible)
+			{
+				ReleaseTiles(shadow);
+				if (light.CastShadows)
+					++Stats.SkippedLights;
+				continue;
+			}
+
+			// a moved light sees other depths: its faces are rendered again before being used
+			if (shadow.TileSize && (shadow.Position != position || shadow.Radius != light.Radius))
+				std::fill(shadow.RenderedFrames, shadow.RenderedFrames + GH_POINT_SHADOW_FACES, 0u);
+			shadow.Position = position;
+			shadow.Radius = light.Radius;
+
+			// fraction of the view height covered by the light sphere, the whole view when the camera is inside it
+			float distance = glm::length(position - cameraPosition);
+			shadow.ScreenSize = distance > light.Radius ? std::min(light.Radius / (distance * tanHalfFovY), 1.0f) : 1.0f;
+
+			AllocationOrder.push_back(l);
+		}
+
+		// the largest lights on screen get their tiles first: when the atlas is full, the smallest ones are left without shadows
+		std::sort(AllocationOrder.begin(), AllocationOrder.end(), [this](unsigned int a, unsigned int b)
+			{
+				if (LightShadows[a].ScreenSize != LightShadows[b].ScreenSize)
+					return LightShadows[a].ScreenSize > LightShadows[b].ScreenSize;
+				return a < b;
+			});
+
+		// all the faces are scaled down together until they fit the atlas, so that many lights share it instead of a few large ones taking it all
+		const unsigned long long atlasArea = (unsigned long long)Settings.Resolution * Settings.Resolution;
+		float sizeScale = 1.0f;
+		for (;;)
+		{
+			unsigned long long neededArea = 0;
+			for (unsigned int l : AllocationOrder)
+			{
+				unsigned int tileSize = GetNeededTileSize(LightShadows[l].ScreenSize * sizeScale);
+				neededArea += (unsigned long long)tileSize * tileSize * GH_POINT_SHADOW_FACES;
+			}
+
+			if (neededArea <= atlasArea || sizeScale * Settings.MaxTileSize <= Settings.MinTileSize)
+				break;
+			sizeScale *= 0.5f;
+		}
+
+		// tiles shrink only when the light needs much smaller ones, before any tile grows
+		for (unsigned int l : AllocationOrder)
+		{
+			LightShadow& shadow = LightShadows[l];
+			if (shadow.TileSize > Settings.MinTileSize && shadow.ScreenSize * sizeScale * Settings.MaxTileSize < shadow.TileSize * GH_SHADOW_ATLAS_SHRINK_RATIO)
+				ReleaseTiles(shadow);
+		}
+
+		// tiles grow only when the larger ones fit, otherwise the light keeps its tiles; new tiles are halved until they fit
+		unsigned int shadowedLights = 0;
+		for (unsigned int l : AllocationOrder)
+		{
+			LightShadow& shadow = LightShadows[l];
+			unsigned int tileSize = GetNeededTileSize(shadow.ScreenSize * sizeScale);
+			if (shadow.TileSize < tileSize)
+			{
+				for (; tileSize > shadow.TileSize; tileSize >>= 1)
+				{
+					if (AllocateTiles(shadow, tileSize))
+						break;
+					if (tileSize <= Settings.MinTileSize)
+						break;
+				}
+			}
+
+			if (!shadow.TileSize)
+			{
+				++Stats.SkippedLights;
+				continue;
+			}
+
+			shadow.ShadowIndex = (int)shadowedLights++;
+		}
+
+		// faces to render: the ones never rendered first, then the oldest ones, as long as the budget allows
+		FaceCandidates.clear();
+		for (unsigned int l : AllocationOrder)
+		{
+			const LightShadow& shadow = LightShadows[l];
+			if (!shadow.TileSize)
+				continue;
+
+			for (unsigned int f = 0; f < GH_POINT_SHADOW_FACES; ++f)
+			{
+				unsigned int renderedFrame = shadow.RenderedFrames[f];
+				bool refresh = renderedFrame == 0 || renderedFrame < StaticChangedFrame || (Settings.RefreshInterval > 0 && Frame - renderedFrame >= Settings.RefreshInterval);
+				if (refresh)
+					FaceCandidates.push_back(FaceCandidate{ renderedFrame, l, f });
+			}
+		}
+
+		std::sort(FaceCandidates.begin(), FaceCandidates.end(), [this](const FaceCandidate& a, const FaceCandidate& b)
+			{
+				if (a.RenderedFrame != b.RenderedFrame)
+					return a.RenderedFrame < b.RenderedFrame;
+				if (a.Light != b.Light)
+					return LightShadows[a.Light].ScreenSize != LightShadows[b.Light].ScreenSize ? LightShadows[a.Light].ScreenSize > LightShadows[b.Light].ScreenSize : a.Light < b.Light;
+				return a.Face < b.Face;
+			});
+
+		RenderedFaces.clear();
+		unsigned int renderedNumber = std::min((unsigned int)FaceCandidates.size(), Settings.UpdateBudget);
+		for (unsigned int c = 0; c < renderedNumber; ++c)
+		{
+			const FaceCandidate& candidate = FaceCandidates[c];
+			LightShadow& shadow = LightShadows[candidate.Light];
+			shadow.RenderedFrames[candidate.Face] = Frame;
+
+			ShadowAtlasFace face{};
+			face.ViewMatrix = GetFaceViewMatrix(shadow.Position, candidate.Face);
+			face.ProjectionMatrix = GetFaceProjectionMatrix(shadow.Radius);
+			face.ViewProjection = face.ProjectionMatrix * face.ViewMatrix;
+			face.LightPosition = shadow.Position;
+			face.TilePosition = shadow.TilePositions[candidate.Face];
+			face.TileSize = shadow.TileSize;
+			RenderedFaces.push_back(face);
+		}
+
+		// shadow buffer, in the order of the shadow indices
+		ShadowBuffer.ClearData();
+		for (unsigned int l : AllocationOrder)
+		{
+			const LightShadow& shadow = LightShadows[l];
+			if (shadow.ShadowIndex < 0)
+				continue;
+
+			PointShadowBufferData data{};
+			glm::mat4 projection = GetFaceProjectionMatrix(shadow.Radius);
+			for (unsigned int f = 0; f < GH_POINT_SHADOW_FACES; ++f)
+			{
+				data.FaceMatrices[f] = projection * GetFaceViewMatrix(shadow.Position, f);
+				if (shadow.RenderedFrames[f])
+					data.FaceRects[f] = glm::vec4(glm::vec2(shadow.TilePositions[f]), glm::vec2((float)shadow.TileSize)) / (float)Allocator.GetSize();
+			}
+			data.Near = GH_POINT_SHADOW_NEAR;
+			data.Far = GetFaceFar(shadow.Radius);
+			data.BiasTexels = GH_POINT_SHADOW_BIAS_TEXELS;
+			ShadowBuffer.AddData(data);
+		}
+
+		Stats.ShadowedLights = shadowedLights;
+		Stats.AllocatedFaces = Allocator.GetAllocationsNumber();
+		Stats.RenderedFaces = renderedNumber;
+		Stats.PendingFaces = (unsigned int)FaceCandidates.size() - renderedNumber;
+		Stats.UsedArea = Allocator.GetUsedArea();
+		Stats.Milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void ShadowAtlas::SetSettings(const ShadowAtlasSettings& settings)
+	{
+		for (LightShadow& shadow : LightShadows)
+			shadow = LightShadow{};
+
+		Allocator = QuadtreeAllocator{ std::max(settings.Resolution, 1u), std::max(settings.MinTileSize, 1u) };
+
+		// tile sides are the powers of two handed out by the allocator
+		Settings = settings;
+		Settings.Resolution = Allocator.GetSize();
+		Settings.MinTileSize = Allocator.GetMinTileSize();
+		Settings.MaxTileSize = std::min(Allocator.GetTileSize(std::max(Settings.MaxTileSize, Settings.MinTileSize)), Settings.Resolution);
+		Settings.UpdateBudget = std::max(Settings.UpdateBudget, 1u);
+	}
+
+	const ShadowAtlasSettings& ShadowAtlas::GetSettings() const
+	{
+		return Settings;
+	}
+
+	const std::vector<ShadowAtlasFace>& ShadowAtlas::GetRenderedFaces() const
+	{
+		return RenderedFaces;
+	}
+
+	int ShadowAtlas::GetLightShadowIndex(unsigned int light) const
+	{
+		return light < LightShadows.size() ? LightShadows[light].ShadowIndex : -1;
+	}
+
+	DynamicBuffer<PointShadowBufferData>& ShadowAtlas::GetShadowBuffer()
+	{
+		return ShadowBuffer;
+	}
+
+	const ShadowAtlasStats& ShadowAtlas::GetStats() const
+	{
+		return Stats;
+	}
+
+	void ShadowAtlas::ReleaseTiles(LightShadow& shadow)
+	{
+		if (shadow.TileSize)
+		{
+			for (unsigned int f = 0; f < GH_POINT_SHADOW_FACES; ++f)
+				Allocator.Free(shadow.TilePositions[f].x, shadow.TilePositions[f].y, shadow.TileSize);
+		}
+
+		shadow.TileSize = 0;
+		shadow.ShadowIndex = -1;
+	}
+
+	bool ShadowAtlas::AllocateTiles(LightShadow& shadow, unsigned int tileSize)
+	{
+		glm::uvec2 positions[GH_POINT_SHADOW_FACES];
+		for (unsigned int f = 0; f < GH_POINT_SHADOW_FACES; ++f)
+		{
+			if (Allocator.Allocate(tileSize, positions[f].x, positions[f].y))
+				continue;
+
+			// all the faces or none
+			for (unsigned int a = 0; a < f; ++a)
+				Allocator.Free(positions[a].x, positions[a].y, tileSize);
+			return false;
+		}
+
+		// the old tiles are released only once the new ones are taken, the faces are rendered again in the new tiles
+		ReleaseTiles(shadow);
+		std::copy(positions, positions + GH_POINT_SHADOW_FACES, shadow.TilePositions);
+		std::fill(shadow.RenderedFrames, shadow.RenderedFrames + GH_POINT_SHADOW_FACES, 0u);
+		shadow.TileSize = tileSize;
+		return true;
+	}
+
+	glm::mat4 ShadowAtlas::GetFaceViewMatrix(const glm::vec3& lightPosition, unsigned int face)
+	{
+		return glm::lookAt(lightPosition, lightPosition + FaceDirections[face], FaceUps[face]);
+	}
+
+	glm::mat4 ShadowAtlas::GetFaceProjectionMatrix(float lightRadius)
+	{
+		// faces are rendered only up to the radius: farther casters can't shadow anything lit by the light
+		return glm::perspective(glm::radians(90.0f), 1.0f, GH_POINT_SHADOW_NEAR, GetFaceFar(lightRadius));
+	}
+
+	unsigned int ShadowAtlas::GetNeededTileSize(float screenSize) const
+	{
+		unsigned int neededSize = (unsigned int)std::ceil(screenSize * Settings.MaxTileSize);
+		return Allocator.GetTileSize(std::min(std::max(neededSize, Settings.MinTileSize), Settings.MaxTileSize));
+	}
+
+	float ShadowAtlas::GetFaceFar(float lightRadius)
+	{
+		return std::max(lightRadius, GH_POINT_SHADOW_NEAR * 2.0f);
+	}
+}
@@ -0,0 +1,130 @@
+// Shadows of the point lights, packed as tiles of a single depth texture (the shadow atlas) instead of a render target for each light
+// Each shadowed light gets six tiles, the faces of a cube around it rendered with 90 degrees projections. Tiles are placed by a quadtree allocator, with a
+// side chosen from the screen size of the light sphere: near lights get detailed shadows, far ones small tiles, lights out of the view none
+// Faces keep their depth between frames: only a few of them are rendered each frame (new faces first, then the oldest ones, so that moving objects
+// are caught up after a while), and the shaders skip the faces never rendered yet
+
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <Utils/QuadtreeAllocator.h>
+#include "Entities/Buffer.hpp"
+#include "Entities/BufferData/ShadowAtlasBufferData.h"
+
+#define GH_DEFAULT_SHADOW_ATLAS_RESOLUTION 4096
+
+namespace GaladHen
+{
+	class Camera;
+	class PointLight;
+
+	struct ShadowAtlasSettings
+	{
+		ShadowAtlasSettings();
+
+		unsigned int Resolution; // pixels of the side of the atlas
+		unsigned int MinTileSize; // pixels of the side of the faces of lights far away
+		unsigned int MaxTileSize; // pixels of the side of the faces of lights covering the whole view
+		unsigned int UpdateBudget; // faces rendered at most in a frame
+		unsigned int RefreshInterval; // frames after which a face is rendered again, to update the shadows of moving objects (0 to render faces only when their light moves)
+	};
+
+	// A face of a point light shadow to render in the frame
+	struct ShadowAtlasFace
+	{
+		glm::mat4 ViewMatrix;
+		glm::mat4 ProjectionMatrix;
+		glm::mat4 ViewProjection;
+		glm::vec3 LightPosition;
+		glm::uvec2 TilePosition; // pixels of the tile corner inside the atlas
+		unsigned int TileSize;
+	};
+
+	struct ShadowAtlasStats
+	{
+		unsigned int ShadowedLights; // lights casting shadows, with tiles in the atlas
+		unsigned int SkippedLights; // lights casting shadows without tiles: out of the view, or no space left in the atlas
+		unsigned int AllocatedFaces;
+		unsigned int RenderedFaces; // faces rendered in the frame
+		unsigned int PendingFaces; // faces needing to be rendered, left to the next frames by the budget
+		float UsedArea; // fraction of the atlas covered by the tiles
+		float Milliseconds; // cpu time to place the tiles and choose the faces to render
+	};
+
+	class ShadowAtlas
+	{
+	public:
+
+		ShadowAtlas(const ShadowAtlasSettings& settings = ShadowAtlasSettings{});
+
+		ShadowAtlas(const ShadowAtlas& source) = delete;
+		ShadowAtlas& operator=(const ShadowAtlas& source) = delete;
+
+		// @brief
+		// Place the tiles of the point lights casting shadows, choose the faces to render in the frame and write the shadow buffer
+		// @param staticVersion: of the render list, all the faces are rendered again when the static objects change
+		void Update(const Camera& camera, const std::vector<PointLight>& pointLights, unsigned int staticVersion);
+
+		// @brief
+		// Change the settings: all the tiles are placed again
+		void SetSettings(const ShadowAtlasSettings& settings);
+
+		const ShadowAtlasSettings& GetSettings() const;
+
+		// @returns the faces to render in the frame, the faces of the shadow buffer are already marked as rendered
+		const std::vector<ShadowAtlasFace>& GetRenderedFaces() const;
+
+		// @returns the index of the shadow of a point light inside the shadow buffer, -1 if the light has no shadow
+		int GetLightShadowIndex(unsigned int light) const;
+
+		// @returns a PointShadowBufferData for each point light with tiles
+		DynamicBuffer<PointShadowBufferData>& GetShadowBuffer();
+
+		const ShadowAtlasStats& GetStats() const;
+
+	protected:
+
+		struct LightShadow
+		{
+			unsigned int TileSize; // 0 without tiles
+			glm::uvec2 TilePositions[GH_POINT_SHADOW_FACES];
+			unsigned int RenderedFrames[GH_POINT_SHADOW_FACES]; // frame of the last render of each face, 0 if it was never rendered
+			glm::vec3 Position; // of the light when its faces were rendered
+			float Radius;
+			float ScreenSize; // of the light sphere in the frame
+			int ShadowIndex;
+		};
+
+		struct FaceCandidate
+		{
+			unsigned int RenderedFrame;
+			unsigned int Light;
+			unsigned int Face;
+		};
+
+		void ReleaseTiles(LightShadow& shadow);
+		bool AllocateTiles(LightShadow& shadow, unsigned int tileSize); // all the faces or none, the old tiles are kept if the new ones don't fit
+
+		unsigned int GetNeededTileSize(float screenSize) const; // @param screenSize: of the light sphere, scaled to fit the atlas
+
+		static glm::mat4 GetFaceViewMatrix(const glm::vec3& lightPosition, unsigned int face);
+		static glm::mat4 GetFaceProjectionMatrix(float lightRadius);
+		static float GetFaceFar(float lightRadius);
+
+		ShadowAtlasSettings Settings;
+		QuadtreeAllocator Allocator;
+		std::vector<LightShadow> LightShadows; // indexed as the point lights of the scene
+		std::vector<unsigned int> AllocationOrder; // shadowed lights by decreasing screen size
+		std::vector<FaceCandidate> FaceCandidates;
+		std::vector<ShadowAtlasFace> RenderedFaces;
+		DynamicBuffer<PointShadowBufferData> ShadowBuffer;
+		ShadowAtlasStats Stats;
+		unsigned int Frame;
+		unsigned int StaticVersion;
+		unsigned int StaticChangedFrame; // faces rendered before this frame miss the last changes of the static objects
+
+	};
+}
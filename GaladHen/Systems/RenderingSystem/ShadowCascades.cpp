@@ -0,0 +1,129 @@
+#include "ShadowCascades.h"
+
+#include "Entities/Camera.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#define GH_SHADOW_CASCADE_RADIUS_STEP 16.0f // sphere radii are rounded up to 1 / step, so that float errors don't change the texel size
+#define GH_SHADOW_CASCADE_BIAS_TEXELS 1.5f // depth bias of each cascade, in texels of its shadow map
+#define GH_SHADOW_CASCADE_STEP_FRACTION 0.25f // cascades move by steps of this fraction of the sphere radius, and are larger by half a step
+
+namespace GaladHen
+{
+	ShadowCascadeSettings::ShadowCascadeSettings()
+		: CascadeNumber(GH_DEFAULT_SHADOW_CASCADES)
+		, Resolution(GH_DEFAULT_SHADOW_RESOLUTION)
+		, MaxDistance(100.0f)
+		, SplitLambda(0.75f)
+		, CasterDistance(50.0f)
+	{}
+
+	ShadowCascades::ShadowCascades(const ShadowCascadeSettings& settings)
+		: Cascades()
+		, BufferData()
+		, LightDirection(0.0f)
+	{
+		SetSettings(settings);
+	}
+
+	void ShadowCascades::Update(const Camera& camera, const glm::vec3& lightDirection)
+	{
+		const float nearDistance = camera.GetNear();
+		const float farDistance = std::max(std::min(camera.GetFar(), Settings.MaxDistance), nearDistance);
+
+		// a point at view depth d of the view border is d * k far from the view axis
+		const float tanHalfFovY = std::tan(glm::radians(camera.GetFovY()) * 0.5f);
+		const float tanHalfFovX = tanHalfFovY * camera.GetAspectRatio();
+		const float kSquared = tanHalfFovX * tanHalfFovX + tanHalfFovY * tanHalfFovY;
+
+		const glm::mat4 inverseView = glm::inverse(camera.GetViewMatrix());
+		const glm::vec3 cameraPosition = glm::vec3(inverseView[3]);
+		const glm::vec3 cameraForward = -glm::normalize(glm::vec3(inverseView[2]));
+
+		const glm::vec3 direction = glm::normalize(lightDirection);
+		const glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+		// light space doesn't depend on the camera: cascades are placed on its grid of steps
+		const glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), direction, up);
+		const bool sameLight = direction == LightDirection;
+		LightDirection = direction;
+
+		BufferData = ShadowCascadeBufferData{};
+		BufferData.CascadeNumber = (int)Settings.CascadeNumber;
+
+		float splitNear = nearDistance;
+		for (unsigned int c = 0; c < Settings.CascadeNumber; ++c)
+		{
+			// practical split scheme: a blend of logarithmic splits (same texel density on screen) and uniform ones (not too short near the camera)
+			float fraction = (float)(c + 1) / Settings.CascadeNumber;
+			float logarithmicSplit = nearDistance * std::pow(farDistance / nearDistance, fraction);
+			float uniformSplit = nearDistance + (farDistance - nearDistance) * fraction;
+			float splitFar = Settings.SplitLambda * logarithmicSplit + (1.0f - Settings.SplitLambda) * uniformSplit;
+
+			// smallest sphere around the slice: centered on the view axis, equally distant from the corners of its near and far planes
+			float centerDepth = std::min((splitFar + splitNear) * (1.0f + kSquared) * 0.5f, splitFar);
+			float nearCornerDistance = std::sqrt((centerDepth - splitNear) * (centerDepth - splitNear) + splitNear * splitNear * kSquared);
+			float farCornerDistance = std::sqrt((splitFar - centerDepth) * (splitFar - centerDepth) + splitFar * splitFar * kSquared);
+			float radius = std::ceil(std::max(nearCornerDistance, farCornerDistance) * GH_SHADOW_CASCADE_RADIUS_STEP) / GH_SHADOW_CASCADE_RADIUS_STEP;
+
+			glm::vec3 center = cameraPosition + cameraForward * centerDepth;
+			glm::vec3 lightCenter = glm::vec3(lightRotation * glm::vec4(center, 1.0f));
+
+			float extent = radius * (1.0f + GH_SHADOW_CASCADE_STEP_FRACTION * 0.5f);
+			float texelSize = 2.0f * extent / Settings.Resolution;
+			float step = std::max(std::floor(radius * GH_SHADOW_CASCADE_STEP_FRACTION / texelSize), 1.0f) * texelSize;
+
+			// the cascade stays in place while the sphere is inside it, otherwise it moves to the nearest step
+			ShadowCascade& cascade = Cascades[c];
+			glm::vec3 distance = glm::abs(lightCenter - glm::vec3(cascade.PlacementCell) * step);
+			bool inside = distance.x <= extent - radius && distance.y <= extent - radius && distance.z <= extent - radius;
+			if (!sameLight || cascade.PlacementStep != step || !inside)
+				cascade.PlacementCell = glm::ivec3(glm::round(lightCenter / step));
+			cascade.PlacementStep = step;
+
+			// looking along the light from the placement, backed up to include the casters
+			glm::vec3 placement = glm::vec3(cascade.PlacementCell) * step;
+			cascade.ViewMatrix = glm::translate(glm::mat4(1.0f), -(placement + glm::vec3(0.0f, 0.0f, extent + Settings.CasterDistance))) * lightRotation;
+			cascade.ProjectionMatrix = glm::ortho(-extent, extent, -extent, extent, 0.0f, 2.0f * extent + Settings.CasterDistance);
+
+			cascade.ViewProjection = cascade.ProjectionMatrix * cascade.ViewMatrix;
+			cascade.SplitNear = splitNear;
+			cascade.SplitFar = splitFar;
+			cascade.TexelSize = texelSize;
+
+			// bias in the [0,1] depth of the cascade, covering the same world distance relative to the texel size in all the cascades
+			BufferData.CascadeMatrices[c] = cascade.ViewProjection;
+			BufferData.CascadeSplits[c] = splitFar;
+			BufferData.CascadeBiases[c] = GH_SHADOW_CASCADE_BIAS_TEXELS * cascade.TexelSize / (2.0f * extent + Settings.CasterDistance);
+
+			splitNear = splitFar;
+		}
+	}
+
+	void ShadowCascades::SetSettings(const ShadowCascadeSettings& settings)
+	{
+		Settings = settings;
+		Settings.CascadeNumber = std::min(std::max(Settings.CascadeNumber, 1u), (unsigned int)GH_MAX_SHADOW_CASCADES);
+		Settings.Resolution = std::max(Settings.Resolution, 1u);
+		Settings.SplitLambda = std::min(std::max(Settings.SplitLambda, 0.0f), 1.0f);
+		Settings.CasterDistance = std::max(Settings.CasterDistance, 0.0f);
+	}
+
+	const ShadowCascadeSettings& ShadowCascades::GetSettings() const
+	{
+		return Settings;
+	}
+
+	const ShadowCascade& ShadowCascades::GetCascade(unsigned int cascade) const
+	{
+		return Cascades[cascade];
+	}
+
+	const ShadowCascadeBufferData& ShadowCascades::GetBufferData() const
+	{
+		return BufferData;
+	}
+}
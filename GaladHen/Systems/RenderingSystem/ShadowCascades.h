@@ -0,0 +1,72 @@
+// Cascaded shadow maps of a directional light: the view of the camera is sliced by depth, and each slice gets its own orthographic shadow map, so that the
+// shadow resolution near the camera is not wasted on far away objects
+// Each cascade covers a square larger than the bounding sphere of its slice, which doesn't change size while the camera rotates, and stays in place
+// until the sphere leaves it: then it moves by a step of whole texels, so shadow edges don't shimmer and static depth can be kept while the camera moves
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "Entities/BufferData/ShadowCascadeBufferData.h"
+
+#define GH_DEFAULT_SHADOW_CASCADES 3
+#define GH_DEFAULT_SHADOW_RESOLUTION 2048
+
+namespace GaladHen
+{
+	class Camera;
+
+	struct ShadowCascadeSettings
+	{
+		ShadowCascadeSettings();
+
+		unsigned int CascadeNumber; // up to GH_MAX_SHADOW_CASCADES
+		unsigned int Resolution; // pixels of the side of each cascade
+		float MaxDistance; // distance from the camera after which there are no shadows, limited by the camera far plane
+		float SplitLambda; // 0 = slices of the same length, 1 = slices growing with the distance as the perspective shrinks the objects
+		float CasterDistance; // distance from the slices at which objects still cast shadows on them
+	};
+
+	struct ShadowCascade
+	{
+		glm::mat4 ViewMatrix;
+		glm::mat4 ProjectionMatrix; // orthographic, snapped to the texels
+		glm::mat4 ViewProjection;
+		float SplitNear; // view depth of the slice
+		float SplitFar;
+		float TexelSize; // world size of a texel
+		glm::ivec3 PlacementCell; // light space position of the cascade, in steps
+		float PlacementStep; // world size of a step, whole texels
+	};
+
+	class ShadowCascades
+	{
+	public:
+
+		ShadowCascades(const ShadowCascadeSettings& settings = ShadowCascadeSettings{});
+
+		// @brief
+		// Fit the cascades to the slices of the camera view
+		// @param lightDirection: direction the light travels along, in world space
+		void Update(const Camera& camera, const glm::vec3& lightDirection);
+
+		// @brief
+		// Change the settings: the number of cascades and the resolution are clamped to the supported range
+		void SetSettings(const ShadowCascadeSettings& settings);
+
+		const ShadowCascadeSettings& GetSettings() const;
+
+		const ShadowCascade& GetCascade(unsigned int cascade) const;
+
+		// @returns the matrices and splits of the cascades updated last, in the layout of the shaders
+		const ShadowCascadeBufferData& GetBufferData() const;
+
+	protected:
+
+		ShadowCascadeSettings Settings;
+		ShadowCascade Cascades[GH_MAX_SHADOW_CASCADES];
+		ShadowCascadeBufferData BufferData;
+		glm::vec3 LightDirection; // of the last update, the placements of the cascades are kept only for the same one
+
+	};
+}
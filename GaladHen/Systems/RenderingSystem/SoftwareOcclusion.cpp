@@ -0,0 +1,506 @@
+#include "SoftwareOcclusion.h"
+
+#include "RenderList.h"
+#include "Entities/Camera.h"
+#include "Entities/Model.h"
+#include <Math/AABB/AABB.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define GH_OCCLUSION_SSE
+#include <xmmintrin.h>
+#endif
+
+#define GH_OCCLUSION_FAR_DEPTH 1.0f // normalized device depth of the far plane, value of the pixels without occluders
+
+namespace GaladHen
+{
+	SoftwareOcclusionSettings::SoftwareOcclusionSettings()
+		: Width(GH_OCCLUSION_DEFAULT_WIDTH)
+		, Height(GH_OCCLUSION_DEFAULT_HEIGHT)
+		, NumberOfThreads(0)
+	{}
+
+	SoftwareOcclusion::SoftwareOcclusion(const SoftwareOcclusionSettings& settings)
+		: Settings(settings)
+		, Stats()
+		, CurrentRenderList(nullptr)
+		, ViewProjection(1.0f)
+		, WorkGeneration(0)
+		, RunningWorkers(0)
+		, CurrentPhase(WorkPhase::Bin)
+		, Quitting(false)
+		, NextWorkItem(0)
+	{
+		TilesX = std::max((Settings.Width + GH_OCCLUSION_TILE_SIZE - 1) / GH_OCCLUSION_TILE_SIZE, 1u);
+		TilesY = std::max((Settings.Height + GH_OCCLUSION_TILE_SIZE - 1) / GH_OCCLUSION_TILE_SIZE, 1u);
+		Settings.Width = TilesX * GH_OCCLUSION_TILE_SIZE;
+		Settings.Height = TilesY * GH_OCCLUSION_TILE_SIZE;
+
+		// Levels halve the resolution down to a single texel
+		unsigned int width = Settings.Width;
+		unsigned int height = Settings.Height;
+		while (true)
+		{
+			Levels.push_back(DepthLevel{ width, height, std::vector<float>(width * height, GH_OCCLUSION_FAR_DEPTH), std::vector<float>(width * height, GH_OCCLUSION_FAR_DEPTH) });
+
+			if (width == 1 && height == 1)
+				break;
+
+			width = (width + 1) / 2;
+			height = (height + 1) / 2;
+		}
+	}
+
+	void SoftwareOcclusion::RenderOccluders(const RenderList& renderList, const Camera& camera)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		if (Bins.empty())
+			StartWorkers();
+
+		CurrentRenderList = &renderList;
+		ViewProjection = camera.GetProjectionMatrix() * camera.GetViewMatrix();
+
+		RunPhase(WorkPhase::Bin);
+		RunPhase(WorkPhase::Rasterize);
+		BuildHierarchy();
+
+		Stats.Occluders = (unsigned int)renderList.GetOccluders().size();
+		Stats.OccluderTriangles = 0;
+		for (const ThreadBins& bins : Bins)
+			Stats.OccluderTriangles += (unsigned int)bins.Triangles.size();
+
+		CurrentRenderList = nullptr;
+		Stats.RasterizationMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	bool SoftwareOcclusion::IsOccluded(const AABB& bounds) const
+	{
+		glm::vec2 minScreen = glm::vec2(std::numeric_limits<float>::max());
+		glm::vec2 maxScreen = glm::vec2(std::numeric_limits<float>::lowest());
+		float nearestDepth = GH_OCCLUSION_FAR_DEPTH;
+
+		for (unsigned int c = 0; c < 8; ++c)
+		{
+			glm::vec3 corner = glm::vec3(c & 1 ? bounds.MaxBound.x : bounds.MinBound.x, c & 2 ? bounds.MaxBound.y : bounds.MinBound.y, c & 4 ? bounds.MaxBound.z : bounds.MinBound.z);
+			glm::vec4 clip = ViewProjection * glm::vec4(corner, 1.0f);
+
+			// boxes crossing the near plane cover the camera: their projection is unbounded
+			if (clip.z < -clip.w || clip.w <= 0.0f)
+				return false;
+
+			glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			minScreen = glm::min(minScreen, glm::vec2(ndc));
+			maxScreen = glm::max(maxScreen, glm::vec2(ndc));
+			nearestDepth = std::min(nearestDepth, ndc.z);
+		}
+
+		// pixels whose centers can be covered by the box, clamped to the screen
+		glm::vec2 size = glm::vec2((float)Settings.Width, (float)Settings.Height);
+		minScreen = (minScreen * 0.5f + 0.5f) * size;
+		maxScreen = (maxScreen * 0.5f + 0.5f) * size;
+		if (maxScreen.x < 0.0f || maxScreen.y < 0.0f || minScreen.x >= size.x || minScreen.y >= size.y)
+			return false;
+
+		int minX = std::max((int)std::floor(minScreen.x), 0);
+		int minY = std::max((int)std::floor(minScreen.y), 0);
+		int maxX = std::min((int)std::floor(maxScreen.x), (int)Settings.Width - 1);
+		int maxY = std::min((int)std::floor(maxScreen.y), (int)Settings.Height - 1);
+
+		// coarsest level covering the box with 2x2 texels at most, refined only where it can't decide
+		unsigned int level = 0;
+		while (level + 1 < Levels.size() && ((maxX >> level) - (minX >> level) > 1 || (maxY >> level) - (minY >> level) > 1))
+			++level;
+
+		return IsRegionOccluded(level, minX, minY, maxX, maxY, nearestDepth);
+	}
+
+	const std::vector<float>& SoftwareOcclusion::GetDepthLevel(unsigned int level, bool farthest, glm::uvec2& outSize) const
+	{
+		const DepthLevel& depthLevel = Levels[std::min(level, (unsigned int)Levels.size() - 1)];
+		outSize = glm::uvec2(depthLevel.Width, depthLevel.Height);
+
+		return farthest ? depthLevel.FarDepth : depthLevel.NearDepth;
+	}
+
+	unsigned int SoftwareOcclusion::GetLevelsNumber() const
+	{
+		return (unsigned int)Levels.size();
+	}
+
+	const SoftwareOcclusionStats& SoftwareOcclusion::GetStats() const
+	{
+		return Stats;
+	}
+
+	SoftwareOcclusion::~SoftwareOcclusion()
+	{
+		StopWorkers();
+	}
+
+	void SoftwareOcclusion::StartWorkers()
+	{
+		unsigned int numberOfThreads = Settings.NumberOfThreads > 0 ? Settings.NumberOfThreads : std::thread::hardware_concurrency();
+		numberOfThreads = std::max(numberOfThreads, 1u);
+
+		Bins.resize(numberOfThreads);
+		for (ThreadBins& bins : Bins)
+			bins.TileTriangles.resize(TilesX * TilesY);
+
+		// the calling thread is the first one
+		for (unsigned int i = 1; i < numberOfThreads; ++i)
+			Workers.emplace_back(&SoftwareOcclusion::WorkerLoop, this, i);
+	}
+
+	void SoftwareOcclusion::StopWorkers()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ WorkMutex };
+			Quitting = true;
+		}
+		WorkStarted.notify_all();
+
+		for (std::thread& worker : Workers)
+			worker.join();
+
+		Workers.clear();
+	}
+
+	void SoftwareOcclusion::WorkerLoop(unsigned int threadIndex)
+	{
+		unsigned int doneGeneration = 0;
+
+		while (true)
+		{
+			WorkPhase phase;
+			{
+				std::unique_lock<std::mutex> lock{ WorkMutex };
+				WorkStarted.wait(lock, [this, doneGeneration]() { return Quitting || WorkGeneration != doneGeneration; });
+
+				if (Quitting)
+					return;
+
+				doneGeneration = WorkGeneration;
+				phase = CurrentPhase;
+			}
+
+			DoPhaseWork(phase, threadIndex);
+
+			std::lock_guard<std::mutex> lock{ WorkMutex };
+			if (--RunningWorkers == 0)
+				WorkFinished.notify_one();
+		}
+	}
+
+	void SoftwareOcclusion::RunPhase(WorkPhase phase)
+	{
+		{
+			std::lock_guard<std::mutex> lock{ WorkMutex };
+			CurrentPhase = phase;
+			NextWorkItem = 0;
+			RunningWorkers = (unsigned int)Workers.size();
+			++WorkGeneration;
+		}
+		WorkStarted.notify_all();
+
+		DoPhaseWork(phase, 0);
+
+		// the next phase reads what all the threads wrote in this one
+		std::unique_lock<std::mutex> lock{ WorkMutex };
+		WorkFinished.wait(lock, [this]() { return RunningWorkers == 0; });
+	}
+
+	void SoftwareOcclusion::DoPhaseWork(WorkPhase phase, unsigned int threadIndex)
+	{
+		switch (phase)
+		{
+		case WorkPhase::Bin:
+		{
+			// bins keep their capacity between the frames
+			ThreadBins& bins = Bins[threadIndex];
+			bins.Triangles.clear();
+			for (std::vector<unsigned int>& tileTriangles : bins.TileTriangles)
+				tileTriangles.clear();
+
+			const unsigned int occludersNumber = (unsigned int)CurrentRenderList->GetOccluders().size();
+			for (unsigned int o = NextWorkItem++; o < occludersNumber; o = NextWorkItem++)
+				BinOccluder(o, bins);
+
+			break;
+		}
+		case WorkPhase::Rasterize:
+		{
+			const unsigned int tilesNumber = TilesX * TilesY;
+			for (unsigned int t = NextWorkItem++; t < tilesNumber; t = NextWorkItem++)
+				RasterizeTile(t);
+
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	void SoftwareOcclusion::BinOccluder(unsigned int occluderIndex, ThreadBins& bins)
+	{
+		const OccluderRecord& occluder = CurrentRenderList->GetOccluders()[occluderIndex];
+		const glm::mat4 modelViewProjection = ViewProjection * CurrentRenderList->GetInstanceModelMatrix(occluder.InstanceSlot);
+
+		for (const Mesh& mesh : occluder.OccluderModel->Meshes)
+		{
+			if (mesh.GetPrimitive() != MeshPrimitive::Triangle)
+				continue;
+
+			const std::vector<MeshVertexData>& vertices = mesh.GetVertices();
+			const std::vector<unsigned int>& indices = mesh.GetIndices();
+
+			bins.ClipVertices.resize(vertices.size());
+			for (unsigned int v = 0; v < vertices.size(); ++v)
+				bins.ClipVertices[v] = modelViewProjection * glm::vec4(vertices[v].Position, 1.0f);
+
+			for (unsigned int i = 0; i + 2 < indices.size(); i += 3)
+				BinTriangle(bins.ClipVertices[indices[i]], bins.ClipVertices[indices[i + 1]], bins.ClipVertices[indices[i + 2]], bins);
+		}
+	}
+
+	void SoftwareOcclusion::BinTriangle(const glm::vec4& clip0, const glm::vec4& clip1, const glm::vec4& clip2, ThreadBins& bins)
+	{
+		// signed distances from the near plane (z = -w in clip space)
+		const glm::vec4 vertices[3] = { clip0, clip1, clip2 };
+		const float distances[3] = { clip0.z + clip0.w, clip1.z + clip1.w, clip2.z + clip2.w };
+
+		if (distances[0] >= 0.0f && distances[1] >= 0.0f && distances[2] >= 0.0f)
+		{
+			SetupTriangle(clip0, clip1, clip2, bins);
+			return;
+		}
+
+		// the part in front of the near plane is a triangle or a quad
+		glm::vec4 clipped[4];
+		unsigned int clippedNumber = 0;
+		for (unsigned int v = 0; v < 3; ++v)
+		{
+			unsigned int next = (v + 1) % 3;
+
+			if (distances[v] >= 0.0f)
+				clipped[clippedNumber++] = vertices[v];
+
+			if ((distances[v] >= 0.0f) != (distances[next] >= 0.0f))
+				clipped[clippedNumber++] = vertices[v] + (vertices[next] - vertices[v]) * (distances[v] / (distances[v] - distances[next]));
+		}
+
+		if (clippedNumber >= 3)
+			SetupTriangle(clipped[0], clipped[1], clipped[2], bins);
+		if (clippedNumber == 4)
+			SetupTriangle(clipped[0], clipped[2], clipped[3], bins);
+	}
+
+	void SoftwareOcclusion::SetupTriangle(const glm::vec4& clip0, const glm::vec4& clip1, const glm::vec4& clip2, ThreadBins& bins)
+	{
+		const glm::vec2 size = glm::vec2((float)Settings.Width, (float)Settings.Height);
+		const glm::vec4* clips[3] = { &clip0, &clip1, &clip2 };
+
+		glm::vec3 screen[3];
+		for (unsigned int v = 0; v < 3; ++v)
+		{
+			glm::vec3 ndc = glm::vec3(*clips[v]) / clips[v]->w;
+			screen[v] = glm::vec3((glm::vec2(ndc) * 0.5f + 0.5f) * size, ndc.z);
+		}
+
+		// counter clockwise triangles are front facing: back faces are hidden by the front faces of closed occluders
+		glm::vec2 edge1 = glm::vec2(screen[1] - screen[0]);
+		glm::vec2 edge2 = glm::vec2(screen[2] - screen[0]);
+		float area = edge1.x * edge2.y - edge2.x * edge1.y;
+		if (!(area > 0.0f))
+			return;
+
+		// pixels whose centers are inside the bounds of the triangle
+		glm::vec2 minBound = glm::min(glm::min(glm::vec2(screen[0]), glm::vec2(screen[1])), glm::vec2(screen[2]));
+		glm::vec2 maxBound = glm::max(glm::max(glm::vec2(screen[0]), glm::vec2(screen[1])), glm::vec2(screen[2]));
+
+		ScreenTriangle triangle;
+		triangle.MinX = std::max((int)std::ceil(minBound.x - 0.5f), 0);
+		triangle.MinY = std::max((int)std::ceil(minBound.y - 0.5f), 0);
+		triangle.MaxX = std::min((int)std::floor(maxBound.x - 0.5f), (int)Settings.Width - 1);
+		triangle.MaxY = std::min((int)std::floor(maxBound.y - 0.5f), (int)Settings.Height - 1);
+		if (triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY)
+			return;
+
+		// edge functions, positive on the left of the edges of a counter clockwise triangle
+		for (unsigned int e = 0; e < 3; ++e)
+		{
+			const glm::vec3& a = screen[e];
+			const glm::vec3& b = screen[(e + 1) % 3];
+			triangle.EdgeA[e] = a.y - b.y;
+			triangle.EdgeB[e] = b.x - a.x;
+			triangle.EdgeC[e] = a.x * b.y - a.y * b.x;
+		}
+
+		// depth is linear in screen space
+		float depth1 = screen[1].z - screen[0].z;
+		float depth2 = screen[2].z - screen[0].z;
+		triangle.DepthA = (depth1 * edge2.y - depth2 * edge1.y) / area;
+		triangle.DepthB = (depth2 * edge1.x - depth1 * edge2.x) / area;
+		triangle.DepthC = screen[0].z - triangle.DepthA * screen[0].x - triangle.DepthB * screen[0].y;
+
+		unsigned int triangleIndex = (unsigned int)bins.Triangles.size();
+		bins.Triangles.push_back(triangle);
+
+		for (int ty = triangle.MinY / GH_OCCLUSION_TILE_SIZE; ty <= triangle.MaxY / GH_OCCLUSION_TILE_SIZE; ++ty)
+		{
+			for (int tx = triangle.MinX / GH_OCCLUSION_TILE_SIZE; tx <= triangle.MaxX / GH_OCCLUSION_TILE_SIZE; ++tx)
+				bins.TileTriangles[ty * TilesX + tx].push_back(triangleIndex);
+		}
+	}
+
+	void SoftwareOcclusion::RasterizeTile(unsigned int tileIndex)
+	{
+		const int tileMinX = (int)(tileIndex % TilesX) * GH_OCCLUSION_TILE_SIZE;
+		const int tileMinY = (int)(tileIndex / TilesX) * GH_OCCLUSION_TILE_SIZE;
+		const int tileMaxX = tileMinX + GH_OCCLUSION_TILE_SIZE - 1;
+		const int tileMaxY = tileMinY + GH_OCCLUSION_TILE_SIZE - 1;
+
+		std::vector<float>& depth = Levels[0].FarDepth;
+		for (int y = tileMinY; y <= tileMaxY; ++y)
+			std::fill(depth.begin() + y * Settings.Width + tileMinX, depth.begin() + y * Settings.Width + tileMaxX + 1, GH_OCCLUSION_FAR_DEPTH);
+
+		// the tile is written by this thread only
+		for (const ThreadBins& bins : Bins)
+		{
+			for (unsigned int triangleIndex : bins.TileTriangles[tileIndex])
+				RasterizeTriangle(bins.Triangles[triangleIndex], tileMinX, tileMinY, tileMaxX, tileMaxY);
+		}
+	}
+
+	void SoftwareOcclusion::RasterizeTriangle(const ScreenTriangle& triangle, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY)
+	{
+		// pixels are processed four at a time from a multiple of four: the tile is made of whole groups, and pixels out of the triangle bounds fail the edge tests
+		const int minX = std::max(triangle.MinX, tileMinX) & ~3;
+		const int maxX = std::min(triangle.MaxX, tileMaxX);
+		const int minY = std::max(triangle.MinY, tileMinY);
+		const int maxY = std::min(triangle.MaxY, tileMaxY);
+
+		float* depth = Levels[0].FarDepth.data();
+
+#ifdef GH_OCCLUSION_SSE
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f); // pixel centers
+		const __m128 edgeA0 = _mm_set1_ps(triangle.EdgeA[0]);
+		const __m128 edgeA1 = _mm_set1_ps(triangle.EdgeA[1]);
+		const __m128 edgeA2 = _mm_set1_ps(triangle.EdgeA[2]);
+		const __m128 depthA = _mm_set1_ps(triangle.DepthA);
+
+		for (int y = minY; y <= maxY; ++y)
+		{
+			const float centerY = (float)y + 0.5f;
+			const __m128 rowEdge0 = _mm_set1_ps(triangle.EdgeB[0] * centerY + triangle.EdgeC[0]);
+			const __m128 rowEdge1 = _mm_set1_ps(triangle.EdgeB[1] * centerY + triangle.EdgeC[1]);
+			const __m128 rowEdge2 = _mm_set1_ps(triangle.EdgeB[2] * centerY + triangle.EdgeC[2]);
+			const __m128 rowDepth = _mm_set1_ps(triangle.DepthB * centerY + triangle.DepthC);
+			float* row = depth + y * Settings.Width;
+
+			for (int x = minX; x <= maxX; x += 4)
+			{
+				__m128 centerX = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+
+				__m128 covered = _mm_and_ps(_mm_and_ps(
+					_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA0, centerX), rowEdge0), zero),
+					_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA1, centerX), rowEdge1), zero)),
+					_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA2, centerX), rowEdge2), zero));
+				if (!_mm_movemask_ps(covered))
+					continue;
+
+				__m128 previous = _mm_loadu_ps(row + x);
+				__m128 nearest = _mm_min_ps(previous, _mm_add_ps(_mm_mul_ps(depthA, centerX), rowDepth));
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(covered, nearest), _mm_andnot_ps(covered, previous)));
+			}
+		}
+#else
+		for (int y = minY; y <= maxY; ++y)
+		{
+			const float centerY = (float)y + 0.5f;
+			float* row = depth + y * Settings.Width;
+
+			for (int x = minX; x <= maxX; ++x)
+			{
+				const float centerX = (float)x + 0.5f;
+
+				bool covered = true;
+				for (unsigned int e = 0; e < 3; ++e)
+					covered &= triangle.EdgeA[e] * centerX + triangle.EdgeB[e] * centerY + triangle.EdgeC[e] >= 0.0f;
+
+				if (covered)
+					row[x] = std::min(row[x], triangle.DepthA * centerX + triangle.DepthB * centerY + triangle.DepthC);
+			}
+		}
+#endif
+	}
+
+	void SoftwareOcclusion::BuildHierarchy()
+	{
+		// the full resolution level has a single depth for each pixel
+		Levels[0].NearDepth = Levels[0].FarDepth;
+
+		for (unsigned int l = 1; l < Levels.size(); ++l)
+		{
+			const DepthLevel& source = Levels[l - 1];
+			DepthLevel& level = Levels[l];
+
+			for (unsigned int y = 0; y < level.Height; ++y)
+			{
+				const unsigned int sourceY0 = y * 2;
+				const unsigned int sourceY1 = std::min(y * 2 + 1, source.Height - 1);
+
+				for (unsigned int x = 0; x < level.Width; ++x)
+				{
+					const unsigned int sourceX0 = x * 2;
+					const unsigned int sourceX1 = std::min(x * 2 + 1, source.Width - 1);
+
+					const unsigned int s00 = sourceY0 * source.Width + sourceX0;
+					const unsigned int s01 = sourceY0 * source.Width + sourceX1;
+					const unsigned int s10 = sourceY1 * source.Width + sourceX0;
+					const unsigned int s11 = sourceY1 * source.Width + sourceX1;
+
+					level.FarDepth[y * level.Width + x] = std::max(std::max(source.FarDepth[s00], source.FarDepth[s01]), std::max(source.FarDepth[s10], source.FarDepth[s11]));
+					level.NearDepth[y * level.Width + x] = std::min(std::min(source.NearDepth[s00], source.NearDepth[s01]), std::min(source.NearDepth[s10], source.NearDepth[s11]));
+				}
+			}
+		}
+	}
+
+	bool SoftwareOcclusion::IsRegionOccluded(unsigned int level, int minX, int minY, int maxX, int maxY, float nearestDepth) const
+	{
+		const DepthLevel& depthLevel = Levels[level];
+
+		for (int y = minY >> level; y <= maxY >> level; ++y)
+		{
+			for (int x = minX >> level; x <= maxX >> level; ++x)
+			{
+				const unsigned int texel = y * depthLevel.Width + x;
+
+				// behind all the occluders of the texel
+				if (nearestDepth > depthLevel.FarDepth[texel])
+					continue;
+
+				// in front of all the occluders of the texel, or at full resolution: visible
+				if (level == 0 || nearestDepth <= depthLevel.NearDepth[texel])
+					return false;
+
+				// partially behind: the finer texels decide, inside the region only
+				int texelMinX = std::max(minX, x << level);
+				int texelMinY = std::max(minY, y << level);
+				int texelMaxX = std::min(maxX, ((x + 1) << level) - 1);
+				int texelMaxY = std::min(maxY, ((y + 1) << level) - 1);
+				if (!IsRegionOccluded(level - 1, texelMinX, texelMinY, texelMaxX, texelMaxY, nearestDepth))
+					return false;
+			}
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,146 @@
+// Occlusion culling on cpu: the occluders of the scene are rasterized in a low resolution depth buffer, and the bounds of the other objects are tested
+// against a hierarchy of its minimum and maximum depths before their draws are built
+// The screen is divided in tiles: occluder triangles are transformed and binned to the tiles they cover, then each tile is rasterized by a single thread
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include <glm/glm.hpp>
+
+#define GH_OCCLUSION_TILE_SIZE 32 // pixels of the side of a tile, multiple of 4 (pixels are rasterized four at a time)
+#define GH_OCCLUSION_DEFAULT_WIDTH 256
+#define GH_OCCLUSION_DEFAULT_HEIGHT 128
+
+namespace GaladHen
+{
+	class RenderList;
+	class Camera;
+	struct AABB;
+
+	struct SoftwareOcclusionSettings
+	{
+		SoftwareOcclusionSettings();
+
+		unsigned int Width; // rounded up to a multiple of the tile size
+		unsigned int Height; // rounded up to a multiple of the tile size
+		unsigned int NumberOfThreads; // 0 = use all the available hardware threads
+	};
+
+	struct SoftwareOcclusionStats
+	{
+		unsigned int Occluders;
+		unsigned int OccluderTriangles; // triangles rasterized, after back face and near plane rejection
+		float RasterizationMilliseconds; // cpu time to rasterize the occluders and build the depth hierarchy
+	};
+
+	class SoftwareOcclusion
+	{
+	public:
+
+		SoftwareOcclusion(const SoftwareOcclusionSettings& settings = SoftwareOcclusionSettings{});
+
+		SoftwareOcclusion(const SoftwareOcclusion& source) = delete;
+		SoftwareOcclusion& operator=(const SoftwareOcclusion& source) = delete;
+
+		// @brief
+		// Rasterize the occluders of a render list seen from a camera, and build the depth hierarchy used by IsOccluded()
+		// Worker threads are started by the first call
+		void RenderOccluders(const RenderList& renderList, const Camera& camera);
+
+		// @brief
+		// Check if a world space box is entirely hidden by the occluders rendered last
+		// The test is conservative: boxes crossing the near plane or outside the screen are never occluded
+		bool IsOccluded(const AABB& bounds) const;
+
+		// @returns the normalized device depth (1 = far plane) of a level of the hierarchy, 0 being the full resolution depth buffer
+		// @param farthest: farthest occluder depth of the pixels covered by each texel if true, nearest otherwise
+		const std::vector<float>& GetDepthLevel(unsigned int level, bool farthest, glm::uvec2& outSize) const;
+
+		unsigned int GetLevelsNumber() const;
+
+		const SoftwareOcclusionStats& GetStats() const;
+
+		~SoftwareOcclusion();
+
+	protected:
+
+		// Triangle in screen space, set up for the edge functions: a pixel is covered when the three edges are not negative at its center
+		struct ScreenTriangle
+		{
+			float EdgeA[3];
+			float EdgeB[3];
+			float EdgeC[3];
+			float DepthA; // depth = DepthA * x + DepthB * y + DepthC
+			float DepthB;
+			float DepthC;
+			int MinX;
+			int MinY;
+			int MaxX; // inclusive
+			int MaxY;
+		};
+
+		// Data written by a single thread while binning, read by all the threads while rasterizing
+		struct ThreadBins
+		{
+			std::vector<glm::vec4> ClipVertices;
+			std::vector<ScreenTriangle> Triangles;
+			std::vector<std::vector<unsigned int>> TileTriangles; // indices of the triangles covering each tile
+		};
+
+		struct DepthLevel
+		{
+			unsigned int Width;
+			unsigned int Height;
+			std::vector<float> FarDepth; // farthest depth of the pixels covered: boxes behind it are hidden
+			std::vector<float> NearDepth; // nearest depth of the pixels covered: boxes in front of it are visible, without testing finer levels
+		};
+
+		enum class WorkPhase
+		{
+			Bin,
+			Rasterize
+		};
+
+		void StartWorkers();
+		void StopWorkers();
+		void WorkerLoop(unsigned int threadIndex);
+		void RunPhase(WorkPhase phase); // on all the workers and on the calling thread, returning when all of them are done
+		void DoPhaseWork(WorkPhase phase, unsigned int threadIndex);
+
+		void BinOccluder(unsigned int occluderIndex, ThreadBins& bins);
+		void BinTriangle(const glm::vec4& clip0, const glm::vec4& clip1, const glm::vec4& clip2, ThreadBins& bins); // clipped against the near plane
+		void SetupTriangle(const glm::vec4& clip0, const glm::vec4& clip1, const glm::vec4& clip2, ThreadBins& bins);
+		void RasterizeTile(unsigned int tileIndex);
+		void RasterizeTriangle(const ScreenTriangle& triangle, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY);
+		void BuildHierarchy();
+		bool IsRegionOccluded(unsigned int level, int minX, int minY, int maxX, int maxY, float nearestDepth) const; // region in level 0 pixels, inclusive
+
+		SoftwareOcclusionSettings Settings;
+		unsigned int TilesX;
+		unsigned int TilesY;
+		std::vector<DepthLevel> Levels;
+		std::vector<ThreadBins> Bins; // one for each thread
+		SoftwareOcclusionStats Stats;
+
+		// Inputs of the current rasterization, read by the workers
+		const RenderList* CurrentRenderList;
+		glm::mat4 ViewProjection;
+
+		// Workers, waiting for the next phase between the phases
+		std::vector<std::thread> Workers;
+		std::mutex WorkMutex;
+		std::condition_variable WorkStarted;
+		std::condition_variable WorkFinished;
+		unsigned int WorkGeneration; // incremented at each phase started
+		unsigned int RunningWorkers;
+		WorkPhase CurrentPhase;
+		bool Quitting;
+		std::atomic<unsigned int> NextWorkItem; // next occluder or tile to process
+
+	};
+}
@@ -0,0 +1,156 @@
+#include "VisibilityList.h"
+
+#include "RenderList.h"
+#include "Entities/Camera.h"
+#include "SoftwareOcclusion.h"
+#include "HardwareOcclusion.h"
+
+#include <Math/Frustum.h>
+
+#include <chrono>
+
+namespace GaladHen
+{
+	VisibilityList::VisibilityList()
+		: InstanceIndexBuffer(DynamicBuffer<unsigned int>{ BufferType::ShaderStorage, BufferAccessType::StreamWrite })
+		, Stats()
+		, Culled(false)
+	{}
+
+	void VisibilityList::Cull(const RenderList& renderList, const Camera& camera, float minScreenSize, const SoftwareOcclusion* occlusion, HardwareOcclusion* queries)
+	{
+		const glm::mat4 projection = camera.GetProjectionMatrix();
+
+		// a sphere of radius r at distance d covers r * cot(fovy / 2) / d of the viewport height
+		CullInstances(renderList, projection * camera.GetViewMatrix(), camera.Transform.GetPosition(), projection[1][1], minScreenSize, occlusion, queries, BatchSelection::All);
+	}
+
+	void VisibilityList::Cull(const RenderList& renderList, const glm::mat4& viewProjection, BatchSelection selection)
+	{
+		CullInstances(renderList, viewProjection, glm::vec3(0.0f), 0.0f, 0.0f, nullptr, nullptr, selection);
+	}
+
+	void VisibilityList::CullInstances(const RenderList& renderList, const glm::mat4& viewProjection, const glm::vec3& cameraPosition, float screenScale, float minScreenSize, const SoftwareOcclusion* occlusion, HardwareOcclusion* queries, BatchSelection selection)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		const std::vector<InstanceBatch>& batches = renderList.GetBatches();
+		const std::vector<AABB>& instanceBounds = renderList.GetInstanceBounds();
+
+		const Frustum frustum{ viewProjection };
+
+		// squared, to test without square roots
+		const float minScreenSizeSquared = minScreenSize * minScreenSize;
+
+		Batches.resize(batches.size());
+		InstanceIndexBuffer.ClearData();
+		Stats = CullingStats{};
+		Culled = true;
+
+		for (unsigned int b = 0; b < batches.size(); ++b)
+		{
+			const InstanceBatch& batch = batches[b];
+			BatchVisibility& visibility = Batches[b];
+			visibility.FirstVisible = Stats.VisibleInstances;
+			visibility.VisibleCount = 0;
+
+			if (!IsSelected(batch, selection))
+				continue;
+
+			FrustumTest batchTest = frustum.ClassifyAABB(batch.InstancesBounds);
+			if (batchTest == FrustumTest::Outside)
+			{
+				Stats.FrustumCulledInstances += batch.InstanceCount;
+				continue;
+			}
+
+			// occluders can't hide themselves: their triangles are inside their bounds, never in front of them
+			if (occlusion && occlusion->IsOccluded(batch.InstancesBounds))
+			{
+				Stats.OcclusionCulledInstances += batch.InstanceCount;
+				continue;
+			}
+
+			for (unsigned int i = batch.FirstInstance; i < batch.FirstInstance + batch.InstanceCount; ++i)
+			{
+				const AABB& bounds = instanceBounds[i];
+
+				if (batchTest == FrustumTest::Intersecting && !frustum.IntersectsAABB(bounds))
+				{
+					++Stats.FrustumCulledInstances;
+					continue;
+				}
+
+				if (minScreenSize > 0.0f)
+				{
+					glm::vec3 toCenter = (bounds.MinBound + bounds.MaxBound) * 0.5f - cameraPosition;
+					glm::vec3 extents = (bounds.MaxBound - bounds.MinBound) * 0.5f;
+					float radiusSquared = glm::dot(extents, extents);
+					float distanceSquared = glm::dot(toCenter, toCenter);
+
+					// instances around the camera are always kept
+					if (distanceSquared > radiusSquared && radiusSquared * screenScale * screenScale < minScreenSizeSquared * distanceSquared)
+					{
+						++Stats.ContributionCulledInstances;
+						continue;
+					}
+				}
+
+				if (occlusion && occlusion->IsOccluded(bounds))
+				{
+					++Stats.OcclusionCulledInstances;
+					continue;
+				}
+
+				if (queries && queries->TestInstance(i, bounds))
+				{
+					++Stats.QueryCulledInstances;
+					continue;
+				}
+
+				InstanceIndexBuffer.AddData(i);
+				++visibility.VisibleCount;
+				++Stats.VisibleInstances;
+			}
+		}
+
+		Stats.Milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void VisibilityList::ShowAll(const RenderList& renderList, BatchSelection selection)
+	{
+		const std::vector<InstanceBatch>& batches = renderList.GetBatches();
+
+		Batches.resize(batches.size());
+		Stats = CullingStats{};
+		Culled = false;
+
+		// instances of the batches are already consecutive, the index buffer is not needed
+		for (unsigned int b = 0; b < batches.size(); ++b)
+		{
+			Batches[b].FirstVisible = batches[b].FirstInstance;
+			Batches[b].VisibleCount = IsSelected(batches[b], selection) ? batches[b].InstanceCount : 0;
+			Stats.VisibleInstances += Batches[b].VisibleCount;
+		}
+	}
+
+	bool VisibilityList::IsSelected(const InstanceBatch& batch, BatchSelection selection)
+	{
+		return selection == BatchSelection::All || batch.Static == (selection == BatchSelection::Static);
+	}
+
+	const std::vector<BatchVisibility>& VisibilityList::GetBatches() const
+	{
+		return Batches;
+	}
+
+	DynamicBuffer<unsigned int>* VisibilityList::GetInstanceIndexBuffer()
+	{
+		return Culled ? &InstanceIndexBuffer : nullptr;
+	}
+
+	const CullingStats& VisibilityList::GetStats() const
+	{
+		return Stats;
+	}
+}
@@ -0,0 +1,89 @@
+// Visible instances of the render list batches from a camera, culled on cpu against the camera frustum and optionally against the occluders of the scene
+// or the occlusion queries of the previous frames
+// The indices of the visible instances are listed batch after batch: draws read them as instance indices, instead of drawing all the instances of a batch
+
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Entities/Buffer.hpp"
+
+namespace GaladHen
+{
+	class RenderList;
+	struct InstanceBatch;
+	class Camera;
+	class SoftwareOcclusion;
+	class HardwareOcclusion;
+
+	struct CullingStats
+	{
+		unsigned int VisibleInstances;
+		unsigned int FrustumCulledInstances;
+		unsigned int ContributionCulledInstances; // inside the frustum, but smaller than the minimum screen size
+		unsigned int OcclusionCulledInstances; // inside the frustum and large enough, but hidden by the occluders
+		unsigned int QueryCulledInstances; // hidden at their last occlusion query
+		float Milliseconds; // cpu time of the visibility tests
+	};
+
+	// Batches whose instances are tested, the others have no visible instances (ex: to render the shadows of static and dynamic scene objects separately)
+	enum class BatchSelection
+	{
+		All,
+		Static,
+		Dynamic
+	};
+
+	// Visible instances of a batch, consecutive inside the instance index buffer
+	struct BatchVisibility
+	{
+		unsigned int FirstVisible; // first index of the batch inside the instance index buffer, or first instance of the batch if there is no index buffer
+		unsigned int VisibleCount;
+	};
+
+	class VisibilityList
+	{
+	public:
+
+		VisibilityList();
+
+		// @brief
+		// Cull the instances of the render list batches against the frustum of a camera
+		// Batches entirely inside or outside the frustum are classified as a whole, the others instance by instance
+		// @param minScreenSize: instances whose bounding sphere covers less than this fraction of the viewport height are culled too (0 to keep them)
+		// @param occlusion: occluders rendered from the same camera, hiding the instances behind them (nullptr to skip the occlusion test)
+		// @param queries: occlusion queries of the previous frames, scheduling new ones for the instances still in view (nullptr to skip them)
+		void Cull(const RenderList& renderList, const Camera& camera, float minScreenSize, const SoftwareOcclusion* occlusion = nullptr, HardwareOcclusion* queries = nullptr);
+
+		// @brief
+		// Cull the instances of the render list batches against the frustum of a view projection matrix only (ex: of a light)
+		void Cull(const RenderList& renderList, const glm::mat4& viewProjection, BatchSelection selection = BatchSelection::All);
+
+		// @brief
+		// Make all the instances of the selected render list batches visible: draws read consecutive instances, without index buffer
+		void ShowAll(const RenderList& renderList, BatchSelection selection = BatchSelection::All);
+
+		// @returns the visible instances of each batch, indexed as the render list batches
+		const std::vector<BatchVisibility>& GetBatches() const;
+
+		// @returns the indices of the visible instances inside the per-instance buffers, grouped by batch; nullptr after ShowAll()
+		DynamicBuffer<unsigned int>* GetInstanceIndexBuffer();
+
+		const CullingStats& GetStats() const;
+
+	protected:
+
+		// @param screenScale: projected size of a sphere of unit radius at unit distance, as a fraction of the viewport height
+		void CullInstances(const RenderList& renderList, const glm::mat4& viewProjection, const glm::vec3& cameraPosition, float screenScale, float minScreenSize, const SoftwareOcclusion* occlusion, HardwareOcclusion* queries, BatchSelection selection);
+
+		static bool IsSelected(const InstanceBatch& batch, BatchSelection selection);
+
+		std::vector<BatchVisibility> Batches;
+		DynamicBuffer<unsigned int> InstanceIndexBuffer;
+		CullingStats Stats;
+		bool Culled;
+
+	};
+}
@@ -0,0 +1,91 @@
+#include "LinearArena.h"
+
+#include <cstdlib>
+#include <cstdint>
+
+LinearArena::LinearArena(size_t capacity)
+	: CurrentBlock(0)
+	, Offset(0)
+	, UsedBytes(0)
+	, GrowthsNumber(0)
+{
+	Blocks.push_back(ArenaBlock{ static_cast<unsigned char*>(malloc(capacity)), capacity });
+}
+
+LinearArena::~LinearArena()
+{
+	for (ArenaBlock& block : Blocks)
+		free(block.Memory);
+}
+
+void* LinearArena::Allocate(size_t bytes, size_t alignment)
+{
+	ArenaBlock* block = &Blocks[CurrentBlock];
+
+	uintptr_t address = reinterpret_cast<uintptr_t>(block->Memory) + Offset;
+	size_t padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+
+	if (Offset + padding + bytes > block->Size)
+	{
+		// Next block, at least twice the current one
+		size_t size = block->Size * 2;
+		if (size < bytes + alignment)
+			size = bytes + alignment;
+
+		Blocks.push_back(ArenaBlock{ static_cast<unsigned char*>(malloc(size)), size });
+		++GrowthsNumber;
+
+		CurrentBlock = (unsigned int)Blocks.size() - 1;
+		Offset = 0;
+		block = &Blocks[CurrentBlock];
+
+		address = reinterpret_cast<uintptr_t>(block->Memory);
+		padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+	}
+
+	void* memory = block->Memory + Offset + padding;
+	Offset += padding + bytes;
+	UsedBytes += padding + bytes;
+
+	return memory;
+}
+
+void LinearArena::Reset()
+{
+	if (Blocks.size() > 1)
+	{
+		size_t capacity = 0;
+		for (ArenaBlock& block : Blocks)
+		{
+			capacity += block.Size;
+			free(block.Memory);
+		}
+
+		Blocks.resize(1);
+		Blocks[0] = ArenaBlock{ static_cast<unsigned char*>(malloc(capacity)), capacity };
+		++GrowthsNumber;
+	}
+
+	CurrentBlock = 0;
+	Offset = 0;
+	UsedBytes = 0;
+}
+
+size_t LinearArena::GetCapacity() const
+{
+	size_t capacity = 0;
+	for (const ArenaBlock& block : Blocks)
+		capacity += block.Size;
+
+	return capacity;
+}
+
+size_t LinearArena::GetUsedBytes() const
+{
+	return UsedBytes;
+}
+
+unsigned int LinearArena::GetGrowthsNumber() const
+{
+	return GrowthsNumber;
+}
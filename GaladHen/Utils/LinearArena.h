@@ -0,0 +1,102 @@
+// A linear (bump) allocator: allocations are released all together with Reset, typically once per frame
+// ArenaAllocator adapts it to the standard containers, so transient containers do not hit the heap in steady state
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+class LinearArena
+{
+public:
+
+	LinearArena(size_t capacity);
+	~LinearArena();
+
+	LinearArena(const LinearArena& other) = delete;
+	LinearArena& operator=(const LinearArena& other) = delete;
+
+	// @brief
+	// Allocate memory from the arena. When the arena is full a new block is allocated from the heap
+	// @param alignment: must be a power of two
+	void* Allocate(size_t bytes, size_t alignment);
+
+	// @brief
+	// Release all the allocations. If the arena grew since the last reset, its blocks are merged into a single one,
+	// so that the next frames with the same usage do not allocate
+	void Reset();
+
+	size_t GetCapacity() const;
+
+	size_t GetUsedBytes() const;
+
+	// @returns the number of heap allocations made by the arena itself (new blocks), since its creation
+	unsigned int GetGrowthsNumber() const;
+
+protected:
+
+	struct ArenaBlock
+	{
+		unsigned char* Memory;
+		size_t Size;
+	};
+
+	std::vector<ArenaBlock> Blocks;
+	unsigned int CurrentBlock;
+	size_t Offset; // Inside the current block
+	size_t UsedBytes; // Inside all the blocks
+	unsigned int GrowthsNumber;
+
+};
+
+// Standard allocator using a LinearArena. Deallocation is a no-op: memory is released by the arena reset
+// A default constructed allocator (no arena) uses the heap, so containers can use the arena only when needed
+template <class T>
+class ArenaAllocator
+{
+public:
+
+	typedef T value_type;
+
+	ArenaAllocator()
+		: Arena(nullptr)
+	{}
+
+	ArenaAllocator(LinearArena& arena)
+		: Arena(&arena)
+	{}
+
+	template <class U>
+	ArenaAllocator(const ArenaAllocator<U>& other)
+		: Arena(other.Arena)
+	{}
+
+	T* allocate(size_t number)
+	{
+		if (Arena)
+			return static_cast<T*>(Arena->Allocate(number * sizeof(T), alignof(T)));
+
+		return static_cast<T*>(::operator new(number * sizeof(T)));
+	}
+
+	void deallocate(T* pointer, size_t /*number*/)
+	{
+		if (!Arena)
+			::operator delete(pointer);
+	}
+
+	template <class U>
+	bool operator==(const ArenaAllocator<U>& other) const
+	{
+		return Arena == other.Arena;
+	}
+
+	template <class U>
+	bool operator!=(const ArenaAllocator<U>& other) const
+	{
+		return Arena != other.Arena;
+	}
+
+	LinearArena* Arena;
+
+};
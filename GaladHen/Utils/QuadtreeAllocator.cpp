@@ -0,0 +1,190 @@
+#include "QuadtreeAllocator.h"
+
+static unsigned int NextPowerOfTwo(unsigned int value)
+{
+	unsigned int power = 1;
+	while (power < value)
+		power <<= 1;
+
+	return power;
+}
+
+QuadtreeAllocator::QuadtreeAllocator(unsigned int size, unsigned int minTileSize)
+	: Size(NextPowerOfTwo(size))
+	, MinTileSize(0)
+	, Levels(1)
+	, AllocationsNumber(0)
+	, UsedArea(0)
+{
+	MinTileSize = NextPowerOfTwo(minTileSize) < Size ? NextPowerOfTwo(minTileSize) : Size;
+	for (unsigned int side = Size; side > MinTileSize; side >>= 1)
+		++Levels;
+
+	// (4^levels - 1) / 3 nodes
+	Nodes.assign((((size_t)1 << (2 * Levels)) - 1) / 3, NodeState::Free);
+}
+
+bool QuadtreeAllocator::Allocate(unsigned int tileSize, unsigned int& outX, unsigned int& outY)
+{
+	unsigned int targetLevel = GetLevel(tileSize);
+
+	// free nodes beside other tiles first, so that large free nodes stay whole for large tiles
+	int node = FindFreeNodeInSplitNodes(0, 0, targetLevel);
+	if (node < 0)
+	{
+		unsigned int freeLevel = 0;
+		node = FindSmallestFreeNode(0, 0, targetLevel, freeLevel);
+		if (node < 0)
+			return false;
+
+		// split down to the target level, always taking the first child
+		for (; freeLevel < targetLevel; ++freeLevel)
+		{
+			Nodes[node] = NodeState::Split;
+			node = 4 * node + 1;
+			for (unsigned int c = 0; c < 4; ++c)
+				Nodes[node + c] = NodeState::Free;
+		}
+	}
+
+	Nodes[node] = NodeState::Allocated;
+	++AllocationsNumber;
+	unsigned int side = Size >> targetLevel;
+	UsedArea += (unsigned long long)side * side;
+
+	// the path from the root gives the position, a quadrant for each level
+	outX = 0;
+	outY = 0;
+	for (unsigned int level = targetLevel; level > 0; --level)
+	{
+		unsigned int child = (node - 1) % 4;
+		unsigned int childSide = Size >> level;
+		outX += (child & 1) ? childSide : 0;
+		outY += (child & 2) ? childSide : 0;
+		node = (node - 1) / 4;
+	}
+
+	return true;
+}
+
+void QuadtreeAllocator::Free(unsigned int x, unsigned int y, unsigned int tileSize)
+{
+	unsigned int targetLevel = GetLevel(tileSize);
+
+	unsigned int node = 0;
+	for (unsigned int level = 1; level <= targetLevel; ++level)
+	{
+		unsigned int childSide = Size >> level;
+		unsigned int child = ((x / childSide) & 1) | (((y / childSide) & 1) << 1);
+		node = 4 * node + 1 + child;
+	}
+
+	if (Nodes[node] != NodeState::Allocated)
+		return;
+
+	Nodes[node] = NodeState::Free;
+	--AllocationsNumber;
+	unsigned int side = Size >> targetLevel;
+	UsedArea -= (unsigned long long)side * side;
+
+	// merge the parents whose children are all free
+	while (node > 0)
+	{
+		unsigned int parent = (node - 1) / 4;
+		unsigned int firstChild = 4 * parent + 1;
+		for (unsigned int c = 0; c < 4; ++c)
+		{
+			if (Nodes[firstChild + c] != NodeState::Free)
+				return;
+		}
+
+		Nodes[parent] = NodeState::Free;
+		node = parent;
+	}
+}
+
+void QuadtreeAllocator::Clear()
+{
+	Nodes.assign(Nodes.size(), NodeState::Free);
+	AllocationsNumber = 0;
+	UsedArea = 0;
+}
+
+unsigned int QuadtreeAllocator::GetSize() const
+{
+	return Size;
+}
+
+unsigned int QuadtreeAllocator::GetMinTileSize() const
+{
+	return MinTileSize;
+}
+
+unsigned int QuadtreeAllocator::GetTileSize(unsigned int tileSize) const
+{
+	return Size >> GetLevel(tileSize);
+}
+
+unsigned int QuadtreeAllocator::GetAllocationsNumber() const
+{
+	return AllocationsNumber;
+}
+
+float QuadtreeAllocator::GetUsedArea() const
+{
+	return (float)UsedArea / ((float)Size * Size);
+}
+
+unsigned int QuadtreeAllocator::GetLevel(unsigned int tileSize) const
+{
+	unsigned int level = 0;
+	for (unsigned int side = Size; side > tileSize && level + 1 < Levels; side >>= 1)
+		++level;
+
+	return level;
+}
+
+int QuadtreeAllocator::FindFreeNodeInSplitNodes(unsigned int node, unsigned int level, unsigned int targetLevel) const
+{
+	if (level == targetLevel)
+		return Nodes[node] == NodeState::Free && level > 0 ? (int)node : -1;
+
+	if (Nodes[node] != NodeState::Split)
+		return -1;
+
+	for (unsigned int c = 0; c < 4; ++c)
+	{
+		int found = FindFreeNodeInSplitNodes(4 * node + 1 + c, level + 1, targetLevel);
+		if (found >= 0)
+			return found;
+	}
+
+	return -1;
+}
+
+int QuadtreeAllocator::FindSmallestFreeNode(unsigned int node, unsigned int level, unsigned int targetLevel, unsigned int& outLevel) const
+{
+	if (Nodes[node] == NodeState::Free)
+	{
+		outLevel = level;
+		return (int)node;
+	}
+
+	if (Nodes[node] != NodeState::Split || level >= targetLevel)
+		return -1;
+
+	// the deepest free node found among the children
+	int smallest = -1;
+	for (unsigned int c = 0; c < 4; ++c)
+	{
+		unsigned int childLevel = 0;
+		int found = FindSmallestFreeNode(4 * node + 1 + c, level + 1, targetLevel, childLevel);
+		if (found >= 0 && (smallest < 0 || childLevel > outLevel))
+		{
+			smallest = found;
+			outLevel = childLevel;
+		}
+	}
+
+	return smallest;
+}
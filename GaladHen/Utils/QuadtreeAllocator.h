@@ -0,0 +1,67 @@
+// A quadtree allocator of square tiles inside a square space (ex: the shadow maps packed in a shadow atlas). It only tracks positions, the memory is owned by the user
+// Tile sides are powers of two: each node of the tree is free, allocated or split in four children of half its side, and four free children are merged back
+// into their parent when freed
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+class QuadtreeAllocator
+{
+public:
+
+	// @param size: side of the space, rounded up to a power of two
+	// @param minTileSize: side of the smallest tiles, rounded up to a power of two
+	QuadtreeAllocator(unsigned int size, unsigned int minTileSize);
+
+	// @brief
+	// Allocate a tile inside a node already split if possible, otherwise by splitting the smallest free node large enough
+	// @param tileSize: side of the tile, rounded up to a power of two between the smallest tile side and the side of the space
+	// @param[out] outX, outY: corner of the tile with the lowest coordinates
+	// @returns false if no free node is large enough
+	bool Allocate(unsigned int tileSize, unsigned int& outX, unsigned int& outY);
+
+	// @brief
+	// Release a tile previously allocated, with the same size
+	void Free(unsigned int x, unsigned int y, unsigned int tileSize);
+
+	// @brief
+	// Release all the tiles
+	void Clear();
+
+	unsigned int GetSize() const;
+
+	unsigned int GetMinTileSize() const;
+
+	// @returns the side of the tiles that an allocation of tileSize gets
+	unsigned int GetTileSize(unsigned int tileSize) const;
+
+	// @returns the number of tiles currently allocated
+	unsigned int GetAllocationsNumber() const;
+
+	// @returns the fraction of the space covered by the allocated tiles
+	float GetUsedArea() const;
+
+protected:
+
+	enum class NodeState : unsigned char
+	{
+		Free,
+		Allocated,
+		Split
+	};
+
+	unsigned int GetLevel(unsigned int tileSize) const; // 0 for the whole space
+	int FindFreeNodeInSplitNodes(unsigned int node, unsigned int level, unsigned int targetLevel) const; // free node of the target level, under split nodes only
+	int FindSmallestFreeNode(unsigned int node, unsigned int level, unsigned int targetLevel, unsigned int& outLevel) const; // free node above the target level
+
+	// nodes of a full tree one level after the other, children of node n are 4n + 1 ... 4n + 4 (x offset by bit 0, y offset by bit 1)
+	std::vector<NodeState> Nodes;
+	unsigned int Size;
+	unsigned int MinTileSize;
+	unsigned int Levels;
+	unsigned int AllocationsNumber;
+	unsigned long long UsedArea;
+
+};
@@ -0,0 +1,105 @@
+#include "RangeAllocator.h"
+
+#include <iterator>
+
+RangeAllocator::RangeAllocator(size_t capacity)
+	: Capacity(0)
+	, UsedSize(0)
+	, AllocationsNumber(0)
+{
+	Grow(capacity);
+}
+
+bool RangeAllocator::Allocate(size_t size, size_t& outOffset)
+{
+	if (size == 0)
+		return false;
+
+	for (std::map<size_t, size_t>::iterator it = FreeRanges.begin(); it != FreeRanges.end(); ++it)
+	{
+		if (it->second < size)
+			continue;
+
+		outOffset = it->first;
+
+		// the remaining part stays free
+		size_t remaining = it->second - size;
+		FreeRanges.erase(it);
+		if (remaining > 0)
+			FreeRanges.emplace(outOffset + size, remaining);
+
+		UsedSize += size;
+		++AllocationsNumber;
+
+		return true;
+	}
+
+	return false;
+}
+
+void RangeAllocator::Free(size_t offset, size_t size)
+{
+	if (size == 0)
+		return;
+
+	UsedSize -= size;
+	--AllocationsNumber;
+
+	InsertFreeRange(offset, size);
+}
+
+void RangeAllocator::Grow(size_t capacity)
+{
+	if (capacity <= Capacity)
+		return;
+
+	// merged with a free range at the end of the previous space
+	InsertFreeRange(Capacity, capacity - Capacity);
+	Capacity = capacity;
+}
+
+size_t RangeAllocator::GetCapacity() const
+{
+	return Capacity;
+}
+
+size_t RangeAllocator::GetUsedSize() const
+{
+	return UsedSize;
+}
+
+unsigned int RangeAllocator::GetAllocationsNumber() const
+{
+	return AllocationsNumber;
+}
+
+unsigned int RangeAllocator::GetFreeRangesNumber() const
+{
+	return (unsigned int)FreeRanges.size();
+}
+
+void RangeAllocator::InsertFreeRange(size_t offset, size_t size)
+{
+	std::map<size_t, size_t>::iterator next = FreeRanges.lower_bound(offset);
+
+	// merge with the previous free range if adjacent
+	if (next != FreeRanges.begin())
+	{
+		std::map<size_t, size_t>::iterator previous = std::prev(next);
+		if (previous->first + previous->second == offset)
+		{
+			offset = previous->first;
+			size += previous->second;
+			FreeRanges.erase(previous);
+		}
+	}
+
+	// merge with the next free range if adjacent
+	if (next != FreeRanges.end() && offset + size == next->first)
+	{
+		size += next->second;
+		FreeRanges.erase(next);
+	}
+
+	FreeRanges.emplace(offset, size);
+}
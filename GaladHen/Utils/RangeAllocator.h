@@ -0,0 +1,48 @@
+// A free-list allocator of ranges inside a linear space (ex: vertices of a large gpu buffer). It only tracks offsets, the memory is owned by the user
+// Free ranges are kept sorted by offset and merged with their neighbours, so that freed space can be reused by larger allocations
+
+#pragma once
+
+#include <map>
+#include <cstddef>
+
+class RangeAllocator
+{
+public:
+
+	RangeAllocator(size_t capacity);
+
+	// @brief
+	// Allocate a range from the first free range large enough
+	// @param[out] outOffset: start of the allocated range
+	// @returns false if no free range is large enough: the space can be grown and the allocation retried
+	bool Allocate(size_t size, size_t& outOffset);
+
+	// @brief
+	// Release a range previously allocated, with the same size
+	void Free(size_t offset, size_t size);
+
+	// @brief
+	// Extend the space, adding the new part to the free ranges
+	void Grow(size_t capacity);
+
+	size_t GetCapacity() const;
+
+	size_t GetUsedSize() const;
+
+	// @returns the number of ranges currently allocated
+	unsigned int GetAllocationsNumber() const;
+
+	// @returns the number of free ranges: more than one means the free space is fragmented
+	unsigned int GetFreeRangesNumber() const;
+
+protected:
+
+	void InsertFreeRange(size_t offset, size_t size);
+
+	std::map<size_t, size_t> FreeRanges; // offset -> size
+	size_t Capacity;
+	size_t UsedSize;
+	unsigned int AllocationsNumber;
+
+};